@@ -0,0 +1,958 @@
+#pragma once
+// 基于 SSD 的图索引（Vamana / DiskANN 风格）
+//
+// 内存中只保留 PQ 压缩向量；完整向量和邻接表按 4KB 扇区对齐写入磁盘文件，
+// 查询时用 beam search 批量发起异步读（优先 io_uring，不可用时退化为线程池 pread）。
+//
+// 文件布局：
+//   扇区 0           文件头 DiskIndexHeader
+//   扇区 1..         节点记录 [float vec[dim]][uint32 cnt][uint32 nbrs[R]]
+//                    记录不超过 4KB 时若干节点共用一个扇区（不跨扇区），否则每个节点独占若干扇区
+//   <path>.pq        PQ 码本和编码，常驻内存
+
+#include <vector>
+#include <queue>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <limits>
+#include <random>
+#include <string>
+#include <fstream>
+#include <stdexcept>
+#include <algorithm>
+#include <unordered_set>
+#include <cstring>
+#include <cstdint>
+#include <cstdlib>
+#include <cerrno>
+#include <exception>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#define DISK_INDEX_USE_IO_URING
+#endif
+#include "hnswlib/hnswlib/hnswlib.h"
+
+static const size_t DISK_SECTOR_LEN = 4096;
+static const uint64_t DISK_INDEX_MAGIC = 0x3158444e4b534944ull; // "DISKNDX1"
+
+struct DiskIndexHeader
+{
+    uint64_t magic;
+    uint64_t n;
+    uint64_t dim;
+    uint64_t R;
+    uint64_t medoid;
+    uint64_t max_node_len;     // 单个节点记录的字节数
+    uint64_t nodes_per_sector; // 0 表示一个节点占多个扇区
+    uint64_t sectors_per_node;
+};
+
+// 一次扇区读请求，buf 必须 4KB 对齐
+struct SectorRead
+{
+    uint64_t offset;
+    size_t len;
+    char *buf;
+};
+
+// === 批量读：线程池 pread ===
+class ThreadPoolReader
+{
+public:
+    ThreadPoolReader(int fd, size_t num_threads) : fd_(fd)
+    {
+        for (size_t i = 0; i < num_threads; ++i)
+            workers_.emplace_back([this] { worker(); });
+    }
+
+    ~ThreadPoolReader()
+    {
+        {
+            std::unique_lock<std::mutex> lock(mu_);
+            stop_ = true;
+        }
+        cv_task_.notify_all();
+        for (auto &t : workers_)
+            t.join();
+    }
+
+    // 阻塞直到整批请求完成；某个请求失败时整批仍会等到全部结束，再在调用线程重新抛出第一个错误
+    void read_batch(std::vector<SectorRead> &reqs)
+    {
+        size_t remaining = reqs.size();
+        std::exception_ptr error;
+        std::mutex done_mu;
+        std::condition_variable done_cv;
+        {
+            std::unique_lock<std::mutex> lock(mu_);
+            for (auto &r : reqs)
+                tasks_.push([this, &r, &remaining, &error, &done_mu, &done_cv] {
+                    std::exception_ptr e;
+                    try
+                    {
+                        pread_full(r);
+                    }
+                    catch (...)
+                    {
+                        e = std::current_exception();
+                    }
+                    std::unique_lock<std::mutex> l(done_mu);
+                    if (e && !error)
+                        error = e;
+                    if (--remaining == 0)
+                        done_cv.notify_one();
+                });
+        }
+        cv_task_.notify_all();
+        std::unique_lock<std::mutex> l(done_mu);
+        done_cv.wait(l, [&] { return remaining == 0; });
+        if (error)
+            std::rethrow_exception(error);
+    }
+
+private:
+    void pread_full(const SectorRead &r)
+    {
+        size_t done = 0;
+        while (done < r.len)
+        {
+            ssize_t got = pread(fd_, r.buf + done, r.len - done, r.offset + done);
+            if (got < 0 && errno == EINTR)
+                continue;
+            if (got <= 0)
+                throw std::runtime_error("disk index: pread failed");
+            done += got;
+        }
+    }
+
+    void worker()
+    {
+        while (true)
+        {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(mu_);
+                cv_task_.wait(lock, [this] { return stop_ || !tasks_.empty(); });
+                if (stop_ && tasks_.empty())
+                    return;
+                task = std::move(tasks_.front());
+                tasks_.pop();
+            }
+            task();
+        }
+    }
+
+    int fd_;
+    bool stop_ = false;
+    std::mutex mu_;
+    std::condition_variable cv_task_;
+    std::queue<std::function<void()>> tasks_;
+    std::vector<std::thread> workers_;
+};
+
+#ifdef DISK_INDEX_USE_IO_URING
+// === 批量读：io_uring（直接走系统调用，不依赖 liburing） ===
+// io_uring 实例不是线程安全的，每个查询线程各持有一个。
+class IoUringReader
+{
+public:
+    IoUringReader(unsigned entries)
+    {
+        io_uring_params params;
+        memset(&params, 0, sizeof(params));
+        ring_fd_ = (int)syscall(__NR_io_uring_setup, entries, &params);
+        if (ring_fd_ < 0)
+            return;
+
+        sq_ring_len_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cq_ring_len_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        sqes_len_ = params.sq_entries * sizeof(io_uring_sqe);
+
+        sq_ring_ = (char *)mmap(nullptr, sq_ring_len_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQ_RING);
+        cq_ring_ = (char *)mmap(nullptr, cq_ring_len_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_CQ_RING);
+        sqes_ = (io_uring_sqe *)mmap(nullptr, sqes_len_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQES);
+        if (sq_ring_ == MAP_FAILED || cq_ring_ == MAP_FAILED || (void *)sqes_ == MAP_FAILED)
+        {
+            release();
+            return;
+        }
+
+        sq_tail_ = (unsigned *)(sq_ring_ + params.sq_off.tail);
+        sq_mask_ = *(unsigned *)(sq_ring_ + params.sq_off.ring_mask);
+        sq_array_ = (unsigned *)(sq_ring_ + params.sq_off.array);
+        cq_head_ = (unsigned *)(cq_ring_ + params.cq_off.head);
+        cq_tail_ = (unsigned *)(cq_ring_ + params.cq_off.tail);
+        cq_mask_ = *(unsigned *)(cq_ring_ + params.cq_off.ring_mask);
+        cqes_ = (io_uring_cqe *)(cq_ring_ + params.cq_off.cqes);
+        entries_ = params.sq_entries;
+    }
+
+    ~IoUringReader() { release(); }
+
+    bool ok() const { return ring_fd_ >= 0; }
+
+    // 返回 false 表示内核不支持 IORING_OP_READ（5.6 之前的内核对未知操作码返回 -EINVAL），
+    // 调用者应改用 ThreadPoolReader 重新读取整批。
+    // 每一段提交的请求都会全部收割后才报错，出错后 ring 仍可继续使用。
+    bool read_batch(int fd, std::vector<SectorRead> &reqs)
+    {
+        for (size_t begin = 0; begin < reqs.size(); begin += entries_)
+        {
+            size_t cnt = std::min<size_t>(entries_, reqs.size() - begin);
+            unsigned tail = *sq_tail_;
+            for (size_t i = 0; i < cnt; ++i)
+            {
+                const SectorRead &r = reqs[begin + i];
+                unsigned idx = (tail + i) & sq_mask_;
+                io_uring_sqe *sqe = &sqes_[idx];
+                memset(sqe, 0, sizeof(*sqe));
+                sqe->opcode = IORING_OP_READ;
+                sqe->fd = fd;
+                sqe->off = r.offset;
+                sqe->addr = (uint64_t)r.buf;
+                sqe->len = (unsigned)r.len;
+                sqe->user_data = begin + i;
+                sq_array_[idx] = idx;
+            }
+            __atomic_store_n(sq_tail_, tail + (unsigned)cnt, __ATOMIC_RELEASE);
+
+            size_t reaped = 0;
+            bool submitted = false;
+            bool unsupported = false;
+            const char *error = nullptr;
+            while (reaped < cnt)
+            {
+                unsigned to_submit = submitted ? 0 : (unsigned)cnt;
+                int ret = (int)syscall(__NR_io_uring_enter, ring_fd_, to_submit, (unsigned)(cnt - reaped), IORING_ENTER_GETEVENTS, nullptr, 0);
+                if (ret < 0 && errno != EINTR)
+                    throw std::runtime_error("disk index: io_uring_enter failed");
+                if (ret >= 0)
+                    submitted = true;
+
+                unsigned head = *cq_head_;
+                unsigned cq_tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+                for (; head != cq_tail; ++head, ++reaped)
+                {
+                    const io_uring_cqe &cqe = cqes_[head & cq_mask_];
+                    if (cqe.res == -EINVAL)
+                        unsupported = true;
+                    else if (cqe.res != (int)reqs[cqe.user_data].len && !error)
+                        error = "disk index: short read from io_uring";
+                }
+                __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+            }
+            if (unsupported && begin == 0)
+                return false;
+            if (unsupported)
+                error = "disk index: io_uring read failed with EINVAL";
+            if (error)
+                throw std::runtime_error(error);
+        }
+        return true;
+    }
+
+private:
+    void release()
+    {
+        if (sqes_ && (void *)sqes_ != MAP_FAILED)
+            munmap(sqes_, sqes_len_);
+        if (cq_ring_ && cq_ring_ != MAP_FAILED)
+            munmap(cq_ring_, cq_ring_len_);
+        if (sq_ring_ && sq_ring_ != MAP_FAILED)
+            munmap(sq_ring_, sq_ring_len_);
+        sqes_ = nullptr;
+        cq_ring_ = sq_ring_ = nullptr;
+        if (ring_fd_ >= 0)
+            close(ring_fd_);
+        ring_fd_ = -1;
+    }
+
+    int ring_fd_ = -1;
+    unsigned entries_ = 0;
+    char *sq_ring_ = nullptr, *cq_ring_ = nullptr;
+    io_uring_sqe *sqes_ = nullptr;
+    size_t sq_ring_len_ = 0, cq_ring_len_ = 0, sqes_len_ = 0;
+    unsigned *sq_tail_ = nullptr, *sq_array_ = nullptr, *cq_head_ = nullptr, *cq_tail_ = nullptr;
+    unsigned sq_mask_ = 0, cq_mask_ = 0;
+    io_uring_cqe *cqes_ = nullptr;
+};
+#endif
+
+// === 乘积量化（PQ），用于内存中的压缩向量 ===
+class ProductQuantizer
+{
+public:
+    static const size_t KSUB = 256;
+
+    size_t dim = 0, m = 0, dsub = 0;
+    std::vector<float> centroids; // m * KSUB * dsub
+
+    // 在 sample 上为每个子空间训练 256 个聚类中心（L2 k-means）
+    void train(const float *data, size_t n, size_t dim_, size_t m_, size_t iters = 10, size_t sample = 20000)
+    {
+        if (dim_ % m_ != 0)
+            throw std::runtime_error("PQ: dim must be divisible by the number of subspaces");
+        dim = dim_;
+        m = m_;
+        dsub = dim / m;
+        centroids.assign(m * KSUB * dsub, 0);
+
+        std::mt19937 rng(1234);
+        size_t ns = std::min(n, sample);
+        std::vector<size_t> ids(n);
+        for (size_t i = 0; i < n; ++i)
+            ids[i] = i;
+        std::shuffle(ids.begin(), ids.end(), rng);
+        ids.resize(ns);
+
+#pragma omp parallel for
+        for (long s = 0; s < (long)m; ++s)
+        {
+            float *cent = centroids.data() + s * KSUB * dsub;
+            for (size_t c = 0; c < KSUB; ++c)
+                memcpy(cent + c * dsub, data + ids[c % ns] * dim + s * dsub, dsub * sizeof(float));
+
+            std::vector<uint32_t> assign(ns);
+            std::vector<float> sum(KSUB * dsub);
+            std::vector<size_t> cnt(KSUB);
+            for (size_t it = 0; it < iters; ++it)
+            {
+                for (size_t i = 0; i < ns; ++i)
+                    assign[i] = nearest(cent, data + ids[i] * dim + s * dsub);
+
+                std::fill(sum.begin(), sum.end(), 0.0f);
+                std::fill(cnt.begin(), cnt.end(), 0);
+                for (size_t i = 0; i < ns; ++i)
+                {
+                    const float *x = data + ids[i] * dim + s * dsub;
+                    for (size_t d = 0; d < dsub; ++d)
+                        sum[assign[i] * dsub + d] += x[d];
+                    cnt[assign[i]]++;
+                }
+                for (size_t c = 0; c < KSUB; ++c)
+                    if (cnt[c])
+                        for (size_t d = 0; d < dsub; ++d)
+                            cent[c * dsub + d] = sum[c * dsub + d] / cnt[c];
+            }
+        }
+    }
+
+    void encode(const float *x, uint8_t *code) const
+    {
+        for (size_t s = 0; s < m; ++s)
+            code[s] = (uint8_t)nearest(centroids.data() + s * KSUB * dsub, x + s * dsub);
+    }
+
+    // 查询时先算出 m x 256 的距离表，之后每个编码的距离只需 m 次查表
+    void compute_table(const float *query, bool ip, float *table) const
+    {
+        for (size_t s = 0; s < m; ++s)
+        {
+            const float *cent = centroids.data() + s * KSUB * dsub;
+            const float *q = query + s * dsub;
+            for (size_t c = 0; c < KSUB; ++c)
+            {
+                float v = 0;
+                for (size_t d = 0; d < dsub; ++d)
+                    v += ip ? q[d] * cent[c * dsub + d] : (q[d] - cent[c * dsub + d]) * (q[d] - cent[c * dsub + d]);
+                table[s * KSUB + c] = v;
+            }
+        }
+    }
+
+    float table_distance(const float *table, const uint8_t *code, bool ip) const
+    {
+        float v = 0;
+        for (size_t s = 0; s < m; ++s)
+            v += table[s * KSUB + code[s]];
+        return ip ? 1 - v : v;
+    }
+
+private:
+    uint32_t nearest(const float *cent, const float *x) const
+    {
+        uint32_t best = 0;
+        float best_dist = std::numeric_limits<float>::max();
+        for (size_t c = 0; c < KSUB; ++c)
+        {
+            float dist = 0;
+            for (size_t d = 0; d < dsub; ++d)
+                dist += (x[d] - cent[c * dsub + d]) * (x[d] - cent[c * dsub + d]);
+            if (dist < best_dist)
+            {
+                best_dist = dist;
+                best = (uint32_t)c;
+            }
+        }
+        return best;
+    }
+};
+
+struct DiskSearchStats
+{
+    size_t n_ios = 0;   // 读取的节点数
+    size_t n_hops = 0;  // beam search 轮数
+    size_t n_cmps = 0;  // PQ 距离计算次数
+};
+
+class DiskIndex
+{
+public:
+    // ip = true 时使用 1 - <x, y>（DEEP100K），否则使用 L2 平方距离
+    DiskIndex(hnswlib::SpaceInterface<float> *s, bool ip) : ip_(ip)
+    {
+        fstdistfunc_ = s->get_dist_func();
+        dist_func_param_ = s->get_dist_func_param();
+    }
+
+    ~DiskIndex()
+    {
+        if (fd_ >= 0)
+            close(fd_);
+    }
+
+    /**
+     * 在内存中构建 Vamana 图并写出磁盘索引。
+     *
+     * @param R 每个节点的最大出度
+     * @param L 构建时的候选列表长度
+     * @param alpha RobustPrune 的放松系数，第二轮使用
+     * @param pq_m PQ 子空间个数（每个向量压缩为 pq_m 字节）
+     */
+    void build(const float *base, size_t n, size_t dim, const std::string &path,
+               size_t R = 32, size_t L = 64, float alpha = 1.2f, size_t pq_m = 0)
+    {
+        n_ = n;
+        dim_ = dim;
+        R_ = R;
+        if (pq_m == 0)
+            pq_m = dim / 4;
+
+        std::vector<std::vector<uint32_t>> graph(n);
+        build_vamana(base, graph, L, alpha);
+
+        pq_.train(base, n, dim, pq_m);
+        pq_codes_.resize(n * pq_.m);
+#pragma omp parallel for
+        for (long i = 0; i < (long)n; ++i)
+            pq_.encode(base + i * dim, pq_codes_.data() + i * pq_.m);
+
+        write_disk(base, graph, path);
+        write_pq(path + ".pq");
+    }
+
+    // 打开磁盘索引，PQ 编码载入内存；num_io_threads 仅在 io_uring 不可用时使用
+    void load(const std::string &path, size_t num_io_threads = 8)
+    {
+        fd_ = open(path.c_str(), O_RDONLY | O_DIRECT);
+        if (fd_ < 0) // 部分文件系统（如 tmpfs）不支持 O_DIRECT
+            fd_ = open(path.c_str(), O_RDONLY);
+        if (fd_ < 0)
+            throw std::runtime_error("disk index: cannot open " + path);
+
+        std::unique_ptr<char, decltype(&free)> sector(alloc_sectors(1), &free);
+        if (pread(fd_, sector.get(), DISK_SECTOR_LEN, 0) != (ssize_t)DISK_SECTOR_LEN)
+            throw std::runtime_error("disk index: cannot read header");
+        memcpy(&header_, sector.get(), sizeof(header_));
+        if (header_.magic != DISK_INDEX_MAGIC)
+            throw std::runtime_error("disk index: bad magic");
+        n_ = header_.n;
+        dim_ = header_.dim;
+        R_ = header_.R;
+
+        read_pq(path + ".pq");
+        io_threads_ = num_io_threads;
+#ifndef DISK_INDEX_USE_IO_URING
+        pool_reader_.reset(new ThreadPoolReader(fd_, io_threads_));
+#endif
+    }
+
+    // 丢弃索引文件的页缓存，用于冷启动测试（O_DIRECT 打开时本就不经过页缓存）
+    void drop_page_cache() const
+    {
+        posix_fadvise(fd_, 0, 0, POSIX_FADV_DONTNEED);
+    }
+
+    /**
+     * beam search：每轮取出候选列表中最近的 beam_width 个未扩展节点，一次性批量读盘，
+     * 用完整向量计算精确距离，用 PQ 距离决定邻居是否进入候选列表。
+     */
+    std::priority_queue<std::pair<float, uint32_t>>
+    search(const float *query, size_t k, size_t L = 64, size_t beam_width = 4, DiskSearchStats *stats = nullptr)
+    {
+        L = std::max(L, k);
+        ScratchGuard guard(*this);
+        Scratch &sc = *guard.sc;
+        sc.prepare(beam_width * header_.sectors_per_node, pq_.m * ProductQuantizer::KSUB);
+        pq_.compute_table(query, ip_, sc.table.data());
+
+        struct Candidate
+        {
+            float dist;
+            uint32_t id;
+            bool expanded;
+        };
+        std::vector<Candidate> retset;
+        retset.reserve(L + 1);
+        std::unordered_set<uint32_t> visited;
+        std::vector<std::pair<float, uint32_t>> full;
+
+        auto try_insert = [&](uint32_t id) {
+            if (!visited.insert(id).second)
+                return;
+            float d = pq_.table_distance(sc.table.data(), pq_codes_.data() + (size_t)id * pq_.m, ip_);
+            if (stats)
+                stats->n_cmps++;
+            if (retset.size() >= L && d >= retset.back().dist)
+                return;
+            Candidate c = {d, id, false};
+            auto pos = std::upper_bound(retset.begin(), retset.end(), c,
+                                        [](const Candidate &a, const Candidate &b) { return a.dist < b.dist; });
+            retset.insert(pos, c);
+            if (retset.size() > L)
+                retset.pop_back();
+        };
+
+        try_insert((uint32_t)header_.medoid);
+
+        std::vector<uint32_t> frontier;
+        std::vector<SectorRead> reqs;
+        while (true)
+        {
+            frontier.clear();
+            for (auto &c : retset)
+            {
+                if (frontier.size() >= beam_width)
+                    break;
+                if (!c.expanded)
+                {
+                    c.expanded = true;
+                    frontier.push_back(c.id);
+                }
+            }
+            if (frontier.empty())
+                break;
+
+            reqs.clear();
+            for (size_t i = 0; i < frontier.size(); ++i)
+                reqs.push_back({node_sector(frontier[i]) * DISK_SECTOR_LEN,
+                                header_.sectors_per_node * DISK_SECTOR_LEN,
+                                sc.buf + i * header_.sectors_per_node * DISK_SECTOR_LEN});
+            read_batch(sc, reqs);
+            if (stats)
+            {
+                stats->n_ios += frontier.size();
+                stats->n_hops++;
+            }
+
+            for (size_t i = 0; i < frontier.size(); ++i)
+            {
+                const char *rec = reqs[i].buf + node_offset_in_sector(frontier[i]);
+                const float *vec = (const float *)rec;
+                uint32_t cnt;
+                memcpy(&cnt, rec + dim_ * sizeof(float), sizeof(cnt));
+                const uint32_t *nbrs = (const uint32_t *)(rec + dim_ * sizeof(float) + sizeof(uint32_t));
+
+                full.emplace_back(fstdistfunc_(query, vec, dist_func_param_), frontier[i]);
+                for (uint32_t j = 0; j < cnt; ++j)
+                    try_insert(nbrs[j]);
+            }
+        }
+
+        size_t kk = std::min(k, full.size());
+        std::partial_sort(full.begin(), full.begin() + kk, full.end());
+        std::priority_queue<std::pair<float, uint32_t>> q;
+        for (size_t i = 0; i < kk; ++i)
+            q.push(full[i]);
+        return q;
+    }
+
+    size_t memory_footprint() const
+    {
+        return pq_codes_.size() + pq_.centroids.size() * sizeof(float);
+    }
+
+private:
+    struct Scratch
+    {
+        std::vector<float> table;
+        char *buf = nullptr;
+        size_t n_sectors = 0;
+#ifdef DISK_INDEX_USE_IO_URING
+        std::unique_ptr<IoUringReader> ring;
+#endif
+
+        void prepare(size_t sectors, size_t table_len)
+        {
+            if (sectors > n_sectors)
+            {
+                free(buf);
+                buf = alloc_sectors(sectors);
+                n_sectors = sectors;
+            }
+            table.resize(table_len);
+        }
+
+        ~Scratch() { free(buf); }
+    };
+
+    static char *alloc_sectors(size_t cnt)
+    {
+        void *p = nullptr;
+        if (posix_memalign(&p, DISK_SECTOR_LEN, cnt * DISK_SECTOR_LEN) != 0)
+            throw std::runtime_error("disk index: posix_memalign failed");
+        memset(p, 0, cnt * DISK_SECTOR_LEN);
+        return (char *)p;
+    }
+
+    // 每个索引实例有自己的 Scratch 池（同 hnswlib 的 VisitedListPool）：
+    // 查询时取出一个，结束时归还，不同维度 / 扇区数的索引不会共用缓冲区
+    struct ScratchGuard
+    {
+        DiskIndex &index;
+        std::unique_ptr<Scratch> sc;
+
+        explicit ScratchGuard(DiskIndex &idx) : index(idx)
+        {
+            std::unique_lock<std::mutex> lock(index.scratch_mu_);
+            if (!index.scratch_pool_.empty())
+            {
+                sc = std::move(index.scratch_pool_.back());
+                index.scratch_pool_.pop_back();
+            }
+            else
+                sc.reset(new Scratch());
+        }
+
+        ~ScratchGuard()
+        {
+            std::unique_lock<std::mutex> lock(index.scratch_mu_);
+            index.scratch_pool_.push_back(std::move(sc));
+        }
+    };
+
+    void read_batch(Scratch &sc, std::vector<SectorRead> &reqs)
+    {
+#ifdef DISK_INDEX_USE_IO_URING
+        if (!sc.ring && !ring_unavailable_)
+        {
+            sc.ring.reset(new IoUringReader(64));
+            if (!sc.ring->ok())
+            {
+                sc.ring.reset();
+                ring_unavailable_ = true;
+            }
+        }
+        if (sc.ring)
+        {
+            if (sc.ring->read_batch(fd_, reqs))
+                return;
+            sc.ring.reset();
+            ring_unavailable_ = true;
+        }
+        std::call_once(pool_once_, [this] { pool_reader_.reset(new ThreadPoolReader(fd_, io_threads_)); });
+#endif
+        pool_reader_->read_batch(reqs);
+    }
+
+    uint64_t node_sector(uint32_t id) const
+    {
+        if (header_.nodes_per_sector)
+            return 1 + id / header_.nodes_per_sector;
+        return 1 + (uint64_t)id * header_.sectors_per_node;
+    }
+
+    uint64_t node_offset_in_sector(uint32_t id) const
+    {
+        if (header_.nodes_per_sector)
+            return (id % header_.nodes_per_sector) * header_.max_node_len;
+        return 0;
+    }
+
+    float dist(const float *a, const float *b) const { return fstdistfunc_(a, b, dist_func_param_); }
+
+    // 贪心搜索，返回访问过的所有节点（带距离）
+    void greedy_search(const float *base, const float *q, size_t L, const std::vector<std::vector<uint32_t>> &graph,
+                       std::vector<std::mutex> &locks, std::vector<std::pair<float, uint32_t>> &visited_out)
+    {
+        std::vector<std::pair<float, uint32_t>> retset;
+        std::vector<bool> expanded;
+        std::unordered_set<uint32_t> visited;
+        visited_out.clear();
+
+        retset.emplace_back(dist(q, base + medoid_ * dim_), medoid_);
+        expanded.push_back(false);
+        visited.insert(medoid_);
+
+        std::vector<uint32_t> nbrs;
+        while (true)
+        {
+            size_t best = retset.size();
+            for (size_t i = 0; i < retset.size(); ++i)
+                if (!expanded[i])
+                {
+                    best = i;
+                    break;
+                }
+            if (best == retset.size())
+                break;
+            expanded[best] = true;
+            uint32_t cur = retset[best].second;
+            visited_out.push_back(retset[best]);
+            {
+                std::unique_lock<std::mutex> lock(locks[cur]);
+                nbrs = graph[cur];
+            }
+            for (uint32_t nb : nbrs)
+            {
+                if (!visited.insert(nb).second)
+                    continue;
+                float d = dist(q, base + (size_t)nb * dim_);
+                if (retset.size() >= L && d >= retset.back().first)
+                    continue;
+                auto pos = std::upper_bound(retset.begin(), retset.end(), std::make_pair(d, nb));
+                size_t idx = pos - retset.begin();
+                retset.insert(pos, std::make_pair(d, nb));
+                expanded.insert(expanded.begin() + idx, false);
+                if (retset.size() > L)
+                {
+                    retset.pop_back();
+                    expanded.pop_back();
+                }
+            }
+        }
+    }
+
+    // RobustPrune：按距离从近到远选邻居，若已选邻居 p* 满足 alpha * d(p*, p') <= d(p, p') 则剔除 p'
+    void robust_prune(const float *base, uint32_t p, std::vector<std::pair<float, uint32_t>> &cands, float alpha,
+                      std::vector<uint32_t> &out)
+    {
+        std::sort(cands.begin(), cands.end());
+        cands.erase(std::unique(cands.begin(), cands.end(),
+                                [](const std::pair<float, uint32_t> &a, const std::pair<float, uint32_t> &b) { return a.second == b.second; }),
+                    cands.end());
+        out.clear();
+        std::vector<bool> pruned(cands.size(), false);
+        for (size_t i = 0; i < cands.size() && out.size() < R_; ++i)
+        {
+            if (pruned[i] || cands[i].second == p)
+                continue;
+            uint32_t star = cands[i].second;
+            out.push_back(star);
+            for (size_t j = i + 1; j < cands.size(); ++j)
+            {
+                if (pruned[j])
+                    continue;
+                float d = dist(base + (size_t)star * dim_, base + (size_t)cands[j].second * dim_);
+                if (alpha * d <= cands[j].first)
+                    pruned[j] = true;
+            }
+        }
+    }
+
+    void build_vamana(const float *base, std::vector<std::vector<uint32_t>> &graph, size_t L, float alpha)
+    {
+        // medoid：离质心最近的点
+        std::vector<float> centroid(dim_, 0);
+        for (size_t i = 0; i < n_; ++i)
+            for (size_t d = 0; d < dim_; ++d)
+                centroid[d] += base[i * dim_ + d] / n_;
+        float best = std::numeric_limits<float>::max();
+        for (size_t i = 0; i < n_; ++i)
+        {
+            float d = 0;
+            for (size_t j = 0; j < dim_; ++j)
+                d += (base[i * dim_ + j] - centroid[j]) * (base[i * dim_ + j] - centroid[j]);
+            if (d < best)
+            {
+                best = d;
+                medoid_ = (uint32_t)i;
+            }
+        }
+
+        // 随机初始化为 R 出度的图
+        std::mt19937 rng(42);
+        std::uniform_int_distribution<uint32_t> uni(0, (uint32_t)n_ - 1);
+        for (size_t i = 0; i < n_; ++i)
+        {
+            size_t deg = std::min(R_, n_ - 1);
+            while (graph[i].size() < deg)
+            {
+                uint32_t j = uni(rng);
+                if (j != i && std::find(graph[i].begin(), graph[i].end(), j) == graph[i].end())
+                    graph[i].push_back(j);
+            }
+        }
+
+        std::vector<uint32_t> order(n_);
+        for (size_t i = 0; i < n_; ++i)
+            order[i] = (uint32_t)i;
+        std::shuffle(order.begin(), order.end(), rng);
+
+        std::vector<std::mutex> locks(n_);
+        for (float a : {1.0f, alpha})
+        {
+#pragma omp parallel for schedule(dynamic, 64)
+            for (long oi = 0; oi < (long)n_; ++oi)
+            {
+                uint32_t p = order[oi];
+                const float *xp = base + (size_t)p * dim_;
+                std::vector<std::pair<float, uint32_t>> cands;
+                greedy_search(base, xp, L, graph, locks, cands);
+                {
+                    std::unique_lock<std::mutex> lock(locks[p]);
+                    for (uint32_t nb : graph[p])
+                        cands.emplace_back(dist(xp, base + (size_t)nb * dim_), nb);
+                }
+                std::vector<uint32_t> pruned;
+                robust_prune(base, p, cands, a, pruned);
+                {
+                    std::unique_lock<std::mutex> lock(locks[p]);
+                    graph[p] = pruned;
+                }
+
+                // 反向边，超过 R 时对邻居重新剪枝
+                for (uint32_t nb : pruned)
+                {
+                    std::unique_lock<std::mutex> lock(locks[nb]);
+                    auto &nl = graph[nb];
+                    if (std::find(nl.begin(), nl.end(), p) != nl.end())
+                        continue;
+                    if (nl.size() < R_)
+                    {
+                        nl.push_back(p);
+                        continue;
+                    }
+                    const float *xn = base + (size_t)nb * dim_;
+                    std::vector<std::pair<float, uint32_t>> nc;
+                    for (uint32_t x : nl)
+                        nc.emplace_back(dist(xn, base + (size_t)x * dim_), x);
+                    nc.emplace_back(dist(xn, xp), p);
+                    std::vector<uint32_t> out;
+                    robust_prune(base, nb, nc, a, out);
+                    nl = out;
+                }
+            }
+        }
+    }
+
+    void write_disk(const float *base, const std::vector<std::vector<uint32_t>> &graph, const std::string &path)
+    {
+        memset(&header_, 0, sizeof(header_));
+        header_.magic = DISK_INDEX_MAGIC;
+        header_.n = n_;
+        header_.dim = dim_;
+        header_.R = R_;
+        header_.medoid = medoid_;
+        header_.max_node_len = dim_ * sizeof(float) + sizeof(uint32_t) + R_ * sizeof(uint32_t);
+        if (header_.max_node_len <= DISK_SECTOR_LEN)
+        {
+            header_.nodes_per_sector = DISK_SECTOR_LEN / header_.max_node_len;
+            header_.sectors_per_node = 1;
+        }
+        else
+        {
+            header_.nodes_per_sector = 0;
+            header_.sectors_per_node = (header_.max_node_len + DISK_SECTOR_LEN - 1) / DISK_SECTOR_LEN;
+        }
+
+        std::ofstream out(path, std::ios::binary);
+        if (!out)
+            throw std::runtime_error("disk index: cannot create " + path);
+        std::vector<char> sector(DISK_SECTOR_LEN, 0);
+        memcpy(sector.data(), &header_, sizeof(header_));
+        out.write(sector.data(), DISK_SECTOR_LEN);
+
+        std::vector<char> rec(header_.max_node_len);
+        auto fill_record = [&](size_t i, char *dst) {
+            memset(dst, 0, header_.max_node_len);
+            memcpy(dst, base + i * dim_, dim_ * sizeof(float));
+            uint32_t cnt = (uint32_t)graph[i].size();
+            memcpy(dst + dim_ * sizeof(float), &cnt, sizeof(cnt));
+            memcpy(dst + dim_ * sizeof(float) + sizeof(cnt), graph[i].data(), cnt * sizeof(uint32_t));
+        };
+
+        if (header_.nodes_per_sector)
+        {
+            for (size_t i = 0; i < n_; i += header_.nodes_per_sector)
+            {
+                std::fill(sector.begin(), sector.end(), 0);
+                for (size_t j = 0; j < header_.nodes_per_sector && i + j < n_; ++j)
+                    fill_record(i + j, sector.data() + j * header_.max_node_len);
+                out.write(sector.data(), DISK_SECTOR_LEN);
+            }
+        }
+        else
+        {
+            std::vector<char> block(header_.sectors_per_node * DISK_SECTOR_LEN);
+            for (size_t i = 0; i < n_; ++i)
+            {
+                std::fill(block.begin(), block.end(), 0);
+                fill_record(i, block.data());
+                out.write(block.data(), block.size());
+            }
+        }
+        out.close();
+    }
+
+    void write_pq(const std::string &path) const
+    {
+        std::ofstream out(path, std::ios::binary);
+        uint64_t dim = pq_.dim, m = pq_.m;
+        out.write((char *)&dim, sizeof(dim));
+        out.write((char *)&m, sizeof(m));
+        out.write((char *)pq_.centroids.data(), pq_.centroids.size() * sizeof(float));
+        out.write((char *)pq_codes_.data(), pq_codes_.size());
+    }
+
+    void read_pq(const std::string &path)
+    {
+        std::ifstream in(path, std::ios::binary);
+        if (!in)
+            throw std::runtime_error("disk index: cannot open " + path);
+        uint64_t dim, m;
+        in.read((char *)&dim, sizeof(dim));
+        in.read((char *)&m, sizeof(m));
+        if (!in)
+            throw std::runtime_error("disk index: cannot read PQ header from " + path);
+        if (m == 0 || dim != header_.dim || dim % m != 0)
+            throw std::runtime_error("disk index: PQ file " + path + " does not match the index");
+        pq_.dim = dim;
+        pq_.m = m;
+        pq_.dsub = dim / m;
+        pq_.centroids.resize(m * ProductQuantizer::KSUB * pq_.dsub);
+        in.read((char *)pq_.centroids.data(), pq_.centroids.size() * sizeof(float));
+        pq_codes_.resize(n_ * m);
+        in.read((char *)pq_codes_.data(), pq_codes_.size());
+        if (!in)
+            throw std::runtime_error("disk index: PQ file " + path + " is truncated");
+    }
+
+    bool ip_;
+    hnswlib::DISTFUNC<float> fstdistfunc_;
+    void *dist_func_param_;
+
+    size_t n_ = 0, dim_ = 0, R_ = 0;
+    uint32_t medoid_ = 0;
+    DiskIndexHeader header_;
+
+    ProductQuantizer pq_;
+    std::vector<uint8_t> pq_codes_;
+
+    int fd_ = -1;
+    size_t io_threads_ = 8;
+    std::unique_ptr<ThreadPoolReader> pool_reader_;
+    std::once_flag pool_once_;
+    std::atomic<bool> ring_unavailable_{false};
+
+    std::mutex scratch_mu_;
+    std::vector<std::unique_ptr<Scratch>> scratch_pool_;
+};
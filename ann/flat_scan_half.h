@@ -0,0 +1,25 @@
+#pragma once
+// fp16 / bf16 存储的暴力搜索，与 flat_scan.h 的 flat_search 返回同样的结果
+// base 和 query 都需要先用 hnswlib::fp32_to_fp16_array / fp32_to_bf16_array 转换
+#include <queue>
+#include "hnswlib/hnswlib/hnswlib.h"
+
+inline std::priority_queue<std::pair<float, uint32_t> > flat_search_half(const uint16_t* base, const uint16_t* query, size_t base_number, size_t vecdim, size_t k, bool bf16 = false) {
+    static bool kernels_selected = (hnswlib::select_half_kernels(), true);
+    (void)kernels_selected;
+    hnswlib::DISTFUNC<float> dist_func = bf16 ? hnswlib::InnerProductDistanceBF16 : hnswlib::InnerProductDistanceFP16;
+
+    std::priority_queue<std::pair<float, uint32_t> > q;
+    for (size_t i = 0; i < base_number; ++i) {
+        // DEEP100K数据集使用ip距离
+        float dis = dist_func(base + i * vecdim, query, &vecdim);
+
+        if (q.size() < k) {
+            q.push({dis, i});
+        } else if (dis < q.top().first) {
+            q.push({dis, i});
+            q.pop();
+        }
+    }
+    return q;
+}
@@ -0,0 +1,28 @@
+#pragma once
+// PCA 旋转 + 提前终止的暴力搜索，与 flat_scan.h 的 flat_search 返回同样的结果
+// base 和 query 都需要先经过 space.transform() 转成旋转后的存储格式
+#include <queue>
+#include "hnswlib/hnswlib/hnswlib.h"
+
+inline std::priority_queue<std::pair<float, uint32_t> > flat_search_pca(const float* base, const float* query, size_t base_number, hnswlib::PcaRotatedSpace& space, size_t k) {
+    hnswlib::DISTFUNC<float> dist_func = space.get_dist_func();
+    hnswlib::BOUNDEDDISTFUNC<float> bounded_dist_func = space.get_bounded_dist_func();
+    void* param = space.get_dist_func_param();
+    size_t stride = space.get_data_size() / sizeof(float);
+
+    std::priority_queue<std::pair<float, uint32_t> > q;
+    for (size_t i = 0; i < base_number; ++i) {
+        const float* x = base + i * stride;
+        if (q.size() < k) {
+            q.push({dist_func(query, x, param), i});
+            continue;
+        }
+        // 堆满后只关心能否进入 top-k，按方差顺序累加，确定不可能时提前放弃
+        float dis = bounded_dist_func(query, x, param, q.top().first);
+        if (dis < q.top().first) {
+            q.push({dis, i});
+            q.pop();
+        }
+    }
+    return q;
+}
@@ -0,0 +1,272 @@
+// 精确 kNN ground truth 生成工具，用于给新数据集生成和 DEEP100K.gt.query.100k.top100.bin 同格式的文件
+// 编译: g++ -O3 -fopenmp -march=native groundtruth.cc -o groundtruth
+// 用法: ./groundtruth <base.fbin> <query.fbin> <out.bin> [k=100] [ip|l2|cos] [chunk_mb=1024]
+// 输出: int32 查询数, int32 k, 然后每条查询 k 个 int32 id（按距离升序），即 main.cc 中 LoadData<int> 读取的格式
+//
+// base 按 chunk 流式读取，内存占用约为 2 * chunk_mb，可以处理比内存大的 base；
+// 读下一个 chunk 和计算当前 chunk 重叠进行。每个 chunk 先打包成按维度主序的 tile，
+// 再按 query 块做分块矩阵乘（query 块 x tile），tile 常驻 L2 被块内所有 query 复用
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <queue>
+#include <string>
+#include <sys/time.h>
+#include <thread>
+#include <vector>
+#include <omp.h>
+
+enum class Metric { IP, L2, COS };
+
+// base tile 宽度：打包后 vecdim * TILE_B 个 float，DEEP 的 96 维约 96KB，可以放进 L2
+static const size_t TILE_B = 256;
+// 微内核一次计算的 query 数，4 x TILE_B 个累加器放在 L1
+static const size_t TILE_Q = 4;
+// 每个线程一次处理的最大 query 块
+static const size_t BLOCK_Q = 64;
+
+typedef std::priority_queue<std::pair<float, int> > TopK;
+
+struct FbinReader
+{
+    std::ifstream fin;
+    size_t n = 0, d = 0;
+
+    bool open(const std::string& path)
+    {
+        fin.open(path, std::ios::in | std::ios::binary);
+        if (!fin) {
+            return false;
+        }
+        int header[2];
+        fin.read((char*)header, sizeof(header));
+        n = header[0];
+        d = header[1];
+        return (bool)fin;
+    }
+
+    size_t read(float* buf, size_t rows)
+    {
+        fin.read((char*)buf, rows * d * sizeof(float));
+        return fin.gcount() / (d * sizeof(float));
+    }
+};
+
+static double now_seconds()
+{
+    struct timeval val;
+    gettimeofday(&val, NULL);
+    return val.tv_sec + val.tv_usec * 1e-6;
+}
+
+static float l2_norm(const float* x, size_t d)
+{
+    float s = 0;
+    for (size_t j = 0; j < d; ++j) {
+        s += x[j] * x[j];
+    }
+    return std::sqrt(s);
+}
+
+// 把 rows 行 base 打包成按维度主序的 tile：packed[t][j][r] = raw[t*TILE_B + r][j]，最后一个 tile 补 0
+// L2 同时计算每行的平方范数，cos 把每行归一化
+static void pack_chunk(const float* raw, size_t rows, size_t d, Metric metric, float* packed, float* sqnorm)
+{
+    size_t tiles = (rows + TILE_B - 1) / TILE_B;
+    #pragma omp parallel for schedule(static)
+    for (long long t = 0; t < (long long)tiles; ++t) {
+        float* dst = packed + t * d * TILE_B;
+        for (size_t r = 0; r < TILE_B; ++r) {
+            size_t row = t * TILE_B + r;
+            if (row >= rows) {
+                for (size_t j = 0; j < d; ++j) {
+                    dst[j * TILE_B + r] = 0;
+                }
+                sqnorm[row] = 0;
+                continue;
+            }
+            const float* src = raw + row * d;
+            float norm = l2_norm(src, d);
+            float scale = (metric == Metric::COS && norm > 0) ? 1.0f / norm : 1.0f;
+            for (size_t j = 0; j < d; ++j) {
+                dst[j * TILE_B + r] = src[j] * scale;
+            }
+            sqnorm[row] = norm * norm;
+        }
+    }
+}
+
+// c[TILE_Q][TILE_B] = q[TILE_Q][d] * tile，tile 已按维度主序打包，内层循环沿 base 行连续可以向量化
+static void micro_kernel(const float* q, size_t d, const float* tile, float* c)
+{
+    memset(c, 0, TILE_Q * TILE_B * sizeof(float));
+    float* c0 = c;
+    float* c1 = c + TILE_B;
+    float* c2 = c + 2 * TILE_B;
+    float* c3 = c + 3 * TILE_B;
+    for (size_t j = 0; j < d; ++j) {
+        const float* b = tile + j * TILE_B;
+        float q0 = q[j], q1 = q[d + j], q2 = q[2 * d + j], q3 = q[3 * d + j];
+        for (size_t r = 0; r < TILE_B; ++r) {
+            c0[r] += q0 * b[r];
+            c1[r] += q1 * b[r];
+            c2[r] += q2 * b[r];
+            c3[r] += q3 * b[r];
+        }
+    }
+}
+
+// 距离定义和 flat_scan.h 一致：ip/cos 为 1 - 内积，l2 为平方距离
+static void search_chunk(const float* query, const float* qsqnorm, size_t query_number, size_t padded_query_number,
+                         const float* packed, const float* sqnorm, size_t rows, size_t base_offset,
+                         size_t d, size_t k, Metric metric, std::vector<TopK>& topk)
+{
+    size_t tiles = (rows + TILE_B - 1) / TILE_B;
+    size_t threads = omp_get_max_threads();
+    // query 少时缩小块，保证每个线程都有活干
+    size_t block = (padded_query_number / threads + TILE_Q - 1) / TILE_Q * TILE_Q;
+    block = std::max(TILE_Q, std::min(BLOCK_Q, block));
+    size_t blocks = (padded_query_number + block - 1) / block;
+
+    #pragma omp parallel
+    {
+        std::vector<float> c(TILE_Q * TILE_B);
+        #pragma omp for schedule(dynamic)
+        for (long long b = 0; b < (long long)blocks; ++b) {
+            size_t q_begin = b * block;
+            size_t q_end = std::min(padded_query_number, q_begin + block);
+            for (size_t t = 0; t < tiles; ++t) {
+                const float* tile = packed + t * d * TILE_B;
+                size_t valid = std::min(TILE_B, rows - t * TILE_B);
+                for (size_t qi = q_begin; qi < q_end; qi += TILE_Q) {
+                    micro_kernel(query + qi * d, d, tile, c.data());
+                    for (size_t s = 0; s < TILE_Q && qi + s < query_number; ++s) {
+                        TopK& heap = topk[qi + s];
+                        const float* dot = c.data() + s * TILE_B;
+                        for (size_t r = 0; r < valid; ++r) {
+                            float dis;
+                            if (metric == Metric::L2) {
+                                dis = qsqnorm[qi + s] + sqnorm[t * TILE_B + r] - 2 * dot[r];
+                            } else {
+                                dis = 1 - dot[r];
+                            }
+                            if (heap.size() < k) {
+                                heap.push({dis, (int)(base_offset + t * TILE_B + r)});
+                            } else if (dis < heap.top().first) {
+                                heap.push({dis, (int)(base_offset + t * TILE_B + r)});
+                                heap.pop();
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 4) {
+        std::cerr << "usage: " << argv[0] << " <base.fbin> <query.fbin> <out.bin> [k=100] [ip|l2|cos] [chunk_mb=1024]\n";
+        return 1;
+    }
+    std::string base_path = argv[1], query_path = argv[2], out_path = argv[3];
+    size_t k = argc > 4 ? atoi(argv[4]) : 100;
+    std::string metric_name = argc > 5 ? argv[5] : "ip";
+    size_t chunk_mb = argc > 6 ? atoi(argv[6]) : 1024;
+
+    Metric metric;
+    if (metric_name == "ip") {
+        metric = Metric::IP;
+    } else if (metric_name == "l2") {
+        metric = Metric::L2;
+    } else if (metric_name == "cos") {
+        metric = Metric::COS;
+    } else {
+        std::cerr << "unknown metric " << metric_name << ", expected ip, l2 or cos\n";
+        return 1;
+    }
+
+    FbinReader base_reader, query_reader;
+    if (!base_reader.open(base_path) || !query_reader.open(query_path)) {
+        std::cerr << "cannot open " << base_path << " or " << query_path << "\n";
+        return 1;
+    }
+    size_t d = base_reader.d;
+    if (query_reader.d != d) {
+        std::cerr << "dimension mismatch: base " << d << ", query " << query_reader.d << "\n";
+        return 1;
+    }
+    size_t base_number = base_reader.n, query_number = query_reader.n;
+    k = std::min(k, base_number);
+    std::cerr << "base: " << base_number << " x " << d << "  query: " << query_number
+              << "  k: " << k << "  metric: " << metric_name << "  threads: " << omp_get_max_threads() << "\n";
+
+    // query 全部读入内存，补齐到 TILE_Q 的倍数
+    size_t padded_query_number = (query_number + TILE_Q - 1) / TILE_Q * TILE_Q;
+    std::vector<float> query(padded_query_number * d, 0);
+    std::vector<float> qsqnorm(padded_query_number, 0);
+    if (query_reader.read(query.data(), query_number) != query_number) {
+        std::cerr << "short read on " << query_path << "\n";
+        return 1;
+    }
+    for (size_t i = 0; i < query_number; ++i) {
+        float norm = l2_norm(query.data() + i * d, d);
+        qsqnorm[i] = norm * norm;
+        if (metric == Metric::COS && norm > 0) {
+            for (size_t j = 0; j < d; ++j) {
+                query[i * d + j] /= norm;
+            }
+        }
+    }
+
+    size_t chunk_rows = chunk_mb * (1 << 20) / (d * sizeof(float)) / TILE_B * TILE_B;
+    chunk_rows = std::max(TILE_B, std::min(chunk_rows, (base_number + TILE_B - 1) / TILE_B * TILE_B));
+    std::vector<float> raw(chunk_rows * d), packed(chunk_rows * d), sqnorm(chunk_rows);
+    std::vector<TopK> topk(query_number);
+
+    double start = now_seconds();
+    size_t rows = base_reader.read(raw.data(), std::min(chunk_rows, base_number));
+    size_t offset = 0;
+    while (rows > 0) {
+        pack_chunk(raw.data(), rows, d, metric, packed.data(), sqnorm.data());
+
+        // 打包完成后 raw 空闲，后台读取下一个 chunk，和当前 chunk 的计算重叠
+        size_t next_offset = offset + rows;
+        size_t next_rows = 0;
+        std::thread reader([&]() {
+            next_rows = base_reader.read(raw.data(), std::min(chunk_rows, base_number - next_offset));
+        });
+
+        search_chunk(query.data(), qsqnorm.data(), query_number, padded_query_number,
+                     packed.data(), sqnorm.data(), rows, offset, d, k, metric, topk);
+        reader.join();
+
+        offset = next_offset;
+        rows = next_rows;
+        std::cerr << "processed " << offset << " / " << base_number << "  elapsed (s): " << now_seconds() - start << "\n";
+    }
+    if (offset != base_number) {
+        std::cerr << "short read on " << base_path << ": " << offset << " of " << base_number << " rows\n";
+        return 1;
+    }
+
+    std::ofstream fout(out_path, std::ios::out | std::ios::binary);
+    int header[2] = {(int)query_number, (int)k};
+    fout.write((char*)header, sizeof(header));
+    std::vector<int> ids(k);
+    for (size_t i = 0; i < query_number; ++i) {
+        // 堆顶是最远的，倒序写出得到距离升序
+        for (size_t j = k; j-- > 0;) {
+            ids[j] = topk[i].top().second;
+            topk[i].pop();
+        }
+        fout.write((char*)ids.data(), k * sizeof(int));
+    }
+    fout.close();
+    std::cerr << "write ground truth " << out_path << "\n";
+    return 0;
+}
@@ -0,0 +1,43 @@
+#include "../../hnswlib/hnswlib.h"
+
+
+int main() {
+    int dim = 16;               // Dimension of the token vectors
+    int num_docs = 1000;        // Maximum number of documents
+    int max_tokens = 20000;     // Maximum number of token vectors over all documents
+    int M = 16;                 // Tightly connected with internal dimensionality of the data
+                                // strongly affects the memory consumption
+    int ef_construction = 200;  // Controls index search speed/build speed tradeoff
+
+    int query_tokens = 4;       // Number of vectors in a query
+    int k = 5;                  // Number of documents to return
+    int candidates = 16;        // Nearest token vectors looked up per query vector,
+                                // their documents are scored exactly
+
+    // Initing index
+    hnswlib::MultiVectorIndex index(dim, num_docs, max_tokens, M, ef_construction);
+
+    // Generate random documents of 5 to 20 vectors each and add them
+    std::mt19937 rng;
+    rng.seed(47);
+    std::uniform_real_distribution<> distrib_real;
+    std::uniform_int_distribution<int> distrib_tokens(5, 20);
+    for (int d = 0; d < num_docs; d++) {
+        int num_tokens = distrib_tokens(rng);
+        std::vector<float> doc(num_tokens * dim);
+        for (auto &v : doc) v = distrib_real(rng);
+        index.addDocument(doc.data(), num_tokens, d);
+    }
+
+    // Query with a random multi-vector query, scored by MaxSim:
+    // sum over query vectors of the best inner product within the document
+    std::vector<float> query(query_tokens * dim);
+    for (auto &v : query) v = distrib_real(rng);
+    std::priority_queue<std::pair<float, hnswlib::labeltype>> result =
+        index.searchKnn(query.data(), query_tokens, k, candidates);
+    while (!result.empty()) {
+        std::cout << "document " << result.top().second << ", MaxSim " << -result.top().first << "\n";
+        result.pop();
+    }
+    return 0;
+}
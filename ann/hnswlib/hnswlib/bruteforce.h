@@ -2,84 +2,203 @@
 #include <unordered_map>
 #include <fstream>
 #include <mutex>
+#include <atomic>
+#include <thread>
+#include <condition_variable>
+#include <functional>
+#include <exception>
+#include <memory>
+#include <queue>
+#include <vector>
 #include <algorithm>
 #include <assert.h>
+#include "huge_alloc.h"
 
 namespace hnswlib {
+// Persistent worker threads for split scans. run(n, f) calls f(0) on the
+// calling thread and f(1) .. f(n - 1) on the workers, and returns when all
+// of them have finished; the first exception thrown by any part is rethrown
+// to the caller. Several threads may call run concurrently, their parts
+// share one queue.
+class ScanThreadPool {
+ public:
+    explicit ScanThreadPool(size_t num_workers) {
+        for (size_t i = 0; i < num_workers; i++)
+            workers_.emplace_back([this]() { worker(); });
+    }
+
+    ~ScanThreadPool() {
+        {
+            std::unique_lock<std::mutex> lock(mu_);
+            stop_ = true;
+        }
+        cv_task_.notify_all();
+        for (auto &t : workers_)
+            t.join();
+    }
+
+    size_t numWorkers() const {
+        return workers_.size();
+    }
+
+    void run(size_t n, const std::function<void(size_t)> &f) {
+        size_t remaining = n - 1;
+        std::exception_ptr error;
+        std::mutex done_mu;
+        std::condition_variable done_cv;
+        auto finish = [&](std::exception_ptr e) {
+            std::unique_lock<std::mutex> l(done_mu);
+            if (e && !error)
+                error = e;
+            if (--remaining == 0)
+                done_cv.notify_one();
+        };
+        {
+            std::unique_lock<std::mutex> lock(mu_);
+            for (size_t i = 1; i < n; i++)
+                tasks_.push([&f, &finish, i]() {
+                    std::exception_ptr e;
+                    try {
+                        f(i);
+                    } catch (...) {
+                        e = std::current_exception();
+                    }
+                    finish(e);
+                });
+        }
+        cv_task_.notify_all();
+
+        std::exception_ptr own;
+        try {
+            f(0);
+        } catch (...) {
+            own = std::current_exception();
+        }
+        std::unique_lock<std::mutex> l(done_mu);
+        done_cv.wait(l, [&]() { return remaining == 0; });
+        if (own)
+            std::rethrow_exception(own);
+        if (error)
+            std::rethrow_exception(error);
+    }
+
+ private:
+    void worker() {
+        while (true) {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(mu_);
+                cv_task_.wait(lock, [this]() { return stop_ || !tasks_.empty(); });
+                if (stop_ && tasks_.empty())
+                    return;
+                task = std::move(tasks_.front());
+                tasks_.pop();
+            }
+            task();
+        }
+    }
+
+    bool stop_{false};
+    std::mutex mu_;
+    std::condition_variable cv_task_;
+    std::queue<std::function<void()>> tasks_;
+    std::vector<std::thread> workers_;
+};
+
+// Exact index. Vectors are stored back to back in one cache-line aligned
+// array and labels in a parallel array, so a scan streams only vector bytes
+// and hands whole tiles to the space's batched kernel when it provides one.
+// Scans of large indexes are split across num_threads_ threads (the caller
+// plus the persistent workers of a ScanThreadPool), each keeping its own
+// top-k; the partial results are merged at the end.
+//
+// Writers (addPoint, removePoint, loadIndex) serialize on index_lock, while
+// searchKnn takes no lock. A new point is fully written before
+// cur_element_count is published, so adding points during a search is safe.
+// A search that overlaps the update or removal of a point may still see the
+// old copy, and may see the element that removePoint moves twice.
+// loadIndex and setNumThreads replace the storage and the worker pool, so
+// they must not run while any search is in progress.
 template<typename dist_t>
 class BruteforceSearch : public AlgorithmInterface<dist_t> {
  public:
-    char *data_;
-    size_t maxelements_;
-    size_t cur_element_count;
-    size_t size_per_element_;
-
-    size_t data_size_;
-    DISTFUNC <dist_t> fstdistfunc_;
-    void *dist_func_param_;
-    std::mutex index_lock;
+    static const size_t TILE_SIZE = 256;               // vectors per batched distance call
+    static const size_t MIN_ELEMENTS_PER_THREAD = 16384;
+
+    char *vectors_{nullptr};
+    labeltype *labels_{nullptr};
+    size_t maxelements_{0};
+    std::atomic<size_t> cur_element_count{0};
+    size_t size_per_element_{0};  // vector + label, the record size of the index file
+
+    size_t data_size_{0};
+    DISTFUNC <dist_t> fstdistfunc_{nullptr};
+    BATCHDISTFUNC<dist_t> fstdistfunc_batch_{nullptr};
+    void *dist_func_param_{nullptr};
+    size_t num_threads_{1};
+    HugePageMode huge_pages_{HUGEPAGE_OFF};
+    mutable std::mutex index_lock;
 
     std::unordered_map<labeltype, size_t > dict_external_to_internal;
+    std::unique_ptr<ScanThreadPool> pool_;
 
 
-    BruteforceSearch(SpaceInterface <dist_t> *s)
-        : data_(nullptr),
-            maxelements_(0),
-            cur_element_count(0),
-            size_per_element_(0),
-            data_size_(0),
-            dist_func_param_(nullptr) {
+    BruteforceSearch(SpaceInterface <dist_t> *s) {
     }
 
 
-    BruteforceSearch(SpaceInterface<dist_t> *s, const std::string &location)
-        : data_(nullptr),
-            maxelements_(0),
-            cur_element_count(0),
-            size_per_element_(0),
-            data_size_(0),
-            dist_func_param_(nullptr) {
+    BruteforceSearch(SpaceInterface<dist_t> *s, const std::string &location,
+                     HugePageMode huge_pages = HUGEPAGE_OFF)
+        : huge_pages_(huge_pages) {
         loadIndex(location, s);
     }
 
 
-    BruteforceSearch(SpaceInterface <dist_t> *s, size_t maxElements) {
-        maxelements_ = maxElements;
-        data_size_ = s->get_data_size();
-        fstdistfunc_ = s->get_dist_func();
-        dist_func_param_ = s->get_dist_func_param();
-        size_per_element_ = data_size_ + sizeof(labeltype);
-        data_ = (char *) malloc(maxElements * size_per_element_);
-        if (data_ == nullptr)
-            throw std::runtime_error("Not enough memory: BruteforceSearch failed to allocate data");
-        cur_element_count = 0;
+    BruteforceSearch(SpaceInterface <dist_t> *s, size_t maxElements,
+                     HugePageMode huge_pages = HUGEPAGE_OFF)
+        : huge_pages_(huge_pages) {
+        setSpace(s);
+        allocate(maxElements);
     }
 
 
     ~BruteforceSearch() {
-        free(data_);
+        huge_free(vectors_);
+        free(labels_);
+    }
+
+
+    // 0 uses every hardware thread. Only scans with at least
+    // MIN_ELEMENTS_PER_THREAD elements per thread are split. Starts
+    // num_threads - 1 worker threads that live as long as the index; must not
+    // be called while a search is in progress.
+    void setNumThreads(size_t num_threads) {
+        if (num_threads == 0)
+            num_threads = std::max(1u, std::thread::hardware_concurrency());
+        num_threads_ = num_threads;
+        if (num_threads_ > 1 && (!pool_ || pool_->numWorkers() != num_threads_ - 1))
+            pool_.reset(new ScanThreadPool(num_threads_ - 1));
+        else if (num_threads_ <= 1)
+            pool_.reset();
     }
 
 
     void addPoint(const void *datapoint, labeltype label, bool replace_deleted = false) {
-        int idx;
-        {
-            std::unique_lock<std::mutex> lock(index_lock);
+        std::unique_lock<std::mutex> lock(index_lock);
 
-            auto search = dict_external_to_internal.find(label);
-            if (search != dict_external_to_internal.end()) {
-                idx = search->second;
-            } else {
-                if (cur_element_count >= maxelements_) {
-                    throw std::runtime_error("The number of elements exceeds the specified limit\n");
-                }
-                idx = cur_element_count;
-                dict_external_to_internal[label] = idx;
-                cur_element_count++;
-            }
+        auto search = dict_external_to_internal.find(label);
+        if (search != dict_external_to_internal.end()) {
+            memcpy(vectors_ + data_size_ * search->second, datapoint, data_size_);
+            return;
         }
-        memcpy(data_ + size_per_element_ * idx + data_size_, &label, sizeof(labeltype));
-        memcpy(data_ + size_per_element_ * idx, datapoint, data_size_);
+        size_t idx = cur_element_count.load(std::memory_order_relaxed);
+        if (idx >= maxelements_) {
+            throw std::runtime_error("The number of elements exceeds the specified limit\n");
+        }
+        memcpy(vectors_ + data_size_ * idx, datapoint, data_size_);
+        labels_[idx] = label;
+        dict_external_to_internal[label] = idx;
+        cur_element_count.store(idx + 1, std::memory_order_release);
     }
 
 
@@ -91,44 +210,108 @@ class BruteforceSearch : public AlgorithmInterface<dist_t> {
             return;
         }
 
-        dict_external_to_internal.erase(found);
-
         size_t cur_c = found->second;
-        labeltype label = *((labeltype*)(data_ + size_per_element_ * (cur_element_count-1) + data_size_));
-        dict_external_to_internal[label] = cur_c;
-        memcpy(data_ + size_per_element_ * cur_c,
-                data_ + size_per_element_ * (cur_element_count-1),
-                data_size_+sizeof(labeltype));
-        cur_element_count--;
+        size_t last = cur_element_count.load(std::memory_order_relaxed) - 1;
+        dict_external_to_internal.erase(found);
+        if (cur_c != last) {
+            memcpy(vectors_ + data_size_ * cur_c, vectors_ + data_size_ * last, data_size_);
+            labels_[cur_c] = labels_[last];
+            dict_external_to_internal[labels_[cur_c]] = cur_c;
+        }
+        cur_element_count.store(last, std::memory_order_release);
     }
 
 
     std::priority_queue<std::pair<dist_t, labeltype >>
     searchKnn(const void *query_data, size_t k, BaseFilterFunctor* isIdAllowed = nullptr) const {
-        assert(k <= cur_element_count);
         std::priority_queue<std::pair<dist_t, labeltype >> topResults;
-        if (cur_element_count == 0) return topResults;
-        for (int i = 0; i < k; i++) {
-            dist_t dist = fstdistfunc_(query_data, data_ + size_per_element_ * i, dist_func_param_);
-            labeltype label = *((labeltype*) (data_ + size_per_element_ * i + data_size_));
-            if ((!isIdAllowed) || (*isIdAllowed)(label)) {
-                topResults.emplace(dist, label);
-            }
+        size_t count = cur_element_count.load(std::memory_order_acquire);
+        if (count == 0 || k == 0) return topResults;
+
+        size_t threads = std::min(num_threads_, count / MIN_ELEMENTS_PER_THREAD);
+        if (threads <= 1) {
+            scanTopK(query_data, 0, count, k, isIdAllowed, topResults);
+            return topResults;
         }
-        dist_t lastdist = topResults.empty() ? std::numeric_limits<dist_t>::max() : topResults.top().first;
-        for (int i = k; i < cur_element_count; i++) {
-            dist_t dist = fstdistfunc_(query_data, data_ + size_per_element_ * i, dist_func_param_);
-            if (dist <= lastdist) {
-                labeltype label = *((labeltype *) (data_ + size_per_element_ * i + data_size_));
-                if ((!isIdAllowed) || (*isIdAllowed)(label)) {
-                    topResults.emplace(dist, label);
+
+        std::vector<std::priority_queue<std::pair<dist_t, labeltype >>> partial(threads);
+        pool_->run(threads, [&](size_t t) {
+            scanTopK(query_data, count * t / threads, count * (t + 1) / threads, k, isIdAllowed, partial[t]);
+        });
+
+        topResults.swap(partial[0]);
+        for (size_t t = 1; t < threads; t++) {
+            while (!partial[t].empty()) {
+                const std::pair<dist_t, labeltype> &cand = partial[t].top();
+                if (topResults.size() < k || cand.first < topResults.top().first) {
+                    topResults.push(cand);
+                    if (topResults.size() > k)
+                        topResults.pop();
                 }
+                partial[t].pop();
+            }
+        }
+        return topResults;
+    }
+
+
+    // Streams every element within `radius` of the query to `callback`, in
+    // storage order; returns the number of matches delivered
+    size_t searchRange(const void *query_data, dist_t radius, BaseRangeCallback<dist_t> &callback,
+                       BaseFilterFunctor* isIdAllowed = nullptr) const {
+        size_t count = cur_element_count.load(std::memory_order_acquire);
+        size_t found = 0;
+        dist_t dists[TILE_SIZE];
+        for (size_t tile = 0; tile < count; tile += TILE_SIZE) {
+            size_t n = count - tile < TILE_SIZE ? count - tile : TILE_SIZE;
+            const char *base = vectors_ + data_size_ * tile;
+            if (fstdistfunc_batch_) {
+                fstdistfunc_batch_(query_data, base, n, dist_func_param_, dists);
+            } else {
+                for (size_t i = 0; i < n; i++)
+                    dists[i] = fstdistfunc_(query_data, base + data_size_ * i, dist_func_param_);
+            }
+            for (size_t i = 0; i < n; i++) {
+                if (dists[i] > radius)
+                    continue;
+                labeltype label = labels_[tile + i];
+                if (isIdAllowed && !(*isIdAllowed)(label))
+                    continue;
+                found++;
+                if (!callback(label, dists[i]))
+                    return found;
+            }
+        }
+        return found;
+    }
+
+
+    // Exact distances to a candidate set, e.g. the ef results of an
+    // approximate index; returns the k closest. Labels not in the index are
+    // skipped. Only the label lookup holds index_lock.
+    std::priority_queue<std::pair<dist_t, labeltype >>
+    rerank(const void *query_data, const std::vector<labeltype> &candidates, size_t k) const {
+        std::vector<std::pair<size_t, labeltype>> internal;
+        internal.reserve(candidates.size());
+        {
+            std::unique_lock<std::mutex> lock(index_lock);
+            for (labeltype label : candidates) {
+                auto found = dict_external_to_internal.find(label);
+                if (found != dict_external_to_internal.end())
+                    internal.emplace_back(found->second, label);
+            }
+        }
+        // Visit the rows in storage order so the hardware prefetcher can help
+        std::sort(internal.begin(), internal.end());
+
+        std::priority_queue<std::pair<dist_t, labeltype >> topResults;
+        if (k == 0) return topResults;
+        for (auto &c : internal) {
+            dist_t dist = fstdistfunc_(query_data, vectors_ + data_size_ * c.first, dist_func_param_);
+            if (topResults.size() < k || dist < topResults.top().first) {
+                topResults.emplace(dist, c.second);
                 if (topResults.size() > k)
                     topResults.pop();
-
-                if (!topResults.empty()) {
-                    lastdist = topResults.top().first;
-                }
             }
         }
         return topResults;
@@ -139,35 +322,107 @@ class BruteforceSearch : public AlgorithmInterface<dist_t> {
         std::ofstream output(location, std::ios::binary);
         std::streampos position;
 
+        size_t count = cur_element_count;
         writeBinaryPOD(output, maxelements_);
         writeBinaryPOD(output, size_per_element_);
-        writeBinaryPOD(output, cur_element_count);
-
-        output.write(data_, maxelements_ * size_per_element_);
+        writeBinaryPOD(output, count);
+
+        // Records keep the interleaved vector + label layout of the format
+        std::vector<char> record(size_per_element_, 0);
+        for (size_t i = 0; i < maxelements_; i++) {
+            if (i < count) {
+                memcpy(record.data(), vectors_ + data_size_ * i, data_size_);
+                memcpy(record.data() + data_size_, labels_ + i, sizeof(labeltype));
+            } else if (i == count) {
+                std::fill(record.begin(), record.end(), 0);
+            }
+            output.write(record.data(), size_per_element_);
+        }
 
         output.close();
     }
 
 
+    // Frees and reallocates the storage: no search may run concurrently
     void loadIndex(const std::string &location, SpaceInterface<dist_t> *s) {
         std::ifstream input(location, std::ios::binary);
-        std::streampos position;
+        if (!input.is_open())
+            throw std::runtime_error("Cannot open file");
+
+        std::unique_lock<std::mutex> lock(index_lock);
+        size_t max_elements, record_size, count;
+        readBinaryPOD(input, max_elements);
+        readBinaryPOD(input, record_size);
+        readBinaryPOD(input, count);
+
+        setSpace(s);
+        if (record_size != size_per_element_)
+            throw std::runtime_error("Index file does not match the space");
+        huge_free(vectors_);
+        free(labels_);
+        allocate(max_elements);
+
+        std::vector<char> record(size_per_element_);
+        dict_external_to_internal.clear();
+        for (size_t i = 0; i < count; i++) {
+            input.read(record.data(), size_per_element_);
+            memcpy(vectors_ + data_size_ * i, record.data(), data_size_);
+            memcpy(labels_ + i, record.data() + data_size_, sizeof(labeltype));
+            dict_external_to_internal[labels_[i]] = i;
+        }
+        cur_element_count.store(count, std::memory_order_release);
 
-        readBinaryPOD(input, maxelements_);
-        readBinaryPOD(input, size_per_element_);
-        readBinaryPOD(input, cur_element_count);
+        input.close();
+    }
 
+ private:
+    void setSpace(SpaceInterface<dist_t> *s) {
         data_size_ = s->get_data_size();
         fstdistfunc_ = s->get_dist_func();
+        fstdistfunc_batch_ = s->get_batch_dist_func();
         dist_func_param_ = s->get_dist_func_param();
         size_per_element_ = data_size_ + sizeof(labeltype);
-        data_ = (char *) malloc(maxelements_ * size_per_element_);
-        if (data_ == nullptr)
-            throw std::runtime_error("Not enough memory: loadIndex failed to allocate data");
+    }
 
-        input.read(data_, maxelements_ * size_per_element_);
 
-        input.close();
+    void allocate(size_t max_elements) {
+        maxelements_ = max_elements;
+        cur_element_count = 0;
+        vectors_ = (char *) huge_malloc(std::max<size_t>(max_elements * data_size_, 1), huge_pages_);
+        labels_ = (labeltype *) malloc(std::max<size_t>(max_elements * sizeof(labeltype), 1));
+        if (vectors_ == nullptr || labels_ == nullptr)
+            throw std::runtime_error("Not enough memory: BruteforceSearch failed to allocate data");
+    }
+
+
+    // Top-k over elements [begin, end), one tile of distances at a time
+    void scanTopK(const void *query_data, size_t begin, size_t end, size_t k,
+                     BaseFilterFunctor* isIdAllowed,
+                     std::priority_queue<std::pair<dist_t, labeltype >> &topResults) const {
+        dist_t dists[TILE_SIZE];
+        dist_t lastdist = std::numeric_limits<dist_t>::max();
+        for (size_t tile = begin; tile < end; tile += TILE_SIZE) {
+            size_t n = end - tile < TILE_SIZE ? end - tile : TILE_SIZE;
+            const char *base = vectors_ + data_size_ * tile;
+            if (fstdistfunc_batch_) {
+                fstdistfunc_batch_(query_data, base, n, dist_func_param_, dists);
+            } else {
+                for (size_t i = 0; i < n; i++)
+                    dists[i] = fstdistfunc_(query_data, base + data_size_ * i, dist_func_param_);
+            }
+            for (size_t i = 0; i < n; i++) {
+                if (dists[i] > lastdist)
+                    continue;
+                labeltype label = labels_[tile + i];
+                if (isIdAllowed && !(*isIdAllowed)(label))
+                    continue;
+                topResults.emplace(dists[i], label);
+                if (topResults.size() > k)
+                    topResults.pop();
+                if (topResults.size() == k)
+                    lastdist = topResults.top().first;
+            }
+        }
     }
 };
 }  // namespace hnswlib
@@ -0,0 +1,188 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <new>
+#include <vector>
+#include <stdexcept>
+#include "huge_alloc.h"
+
+namespace hnswlib {
+
+// Records of a fixed size stored in chunks of 2^shift records: record i is
+// slot (i & mask) of chunk (i >> shift). Growing appends chunks, existing
+// records never move, so there is no copy, no pause and no transient second
+// copy of the data, and readers may look records up while another thread
+// grows the buffer.
+//
+// The chunk pointers live in a table that is itself replaced when it fills
+// up; replaced tables are kept until clear() because a reader may still be
+// using one. reserve() calls must be serialized by the owner, lookups need
+// no locking.
+class ChunkedBuffer {
+ public:
+    ChunkedBuffer() {}
+    ChunkedBuffer(const ChunkedBuffer &) = delete;
+    ChunkedBuffer &operator=(const ChunkedBuffer &) = delete;
+
+    ~ChunkedBuffer() {
+        clear();
+    }
+
+
+    // Sets the layout of an empty buffer
+    void init(size_t record_size, size_t chunk_shift, HugePageMode huge_pages = HUGEPAGE_OFF) {
+        clear();
+        record_size_ = record_size;
+        shift_ = chunk_shift;
+        mask_ = ((size_t) 1 << chunk_shift) - 1;
+        huge_pages_ = huge_pages;
+    }
+
+
+    // Appends chunks until at least `capacity` records fit
+    void reserve(size_t capacity) {
+        size_t needed = (capacity + mask_) >> shift_;
+        size_t count = num_chunks_.load(std::memory_order_relaxed);
+        if (needed <= count)
+            return;
+        char **table = table_.load(std::memory_order_relaxed);
+        if (needed > table_size_) {
+            size_t size = std::max(needed, 2 * table_size_);
+            char **bigger = new char *[size]();
+            for (size_t c = 0; c < count; c++)
+                bigger[c] = table[c];
+            table_.store(bigger, std::memory_order_release);
+            if (table)
+                retired_tables_.push_back(table);
+            table = bigger;
+            table_size_ = size;
+        }
+        for (size_t c = count; c < needed; c++) {
+            char *chunk = (char *) huge_malloc(record_size_ << shift_, huge_pages_);
+            if (chunk == nullptr)
+                throw std::runtime_error("Not enough memory: failed to allocate a storage chunk");
+            table[c] = chunk;
+            num_chunks_.store(c + 1, std::memory_order_release);
+        }
+    }
+
+
+    size_t capacity() const {
+        return num_chunks_.load(std::memory_order_acquire) << shift_;
+    }
+
+
+    size_t chunkShift() const {
+        return shift_;
+    }
+
+
+    inline char *at(size_t i) const {
+        return table_.load(std::memory_order_acquire)[i >> shift_] + (i & mask_) * record_size_;
+    }
+
+
+    // Like at(), but nullptr for records beyond the allocated chunks. For
+    // prefetching ids that may have been read past the end of a link list.
+    inline const char *find(size_t i) const {
+        size_t c = i >> shift_;
+        if (c >= num_chunks_.load(std::memory_order_acquire))
+            return nullptr;
+        return table_.load(std::memory_order_acquire)[c] + (i & mask_) * record_size_;
+    }
+
+
+    // Calls f(records, n) over the records [0, count), one contiguous run per chunk
+    template<typename F>
+    void forEachRun(size_t count, F f) const {
+        for (size_t begin = 0; begin < count; begin += (size_t) 1 << shift_) {
+            size_t n = std::min(count - begin, (size_t) 1 << shift_);
+            f(at(begin), n);
+        }
+    }
+
+
+    void clear() {
+        char **table = table_.load(std::memory_order_relaxed);
+        size_t count = num_chunks_.load(std::memory_order_relaxed);
+        for (size_t c = 0; c < count; c++)
+            huge_free(table[c]);
+        delete[] table;
+        for (char **retired : retired_tables_)
+            delete[] retired;
+        retired_tables_.clear();
+        table_.store(nullptr, std::memory_order_relaxed);
+        table_size_ = 0;
+        num_chunks_.store(0, std::memory_order_relaxed);
+    }
+
+ private:
+    size_t record_size_{0};
+    size_t shift_{0};
+    size_t mask_{0};
+    HugePageMode huge_pages_{HUGEPAGE_OFF};
+
+    std::atomic<char **> table_{nullptr};
+    size_t table_size_{0};
+    std::atomic<size_t> num_chunks_{0};
+    std::vector<char **> retired_tables_;
+};
+
+
+// ChunkedBuffer of T, value-initialized when their chunk is added
+template<typename T>
+class ChunkedArray {
+ public:
+    ChunkedArray() {}
+
+    ~ChunkedArray() {
+        clear();
+    }
+
+
+    void init(size_t chunk_shift, HugePageMode huge_pages = HUGEPAGE_OFF) {
+        clear();
+        buffer_.init(sizeof(T), chunk_shift, huge_pages);
+    }
+
+
+    void reserve(size_t capacity) {
+        size_t old_capacity = buffer_.capacity();
+        try {
+            buffer_.reserve(capacity);
+        } catch (...) {
+            construct(old_capacity);
+            throw;
+        }
+        construct(old_capacity);
+    }
+
+
+    size_t capacity() const {
+        return buffer_.capacity();
+    }
+
+
+    inline T &operator[](size_t i) const {
+        return *(T *) buffer_.at(i);
+    }
+
+
+    void clear() {
+        size_t capacity = buffer_.capacity();
+        for (size_t i = 0; i < capacity; i++)
+            (*this)[i].~T();
+        buffer_.clear();
+    }
+
+ private:
+    void construct(size_t begin) {
+        for (size_t i = begin; i < buffer_.capacity(); i++)
+            new (buffer_.at(i)) T();
+    }
+
+    ChunkedBuffer buffer_;
+};
+
+}  // namespace hnswlib
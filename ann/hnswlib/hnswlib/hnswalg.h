@@ -1,6 +1,7 @@
 #pragma once
 
 #include "visited_list_pool.h"
+#include "chunked_storage.h"
 #include "hnswlib.h"
 #include <atomic>
 #include <random>
@@ -9,16 +10,67 @@
 #include <unordered_set>
 #include <list>
 #include <memory>
+#include <limits>
+#include <cmath>
+#include <functional>
 
 namespace hnswlib {
 typedef unsigned int tableint;
 typedef unsigned int linklistsizeint;
 
+// Per-level connectivity report produced by HierarchicalNSW::analyzeGraph()
+struct GraphLevelStats {
+    int level{0};
+    size_t nodes{0};          // elements present on this level, deleted ones included
+    size_t deleted{0};
+    size_t unreachable{0};    // live elements no path from the entry point reaches
+    size_t edges{0};
+    size_t zero_in_degree{0};
+    size_t max_in_degree{0};
+    std::vector<size_t> out_degree_hist;  // [d] = elements with d links
+    std::vector<size_t> in_degree_hist;   // [d] = elements with d in-links, the last bucket also counts larger degrees
+    // Hubness of the in-degree distribution: skewness well above 1, or a large
+    // share of in-links held by the top 1% of elements, means a few hubs
+    // attract most traversals
+    double in_degree_skewness{0};
+    double top1_in_share{0};
+
+    void report(std::ostream &out) const {
+        out << "level " << level << ": " << nodes << " nodes (" << deleted << " deleted), "
+            << unreachable << " unreachable, " << edges << " edges, avg out-degree "
+            << (nodes ? (double) edges / nodes : 0.0) << "\n";
+        out << "  in-degree: " << zero_in_degree << " zero, max " << max_in_degree
+            << ", skewness " << in_degree_skewness << ", top 1% share " << top1_in_share << "\n";
+        out << "  out-degree histogram:";
+        for (size_t d = 0; d < out_degree_hist.size(); d++)
+            if (out_degree_hist[d]) out << " " << d << ":" << out_degree_hist[d];
+        out << "\n  in-degree histogram:";
+        for (size_t d = 0; d < in_degree_hist.size(); d++)
+            if (in_degree_hist[d])
+                out << " " << d << (d + 1 == in_degree_hist.size() ? "+:" : ":") << in_degree_hist[d];
+        out << "\n";
+    }
+};
+
+struct GraphStats {
+    std::vector<GraphLevelStats> levels;     // indexed by level
+    std::vector<tableint> unreachable_nodes;  // live level 0 elements the entry point cannot reach
+
+    void report(std::ostream &out) const {
+        for (size_t l = levels.size(); l-- > 0;)
+            levels[l].report(out);
+    }
+};
+
 template<typename dist_t>
 class HierarchicalNSW : public AlgorithmInterface<dist_t> {
  public:
     static const tableint MAX_LABEL_OPERATION_LOCKS = 65536;
     static const unsigned char DELETE_MARK = 0x01;
+    // Elements per storage chunk: the smallest power of two holding the
+    // initial max_elements, within these bounds
+    static const size_t MIN_CHUNK_SHIFT = 10;
+    static const size_t MAX_CHUNK_SHIFT = 16;
 
     size_t max_elements_{0};
     mutable std::atomic<size_t> cur_element_count{0};  // current number of elements
@@ -40,20 +92,24 @@ class HierarchicalNSW : public AlgorithmInterface<dist_t> {
     mutable std::vector<std::mutex> label_op_locks_;
 
     std::mutex global;
-    std::vector<std::mutex> link_list_locks_;
+    ChunkedArray<std::mutex> link_list_locks_;
 
     tableint enterpoint_node_{0};
 
     size_t size_links_level0_{0};
     size_t offsetData_{0}, offsetLevel0_{0}, label_offset_{ 0 };
 
-    char *data_level0_memory_{nullptr};
-    char **linkLists_{nullptr};
-    std::vector<int> element_levels_;  // keeps level of each element
+    // Per-element storage is split into chunks addressed by internal id >> chunk
+    // shift, so resizeIndex appends chunks instead of moving the whole index
+    ChunkedBuffer data_level0_memory_;  // level 0 links, vector and label of each element
+    ChunkedArray<char *> linkLists_;
+    ChunkedArray<int> element_levels_;  // keeps level of each element
+    std::mutex resize_lock_;  // serializes resizeIndex
 
     size_t data_size_{0};
 
     DISTFUNC<dist_t> fstdistfunc_;
+    BOUNDEDDISTFUNC<dist_t> fstdistfunc_bounded_{nullptr};
     void *dist_func_param_{nullptr};
 
     mutable std::mutex label_lookup_lock;  // lock for label_lookup_
@@ -66,6 +122,11 @@ class HierarchicalNSW : public AlgorithmInterface<dist_t> {
     mutable std::atomic<long> metric_hops{0};
 
     bool allow_replace_deleted_ = false;  // flag to replace deleted elements (marked as deleted) during insertions
+    HugePageMode huge_pages_{HUGEPAGE_OFF};  // backing of the level 0 chunks, linkLists_ and visited lists
+
+    // optional level-0 entry points replacing the upper layer descent, see buildEntryPointTable
+    std::vector<tableint> entry_point_nodes_;
+    std::vector<char> entry_point_data_;  // vectors of entry_point_nodes_, contiguous
 
     std::mutex deleted_elements_lock;  // lock for deleted_elements
     std::unordered_set<tableint> deleted_elements;  // contains internal ids of deleted elements
@@ -80,8 +141,9 @@ class HierarchicalNSW : public AlgorithmInterface<dist_t> {
         const std::string &location,
         bool nmslib = false,
         size_t max_elements = 0,
-        bool allow_replace_deleted = false)
-        : allow_replace_deleted_(allow_replace_deleted) {
+        bool allow_replace_deleted = false,
+        HugePageMode huge_pages = HUGEPAGE_OFF)
+        : allow_replace_deleted_(allow_replace_deleted), huge_pages_(huge_pages) {
         loadIndex(location, s, max_elements);
     }
 
@@ -92,15 +154,16 @@ class HierarchicalNSW : public AlgorithmInterface<dist_t> {
         size_t M = 16,
         size_t ef_construction = 200,
         size_t random_seed = 100,
-        bool allow_replace_deleted = false)
+        bool allow_replace_deleted = false,
+        HugePageMode huge_pages = HUGEPAGE_OFF)
         : label_op_locks_(MAX_LABEL_OPERATION_LOCKS),
-            link_list_locks_(max_elements),
-            element_levels_(max_elements),
-            allow_replace_deleted_(allow_replace_deleted) {
+            allow_replace_deleted_(allow_replace_deleted),
+            huge_pages_(huge_pages) {
         max_elements_ = max_elements;
         num_deleted_ = 0;
         data_size_ = s->get_data_size();
         fstdistfunc_ = s->get_dist_func();
+        fstdistfunc_bounded_ = s->get_bounded_dist_func();
         dist_func_param_ = s->get_dist_func_param();
         if ( M <= 10000 ) {
             M_ = M;
@@ -123,21 +186,16 @@ class HierarchicalNSW : public AlgorithmInterface<dist_t> {
         label_offset_ = size_links_level0_ + data_size_;
         offsetLevel0_ = 0;
 
-        data_level0_memory_ = (char *) malloc(max_elements_ * size_data_per_element_);
-        if (data_level0_memory_ == nullptr)
-            throw std::runtime_error("Not enough memory");
+        initStorage(max_elements_);
 
         cur_element_count = 0;
 
-        visited_list_pool_ = std::unique_ptr<VisitedListPool>(new VisitedListPool(1, max_elements));
+        visited_list_pool_ = std::unique_ptr<VisitedListPool>(new VisitedListPool(1, max_elements, huge_pages_));
 
         // initializations for special treatment of the first node
         enterpoint_node_ = -1;
         maxlevel_ = -1;
 
-        linkLists_ = (char **) malloc(sizeof(void *) * max_elements_);
-        if (linkLists_ == nullptr)
-            throw std::runtime_error("Not enough memory: HierarchicalNSW failed to allocate linklists");
         size_links_per_element_ = maxM_ * sizeof(tableint) + sizeof(linklistsizeint);
         mult_ = 1 / log(1.0 * M_);
         revSize_ = 1.0 / mult_;
@@ -149,14 +207,15 @@ class HierarchicalNSW : public AlgorithmInterface<dist_t> {
     }
 
     void clear() {
-        free(data_level0_memory_);
-        data_level0_memory_ = nullptr;
         for (tableint i = 0; i < cur_element_count; i++) {
             if (element_levels_[i] > 0)
                 free(linkLists_[i]);
         }
-        free(linkLists_);
-        linkLists_ = nullptr;
+        data_level0_memory_.clear();
+        linkLists_.clear();
+        element_levels_.clear();
+        link_list_locks_.clear();
+        clearEntryPointTable();
         cur_element_count = 0;
         visited_list_pool_.reset(nullptr);
     }
@@ -184,23 +243,34 @@ class HierarchicalNSW : public AlgorithmInterface<dist_t> {
 
     inline labeltype getExternalLabel(tableint internal_id) const {
         labeltype return_label;
-        memcpy(&return_label, (data_level0_memory_ + internal_id * size_data_per_element_ + label_offset_), sizeof(labeltype));
+        memcpy(&return_label, (data_level0_memory_.at(internal_id) + label_offset_), sizeof(labeltype));
         return return_label;
     }
 
 
     inline void setExternalLabel(tableint internal_id, labeltype label) const {
-        memcpy((data_level0_memory_ + internal_id * size_data_per_element_ + label_offset_), &label, sizeof(labeltype));
+        memcpy((data_level0_memory_.at(internal_id) + label_offset_), &label, sizeof(labeltype));
     }
 
 
     inline labeltype *getExternalLabeLp(tableint internal_id) const {
-        return (labeltype *) (data_level0_memory_ + internal_id * size_data_per_element_ + label_offset_);
+        return (labeltype *) (data_level0_memory_.at(internal_id) + label_offset_);
     }
 
 
     inline char *getDataByInternalId(tableint internal_id) const {
-        return (data_level0_memory_ + internal_id * size_data_per_element_ + offsetData_);
+        return (data_level0_memory_.at(internal_id) + offsetData_);
+    }
+
+
+    // Prefetches the level 0 record of an id that may have been read past
+    // the end of a link list, so it may not address any allocated chunk
+    inline void prefetchElement(tableint internal_id, size_t offset) const {
+#ifdef USE_SSE
+        const char *record = data_level0_memory_.find(internal_id);
+        if (record)
+            _mm_prefetch(record + offset, _MM_HINT_T0);
+#endif
     }
 
 
@@ -224,7 +294,8 @@ class HierarchicalNSW : public AlgorithmInterface<dist_t> {
 
     std::priority_queue<std::pair<dist_t, tableint>, std::vector<std::pair<dist_t, tableint>>, CompareByFirst>
     searchBaseLayer(tableint ep_id, const void *data_point, int layer) {
-        VisitedList *vl = visited_list_pool_->getFreeVisitedList();
+        VisitedListLease lease(*visited_list_pool_);
+        VisitedList *vl = lease.list;
         vl_type *visited_array = vl->mass;
         vl_type visited_array_tag = vl->curV;
 
@@ -266,8 +337,8 @@ class HierarchicalNSW : public AlgorithmInterface<dist_t> {
 #ifdef USE_SSE
             _mm_prefetch((char *) (visited_array + *(data + 1)), _MM_HINT_T0);
             _mm_prefetch((char *) (visited_array + *(data + 1) + 64), _MM_HINT_T0);
-            _mm_prefetch(getDataByInternalId(*datal), _MM_HINT_T0);
-            _mm_prefetch(getDataByInternalId(*(datal + 1)), _MM_HINT_T0);
+            prefetchElement(*datal, offsetData_);
+            prefetchElement(*(datal + 1), offsetData_);
 #endif
 
             for (size_t j = 0; j < size; j++) {
@@ -275,7 +346,7 @@ class HierarchicalNSW : public AlgorithmInterface<dist_t> {
 //                    if (candidate_id == 0) continue;
 #ifdef USE_SSE
                 _mm_prefetch((char *) (visited_array + *(datal + j + 1)), _MM_HINT_T0);
-                _mm_prefetch(getDataByInternalId(*(datal + j + 1)), _MM_HINT_T0);
+                prefetchElement(*(datal + j + 1), offsetData_);
 #endif
                 if (visited_array[candidate_id] == visited_array_tag) continue;
                 visited_array[candidate_id] = visited_array_tag;
@@ -299,8 +370,6 @@ class HierarchicalNSW : public AlgorithmInterface<dist_t> {
                 }
             }
         }
-        visited_list_pool_->releaseVisitedList(vl);
-
         return top_candidates;
     }
 
@@ -314,7 +383,8 @@ class HierarchicalNSW : public AlgorithmInterface<dist_t> {
         size_t ef,
         BaseFilterFunctor* isIdAllowed = nullptr,
         BaseSearchStopCondition<dist_t>* stop_condition = nullptr) const {
-        VisitedList *vl = visited_list_pool_->getFreeVisitedList();
+        VisitedListLease lease(*visited_list_pool_);
+        VisitedList *vl = lease.list;
         vl_type *visited_array = vl->mass;
         vl_type visited_array_tag = vl->curV;
 
@@ -370,7 +440,7 @@ class HierarchicalNSW : public AlgorithmInterface<dist_t> {
 #ifdef USE_SSE
             _mm_prefetch((char *) (visited_array + *(data + 1)), _MM_HINT_T0);
             _mm_prefetch((char *) (visited_array + *(data + 1) + 64), _MM_HINT_T0);
-            _mm_prefetch(data_level0_memory_ + (*(data + 1)) * size_data_per_element_ + offsetData_, _MM_HINT_T0);
+            prefetchElement(*(data + 1), offsetData_);
             _mm_prefetch((char *) (data + 2), _MM_HINT_T0);
 #endif
 
@@ -379,14 +449,18 @@ class HierarchicalNSW : public AlgorithmInterface<dist_t> {
 //                    if (candidate_id == 0) continue;
 #ifdef USE_SSE
                 _mm_prefetch((char *) (visited_array + *(data + j + 1)), _MM_HINT_T0);
-                _mm_prefetch(data_level0_memory_ + (*(data + j + 1)) * size_data_per_element_ + offsetData_,
-                                _MM_HINT_T0);  ////////////
+                prefetchElement(*(data + j + 1), offsetData_);
 #endif
                 if (!(visited_array[candidate_id] == visited_array_tag)) {
                     visited_array[candidate_id] = visited_array_tag;
 
                     char *currObj1 = (getDataByInternalId(candidate_id));
-                    dist_t dist = fstdistfunc_(data_point, currObj1, dist_func_param_);
+                    dist_t dist;
+                    // once the result set is full, only distances below lowerBound matter
+                    if (fstdistfunc_bounded_ && (bare_bone_search || !stop_condition) && top_candidates.size() >= ef)
+                        dist = fstdistfunc_bounded_(data_point, currObj1, dist_func_param_, lowerBound);
+                    else
+                        dist = fstdistfunc_(data_point, currObj1, dist_func_param_);
 
                     bool flag_consider_candidate;
                     if (!bare_bone_search && stop_condition) {
@@ -398,9 +472,8 @@ class HierarchicalNSW : public AlgorithmInterface<dist_t> {
                     if (flag_consider_candidate) {
                         candidate_set.emplace(-dist, candidate_id);
 #ifdef USE_SSE
-                        _mm_prefetch(data_level0_memory_ + candidate_set.top().second * size_data_per_element_ +
-                                        offsetLevel0_,  ///////////
-                                        _MM_HINT_T0);  ////////////////////////
+                        _mm_prefetch(data_level0_memory_.at(candidate_set.top().second) + offsetLevel0_,
+                                        _MM_HINT_T0);
 #endif
 
                         if (bare_bone_search || 
@@ -435,7 +508,6 @@ class HierarchicalNSW : public AlgorithmInterface<dist_t> {
             }
         }
 
-        visited_list_pool_->releaseVisitedList(vl);
         return top_candidates;
     }
 
@@ -484,12 +556,7 @@ class HierarchicalNSW : public AlgorithmInterface<dist_t> {
 
 
     linklistsizeint *get_linklist0(tableint internal_id) const {
-        return (linklistsizeint *) (data_level0_memory_ + internal_id * size_data_per_element_ + offsetLevel0_);
-    }
-
-
-    linklistsizeint *get_linklist0(tableint internal_id, char *data_level0_memory_) const {
-        return (linklistsizeint *) (data_level0_memory_ + internal_id * size_data_per_element_ + offsetLevel0_);
+        return (linklistsizeint *) (data_level0_memory_.at(internal_id) + offsetLevel0_);
     }
 
 
@@ -630,29 +697,60 @@ class HierarchicalNSW : public AlgorithmInterface<dist_t> {
     }
 
 
+    // Storage grows by appending chunks: elements never move and nothing is
+    // copied, so addPoint and searches may keep running during the resize.
+    // Shrinking only lowers the limit, chunks are released by clear().
+    //
+    // Growing waits until every search that started before it has finished
+    // (see VisitedListPool::grow). It must therefore not be called from
+    // inside a search, e.g. from a filter functor or a stop condition: the
+    // calling thread holding a visited list is detected and throws, but a
+    // resize from one search callback that waits on another search blocked
+    // on this resize deadlocks.
     void resizeIndex(size_t new_max_elements) {
+        std::unique_lock <std::mutex> lock_resize(resize_lock_);
         if (new_max_elements < cur_element_count)
             throw std::runtime_error("Cannot resize, max element is less than the current number of elements");
 
-        visited_list_pool_.reset(new VisitedListPool(1, new_max_elements));
+        reserveStorage(new_max_elements);
+        // ids beyond the old limit may only show up once no search uses a shorter visited list
+        visited_list_pool_->grow(new_max_elements);
 
-        element_levels_.resize(new_max_elements);
+        std::unique_lock <std::mutex> lock_table(label_lookup_lock);
+        if (new_max_elements < cur_element_count)
+            throw std::runtime_error("Cannot resize, max element is less than the current number of elements");
+        max_elements_ = new_max_elements;
+    }
 
-        std::vector<std::mutex>(new_max_elements).swap(link_list_locks_);
 
-        // Reallocate base layer
-        char * data_level0_memory_new = (char *) realloc(data_level0_memory_, new_max_elements * size_data_per_element_);
-        if (data_level0_memory_new == nullptr)
-            throw std::runtime_error("Not enough memory: resizeIndex failed to allocate base layer");
-        data_level0_memory_ = data_level0_memory_new;
+    void initStorage(size_t max_elements) {
+        size_t shift = MIN_CHUNK_SHIFT;
+        while (shift < MAX_CHUNK_SHIFT && ((size_t) 1 << shift) < max_elements)
+            shift++;
+        data_level0_memory_.init(size_data_per_element_, hugeChunkShift(shift, size_data_per_element_), huge_pages_);
+        linkLists_.init(hugeChunkShift(shift, sizeof(char *)), huge_pages_);
+        element_levels_.init(shift);
+        link_list_locks_.init(shift);
+        reserveStorage(max_elements);
+    }
 
-        // Reallocate all other layers
-        char ** linkLists_new = (char **) realloc(linkLists_, sizeof(void *) * new_max_elements);
-        if (linkLists_new == nullptr)
-            throw std::runtime_error("Not enough memory: resizeIndex failed to allocate other layers");
-        linkLists_ = linkLists_new;
 
-        max_elements_ = new_max_elements;
+    // Chunks backed by huge pages must span at least HUGE_PAGE_SIZE, otherwise
+    // huge_malloc falls back to plain malloc for them
+    size_t hugeChunkShift(size_t shift, size_t record_size) const {
+        if (huge_pages_ == HUGEPAGE_OFF)
+            return shift;
+        while ((record_size << shift) < HUGE_PAGE_SIZE)
+            shift++;
+        return shift;
+    }
+
+
+    void reserveStorage(size_t max_elements) {
+        link_list_locks_.reserve(max_elements);
+        element_levels_.reserve(max_elements);
+        linkLists_.reserve(max_elements);
+        data_level0_memory_.reserve(max_elements);
     }
 
     size_t indexFileSize() const {
@@ -701,7 +799,9 @@ class HierarchicalNSW : public AlgorithmInterface<dist_t> {
         writeBinaryPOD(output, mult_);
         writeBinaryPOD(output, ef_construction_);
 
-        output.write(data_level0_memory_, cur_element_count * size_data_per_element_);
+        data_level0_memory_.forEachRun(cur_element_count, [&](const char *records, size_t n) {
+            output.write(records, n * size_data_per_element_);
+        });
 
         for (size_t i = 0; i < cur_element_count; i++) {
             unsigned int linkListSize = element_levels_[i] > 0 ? size_links_per_element_ * element_levels_[i] : 0;
@@ -747,6 +847,7 @@ class HierarchicalNSW : public AlgorithmInterface<dist_t> {
 
         data_size_ = s->get_data_size();
         fstdistfunc_ = s->get_dist_func();
+        fstdistfunc_bounded_ = s->get_bounded_dist_func();
         dist_func_param_ = s->get_dist_func_param();
 
         auto pos = input.tellg();
@@ -774,23 +875,18 @@ class HierarchicalNSW : public AlgorithmInterface<dist_t> {
 
         input.seekg(pos, input.beg);
 
-        data_level0_memory_ = (char *) malloc(max_elements * size_data_per_element_);
-        if (data_level0_memory_ == nullptr)
-            throw std::runtime_error("Not enough memory: loadIndex failed to allocate level0");
-        input.read(data_level0_memory_, cur_element_count * size_data_per_element_);
+        initStorage(max_elements);
+        data_level0_memory_.forEachRun(cur_element_count, [&](char *records, size_t n) {
+            input.read(records, n * size_data_per_element_);
+        });
 
         size_links_per_element_ = maxM_ * sizeof(tableint) + sizeof(linklistsizeint);
 
         size_links_level0_ = maxM0_ * sizeof(tableint) + sizeof(linklistsizeint);
-        std::vector<std::mutex>(max_elements).swap(link_list_locks_);
         std::vector<std::mutex>(MAX_LABEL_OPERATION_LOCKS).swap(label_op_locks_);
 
-        visited_list_pool_.reset(new VisitedListPool(1, max_elements));
+        visited_list_pool_.reset(new VisitedListPool(1, max_elements, huge_pages_));
 
-        linkLists_ = (char **) malloc(sizeof(void *) * max_elements);
-        if (linkLists_ == nullptr)
-            throw std::runtime_error("Not enough memory: loadIndex failed to allocate linklists");
-        element_levels_ = std::vector<int>(max_elements);
         revSize_ = 1.0 / mult_;
         ef_ = 10;
         for (size_t i = 0; i < cur_element_count; i++) {
@@ -1090,11 +1186,11 @@ class HierarchicalNSW : public AlgorithmInterface<dist_t> {
                     int size = getListCount(data);
                     tableint *datal = (tableint *) (data + 1);
 #ifdef USE_SSE
-                    _mm_prefetch(getDataByInternalId(*datal), _MM_HINT_T0);
+                    prefetchElement(*datal, offsetData_);
 #endif
                     for (int i = 0; i < size; i++) {
 #ifdef USE_SSE
-                        _mm_prefetch(getDataByInternalId(*(datal + i + 1)), _MM_HINT_T0);
+                        prefetchElement(*(datal + i + 1), offsetData_);
 #endif
                         tableint cand = datal[i];
                         dist_t d = fstdistfunc_(dataPoint, getDataByInternalId(cand), dist_func_param_);
@@ -1197,7 +1293,7 @@ class HierarchicalNSW : public AlgorithmInterface<dist_t> {
         tableint currObj = enterpoint_node_;
         tableint enterpoint_copy = enterpoint_node_;
 
-        memset(data_level0_memory_ + cur_c * size_data_per_element_ + offsetLevel0_, 0, size_data_per_element_);
+        memset(data_level0_memory_.at(cur_c) + offsetLevel0_, 0, size_data_per_element_);
 
         // Initialisation of the data and label
         memcpy(getExternalLabeLp(cur_c), &label, sizeof(labeltype));
@@ -1267,10 +1363,26 @@ class HierarchicalNSW : public AlgorithmInterface<dist_t> {
     }
 
 
-    std::priority_queue<std::pair<dist_t, labeltype >>
-    searchKnn(const void *query_data, size_t k, BaseFilterFunctor* isIdAllowed = nullptr) const {
-        std::priority_queue<std::pair<dist_t, labeltype >> result;
-        if (cur_element_count == 0) return result;
+    /*
+    * Level-0 entry point for a query: the closest node of the entry point
+    * table if one was built, otherwise greedy descent through the upper layers.
+    */
+    tableint getSearchEntryPoint(const void *query_data) const {
+        if (!entry_point_nodes_.empty()) {
+            size_t num_entries = entry_point_nodes_.size();
+            const char *entry_data = entry_point_data_.data();
+            tableint currObj = entry_point_nodes_[0];
+            dist_t curdist = fstdistfunc_(query_data, entry_data, dist_func_param_);
+            for (size_t i = 1; i < num_entries; i++) {
+                dist_t d = fstdistfunc_(query_data, entry_data + i * data_size_, dist_func_param_);
+                if (d < curdist) {
+                    curdist = d;
+                    currObj = entry_point_nodes_[i];
+                }
+            }
+            metric_distance_computations += num_entries;
+            return currObj;
+        }
 
         tableint currObj = enterpoint_node_;
         dist_t curdist = fstdistfunc_(query_data, getDataByInternalId(enterpoint_node_), dist_func_param_);
@@ -1301,6 +1413,119 @@ class HierarchicalNSW : public AlgorithmInterface<dist_t> {
                 }
             }
         }
+        return currObj;
+    }
+
+
+    /*
+    * Builds a table of up to `num_entries` nodes that replaces the upper layer
+    * descent in searches: the query is compared against every entry (one pass
+    * over a contiguous copy of their vectors) and the closest one seeds the
+    * level-0 search. Entries are k-medoids cluster representatives of a random
+    * sample of `sample_per_entry * num_entries` elements, computed with the
+    * space's own distance so that it works for every space.
+    * Not thread safe with searches or insertions, and not saved by saveIndex:
+    * rebuild it after loading or after large updates.
+    */
+    void buildEntryPointTable(size_t num_entries, size_t sample_per_entry = 8, size_t iterations = 3, size_t random_seed = 100) {
+        std::vector<tableint> alive;
+        alive.reserve(cur_element_count);
+        for (tableint i = 0; i < cur_element_count; i++) {
+            if (!isMarkedDeleted(i))
+                alive.push_back(i);
+        }
+        num_entries = std::min(num_entries, alive.size());
+        if (num_entries == 0) {
+            clearEntryPointTable();
+            return;
+        }
+
+        // random sample, the first num_entries of it are the initial medoids
+        std::mt19937 rng(random_seed);
+        size_t sample_size = std::min(alive.size(), std::max(num_entries, num_entries * sample_per_entry));
+        for (size_t i = 0; i < sample_size; i++) {
+            std::uniform_int_distribution<size_t> pick(i, alive.size() - 1);
+            std::swap(alive[i], alive[pick(rng)]);
+        }
+        std::vector<tableint> sample(alive.begin(), alive.begin() + sample_size);
+        std::vector<tableint> medoids(sample.begin(), sample.begin() + num_entries);
+
+        std::vector<size_t> assignment(sample_size);
+        std::vector<std::vector<tableint>> clusters(num_entries);
+        for (size_t iter = 0; iter < iterations; iter++) {
+            for (auto &c : clusters)
+                c.clear();
+            for (size_t i = 0; i < sample_size; i++) {
+                const char *point = getDataByInternalId(sample[i]);
+                size_t best = 0;
+                dist_t best_dist = fstdistfunc_(point, getDataByInternalId(medoids[0]), dist_func_param_);
+                for (size_t c = 1; c < num_entries; c++) {
+                    dist_t d = fstdistfunc_(point, getDataByInternalId(medoids[c]), dist_func_param_);
+                    if (d < best_dist) {
+                        best_dist = d;
+                        best = c;
+                    }
+                }
+                clusters[best].push_back(sample[i]);
+            }
+            // new medoid: the member with the smallest total distance to the rest of its cluster
+            for (size_t c = 0; c < num_entries; c++) {
+                const std::vector<tableint> &members = clusters[c];
+                dist_t best_sum = std::numeric_limits<dist_t>::max();
+                for (tableint candidate : members) {
+                    dist_t sum = 0;
+                    const char *candidate_data = getDataByInternalId(candidate);
+                    for (tableint other : members)
+                        sum += fstdistfunc_(candidate_data, getDataByInternalId(other), dist_func_param_);
+                    if (sum < best_sum) {
+                        best_sum = sum;
+                        medoids[c] = candidate;
+                    }
+                }
+            }
+        }
+        setEntryPointNodes(medoids);
+    }
+
+
+    // Uses the given elements (e.g. the nodes closest to externally computed k-means centroids) as the entry point table
+    void setEntryPointTable(const std::vector<labeltype> &labels) {
+        std::vector<tableint> nodes;
+        for (labeltype label : labels) {
+            auto search = label_lookup_.find(label);
+            if (search == label_lookup_.end() || isMarkedDeleted(search->second))
+                throw std::runtime_error("Label not found");
+            nodes.push_back(search->second);
+        }
+        setEntryPointNodes(nodes);
+    }
+
+
+    void clearEntryPointTable() {
+        std::vector<tableint>().swap(entry_point_nodes_);
+        std::vector<char>().swap(entry_point_data_);
+    }
+
+
+    size_t getEntryPointTableSize() const {
+        return entry_point_nodes_.size();
+    }
+
+
+    void setEntryPointNodes(const std::vector<tableint> &nodes) {
+        entry_point_nodes_ = nodes;
+        entry_point_data_.resize(nodes.size() * data_size_);
+        for (size_t i = 0; i < nodes.size(); i++)
+            memcpy(entry_point_data_.data() + i * data_size_, getDataByInternalId(nodes[i]), data_size_);
+    }
+
+
+    std::priority_queue<std::pair<dist_t, labeltype >>
+    searchKnn(const void *query_data, size_t k, BaseFilterFunctor* isIdAllowed = nullptr) const {
+        std::priority_queue<std::pair<dist_t, labeltype >> result;
+        if (cur_element_count == 0) return result;
+
+        tableint currObj = getSearchEntryPoint(query_data);
 
         std::priority_queue<std::pair<dist_t, tableint>, std::vector<std::pair<dist_t, tableint>>, CompareByFirst> top_candidates;
         bool bare_bone_search = !num_deleted_ && !isIdAllowed;
@@ -1332,35 +1557,7 @@ class HierarchicalNSW : public AlgorithmInterface<dist_t> {
         std::vector<std::pair<dist_t, labeltype >> result;
         if (cur_element_count == 0) return result;
 
-        tableint currObj = enterpoint_node_;
-        dist_t curdist = fstdistfunc_(query_data, getDataByInternalId(enterpoint_node_), dist_func_param_);
-
-        for (int level = maxlevel_; level > 0; level--) {
-            bool changed = true;
-            while (changed) {
-                changed = false;
-                unsigned int *data;
-
-                data = (unsigned int *) get_linklist(currObj, level);
-                int size = getListCount(data);
-                metric_hops++;
-                metric_distance_computations+=size;
-
-                tableint *datal = (tableint *) (data + 1);
-                for (int i = 0; i < size; i++) {
-                    tableint cand = datal[i];
-                    if (cand < 0 || cand > max_elements_)
-                        throw std::runtime_error("cand error");
-                    dist_t d = fstdistfunc_(query_data, getDataByInternalId(cand), dist_func_param_);
-
-                    if (d < curdist) {
-                        curdist = d;
-                        currObj = cand;
-                        changed = true;
-                    }
-                }
-            }
-        }
+        tableint currObj = getSearchEntryPoint(query_data);
 
         std::priority_queue<std::pair<dist_t, tableint>, std::vector<std::pair<dist_t, tableint>>, CompareByFirst> top_candidates;
         top_candidates = searchBaseLayerST<false>(currObj, query_data, 0, isIdAllowed, &stop_condition);
@@ -1378,6 +1575,115 @@ class HierarchicalNSW : public AlgorithmInterface<dist_t> {
     }
 
 
+    // Streams every element within `radius` of the query to `callback`, in
+    // no particular order and without materializing the result set. Until
+    // the first match this is a beam search of width ef_; after that the
+    // frontier grows only through matches, plus up to `max_outside_hops`
+    // hops through elements outside the radius to bridge gaps in the region.
+    // Bridging stops after ef_ such expansions in a row find nothing new.
+    // Memory is the visited list and the frontier. Returns the number of
+    // matches delivered.
+    size_t searchRange(
+        const void *query_data,
+        dist_t radius,
+        BaseRangeCallback<dist_t> &callback,
+        BaseFilterFunctor* isIdAllowed = nullptr,
+        size_t max_outside_hops = 1) const {
+        if (cur_element_count == 0) return 0;
+
+        struct Candidate {
+            dist_t dist;
+            tableint id;
+            size_t outside_hops;
+            bool operator<(const Candidate &other) const { return dist > other.dist; }  // closest on top
+        };
+
+        tableint ep_id = getSearchEntryPoint(query_data);
+        VisitedListLease lease(*visited_list_pool_);
+        VisitedList *vl = lease.list;
+        vl_type *visited_array = vl->mass;
+        vl_type visited_array_tag = vl->curV;
+
+        size_t found = 0;
+        bool in_region = false;
+        bool stop = false;
+        auto deliver = [&](tableint id, dist_t dist) {
+            in_region = true;
+            if (isMarkedDeleted(id))
+                return;
+            labeltype label = getExternalLabel(id);
+            if (isIdAllowed && !(*isIdAllowed)(label))
+                return;
+            found++;
+            stop = !callback(label, dist);
+        };
+
+        std::priority_queue<Candidate> frontier;
+        std::priority_queue<dist_t> beam;  // best distances seen before the first match
+        dist_t ep_dist = fstdistfunc_(query_data, getDataByInternalId(ep_id), dist_func_param_);
+        visited_array[ep_id] = visited_array_tag;
+        frontier.push({ep_dist, ep_id, 0});
+        beam.push(ep_dist);
+        if (ep_dist <= radius)
+            deliver(ep_id, ep_dist);
+
+        // Expansions of elements outside the radius in a row that found no
+        // new match; the frontier is closest first, so once these start the
+        // region itself is exhausted and only bridging attempts remain
+        size_t fruitless = 0;
+        while (!stop && !frontier.empty()) {
+            Candidate current = frontier.top();
+            if (!in_region && beam.size() >= ef_ && current.dist > beam.top())
+                break;  // the closest region is outside the radius
+            if (in_region && current.dist > radius && fruitless >= ef_)
+                break;
+            frontier.pop();
+            size_t found_before = found;
+            bool was_in_region = in_region;
+
+            int *data = (int *) get_linklist0(current.id);
+            size_t size = getListCount((linklistsizeint*)data);
+            metric_hops++;
+            metric_distance_computations += size;
+#ifdef USE_SSE
+            _mm_prefetch((char *) (visited_array + *(data + 1)), _MM_HINT_T0);
+            prefetchElement(*(data + 1), offsetData_);
+            _mm_prefetch((char *) (data + 2), _MM_HINT_T0);
+#endif
+            for (size_t j = 1; j <= size && !stop; j++) {
+                int candidate_id = *(data + j);
+#ifdef USE_SSE
+                _mm_prefetch((char *) (visited_array + *(data + j + 1)), _MM_HINT_T0);
+                prefetchElement(*(data + j + 1), offsetData_);
+#endif
+                if (visited_array[candidate_id] == visited_array_tag)
+                    continue;
+                visited_array[candidate_id] = visited_array_tag;
+
+                dist_t dist = fstdistfunc_(query_data, getDataByInternalId(candidate_id), dist_func_param_);
+                if (dist <= radius) {
+                    frontier.push({dist, (tableint) candidate_id, 0});
+                    deliver(candidate_id, dist);
+                } else if (!in_region) {
+                    if (beam.size() < ef_ || dist < beam.top()) {
+                        // Only there to find the region, do not grow a fringe around it
+                        frontier.push({dist, (tableint) candidate_id, max_outside_hops});
+                        beam.push(dist);
+                        if (beam.size() > ef_)
+                            beam.pop();
+                    }
+                } else if (current.outside_hops < max_outside_hops) {
+                    frontier.push({dist, (tableint) candidate_id, current.outside_hops + 1});
+                }
+            }
+            if (was_in_region && current.dist > radius)
+                fruitless = found > found_before ? 0 : fruitless + 1;
+        }
+
+        return found;
+    }
+
+
     void checkIntegrity() {
         int connections_checked = 0;
         std::vector <int > inbound_connections_num(cur_element_count, 0);
@@ -1408,5 +1714,229 @@ class HierarchicalNSW : public AlgorithmInterface<dist_t> {
         }
         std::cout << "integrity ok, checked " << connections_checked << " connections\n";
     }
+
+    // Elements reachable from the entry point through the links of `level`
+    std::vector<char> reachableAtLevel(int level) const {
+        std::vector<char> reached(cur_element_count, 0);
+        if (enterpoint_node_ == (tableint) -1 || maxlevel_ < level)
+            return reached;
+        std::vector<tableint> queue(1, enterpoint_node_);
+        reached[enterpoint_node_] = 1;
+        for (size_t head = 0; head < queue.size(); head++) {
+            linklistsizeint *ll = get_linklist_at_level(queue[head], level);
+            size_t size = getListCount(ll);
+            tableint *data = (tableint *) (ll + 1);
+            for (size_t j = 0; j < size; j++) {
+                if (!reached[data[j]]) {
+                    reached[data[j]] = 1;
+                    queue.push_back(data[j]);
+                }
+            }
+        }
+        return reached;
+    }
+
+
+    // Reachability from the entry point, in/out-degree histograms and hubness
+    // for every level. Not safe to run concurrently with insertions.
+    GraphStats analyzeGraph() const {
+        GraphStats stats;
+        if (enterpoint_node_ == (tableint) -1)
+            return stats;
+        size_t count = cur_element_count;
+        stats.levels.resize(maxlevel_ + 1);
+        for (int level = 0; level <= maxlevel_; level++) {
+            GraphLevelStats &ls = stats.levels[level];
+            size_t maxM = level ? maxM_ : maxM0_;
+            ls.level = level;
+            ls.out_degree_hist.assign(maxM + 1, 0);
+            ls.in_degree_hist.assign(2 * maxM0_ + 1, 0);
+
+            std::vector<char> reached = reachableAtLevel(level);
+            std::vector<size_t> in_degree(count, 0);
+            for (tableint i = 0; i < count; i++) {
+                if (element_levels_[i] < level)
+                    continue;
+                linklistsizeint *ll = get_linklist_at_level(i, level);
+                size_t size = getListCount(ll);
+                tableint *data = (tableint *) (ll + 1);
+                for (size_t j = 0; j < size; j++)
+                    in_degree[data[j]]++;
+                ls.out_degree_hist[std::min(size, maxM)]++;
+                ls.edges += size;
+                ls.nodes++;
+                if (isMarkedDeleted(i)) {
+                    ls.deleted++;
+                } else if (!reached[i]) {
+                    ls.unreachable++;
+                    if (level == 0)
+                        stats.unreachable_nodes.push_back(i);
+                }
+            }
+
+            std::vector<size_t> degrees;
+            degrees.reserve(ls.nodes);
+            for (tableint i = 0; i < count; i++) {
+                if (element_levels_[i] >= level)
+                    degrees.push_back(in_degree[i]);
+            }
+            if (degrees.empty())
+                continue;
+            double mean = (double) ls.edges / degrees.size();
+            double m2 = 0, m3 = 0;
+            for (size_t d : degrees) {
+                ls.in_degree_hist[std::min(d, ls.in_degree_hist.size() - 1)]++;
+                if (d == 0)
+                    ls.zero_in_degree++;
+                ls.max_in_degree = std::max(ls.max_in_degree, d);
+                m2 += (d - mean) * (d - mean);
+                m3 += (d - mean) * (d - mean) * (d - mean);
+            }
+            m2 /= degrees.size();
+            m3 /= degrees.size();
+            ls.in_degree_skewness = m2 > 0 ? m3 / std::pow(m2, 1.5) : 0;
+
+            size_t top = std::max<size_t>(1, degrees.size() / 100);
+            std::nth_element(degrees.begin(), degrees.begin() + top - 1, degrees.end(), std::greater<size_t>());
+            size_t top_edges = 0;
+            for (size_t j = 0; j < top; j++)
+                top_edges += degrees[j];
+            ls.top1_in_share = ls.edges ? (double) top_edges / ls.edges : 0;
+        }
+        return stats;
+    }
+
+
+    // Reconnects live elements the entry point cannot reach, level by level.
+    // Each one gets an in-link from the closest reachable element that has a
+    // free slot, or else replaces that element's farthest link whose target
+    // has another in-link from a reachable element. That other in-link may
+    // itself only be reachable through the target (a cycle), so a
+    // replacement can still cut elements off; each pass recomputes
+    // reachability and picks those up, and whatever is left after
+    // max_passes stays unreachable (see analyzeGraph).
+    // Elements left without any links also get heuristic-selected out-links.
+    // Returns the number of links added; the index must not be modified
+    // concurrently.
+    size_t repairConnectivity(int max_passes = 3) {
+        size_t added = 0;
+        for (int level = maxlevel_; level >= 0; level--) {
+            for (int pass = 0; pass < max_passes; pass++) {
+                size_t n = repairLevel(level);
+                added += n;
+                if (n == 0)
+                    break;
+            }
+        }
+        return added;
+    }
+
+
+    size_t repairLevel(int level) {
+        if (enterpoint_node_ == (tableint) -1)
+            return 0;
+        size_t count = cur_element_count;
+        size_t maxM = level ? maxM_ : maxM0_;
+        std::vector<char> reached = reachableAtLevel(level);
+
+        // In-links coming from reachable elements; a link may only be
+        // dropped if its target keeps at least one other. This is a cheap
+        // filter, not a guarantee: the other in-link can depend on the
+        // dropped one, which the next pass of repairConnectivity repairs.
+        std::vector<unsigned> reachable_in(count, 0);
+        for (tableint i = 0; i < count; i++) {
+            if (!reached[i])
+                continue;
+            linklistsizeint *ll = get_linklist_at_level(i, level);
+            size_t size = getListCount(ll);
+            tableint *data = (tableint *) (ll + 1);
+            for (size_t j = 0; j < size; j++)
+                reachable_in[data[j]]++;
+        }
+
+        size_t added = 0;
+        for (tableint u = 0; u < count; u++) {
+            if (element_levels_[u] < level || reached[u] || isMarkedDeleted(u))
+                continue;
+            char *u_data = getDataByInternalId(u);
+            std::priority_queue<std::pair<dist_t, tableint>, std::vector<std::pair<dist_t, tableint>>, CompareByFirst>
+                top_candidates = searchBaseLayer(enterpoint_node_, u_data, level);
+            std::vector<std::pair<dist_t, tableint>> closest;
+            while (!top_candidates.empty()) {
+                if (top_candidates.top().second != u)
+                    closest.push_back(top_candidates.top());
+                top_candidates.pop();
+            }
+            std::reverse(closest.begin(), closest.end());
+
+            bool linked = false;
+            for (auto &cand : closest) {
+                tableint c = cand.second;
+                std::unique_lock <std::mutex> lock(link_list_locks_[c]);
+                linklistsizeint *ll = get_linklist_at_level(c, level);
+                size_t size = getListCount(ll);
+                tableint *data = (tableint *) (ll + 1);
+                if (size < maxM) {
+                    data[size] = u;
+                    setListCount(ll, size + 1);
+                    linked = true;
+                } else {
+                    int victim = -1;
+                    dist_t victim_dist = cand.first;
+                    for (size_t j = 0; j < size; j++) {
+                        if (reachable_in[data[j]] < 2)
+                            continue;
+                        dist_t d = fstdistfunc_(getDataByInternalId(c), getDataByInternalId(data[j]), dist_func_param_);
+                        if (d > victim_dist) {
+                            victim = j;
+                            victim_dist = d;
+                        }
+                    }
+                    if (victim >= 0) {
+                        reachable_in[data[victim]]--;
+                        data[victim] = u;
+                        linked = true;
+                    }
+                }
+                if (linked)
+                    break;
+            }
+            if (!linked)
+                continue;
+            added++;
+
+            linklistsizeint *ll_u = get_linklist_at_level(u, level);
+            if (getListCount(ll_u) == 0 && !closest.empty()) {
+                std::priority_queue<std::pair<dist_t, tableint>, std::vector<std::pair<dist_t, tableint>>, CompareByFirst>
+                    candidates(closest.begin(), closest.end());
+                getNeighborsByHeuristic2(candidates, M_);
+                tableint *data = (tableint *) (ll_u + 1);
+                size_t size = 0;
+                while (!candidates.empty() && size < maxM) {
+                    data[size++] = candidates.top().second;
+                    candidates.pop();
+                }
+                setListCount(ll_u, size);
+            }
+
+            // Everything u leads to is reachable now
+            reachable_in[u]++;
+            reached[u] = 1;
+            std::vector<tableint> queue(1, u);
+            for (size_t head = 0; head < queue.size(); head++) {
+                linklistsizeint *ll = get_linklist_at_level(queue[head], level);
+                size_t size = getListCount(ll);
+                tableint *data = (tableint *) (ll + 1);
+                for (size_t j = 0; j < size; j++) {
+                    reachable_in[data[j]]++;
+                    if (!reached[data[j]]) {
+                        reached[data[j]] = 1;
+                        queue.push_back(data[j]);
+                    }
+                }
+            }
+        }
+        return added;
+    }
 };
 }  // namespace hnswlib
@@ -131,6 +131,14 @@ class BaseFilterFunctor {
     virtual ~BaseFilterFunctor() {};
 };
 
+// Receives range search matches one at a time; returning false stops the search
+template<typename dist_t>
+class BaseRangeCallback {
+ public:
+    virtual bool operator()(labeltype label, dist_t dist) = 0;
+    virtual ~BaseRangeCallback() {}
+};
+
 template<typename dist_t>
 class BaseSearchStopCondition {
  public:
@@ -170,6 +178,16 @@ static void readBinaryPOD(std::istream &in, T &podRef) {
 template<typename MTYPE>
 using DISTFUNC = MTYPE(*)(const void *, const void *, const void *);
 
+// Distance that may stop early: once the partial result proves the distance
+// exceeds `bound`, it returns any value > bound instead of the exact distance.
+template<typename MTYPE>
+using BOUNDEDDISTFUNC = MTYPE(*)(const void *, const void *, const void *, MTYPE);
+
+// Distances from one query to `count` vectors stored back to back
+// (get_data_size() bytes apart), written to out[0..count).
+template<typename MTYPE>
+using BATCHDISTFUNC = void(*)(const void *, const void *, size_t, const void *, MTYPE *);
+
 template<typename MTYPE>
 class SpaceInterface {
  public:
@@ -180,6 +198,12 @@ class SpaceInterface {
 
     virtual void *get_dist_func_param() = 0;
 
+    // Optional early-abandoning variant of get_dist_func(), same param
+    virtual BOUNDEDDISTFUNC<MTYPE> get_bounded_dist_func() { return nullptr; }
+
+    // Optional batched variant of get_dist_func() for flat scans, same param
+    virtual BATCHDISTFUNC<MTYPE> get_batch_dist_func() { return nullptr; }
+
     virtual ~SpaceInterface() {}
 };
 
@@ -223,6 +247,9 @@ AlgorithmInterface<dist_t>::searchKnnCloserFirst(const void* query_data, size_t
 
 #include "space_l2.h"
 #include "space_ip.h"
+#include "space_half.h"
+#include "space_pca.h"
 #include "stop_condition.h"
 #include "bruteforce.h"
 #include "hnswalg.h"
+#include "multivector_index.h"
@@ -0,0 +1,173 @@
+#pragma once
+
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#if defined(_WIN32)
+#include <malloc.h>
+#endif
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+// Allocation of large, randomly accessed arrays (level 0 graph + vectors,
+// link list tables, visited lists, flat-scan bases) on 2MB pages to cut dTLB
+// misses during graph traversal.
+//
+//   HUGEPAGE_OFF          plain (cache-line aligned) malloc
+//   HUGEPAGE_TRANSPARENT  2MB-aligned anonymous mmap + madvise(MADV_HUGEPAGE),
+//                         needs THP "always" or "madvise"
+//   HUGEPAGE_EXPLICIT     MAP_HUGETLB from the reserved pool (vm.nr_hugepages),
+//                         falls back to TRANSPARENT when the pool is empty
+//
+// Requests smaller than one huge page, and every request on non-Linux
+// systems, fall back to the aligned malloc. Every block carries a small header so
+// huge_free() / huge_realloc() work regardless of how it was obtained.
+
+namespace hnswlib {
+
+enum HugePageMode {
+    HUGEPAGE_OFF = 0,
+    HUGEPAGE_TRANSPARENT = 1,
+    HUGEPAGE_EXPLICIT = 2
+};
+
+static const size_t HUGE_PAGE_SIZE = 2 << 20;
+
+struct HugeAllocStats {
+    std::atomic<size_t> malloc_bytes{0};
+    std::atomic<size_t> transparent_bytes{0};
+    std::atomic<size_t> explicit_bytes{0};
+};
+
+inline HugeAllocStats &huge_alloc_stats() {
+    static HugeAllocStats stats;
+    return stats;
+}
+
+struct alignas(64) HugeAllocHeader {
+    size_t size;    // usable bytes
+    size_t mapped;  // bytes mapped, 0 for malloc
+    int kind;       // HugePageMode actually used
+};
+
+static_assert(sizeof(HugeAllocHeader) == 64, "header must keep the payload cache-line aligned");
+
+inline void huge_account(int kind, size_t size, bool add) {
+    HugeAllocStats &stats = huge_alloc_stats();
+    std::atomic<size_t> &counter = kind == HUGEPAGE_EXPLICIT ? stats.explicit_bytes
+                                 : kind == HUGEPAGE_TRANSPARENT ? stats.transparent_bytes
+                                 : stats.malloc_bytes;
+    if (add)
+        counter += size;
+    else
+        counter -= size;
+}
+
+#if defined(__linux__)
+// Anonymous mapping of `len` bytes (multiple of HUGE_PAGE_SIZE) starting on a
+// 2MB boundary, so THP can back it from the first byte.
+inline void *huge_map_aligned(size_t len) {
+    size_t over = len + HUGE_PAGE_SIZE;
+    void *p = mmap(nullptr, over, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED)
+        return nullptr;
+    uintptr_t start = (uintptr_t) p;
+    uintptr_t aligned = (start + HUGE_PAGE_SIZE - 1) & ~(uintptr_t) (HUGE_PAGE_SIZE - 1);
+    if (aligned > start)
+        munmap(p, aligned - start);
+    size_t tail = (start + over) - (aligned + len);
+    if (tail > 0)
+        munmap((void *) (aligned + len), tail);
+    return (void *) aligned;
+}
+#endif
+
+inline void *huge_malloc(size_t size, HugePageMode mode) {
+    size_t total = size + sizeof(HugeAllocHeader);
+    HugeAllocHeader *h = nullptr;
+#if defined(__linux__)
+    if (mode != HUGEPAGE_OFF && size >= HUGE_PAGE_SIZE) {
+        size_t len = (total + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+#ifdef MAP_HUGETLB
+        if (mode == HUGEPAGE_EXPLICIT) {
+            void *p = mmap(nullptr, len, PROT_READ | PROT_WRITE,
+                           MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+            if (p != MAP_FAILED) {
+                h = (HugeAllocHeader *) p;
+                h->kind = HUGEPAGE_EXPLICIT;
+                h->mapped = len;
+            }
+        }
+#endif
+        if (h == nullptr) {
+            void *p = huge_map_aligned(len);
+            if (p != nullptr) {
+#ifdef MADV_HUGEPAGE
+                madvise(p, len, MADV_HUGEPAGE);
+#endif
+                h = (HugeAllocHeader *) p;
+                h->kind = HUGEPAGE_TRANSPARENT;
+                h->mapped = len;
+            }
+        }
+    }
+#else
+    (void) mode;
+#endif
+    if (h == nullptr) {
+#if defined(_WIN32)
+        h = (HugeAllocHeader *) _aligned_malloc(total, sizeof(HugeAllocHeader));
+#else
+        void *p = nullptr;
+        if (posix_memalign(&p, sizeof(HugeAllocHeader), total) == 0)
+            h = (HugeAllocHeader *) p;
+#endif
+        if (h == nullptr)
+            return nullptr;
+        h->kind = HUGEPAGE_OFF;
+        h->mapped = 0;
+    }
+    h->size = size;
+    huge_account(h->kind, size, true);
+    return (char *) h + sizeof(HugeAllocHeader);
+}
+
+inline void huge_free(void *ptr) {
+    if (ptr == nullptr)
+        return;
+    HugeAllocHeader *h = (HugeAllocHeader *) ((char *) ptr - sizeof(HugeAllocHeader));
+    huge_account(h->kind, h->size, false);
+#if defined(__linux__)
+    if (h->mapped) {
+        munmap(h, h->mapped);
+        return;
+    }
+#endif
+#if defined(_WIN32)
+    _aligned_free(h);
+#else
+    free(h);
+#endif
+}
+
+// Same contract as realloc: on failure returns nullptr and leaves `ptr` intact
+inline void *huge_realloc(void *ptr, size_t size, HugePageMode mode) {
+    if (ptr == nullptr)
+        return huge_malloc(size, mode);
+    HugeAllocHeader *h = (HugeAllocHeader *) ((char *) ptr - sizeof(HugeAllocHeader));
+    if (size <= h->size) {
+        huge_account(h->kind, h->size - size, false);
+        h->size = size;
+        return ptr;
+    }
+    void *res = huge_malloc(size, mode);
+    if (res == nullptr)
+        return nullptr;
+    memcpy(res, ptr, h->size < size ? h->size : size);
+    huge_free(ptr);
+    return res;
+}
+
+}  // namespace hnswlib
@@ -0,0 +1,198 @@
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <memory>
+#include <vector>
+#include <algorithm>
+#include <limits>
+#include "hnswalg.h"
+
+namespace hnswlib {
+
+// Late-interaction (ColBERT style) index over multi-vector documents.
+//
+// A document is a block of token vectors stored back to back, so scoring it
+// reads one contiguous range. Documents are ranked by MaxSim:
+//     score(Q, D) = sum over query tokens q of max over document tokens d of <q, d>
+// Candidate documents come from an HNSW graph over all token vectors (the
+// label of a token is its position in the token array, and its document is
+// a plain array lookup). Every candidate is then scored exactly with the
+// batched inner-product kernel of InnerProductSpace.
+//
+// addDocument may be called from several threads and concurrently with
+// searches; a document becomes visible once addDocument returns. Results
+// follow the hnswlib convention with distance = -score, so the top of the
+// returned priority queue is the worst of the k documents.
+class MultiVectorIndex {
+ public:
+    MultiVectorIndex(
+        size_t dim,
+        size_t max_documents,
+        size_t max_tokens,
+        size_t M = 16,
+        size_t ef_construction = 200,
+        size_t random_seed = 100)
+        : space_(dim),
+          dim_(dim),
+          max_documents_(max_documents),
+          max_tokens_(max_tokens),
+          vectors_(max_tokens * dim),
+          token_doc_(max_tokens),
+          doc_begin_(max_documents),
+          doc_size_(max_documents),
+          doc_labels_(max_documents),
+          doc_ready_(new std::atomic<bool>[max_documents]),
+          token_graph_(&space_, max_tokens, M, ef_construction, random_seed) {
+        fstdistfunc_batch_ = space_.get_batch_dist_func();
+        for (size_t i = 0; i < max_documents; i++)
+            doc_ready_[i] = false;
+    }
+
+
+    // Adds a document made of `num_tokens` vectors of dim floats each
+    void addDocument(const float *tokens, size_t num_tokens, labeltype label) {
+        if (num_tokens == 0)
+            throw std::runtime_error("A document needs at least one vector");
+        size_t doc, begin;
+        {
+            std::unique_lock<std::mutex> lock(write_lock_);
+            if (cur_documents_ >= max_documents_)
+                throw std::runtime_error("The number of documents exceeds the specified limit");
+            if (cur_tokens_ + num_tokens > max_tokens_)
+                throw std::runtime_error("The number of vectors exceeds the specified limit");
+            doc = cur_documents_++;
+            begin = cur_tokens_;
+            cur_tokens_ += num_tokens;
+        }
+        memcpy(vectors_.data() + begin * dim_, tokens, num_tokens * dim_ * sizeof(float));
+        doc_begin_[doc] = begin;
+        doc_size_[doc] = num_tokens;
+        doc_labels_[doc] = label;
+        for (size_t t = 0; t < num_tokens; t++) {
+            token_doc_[begin + t] = doc;
+            token_graph_.addPoint(vectors_.data() + (begin + t) * dim_, begin + t);
+        }
+        doc_ready_[doc].store(true, std::memory_order_release);
+    }
+
+
+    // ef of the token graph; searches use max(ef, candidates_per_token)
+    void setEf(size_t ef) {
+        token_graph_.setEf(ef);
+    }
+
+
+    // Scores the documents owning the candidates_per_token nearest tokens of
+    // every query token. `num_candidates`, if given, receives the number of
+    // documents scored.
+    std::priority_queue<std::pair<float, labeltype>>
+    searchKnn(const float *query, size_t query_tokens, size_t k, size_t candidates_per_token = 32,
+              size_t *num_candidates = nullptr) const {
+        std::vector<unsigned> docs;
+        docs.reserve(query_tokens * candidates_per_token);
+        for (size_t i = 0; i < query_tokens; i++) {
+            auto res = token_graph_.searchKnn(query + i * dim_, candidates_per_token);
+            while (!res.empty()) {
+                unsigned doc = token_doc_[res.top().second];
+                if (doc_ready_[doc].load(std::memory_order_acquire))
+                    docs.push_back(doc);
+                res.pop();
+            }
+        }
+        std::sort(docs.begin(), docs.end());
+        docs.erase(std::unique(docs.begin(), docs.end()), docs.end());
+        if (num_candidates)
+            *num_candidates = docs.size();
+
+        std::priority_queue<std::pair<float, labeltype>> top_results;
+        for (unsigned doc : docs)
+            pushResult(top_results, -maxSim(query, query_tokens, doc), doc_labels_[doc], k);
+        return top_results;
+    }
+
+
+    // Exact MaxSim over every document, for ground truth and small collections
+    std::priority_queue<std::pair<float, labeltype>>
+    searchExhaustive(const float *query, size_t query_tokens, size_t k) const {
+        std::priority_queue<std::pair<float, labeltype>> top_results;
+        size_t count = size();
+        for (size_t doc = 0; doc < count; doc++) {
+            if (doc_ready_[doc].load(std::memory_order_acquire))
+                pushResult(top_results, -maxSim(query, query_tokens, doc), doc_labels_[doc], k);
+        }
+        return top_results;
+    }
+
+
+    // MaxSim of the query against the doc-th added document
+    float maxSim(const float *query, size_t query_tokens, size_t doc) const {
+        const float *block = vectors_.data() + doc_begin_[doc] * dim_;
+        size_t size = doc_size_[doc];
+        float dists[TILE_SIZE];
+        float score = 0;
+        for (size_t i = 0; i < query_tokens; i++) {
+            const float *q = query + i * dim_;
+            // The batched kernel returns 1 - <q, d>, so the best match is the smallest
+            float best = std::numeric_limits<float>::max();
+            for (size_t tile = 0; tile < size; tile += TILE_SIZE) {
+                size_t n = size - tile < TILE_SIZE ? size - tile : TILE_SIZE;
+                fstdistfunc_batch_(q, block + tile * dim_, n, &dim_, dists);
+                for (size_t j = 0; j < n; j++)
+                    best = std::min(best, dists[j]);
+            }
+            score += 1.0f - best;
+        }
+        return score;
+    }
+
+
+    size_t size() const {
+        std::unique_lock<std::mutex> lock(write_lock_);
+        return cur_documents_;
+    }
+
+
+    size_t numTokens() const {
+        std::unique_lock<std::mutex> lock(write_lock_);
+        return cur_tokens_;
+    }
+
+
+    const HierarchicalNSW<float> &tokenGraph() const {
+        return token_graph_;
+    }
+
+ private:
+    static const size_t TILE_SIZE = 256;   // document tokens per batched kernel call
+
+    static void pushResult(std::priority_queue<std::pair<float, labeltype>> &top_results,
+                           float dist, labeltype label, size_t k) {
+        if (top_results.size() < k || dist < top_results.top().first) {
+            top_results.emplace(dist, label);
+            if (top_results.size() > k)
+                top_results.pop();
+        }
+    }
+
+    InnerProductSpace space_;
+    size_t dim_;
+    size_t max_documents_;
+    size_t max_tokens_;
+    BATCHDISTFUNC<float> fstdistfunc_batch_;
+
+    std::vector<float> vectors_;          // token vectors, documents back to back
+    std::vector<unsigned> token_doc_;     // token -> document
+    std::vector<size_t> doc_begin_;       // document -> first token
+    std::vector<size_t> doc_size_;
+    std::vector<labeltype> doc_labels_;
+    std::unique_ptr<std::atomic<bool>[]> doc_ready_;
+
+    mutable std::mutex write_lock_;
+    size_t cur_documents_{0};
+    size_t cur_tokens_{0};
+
+    HierarchicalNSW<float> token_graph_;
+};
+
+}  // namespace hnswlib
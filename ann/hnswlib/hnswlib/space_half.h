@@ -0,0 +1,425 @@
+#pragma once
+#include "hnswlib.h"
+#include <stdint.h>
+
+// Half-precision (IEEE fp16) and bfloat16 vector storage.
+// Vectors are stored as 16-bit words, so queries have to be converted with
+// the same format before calling searchKnn / addPoint.
+// Distances are always accumulated in fp32.
+
+namespace hnswlib {
+
+typedef uint16_t fp16_t;
+typedef uint16_t bf16_t;
+
+static inline uint32_t float_bits(float f) {
+    uint32_t u;
+    memcpy(&u, &f, sizeof(u));
+    return u;
+}
+
+static inline float bits_float(uint32_t u) {
+    float f;
+    memcpy(&f, &u, sizeof(f));
+    return f;
+}
+
+static inline fp16_t fp32_to_fp16(float f) {
+    uint32_t x = float_bits(f);
+    uint32_t sign = (x >> 16) & 0x8000;
+    uint32_t mantissa = x & 0x007fffff;
+    int32_t exp = (int32_t)((x >> 23) & 0xff) - 127 + 15;
+
+    if (((x >> 23) & 0xff) == 0xff)  // inf / nan
+        return (fp16_t)(sign | 0x7c00 | (mantissa ? 0x200 : 0));
+    if (exp >= 0x1f)  // overflow
+        return (fp16_t)(sign | 0x7c00);
+    if (exp <= 0) {  // subnormal or zero
+        if (exp < -10)
+            return (fp16_t)sign;
+        mantissa |= 0x00800000;
+        uint32_t shift = (uint32_t)(14 - exp);
+        uint32_t half = mantissa >> shift;
+        uint32_t rem = mantissa & ((1u << shift) - 1);
+        uint32_t halfway = 1u << (shift - 1);
+        if (rem > halfway || (rem == halfway && (half & 1)))
+            half++;
+        return (fp16_t)(sign | half);
+    }
+    uint32_t half = sign | ((uint32_t)exp << 10) | (mantissa >> 13);
+    uint32_t rem = mantissa & 0x1fff;
+    if (rem > 0x1000 || (rem == 0x1000 && (half & 1)))
+        half++;  // may carry into the exponent, which rounds up to inf correctly
+    return (fp16_t)half;
+}
+
+static inline float fp16_to_fp32(fp16_t h) {
+    uint32_t sign = ((uint32_t)h & 0x8000) << 16;
+    uint32_t exp = (h >> 10) & 0x1f;
+    uint32_t mantissa = h & 0x3ff;
+
+    if (exp == 0x1f)
+        return bits_float(sign | 0x7f800000 | (mantissa << 13));
+    if (exp == 0) {
+        if (mantissa == 0)
+            return bits_float(sign);
+        // subnormal: normalise
+        exp = 1;
+        while (!(mantissa & 0x400)) {
+            mantissa <<= 1;
+            exp--;
+        }
+        mantissa &= 0x3ff;
+    }
+    return bits_float(sign | ((exp + 127 - 15) << 23) | (mantissa << 13));
+}
+
+static inline bf16_t fp32_to_bf16(float f) {
+    uint32_t x = float_bits(f);
+    if ((x & 0x7fffffff) > 0x7f800000)  // nan, keep it quiet
+        return (bf16_t)((x >> 16) | 0x40);
+    x += 0x7fff + ((x >> 16) & 1);  // round to nearest even
+    return (bf16_t)(x >> 16);
+}
+
+static inline float bf16_to_fp32(bf16_t h) {
+    return bits_float((uint32_t)h << 16);
+}
+
+static inline void fp32_to_fp16_array(const float *src, fp16_t *dst, size_t n) {
+    size_t i = 0;
+#if defined(USE_AVX) && defined(__F16C__)
+    for (; i + 8 <= n; i += 8)
+        _mm_storeu_si128((__m128i *)(dst + i), _mm256_cvtps_ph(_mm256_loadu_ps(src + i), _MM_FROUND_TO_NEAREST_INT));
+#endif
+    for (; i < n; i++)
+        dst[i] = fp32_to_fp16(src[i]);
+}
+
+static inline void fp32_to_bf16_array(const float *src, bf16_t *dst, size_t n) {
+    for (size_t i = 0; i < n; i++)
+        dst[i] = fp32_to_bf16(src[i]);
+}
+
+
+// Scalar fallbacks
+static float
+InnerProductFP16(const void *pVect1v, const void *pVect2v, const void *qty_ptr) {
+    const fp16_t *pVect1 = (const fp16_t *) pVect1v;
+    const fp16_t *pVect2 = (const fp16_t *) pVect2v;
+    size_t qty = *((size_t *) qty_ptr);
+    float res = 0;
+    for (size_t i = 0; i < qty; i++)
+        res += fp16_to_fp32(pVect1[i]) * fp16_to_fp32(pVect2[i]);
+    return res;
+}
+
+static float
+L2SqrFP16(const void *pVect1v, const void *pVect2v, const void *qty_ptr) {
+    const fp16_t *pVect1 = (const fp16_t *) pVect1v;
+    const fp16_t *pVect2 = (const fp16_t *) pVect2v;
+    size_t qty = *((size_t *) qty_ptr);
+    float res = 0;
+    for (size_t i = 0; i < qty; i++) {
+        float t = fp16_to_fp32(pVect1[i]) - fp16_to_fp32(pVect2[i]);
+        res += t * t;
+    }
+    return res;
+}
+
+static float
+InnerProductBF16(const void *pVect1v, const void *pVect2v, const void *qty_ptr) {
+    const bf16_t *pVect1 = (const bf16_t *) pVect1v;
+    const bf16_t *pVect2 = (const bf16_t *) pVect2v;
+    size_t qty = *((size_t *) qty_ptr);
+    float res = 0;
+    for (size_t i = 0; i < qty; i++)
+        res += bf16_to_fp32(pVect1[i]) * bf16_to_fp32(pVect2[i]);
+    return res;
+}
+
+static float
+L2SqrBF16(const void *pVect1v, const void *pVect2v, const void *qty_ptr) {
+    const bf16_t *pVect1 = (const bf16_t *) pVect1v;
+    const bf16_t *pVect2 = (const bf16_t *) pVect2v;
+    size_t qty = *((size_t *) qty_ptr);
+    float res = 0;
+    for (size_t i = 0; i < qty; i++) {
+        float t = bf16_to_fp32(pVect1[i]) - bf16_to_fp32(pVect2[i]);
+        res += t * t;
+    }
+    return res;
+}
+
+#if defined(USE_AVX) && defined(__F16C__)
+
+static inline float horizontal_sum256(__m256 v) {
+    __m128 s = _mm_add_ps(_mm256_extractf128_ps(v, 0), _mm256_extractf128_ps(v, 1));
+    s = _mm_hadd_ps(s, s);
+    s = _mm_hadd_ps(s, s);
+    return _mm_cvtss_f32(s);
+}
+
+// F16C widens 8 halves per instruction to fp32
+static float
+InnerProductFP16AVX(const void *pVect1v, const void *pVect2v, const void *qty_ptr) {
+    const fp16_t *pVect1 = (const fp16_t *) pVect1v;
+    const fp16_t *pVect2 = (const fp16_t *) pVect2v;
+    size_t qty = *((size_t *) qty_ptr);
+    size_t qty8 = qty >> 3 << 3;
+
+    __m256 sum = _mm256_set1_ps(0);
+    for (size_t i = 0; i < qty8; i += 8) {
+        __m256 v1 = _mm256_cvtph_ps(_mm_loadu_si128((const __m128i *)(pVect1 + i)));
+        __m256 v2 = _mm256_cvtph_ps(_mm_loadu_si128((const __m128i *)(pVect2 + i)));
+        sum = _mm256_add_ps(sum, _mm256_mul_ps(v1, v2));
+    }
+    float res = horizontal_sum256(sum);
+    for (size_t i = qty8; i < qty; i++)
+        res += fp16_to_fp32(pVect1[i]) * fp16_to_fp32(pVect2[i]);
+    return res;
+}
+
+static float
+L2SqrFP16AVX(const void *pVect1v, const void *pVect2v, const void *qty_ptr) {
+    const fp16_t *pVect1 = (const fp16_t *) pVect1v;
+    const fp16_t *pVect2 = (const fp16_t *) pVect2v;
+    size_t qty = *((size_t *) qty_ptr);
+    size_t qty8 = qty >> 3 << 3;
+
+    __m256 sum = _mm256_set1_ps(0);
+    for (size_t i = 0; i < qty8; i += 8) {
+        __m256 v1 = _mm256_cvtph_ps(_mm_loadu_si128((const __m128i *)(pVect1 + i)));
+        __m256 v2 = _mm256_cvtph_ps(_mm_loadu_si128((const __m128i *)(pVect2 + i)));
+        __m256 diff = _mm256_sub_ps(v1, v2);
+        sum = _mm256_add_ps(sum, _mm256_mul_ps(diff, diff));
+    }
+    float res = horizontal_sum256(sum);
+    for (size_t i = qty8; i < qty; i++) {
+        float t = fp16_to_fp32(pVect1[i]) - fp16_to_fp32(pVect2[i]);
+        res += t * t;
+    }
+    return res;
+}
+
+#endif
+
+#if defined(USE_AVX) && defined(__AVX2__)
+
+// bf16 is the upper half of an fp32, so widening is a zero-extend and a shift
+static inline __m256 bf16x8_to_ps(const bf16_t *p) {
+    __m256i w = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i *)p));
+    return _mm256_castsi256_ps(_mm256_slli_epi32(w, 16));
+}
+
+static float
+InnerProductBF16AVX2(const void *pVect1v, const void *pVect2v, const void *qty_ptr) {
+    const bf16_t *pVect1 = (const bf16_t *) pVect1v;
+    const bf16_t *pVect2 = (const bf16_t *) pVect2v;
+    size_t qty = *((size_t *) qty_ptr);
+    size_t qty8 = qty >> 3 << 3;
+
+    __m256 sum = _mm256_set1_ps(0);
+    for (size_t i = 0; i < qty8; i += 8)
+        sum = _mm256_add_ps(sum, _mm256_mul_ps(bf16x8_to_ps(pVect1 + i), bf16x8_to_ps(pVect2 + i)));
+    __m128 s = _mm_add_ps(_mm256_extractf128_ps(sum, 0), _mm256_extractf128_ps(sum, 1));
+    s = _mm_hadd_ps(s, s);
+    s = _mm_hadd_ps(s, s);
+    float res = _mm_cvtss_f32(s);
+    for (size_t i = qty8; i < qty; i++)
+        res += bf16_to_fp32(pVect1[i]) * bf16_to_fp32(pVect2[i]);
+    return res;
+}
+
+static float
+L2SqrBF16AVX2(const void *pVect1v, const void *pVect2v, const void *qty_ptr) {
+    const bf16_t *pVect1 = (const bf16_t *) pVect1v;
+    const bf16_t *pVect2 = (const bf16_t *) pVect2v;
+    size_t qty = *((size_t *) qty_ptr);
+    size_t qty8 = qty >> 3 << 3;
+
+    __m256 sum = _mm256_set1_ps(0);
+    for (size_t i = 0; i < qty8; i += 8) {
+        __m256 diff = _mm256_sub_ps(bf16x8_to_ps(pVect1 + i), bf16x8_to_ps(pVect2 + i));
+        sum = _mm256_add_ps(sum, _mm256_mul_ps(diff, diff));
+    }
+    __m128 s = _mm_add_ps(_mm256_extractf128_ps(sum, 0), _mm256_extractf128_ps(sum, 1));
+    s = _mm_hadd_ps(s, s);
+    s = _mm_hadd_ps(s, s);
+    float res = _mm_cvtss_f32(s);
+    for (size_t i = qty8; i < qty; i++) {
+        float t = bf16_to_fp32(pVect1[i]) - bf16_to_fp32(pVect2[i]);
+        res += t * t;
+    }
+    return res;
+}
+
+#endif
+
+#if defined(USE_AVX512) && defined(__AVX512BF16__)
+
+// vdpbf16ps: 32 bf16 products accumulated into 16 fp32 lanes per instruction
+static float
+InnerProductBF16AVX512(const void *pVect1v, const void *pVect2v, const void *qty_ptr) {
+    const bf16_t *pVect1 = (const bf16_t *) pVect1v;
+    const bf16_t *pVect2 = (const bf16_t *) pVect2v;
+    size_t qty = *((size_t *) qty_ptr);
+    size_t qty32 = qty >> 5 << 5;
+
+    __m512 sum = _mm512_setzero_ps();
+    for (size_t i = 0; i < qty32; i += 32) {
+        __m512i v1 = _mm512_loadu_si512((const void *)(pVect1 + i));
+        __m512i v2 = _mm512_loadu_si512((const void *)(pVect2 + i));
+        sum = _mm512_dpbf16_ps(sum, (__m512bh)v1, (__m512bh)v2);
+    }
+    float res = _mm512_reduce_add_ps(sum);
+    for (size_t i = qty32; i < qty; i++)
+        res += bf16_to_fp32(pVect1[i]) * bf16_to_fp32(pVect2[i]);
+    return res;
+}
+
+#endif
+
+static DISTFUNC<float> InnerProductFP16Ext = InnerProductFP16;
+static DISTFUNC<float> L2SqrFP16Ext = L2SqrFP16;
+static DISTFUNC<float> InnerProductBF16Ext = InnerProductBF16;
+static DISTFUNC<float> L2SqrBF16Ext = L2SqrBF16;
+
+static float
+InnerProductDistanceFP16(const void *pVect1v, const void *pVect2v, const void *qty_ptr) {
+    return 1.0f - InnerProductFP16Ext(pVect1v, pVect2v, qty_ptr);
+}
+
+static float
+InnerProductDistanceBF16(const void *pVect1v, const void *pVect2v, const void *qty_ptr) {
+    return 1.0f - InnerProductBF16Ext(pVect1v, pVect2v, qty_ptr);
+}
+
+static void select_half_kernels() {
+#if defined(USE_AVX) && defined(__F16C__)
+    if (AVXCapable()) {
+        InnerProductFP16Ext = InnerProductFP16AVX;
+        L2SqrFP16Ext = L2SqrFP16AVX;
+    }
+#endif
+#if defined(USE_AVX) && defined(__AVX2__)
+    if (AVXCapable()) {
+        InnerProductBF16Ext = InnerProductBF16AVX2;
+        L2SqrBF16Ext = L2SqrBF16AVX2;
+    }
+#endif
+#if defined(USE_AVX512) && defined(__AVX512BF16__)
+    if (AVX512Capable())
+        InnerProductBF16Ext = InnerProductBF16AVX512;
+#endif
+}
+
+
+class InnerProductSpaceFP16 : public SpaceInterface<float> {
+    size_t data_size_;
+    size_t dim_;
+
+ public:
+    InnerProductSpaceFP16(size_t dim) {
+        select_half_kernels();
+        dim_ = dim;
+        data_size_ = dim * sizeof(fp16_t);
+    }
+
+    size_t get_data_size() {
+        return data_size_;
+    }
+
+    DISTFUNC<float> get_dist_func() {
+        return InnerProductDistanceFP16;
+    }
+
+    void *get_dist_func_param() {
+        return &dim_;
+    }
+
+    ~InnerProductSpaceFP16() {}
+};
+
+
+class InnerProductSpaceBF16 : public SpaceInterface<float> {
+    size_t data_size_;
+    size_t dim_;
+
+ public:
+    InnerProductSpaceBF16(size_t dim) {
+        select_half_kernels();
+        dim_ = dim;
+        data_size_ = dim * sizeof(bf16_t);
+    }
+
+    size_t get_data_size() {
+        return data_size_;
+    }
+
+    DISTFUNC<float> get_dist_func() {
+        return InnerProductDistanceBF16;
+    }
+
+    void *get_dist_func_param() {
+        return &dim_;
+    }
+
+    ~InnerProductSpaceBF16() {}
+};
+
+
+class L2SpaceFP16 : public SpaceInterface<float> {
+    size_t data_size_;
+    size_t dim_;
+
+ public:
+    L2SpaceFP16(size_t dim) {
+        select_half_kernels();
+        dim_ = dim;
+        data_size_ = dim * sizeof(fp16_t);
+    }
+
+    size_t get_data_size() {
+        return data_size_;
+    }
+
+    DISTFUNC<float> get_dist_func() {
+        return L2SqrFP16Ext;
+    }
+
+    void *get_dist_func_param() {
+        return &dim_;
+    }
+
+    ~L2SpaceFP16() {}
+};
+
+
+class L2SpaceBF16 : public SpaceInterface<float> {
+    size_t data_size_;
+    size_t dim_;
+
+ public:
+    L2SpaceBF16(size_t dim) {
+        select_half_kernels();
+        dim_ = dim;
+        data_size_ = dim * sizeof(bf16_t);
+    }
+
+    size_t get_data_size() {
+        return data_size_;
+    }
+
+    DISTFUNC<float> get_dist_func() {
+        return L2SqrBF16Ext;
+    }
+
+    void *get_dist_func_param() {
+        return &dim_;
+    }
+
+    ~L2SpaceBF16() {}
+};
+
+}  // namespace hnswlib
@@ -339,14 +339,99 @@ InnerProductDistanceSIMD4ExtResiduals(const void *pVect1v, const void *pVect2v,
 }
 #endif
 
+// Batched kernels for flat scans, see L2SqrBatch
+static void
+InnerProductDistanceBatch(const void *query, const void *base, size_t count, const void *qty_ptr, float *out) {
+    size_t qty = *((size_t *) qty_ptr);
+    const float *q = (const float *) query;
+    const float *v = (const float *) base;
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4, v += 4 * qty) {
+        float s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+        for (size_t j = 0; j < qty; j++) {
+            s0 += v[j] * q[j];
+            s1 += v[qty + j] * q[j];
+            s2 += v[2 * qty + j] * q[j];
+            s3 += v[3 * qty + j] * q[j];
+        }
+        out[i] = 1.0f - s0;
+        out[i + 1] = 1.0f - s1;
+        out[i + 2] = 1.0f - s2;
+        out[i + 3] = 1.0f - s3;
+    }
+    for (; i < count; i++, v += qty)
+        out[i] = InnerProductDistance(q, v, qty_ptr);
+}
+
+#if defined(USE_AVX)
+static void
+InnerProductDistanceBatchAVX(const void *query, const void *base, size_t count, const void *qty_ptr, float *out) {
+    float PORTABLE_ALIGN32 TmpRes[8];
+    size_t qty = *((size_t *) qty_ptr);
+    size_t qty8 = qty >> 3 << 3;
+    const float *q = (const float *) query;
+    const float *v = (const float *) base;
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4, v += 4 * qty) {
+        __m256 s[4] = {_mm256_setzero_ps(), _mm256_setzero_ps(), _mm256_setzero_ps(), _mm256_setzero_ps()};
+        for (size_t j = 0; j < qty8; j += 8) {
+            __m256 vq = _mm256_loadu_ps(q + j);
+            for (int r = 0; r < 4; r++)
+                s[r] = _mm256_add_ps(s[r], _mm256_mul_ps(_mm256_loadu_ps(v + r * qty + j), vq));
+        }
+        for (int r = 0; r < 4; r++) {
+            _mm256_store_ps(TmpRes, s[r]);
+            float res = TmpRes[0] + TmpRes[1] + TmpRes[2] + TmpRes[3] +
+                        TmpRes[4] + TmpRes[5] + TmpRes[6] + TmpRes[7];
+            for (size_t j = qty8; j < qty; j++)
+                res += v[r * qty + j] * q[j];
+            out[i + r] = 1.0f - res;
+        }
+    }
+    for (; i < count; i++, v += qty)
+        out[i] = InnerProductDistance(q, v, qty_ptr);
+}
+#endif
+
+#if defined(USE_SSE)
+static void
+InnerProductDistanceBatchSSE(const void *query, const void *base, size_t count, const void *qty_ptr, float *out) {
+    float PORTABLE_ALIGN32 TmpRes[8];
+    size_t qty = *((size_t *) qty_ptr);
+    size_t qty4 = qty >> 2 << 2;
+    const float *q = (const float *) query;
+    const float *v = (const float *) base;
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4, v += 4 * qty) {
+        __m128 s[4] = {_mm_setzero_ps(), _mm_setzero_ps(), _mm_setzero_ps(), _mm_setzero_ps()};
+        for (size_t j = 0; j < qty4; j += 4) {
+            __m128 vq = _mm_loadu_ps(q + j);
+            for (int r = 0; r < 4; r++)
+                s[r] = _mm_add_ps(s[r], _mm_mul_ps(_mm_loadu_ps(v + r * qty + j), vq));
+        }
+        for (int r = 0; r < 4; r++) {
+            _mm_store_ps(TmpRes, s[r]);
+            float res = TmpRes[0] + TmpRes[1] + TmpRes[2] + TmpRes[3];
+            for (size_t j = qty4; j < qty; j++)
+                res += v[r * qty + j] * q[j];
+            out[i + r] = 1.0f - res;
+        }
+    }
+    for (; i < count; i++, v += qty)
+        out[i] = InnerProductDistance(q, v, qty_ptr);
+}
+#endif
+
 class InnerProductSpace : public SpaceInterface<float> {
     DISTFUNC<float> fstdistfunc_;
+    BATCHDISTFUNC<float> fstdistfunc_batch_;
     size_t data_size_;
     size_t dim_;
 
  public:
     InnerProductSpace(size_t dim) {
         fstdistfunc_ = InnerProductDistance;
+        fstdistfunc_batch_ = InnerProductDistanceBatch;
 #if defined(USE_AVX) || defined(USE_SSE) || defined(USE_AVX512)
     #if defined(USE_AVX512)
         if (AVX512Capable()) {
@@ -377,6 +462,12 @@ class InnerProductSpace : public SpaceInterface<float> {
             fstdistfunc_ = InnerProductDistanceSIMD16ExtResiduals;
         else if (dim > 4)
             fstdistfunc_ = InnerProductDistanceSIMD4ExtResiduals;
+
+        fstdistfunc_batch_ = InnerProductDistanceBatchSSE;
+    #if defined(USE_AVX)
+        if (AVXCapable())
+            fstdistfunc_batch_ = InnerProductDistanceBatchAVX;
+    #endif
 #endif
         dim_ = dim;
         data_size_ = dim * sizeof(float);
@@ -390,6 +481,10 @@ class InnerProductSpace : public SpaceInterface<float> {
         return fstdistfunc_;
     }
 
+    BATCHDISTFUNC<float> get_batch_dist_func() {
+        return fstdistfunc_batch_;
+    }
+
     void *get_dist_func_param() {
         return &dim_;
     }
@@ -205,14 +205,112 @@ L2SqrSIMD4ExtResiduals(const void *pVect1v, const void *pVect2v, const void *qty
 }
 #endif
 
+// Batched kernels for flat scans: four base vectors per pass share each load
+// of the query, and there is one indirect call per tile instead of per vector.
+static void
+L2SqrBatch(const void *query, const void *base, size_t count, const void *qty_ptr, float *out) {
+    size_t qty = *((size_t *) qty_ptr);
+    const float *q = (const float *) query;
+    const float *v = (const float *) base;
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4, v += 4 * qty) {
+        float s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+        for (size_t j = 0; j < qty; j++) {
+            float t0 = v[j] - q[j];
+            float t1 = v[qty + j] - q[j];
+            float t2 = v[2 * qty + j] - q[j];
+            float t3 = v[3 * qty + j] - q[j];
+            s0 += t0 * t0;
+            s1 += t1 * t1;
+            s2 += t2 * t2;
+            s3 += t3 * t3;
+        }
+        out[i] = s0;
+        out[i + 1] = s1;
+        out[i + 2] = s2;
+        out[i + 3] = s3;
+    }
+    for (; i < count; i++, v += qty)
+        out[i] = L2Sqr(q, v, qty_ptr);
+}
+
+#if defined(USE_AVX)
+static void
+L2SqrBatchAVX(const void *query, const void *base, size_t count, const void *qty_ptr, float *out) {
+    float PORTABLE_ALIGN32 TmpRes[8];
+    size_t qty = *((size_t *) qty_ptr);
+    size_t qty8 = qty >> 3 << 3;
+    const float *q = (const float *) query;
+    const float *v = (const float *) base;
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4, v += 4 * qty) {
+        __m256 s[4] = {_mm256_setzero_ps(), _mm256_setzero_ps(), _mm256_setzero_ps(), _mm256_setzero_ps()};
+        for (size_t j = 0; j < qty8; j += 8) {
+            __m256 vq = _mm256_loadu_ps(q + j);
+            for (int r = 0; r < 4; r++) {
+                __m256 diff = _mm256_sub_ps(_mm256_loadu_ps(v + r * qty + j), vq);
+                s[r] = _mm256_add_ps(s[r], _mm256_mul_ps(diff, diff));
+            }
+        }
+        for (int r = 0; r < 4; r++) {
+            _mm256_store_ps(TmpRes, s[r]);
+            float res = TmpRes[0] + TmpRes[1] + TmpRes[2] + TmpRes[3] +
+                        TmpRes[4] + TmpRes[5] + TmpRes[6] + TmpRes[7];
+            for (size_t j = qty8; j < qty; j++) {
+                float t = v[r * qty + j] - q[j];
+                res += t * t;
+            }
+            out[i + r] = res;
+        }
+    }
+    for (; i < count; i++, v += qty)
+        out[i] = L2Sqr(q, v, qty_ptr);
+}
+#endif
+
+#if defined(USE_SSE)
+static void
+L2SqrBatchSSE(const void *query, const void *base, size_t count, const void *qty_ptr, float *out) {
+    float PORTABLE_ALIGN32 TmpRes[8];
+    size_t qty = *((size_t *) qty_ptr);
+    size_t qty4 = qty >> 2 << 2;
+    const float *q = (const float *) query;
+    const float *v = (const float *) base;
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4, v += 4 * qty) {
+        __m128 s[4] = {_mm_setzero_ps(), _mm_setzero_ps(), _mm_setzero_ps(), _mm_setzero_ps()};
+        for (size_t j = 0; j < qty4; j += 4) {
+            __m128 vq = _mm_loadu_ps(q + j);
+            for (int r = 0; r < 4; r++) {
+                __m128 diff = _mm_sub_ps(_mm_loadu_ps(v + r * qty + j), vq);
+                s[r] = _mm_add_ps(s[r], _mm_mul_ps(diff, diff));
+            }
+        }
+        for (int r = 0; r < 4; r++) {
+            _mm_store_ps(TmpRes, s[r]);
+            float res = TmpRes[0] + TmpRes[1] + TmpRes[2] + TmpRes[3];
+            for (size_t j = qty4; j < qty; j++) {
+                float t = v[r * qty + j] - q[j];
+                res += t * t;
+            }
+            out[i + r] = res;
+        }
+    }
+    for (; i < count; i++, v += qty)
+        out[i] = L2Sqr(q, v, qty_ptr);
+}
+#endif
+
 class L2Space : public SpaceInterface<float> {
     DISTFUNC<float> fstdistfunc_;
+    BATCHDISTFUNC<float> fstdistfunc_batch_;
     size_t data_size_;
     size_t dim_;
 
  public:
     L2Space(size_t dim) {
         fstdistfunc_ = L2Sqr;
+        fstdistfunc_batch_ = L2SqrBatch;
 #if defined(USE_SSE) || defined(USE_AVX) || defined(USE_AVX512)
     #if defined(USE_AVX512)
         if (AVX512Capable())
@@ -232,6 +330,12 @@ class L2Space : public SpaceInterface<float> {
             fstdistfunc_ = L2SqrSIMD16ExtResiduals;
         else if (dim > 4)
             fstdistfunc_ = L2SqrSIMD4ExtResiduals;
+
+        fstdistfunc_batch_ = L2SqrBatchSSE;
+    #if defined(USE_AVX)
+        if (AVXCapable())
+            fstdistfunc_batch_ = L2SqrBatchAVX;
+    #endif
 #endif
         dim_ = dim;
         data_size_ = dim * sizeof(float);
@@ -245,6 +349,10 @@ class L2Space : public SpaceInterface<float> {
         return fstdistfunc_;
     }
 
+    BATCHDISTFUNC<float> get_batch_dist_func() {
+        return fstdistfunc_batch_;
+    }
+
     void *get_dist_func_param() {
         return &dim_;
     }
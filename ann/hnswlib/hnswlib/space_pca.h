@@ -0,0 +1,303 @@
+#pragma once
+#include "hnswlib.h"
+#include <cmath>
+#include <algorithm>
+#include <stdexcept>
+
+// PCA-rotated spaces with early-abandoning distances.
+//
+// Vectors are rotated so that dimensions come in decreasing variance order and
+// stored as [rotated vector (dim floats)][tail norms (num_checkpoints floats)],
+// where tail norm c is the L2 norm of the dimensions after checkpoint c.
+// Queries must go through the same transform() before searching.
+//
+// The bounded distance evaluates the vector checkpoint by checkpoint and
+// stops as soon as a lower bound on the full distance exceeds the caller's
+// bound (the current top-ef threshold):
+//   IP: 1 - <q, x> >= 1 - partial - |q_tail| * |x_tail|   (Cauchy-Schwarz)
+//   L2: |q - x|^2  >= partial + (|q_tail| - |x_tail|)^2
+// With tail_scale = 1 the bound is exact; tail_scale < 1 shrinks the
+// Cauchy-Schwarz slack and trades a little recall for earlier abandoning,
+// in the spirit of ADSampling.
+
+namespace hnswlib {
+
+struct PcaDistParam {
+    size_t dim;  // must stay first: getDataByLabel reads it as the dimension
+    size_t step;
+    size_t num_checkpoints;
+    float tail_scale;
+};
+
+// Partial sums over [begin, end) reuse the SIMD kernels of space_ip.h /
+// space_l2.h: 16-float blocks, then 4-float blocks, then a scalar tail.
+static inline float pca_partial_ip(const float *a, const float *b, size_t begin, size_t end) {
+    float res = 0;
+#if defined(USE_SSE)
+    size_t qty16 = (end - begin) >> 4 << 4;
+    if (qty16) {
+        res += InnerProductSIMD16Ext(a + begin, b + begin, &qty16);
+        begin += qty16;
+    }
+    size_t qty4 = (end - begin) >> 2 << 2;
+    if (qty4) {
+        res += InnerProductSIMD4Ext(a + begin, b + begin, &qty4);
+        begin += qty4;
+    }
+#endif
+    for (size_t i = begin; i < end; i++)
+        res += a[i] * b[i];
+    return res;
+}
+
+static inline float pca_partial_l2(const float *a, const float *b, size_t begin, size_t end) {
+    float res = 0;
+#if defined(USE_SSE)
+    size_t qty16 = (end - begin) >> 4 << 4;
+    if (qty16) {
+        res += L2SqrSIMD16Ext(a + begin, b + begin, &qty16);
+        begin += qty16;
+    }
+    size_t qty4 = (end - begin) >> 2 << 2;
+    if (qty4) {
+        res += L2SqrSIMD4Ext(a + begin, b + begin, &qty4);
+        begin += qty4;
+    }
+#endif
+    for (size_t i = begin; i < end; i++) {
+        float t = a[i] - b[i];
+        res += t * t;
+    }
+    return res;
+}
+
+static float
+PcaInnerProductDistance(const void *pVect1v, const void *pVect2v, const void *param_ptr) {
+    const PcaDistParam *param = (const PcaDistParam *) param_ptr;
+    return 1.0f - pca_partial_ip((const float *) pVect1v, (const float *) pVect2v, 0, param->dim);
+}
+
+static float
+PcaInnerProductDistanceBounded(const void *pVect1v, const void *pVect2v, const void *param_ptr, float bound) {
+    const PcaDistParam *param = (const PcaDistParam *) param_ptr;
+    const float *q = (const float *) pVect1v;
+    const float *x = (const float *) pVect2v;
+    const float *q_tail = q + param->dim;
+    const float *x_tail = x + param->dim;
+
+    float acc = 0;
+    size_t begin = 0;
+    for (size_t c = 0; c < param->num_checkpoints; c++) {
+        size_t end = begin + param->step;
+        acc += pca_partial_ip(q, x, begin, end);
+        float lower = 1.0f - acc - param->tail_scale * q_tail[c] * x_tail[c];
+        if (lower > bound)
+            return lower;
+        begin = end;
+    }
+    acc += pca_partial_ip(q, x, begin, param->dim);
+    return 1.0f - acc;
+}
+
+static float
+PcaL2Sqr(const void *pVect1v, const void *pVect2v, const void *param_ptr) {
+    const PcaDistParam *param = (const PcaDistParam *) param_ptr;
+    return pca_partial_l2((const float *) pVect1v, (const float *) pVect2v, 0, param->dim);
+}
+
+static float
+PcaL2SqrBounded(const void *pVect1v, const void *pVect2v, const void *param_ptr, float bound) {
+    const PcaDistParam *param = (const PcaDistParam *) param_ptr;
+    const float *q = (const float *) pVect1v;
+    const float *x = (const float *) pVect2v;
+    const float *q_tail = q + param->dim;
+    const float *x_tail = x + param->dim;
+
+    float acc = 0;
+    size_t begin = 0;
+    for (size_t c = 0; c < param->num_checkpoints; c++) {
+        size_t end = begin + param->step;
+        acc += pca_partial_l2(q, x, begin, end);
+        float t = q_tail[c] - x_tail[c];
+        float lower = acc + param->tail_scale * t * t;
+        if (lower > bound)
+            return lower;
+        begin = end;
+    }
+    return acc + pca_partial_l2(q, x, begin, param->dim);
+}
+
+
+class PcaRotatedSpace : public SpaceInterface<float> {
+    DISTFUNC<float> fstdistfunc_;
+    BOUNDEDDISTFUNC<float> fstdistfunc_bounded_;
+    size_t data_size_;
+    PcaDistParam param_;
+    std::vector<float> rotation_;  // row i = i-th principal axis
+    std::vector<float> variance_;
+
+ public:
+    /*
+    * Fits PCA on `sample` (n x dim, row major). The data is not centred, so the
+    * rotation is orthogonal and both IP and L2 distances are preserved exactly.
+    */
+    PcaRotatedSpace(size_t dim, const float *sample, size_t n, bool ip = true,
+                    size_t step = 16, float tail_scale = 1.0f) {
+        if (step == 0 || step > dim)
+            step = dim;
+        param_.dim = dim;
+        param_.step = step;
+        param_.num_checkpoints = (dim - 1) / step;
+        param_.tail_scale = tail_scale;
+        data_size_ = (dim + param_.num_checkpoints) * sizeof(float);
+        if (ip) {
+            fstdistfunc_ = PcaInnerProductDistance;
+            fstdistfunc_bounded_ = PcaInnerProductDistanceBounded;
+        } else {
+            fstdistfunc_ = PcaL2Sqr;
+            fstdistfunc_bounded_ = PcaL2SqrBounded;
+        }
+#if defined(USE_SSE)
+    #if defined(USE_AVX512)
+        if (AVX512Capable()) {
+            InnerProductSIMD16Ext = InnerProductSIMD16ExtAVX512;
+            L2SqrSIMD16Ext = L2SqrSIMD16ExtAVX512;
+        } else if (AVXCapable()) {
+            InnerProductSIMD16Ext = InnerProductSIMD16ExtAVX;
+            L2SqrSIMD16Ext = L2SqrSIMD16ExtAVX;
+        }
+    #elif defined(USE_AVX)
+        if (AVXCapable()) {
+            InnerProductSIMD16Ext = InnerProductSIMD16ExtAVX;
+            L2SqrSIMD16Ext = L2SqrSIMD16ExtAVX;
+        }
+    #endif
+    #if defined(USE_AVX)
+        if (AVXCapable())
+            InnerProductSIMD4Ext = InnerProductSIMD4ExtAVX;
+    #endif
+#endif
+        fit(sample, n);
+    }
+
+    // Rotates `in` (dim floats) into the stored layout (get_data_size() bytes)
+    void transform(const float *in, float *out) const {
+        size_t dim = param_.dim;
+        for (size_t i = 0; i < dim; i++) {
+            const float *axis = rotation_.data() + i * dim;
+            float v = 0;
+            for (size_t j = 0; j < dim; j++)
+                v += axis[j] * in[j];
+            out[i] = v;
+        }
+        float tail = 0;
+        float *tails = out + dim;
+        size_t c = param_.num_checkpoints;
+        for (size_t i = dim; i-- > 0;) {
+            tail += out[i] * out[i];
+            if (c > 0 && i == c * param_.step) {
+                tails[c - 1] = std::sqrt(tail);
+                c--;
+            }
+        }
+    }
+
+    void set_tail_scale(float tail_scale) {
+        param_.tail_scale = tail_scale;
+    }
+
+    const std::vector<float> &get_variance() const {
+        return variance_;
+    }
+
+    size_t get_data_size() {
+        return data_size_;
+    }
+
+    DISTFUNC<float> get_dist_func() {
+        return fstdistfunc_;
+    }
+
+    BOUNDEDDISTFUNC<float> get_bounded_dist_func() {
+        return fstdistfunc_bounded_;
+    }
+
+    void *get_dist_func_param() {
+        return &param_;
+    }
+
+    ~PcaRotatedSpace() {}
+
+ private:
+    // Covariance (second moment) + cyclic Jacobi eigendecomposition
+    void fit(const float *sample, size_t n) {
+        size_t dim = param_.dim;
+        std::vector<double> cov(dim * dim, 0);
+        for (size_t k = 0; k < n; k++) {
+            const float *x = sample + k * dim;
+            for (size_t i = 0; i < dim; i++)
+                for (size_t j = i; j < dim; j++)
+                    cov[i * dim + j] += (double) x[i] * x[j];
+        }
+        for (size_t i = 0; i < dim; i++)
+            for (size_t j = i; j < dim; j++)
+                cov[j * dim + i] = cov[i * dim + j] /= std::max<size_t>(n, 1);
+
+        std::vector<double> vec(dim * dim, 0);
+        for (size_t i = 0; i < dim; i++)
+            vec[i * dim + i] = 1;
+
+        for (int sweep = 0; sweep < 50; sweep++) {
+            double off = 0;
+            for (size_t i = 0; i < dim; i++)
+                for (size_t j = i + 1; j < dim; j++)
+                    off += cov[i * dim + j] * cov[i * dim + j];
+            if (off < 1e-18)
+                break;
+
+            for (size_t p = 0; p < dim; p++) {
+                for (size_t q = p + 1; q < dim; q++) {
+                    double apq = cov[p * dim + q];
+                    if (std::fabs(apq) < 1e-30)
+                        continue;
+                    double theta = (cov[q * dim + q] - cov[p * dim + p]) / (2 * apq);
+                    double t = (theta >= 0 ? 1 : -1) / (std::fabs(theta) + std::sqrt(theta * theta + 1));
+                    double c = 1 / std::sqrt(t * t + 1), s = t * c;
+                    for (size_t k = 0; k < dim; k++) {
+                        double akp = cov[k * dim + p], akq = cov[k * dim + q];
+                        cov[k * dim + p] = c * akp - s * akq;
+                        cov[k * dim + q] = s * akp + c * akq;
+                    }
+                    for (size_t k = 0; k < dim; k++) {
+                        double apk = cov[p * dim + k], aqk = cov[q * dim + k];
+                        cov[p * dim + k] = c * apk - s * aqk;
+                        cov[q * dim + k] = s * apk + c * aqk;
+                    }
+                    for (size_t k = 0; k < dim; k++) {
+                        double vkp = vec[k * dim + p], vkq = vec[k * dim + q];
+                        vec[k * dim + p] = c * vkp - s * vkq;
+                        vec[k * dim + q] = s * vkp + c * vkq;
+                    }
+                }
+            }
+        }
+
+        std::vector<size_t> order(dim);
+        for (size_t i = 0; i < dim; i++)
+            order[i] = i;
+        std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+            return cov[a * dim + a] > cov[b * dim + b];
+        });
+
+        rotation_.assign(dim * dim, 0);
+        variance_.assign(dim, 0);
+        for (size_t i = 0; i < dim; i++) {
+            size_t col = order[i];
+            variance_[i] = (float) cov[col * dim + col];
+            for (size_t j = 0; j < dim; j++)
+                rotation_[i * dim + j] = (float) vec[j * dim + col];
+        }
+    }
+};
+
+}  // namespace hnswlib
@@ -3,6 +3,7 @@
 #include "space_ip.h"
 #include <assert.h>
 #include <unordered_map>
+#include <functional>
 
 namespace hnswlib {
 
@@ -115,6 +116,7 @@ class MultiVectorInnerProductSpace : public BaseMultiVectorSpace<DOCIDTYPE> {
         else if (dim > 4)
             fstdistfunc_ = InnerProductDistanceSIMD4ExtResiduals;
 #endif
+        dim_ = dim;
         vector_size_ = dim * sizeof(float);
         data_size_ = vector_size_ + sizeof(DOCIDTYPE);
     }
@@ -273,4 +275,38 @@ class EpsilonSearchStopCondition : public BaseSearchStopCondition<dist_t> {
 
     ~EpsilonSearchStopCondition() {}
 };
+// Bounded-memory sink for searchRange: matches are collected in a buffer of
+// chunk_size entries and each full chunk is handed to `consume`, which
+// returns false to stop the search. Call finish() afterwards for the rest.
+template<typename dist_t>
+class RangeChunkBuffer : public BaseRangeCallback<dist_t> {
+    size_t chunk_size_;
+    std::function<bool(const std::vector<std::pair<dist_t, labeltype>> &)> consume_;
+    std::vector<std::pair<dist_t, labeltype>> chunk_;
+
+ public:
+    RangeChunkBuffer(
+        size_t chunk_size,
+        std::function<bool(const std::vector<std::pair<dist_t, labeltype>> &)> consume)
+        : chunk_size_(std::max<size_t>(chunk_size, 1)), consume_(consume) {
+        chunk_.reserve(chunk_size_);
+    }
+
+    bool operator()(labeltype label, dist_t dist) override {
+        chunk_.emplace_back(dist, label);
+        if (chunk_.size() < chunk_size_)
+            return true;
+        bool more = consume_(chunk_);
+        chunk_.clear();
+        return more;
+    }
+
+    bool finish() {
+        if (chunk_.empty())
+            return true;
+        bool more = consume_(chunk_);
+        chunk_.clear();
+        return more;
+    }
+};
 }  // namespace hnswlib
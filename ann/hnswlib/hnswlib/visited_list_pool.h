@@ -1,8 +1,11 @@
 #pragma once
 
 #include <mutex>
+#include <condition_variable>
 #include <string.h>
 #include <deque>
+#include <stdexcept>
+#include "huge_alloc.h"
 
 namespace hnswlib {
 typedef unsigned short int vl_type;
@@ -13,10 +16,12 @@ class VisitedList {
     vl_type *mass;
     unsigned int numelements;
 
-    VisitedList(int numelements1) {
+    VisitedList(int numelements1, HugePageMode huge_pages = HUGEPAGE_OFF) {
         curV = -1;
         numelements = numelements1;
-        mass = new vl_type[numelements];
+        mass = (vl_type *) huge_malloc(sizeof(vl_type) * numelements, huge_pages);
+        if (mass == nullptr)
+            throw std::runtime_error("Not enough memory: VisitedList failed to allocate");
     }
 
     void reset() {
@@ -27,7 +32,7 @@ class VisitedList {
         }
     }
 
-    ~VisitedList() { delete[] mass; }
+    ~VisitedList() { huge_free(mass); }
 };
 ///////////////////////////////////////////////////////////
 //
@@ -35,16 +40,23 @@ class VisitedList {
 //
 /////////////////////////////////////////////////////////
 
+class VisitedListLease;
+
 class VisitedListPool {
     std::deque<VisitedList *> pool;
     std::mutex poolguard;
+    std::condition_variable released;
     int numelements;
+    HugePageMode huge_pages;
+    size_t in_use{0};
+    size_t in_use_short{0};  // lists handed out before the last grow()
 
  public:
-    VisitedListPool(int initmaxpools, int numelements1) {
+    VisitedListPool(int initmaxpools, int numelements1, HugePageMode huge_pages1 = HUGEPAGE_OFF) {
         numelements = numelements1;
+        huge_pages = huge_pages1;
         for (int i = 0; i < initmaxpools; i++)
-            pool.push_front(new VisitedList(numelements));
+            pool.push_front(new VisitedList(numelements, huge_pages));
     }
 
     VisitedList *getFreeVisitedList() {
@@ -55,8 +67,9 @@ class VisitedListPool {
                 rez = pool.front();
                 pool.pop_front();
             } else {
-                rez = new VisitedList(numelements);
+                rez = new VisitedList(numelements, huge_pages);
             }
+            in_use++;
         }
         rez->reset();
         return rez;
@@ -64,9 +77,38 @@ class VisitedListPool {
 
     void releaseVisitedList(VisitedList *vl) {
         std::unique_lock <std::mutex> lock(poolguard);
+        in_use--;
+        if ((int) vl->numelements < numelements) {
+            delete vl;
+            in_use_short--;
+            released.notify_all();
+            return;
+        }
         pool.push_front(vl);
     }
 
+    // Makes new lists numelements1 long. Lists already handed out keep their
+    // old length, so this waits until all of them have been released: ids
+    // past that length may only appear once nobody is still using one.
+    // A thread that holds a list itself (through a VisitedListLease) would
+    // wait forever, so that throws (with nothing changed) instead.
+    void grow(int numelements1) {
+        std::unique_lock <std::mutex> lock(poolguard);
+        if (numelements1 <= numelements)
+            return;
+        if (heldByCurrentThread())
+            throw std::runtime_error("Cannot grow the visited list pool from a thread that holds a visited list");
+        numelements = numelements1;
+        while (pool.size()) {
+            delete pool.front();
+            pool.pop_front();
+        }
+        in_use_short = in_use;
+        released.wait(lock, [this]() { return in_use_short == 0; });
+    }
+
+    inline bool heldByCurrentThread() const;
+
     ~VisitedListPool() {
         while (pool.size()) {
             VisitedList *rez = pool.front();
@@ -75,4 +117,45 @@ class VisitedListPool {
         }
     }
 };
+
+
+// Holds a list from the pool for one search and returns it even when a
+// filter or stop condition throws, so grow() is never left waiting for it.
+// The leases of a thread form a stack (nested searches, e.g. from a filter),
+// linked through a thread_local top so grow() can find them without a lock.
+class VisitedListLease {
+    VisitedListPool &pool_;
+    VisitedListLease *prev_;
+
+ public:
+    VisitedList *const list;
+
+    explicit VisitedListLease(VisitedListPool &pool) : pool_(pool), prev_(top()), list(pool.getFreeVisitedList()) {
+        top() = this;
+    }
+    VisitedListLease(const VisitedListLease &) = delete;
+    VisitedListLease &operator=(const VisitedListLease &) = delete;
+    ~VisitedListLease() {
+        top() = prev_;
+        pool_.releaseVisitedList(list);
+    }
+
+    static VisitedListLease *&top() {
+        static thread_local VisitedListLease *top = nullptr;
+        return top;
+    }
+
+    static bool held(const VisitedListPool &pool) {
+        for (VisitedListLease *lease = top(); lease != nullptr; lease = lease->prev_) {
+            if (&lease->pool_ == &pool)
+                return true;
+        }
+        return false;
+    }
+};
+
+
+bool VisitedListPool::heldByCurrentThread() const {
+    return VisitedListLease::held(*this);
+}
 }  // namespace hnswlib
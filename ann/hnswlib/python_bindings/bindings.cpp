@@ -6,6 +6,9 @@
 #include "hnswlib.h"
 #include <thread>
 #include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <memory>
 #include <stdlib.h>
 #include <assert.h>
 
@@ -74,6 +77,117 @@ inline void ParallelFor(size_t start, size_t end, size_t numThreads, Function fn
 }
 
 
+/*
+ * Persistent counterpart of ParallelFor: worker threads are started once and
+ * parked between calls, so even a batch of a few queries can be spread over
+ * all cores without paying thread start-up on every call.
+ * The calling thread takes part as threadId 0. Not reentrant.
+ */
+class WorkerPool {
+ public:
+    explicit WorkerPool(size_t numThreads) : numThreads_(numThreads > 0 ? numThreads : 1) {
+        for (size_t threadId = 1; threadId < numThreads_; ++threadId) {
+            workers_.push_back(std::thread([this, threadId] { workerLoop(threadId); }));
+        }
+    }
+
+    ~WorkerPool() {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        wakeCv_.notify_all();
+        for (auto &thread : workers_) {
+            thread.join();
+        }
+    }
+
+    size_t size() const { return numThreads_; }
+
+    template<class Function>
+    void parallelFor(size_t start, size_t end, Function fn) {
+        if (numThreads_ == 1 || end - start <= 1) {
+            for (size_t id = start; id < end; id++) {
+                fn(id, 0);
+            }
+            return;
+        }
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            job_ = [&fn](size_t id, size_t threadId) { fn(id, threadId); };
+            current_ = start;
+            end_ = end;
+            lastException_ = nullptr;
+            active_ = numThreads_ - 1;
+            generation_++;
+        }
+        wakeCv_.notify_all();
+        run(0);
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        doneCv_.wait(lock, [this] { return active_ == 0; });
+        job_ = nullptr;
+        if (lastException_) {
+            std::exception_ptr e = lastException_;
+            lastException_ = nullptr;
+            std::rethrow_exception(e);
+        }
+    }
+
+ private:
+    void run(size_t threadId) {
+        while (true) {
+            size_t id = current_.fetch_add(1);
+            if (id >= end_) {
+                break;
+            }
+            try {
+                job_(id, threadId);
+            } catch (...) {
+                std::unique_lock<std::mutex> lock(mutex_);
+                lastException_ = std::current_exception();
+                current_ = end_;
+                break;
+            }
+        }
+    }
+
+    void workerLoop(size_t threadId) {
+        size_t seen = 0;
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                wakeCv_.wait(lock, [&] { return stop_ || generation_ != seen; });
+                if (stop_) {
+                    return;
+                }
+                seen = generation_;
+            }
+            run(threadId);
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                if (--active_ == 0) {
+                    doneCv_.notify_one();
+                }
+            }
+        }
+    }
+
+    size_t numThreads_;
+    std::vector<std::thread> workers_;
+    std::mutex mutex_;
+    std::condition_variable wakeCv_;
+    std::condition_variable doneCv_;
+    std::function<void(size_t, size_t)> job_;
+    std::atomic<size_t> current_{0};
+    size_t end_ = 0;
+    size_t active_ = 0;
+    size_t generation_ = 0;
+    bool stop_ = false;
+    std::exception_ptr lastException_ = nullptr;
+};
+
+
 inline void assert_true(bool expr, const std::string & msg) {
     if (expr == false) throw std::runtime_error("Unpickle Error: " + msg);
     return;
@@ -160,6 +274,11 @@ class Index {
     hnswlib::HierarchicalNSW<dist_t>* appr_alg;
     hnswlib::SpaceInterface<float>* l2space;
 
+    // reused by knnQuery_into across calls
+    std::unique_ptr<WorkerPool> query_pool;
+    std::mutex query_pool_lock;
+    std::vector<float> query_scratch;  // per-thread normalized query buffers
+
 
     Index(const std::string &space_name, const int dim) : space_name(space_name), dim(dim) {
         normalize = false;
@@ -364,7 +483,7 @@ class Index {
 
         char* data_level0_npy = (char*)malloc(level0_npy_size);
         char* link_list_npy = (char*)malloc(link_npy_size);
-        int* element_levels_npy = (int*)malloc(appr_alg->element_levels_.size() * sizeof(int));
+        int* element_levels_npy = (int*)malloc(appr_alg->max_elements_ * sizeof(int));
 
         hnswlib::labeltype* label_lookup_key_npy = (hnswlib::labeltype*)malloc(appr_alg->label_lookup_.size() * sizeof(hnswlib::labeltype));
         hnswlib::tableint* label_lookup_val_npy = (hnswlib::tableint*)malloc(appr_alg->label_lookup_.size() * sizeof(hnswlib::tableint));
@@ -381,8 +500,13 @@ class Index {
 
         memset(link_list_npy, 0, link_npy_size);
 
-        memcpy(data_level0_npy, appr_alg->data_level0_memory_, level0_npy_size);
-        memcpy(element_levels_npy, appr_alg->element_levels_.data(), appr_alg->element_levels_.size() * sizeof(int));
+        char* level0_out = data_level0_npy;
+        appr_alg->data_level0_memory_.forEachRun(appr_alg->cur_element_count, [&](const char* records, size_t n) {
+            memcpy(level0_out, records, n * appr_alg->size_data_per_element_);
+            level0_out += n * appr_alg->size_data_per_element_;
+        });
+        for (size_t i = 0; i < appr_alg->max_elements_; i++)
+            element_levels_npy[i] = appr_alg->element_levels_[i];
 
         for (size_t i = 0; i < appr_alg->cur_element_count; i++) {
             size_t linkListSize = appr_alg->element_levels_[i] > 0 ? appr_alg->size_links_per_element_ * appr_alg->element_levels_[i] : 0;
@@ -442,7 +566,7 @@ class Index {
                 free_when_done_id),
 
             "element_levels"_a = py::array_t<int>(
-                { appr_alg->element_levels_.size() },  // shape
+                { appr_alg->max_elements_ },  // shape
                 { sizeof(int) },  // C-style contiguous strides for each index
                 element_levels_npy,  // the data pointer
                 free_when_done_lvl),
@@ -562,7 +686,8 @@ class Index {
             }
         }
 
-        memcpy(appr_alg->element_levels_.data(), element_levels_npy.data(), element_levels_npy.nbytes());
+        for (size_t i = 0; i < (size_t) element_levels_npy.size(); i++)
+            appr_alg->element_levels_[i] = element_levels_npy.data()[i];
 
         size_t link_npy_size = 0;
         std::vector<size_t> link_npy_offsets(appr_alg->cur_element_count);
@@ -574,7 +699,11 @@ class Index {
                 link_npy_size += linkListSize;
         }
 
-        memcpy(appr_alg->data_level0_memory_, data_level0_npy.data(), data_level0_npy.nbytes());
+        const char* level0_in = data_level0_npy.data();
+        appr_alg->data_level0_memory_.forEachRun(appr_alg->cur_element_count, [&](char* records, size_t n) {
+            memcpy(records, level0_in, n * appr_alg->size_data_per_element_);
+            level0_in += n * appr_alg->size_data_per_element_;
+        });
 
         for (size_t i = 0; i < appr_alg->max_elements_; i++) {
             size_t linkListSize = appr_alg->element_levels_[i] > 0 ? appr_alg->size_links_per_element_ * appr_alg->element_levels_[i] : 0;
@@ -697,6 +826,88 @@ class Index {
     }
 
 
+    /*
+     * Batch search writing into caller-owned C-contiguous (rows, k) arrays:
+     * labels of dtype uint64 and distances of dtype float32, k is taken from
+     * their shape. The GIL is released for the whole batch, the worker
+     * threads and normalization buffers are kept between calls, and batches of
+     * any size are spread over the threads.
+     */
+    void knnQuery_into(
+        py::object input,
+        py::array labels,
+        py::array distances,
+        int num_threads = -1,
+        const std::function<bool(hnswlib::labeltype)>& filter = nullptr) {
+        py::array_t < dist_t, py::array::c_style | py::array::forcecast > items(input);
+        auto buffer = items.request();
+        size_t rows, features;
+        get_input_array_shapes(buffer, &rows, &features);
+        if (features != dim)
+            throw std::runtime_error("Wrong dimensionality of the vectors");
+
+        if (!labels.dtype().is(py::dtype::of<hnswlib::labeltype>()) || !distances.dtype().is(py::dtype::of<dist_t>()))
+            throw std::runtime_error("labels must be a uint64 array and distances a float32 array");
+        if (labels.ndim() != 2 || distances.ndim() != 2 ||
+            (size_t)labels.shape(0) != rows || (size_t)distances.shape(0) != rows ||
+            labels.shape(1) != distances.shape(1))
+            throw std::runtime_error("labels and distances must both have shape (rows, k)");
+        if (!(labels.flags() & py::array::c_style) || !(distances.flags() & py::array::c_style) ||
+            !labels.writeable() || !distances.writeable())
+            throw std::runtime_error("labels and distances must be writeable C-contiguous arrays");
+        size_t k = labels.shape(1);
+        hnswlib::labeltype* data_numpy_l = (hnswlib::labeltype*)labels.mutable_data();
+        dist_t* data_numpy_d = (dist_t*)distances.mutable_data();
+
+        if (num_threads <= 0)
+            num_threads = num_threads_default;
+
+        {
+            py::gil_scoped_release l;
+
+            CustomFilterFunctor idFilter(filter);
+            CustomFilterFunctor* p_idFilter = filter ? &idFilter : nullptr;
+
+            auto search_row = [&](size_t row, float* scratch) {
+                const void* query = items.data(row);
+                if (normalize) {
+                    normalize_vector((float*)items.data(row), scratch);
+                    query = scratch;
+                }
+                std::priority_queue<std::pair<dist_t, hnswlib::labeltype >> result = appr_alg->searchKnn(
+                    query, k, p_idFilter);
+                if (result.size() != k)
+                    throw std::runtime_error(
+                        "Cannot return the results in a contiguous 2D array. Probably ef or M is too small");
+                for (int i = k - 1; i >= 0; i--) {
+                    auto& result_tuple = result.top();
+                    data_numpy_d[row * k + i] = result_tuple.first;
+                    data_numpy_l[row * k + i] = result_tuple.second;
+                    result.pop();
+                }
+            };
+
+            std::unique_lock<std::mutex> lock(query_pool_lock, std::try_to_lock);
+            if (lock.owns_lock()) {
+                if (!query_pool || query_pool->size() != (size_t)num_threads)
+                    query_pool.reset(new WorkerPool(num_threads));
+                if (query_scratch.size() < num_threads * dim)
+                    query_scratch.resize(num_threads * dim);
+                float* scratch = query_scratch.data();
+                query_pool->parallelFor(0, rows, [&](size_t row, size_t threadId) {
+                    search_row(row, scratch + threadId * dim);
+                });
+            } else {
+                // another batch is using the pool concurrently: fall back to short-lived threads
+                std::vector<float> norm_array(num_threads * dim);
+                ParallelFor(0, rows, num_threads, [&](size_t row, size_t threadId) {
+                    search_row(row, norm_array.data() + threadId * dim);
+                });
+            }
+        }
+    }
+
+
     void markDeleted(size_t label) {
         appr_alg->markDelete(label);
     }
@@ -928,6 +1139,13 @@ PYBIND11_PLUGIN(hnswlib) {
             py::arg("k") = 1,
             py::arg("num_threads") = -1,
             py::arg("filter") = py::none())
+        .def("knn_query_into",
+            &Index<float>::knnQuery_into,
+            py::arg("data"),
+            py::arg("labels"),
+            py::arg("distances"),
+            py::arg("num_threads") = -1,
+            py::arg("filter") = py::none())
         .def("add_items",
             &Index<float>::addItems,
             py::arg("data"),
@@ -0,0 +1,260 @@
+// Checks the tiled, multi-threaded BruteforceSearch against a naive scan:
+// batched kernels (SIMD and residual dimensions), the parallel top-k merge,
+// filtering, removal, save/load, rerank and searches running next to adds.
+
+#include "../../hnswlib/hnswlib.h"
+
+#include <assert.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace {
+
+typedef std::priority_queue<std::pair<float, hnswlib::labeltype>> Result;
+
+class PickEven : public hnswlib::BaseFilterFunctor {
+ public:
+    bool operator()(hnswlib::labeltype label_id) {
+        return label_id % 2 == 0;
+    }
+};
+
+std::vector<hnswlib::labeltype> labels_of(Result res) {
+    std::vector<hnswlib::labeltype> labels;
+    while (!res.empty()) {
+        labels.push_back(res.top().second);
+        res.pop();
+    }
+    return labels;
+}
+
+Result naive_knn(hnswlib::SpaceInterface<float> &space, const std::vector<float> &data, size_t n, size_t d,
+                 const float *query, size_t k, hnswlib::BaseFilterFunctor *filter, hnswlib::labeltype first_label) {
+    hnswlib::DISTFUNC<float> dist = space.get_dist_func();
+    Result res;
+    for (size_t i = 0; i < n; i++) {
+        hnswlib::labeltype label = first_label + i;
+        if (filter && !(*filter)(label))
+            continue;
+        res.emplace(dist(query, data.data() + i * d, space.get_dist_func_param()), label);
+        if (res.size() > k)
+            res.pop();
+    }
+    return res;
+}
+
+void check_batch_kernel(hnswlib::SpaceInterface<float> &space, size_t d) {
+    std::mt19937 rng(d);
+    std::uniform_real_distribution<float> distrib;
+    size_t n = 11;
+    std::vector<float> data(n * d), query(d), out(n);
+    for (auto &v : data) v = distrib(rng);
+    for (auto &v : query) v = distrib(rng);
+
+    hnswlib::BATCHDISTFUNC<float> batch = space.get_batch_dist_func();
+    assert(batch != nullptr);
+    batch(query.data(), data.data(), n, space.get_dist_func_param(), out.data());
+    for (size_t i = 0; i < n; i++) {
+        float expected = space.get_dist_func()(query.data(), data.data() + i * d, space.get_dist_func_param());
+        assert(std::abs(out[i] - expected) <= 1e-4f * (1 + std::abs(expected)));
+    }
+}
+
+void test_matches_naive(hnswlib::SpaceInterface<float> &space, size_t d, size_t n, size_t threads) {
+    size_t nq = 20;
+    size_t k = 10;
+    hnswlib::labeltype first_label = 1000;
+    std::mt19937 rng(47);
+    std::uniform_real_distribution<float> distrib;
+    std::vector<float> data(n * d), queries(nq * d);
+    for (auto &v : data) v = distrib(rng);
+    for (auto &v : queries) v = distrib(rng);
+
+    hnswlib::BruteforceSearch<float> alg(&space, n);
+    alg.setNumThreads(threads);
+    for (size_t i = 0; i < n; i++)
+        alg.addPoint(data.data() + i * d, first_label + i);
+
+    PickEven even;
+    for (size_t q = 0; q < nq; q++) {
+        const float *query = queries.data() + q * d;
+        for (hnswlib::BaseFilterFunctor *filter : {(hnswlib::BaseFilterFunctor *) nullptr, (hnswlib::BaseFilterFunctor *) &even}) {
+            Result got = alg.searchKnn(query, k, filter);
+            Result expected = naive_knn(space, data, n, d, query, k, filter, first_label);
+            assert(got.size() == k);
+            assert(labels_of(got) == labels_of(expected));
+        }
+    }
+    // Asking for more results than there are elements returns all of them
+    assert(alg.searchKnn(queries.data(), n + 5).size() == n);
+}
+
+void test_remove_and_save_load() {
+    size_t d = 16;
+    size_t n = 300;
+    size_t k = 5;
+    hnswlib::L2Space space(d);
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> distrib;
+    std::vector<float> data(n * d);
+    for (auto &v : data) v = distrib(rng);
+
+    hnswlib::BruteforceSearch<float> alg(&space, n);
+    for (size_t i = 0; i < n; i++)
+        alg.addPoint(data.data() + i * d, i);
+
+    // Removing the last element must not leave it reachable by label
+    alg.removePoint(n - 1);
+    assert(alg.dict_external_to_internal.count(n - 1) == 0);
+    // Every point is its own nearest neighbour until removed
+    alg.removePoint(3);
+    assert(alg.cur_element_count == n - 2);
+    Result res = alg.searchKnn(data.data() + 3 * d, 1);
+    assert(res.top().second != 3);
+    res = alg.searchKnn(data.data() + 10 * d, 1);
+    assert(res.top().second == 10);
+
+    const char *path = "bruteforce_parallel_test.bin";
+    alg.saveIndex(path);
+    hnswlib::BruteforceSearch<float> loaded(&space, path);
+    assert(loaded.cur_element_count == n - 2);
+    assert(loaded.maxelements_ == n);
+    for (size_t i = 0; i < 20; i++) {
+        const float *query = data.data() + i * d;
+        assert(labels_of(loaded.searchKnn(query, k)) == labels_of(alg.searchKnn(query, k)));
+    }
+    // The label map is rebuilt on load, so removals keep working
+    loaded.removePoint(10);
+    assert(loaded.searchKnn(data.data() + 10 * d, 1).top().second != 10);
+    remove(path);
+}
+
+void test_rerank() {
+    size_t d = 32;
+    size_t n = 2000;
+    size_t k = 10;
+    hnswlib::InnerProductSpace space(d);
+    std::mt19937 rng(11);
+    std::uniform_real_distribution<float> distrib;
+    std::vector<float> data(n * d);
+    for (auto &v : data) v = distrib(rng);
+
+    hnswlib::BruteforceSearch<float> brute(&space, n);
+    hnswlib::HierarchicalNSW<float> hnsw(&space, n, 8, 40);
+    for (size_t i = 0; i < n; i++) {
+        brute.addPoint(data.data() + i * d, i);
+        hnsw.addPoint(data.data() + i * d, i);
+    }
+    hnsw.setEf(50);
+    const float *query = data.data() + 5 * d;
+    Result approx = hnsw.searchKnn(query, 50);
+    std::vector<hnswlib::labeltype> candidates = labels_of(approx);
+    candidates.push_back(n + 100);  // unknown labels are skipped
+
+    Result reranked = brute.rerank(query, candidates, k);
+    assert(reranked.size() == k);
+    // Same as an exact search restricted to the candidates
+    std::vector<std::pair<float, hnswlib::labeltype>> sorted;
+    for (hnswlib::labeltype label : candidates) {
+        if (label < n)
+            sorted.emplace_back(space.get_dist_func()(query, data.data() + label * d, space.get_dist_func_param()), label);
+    }
+    std::sort(sorted.begin(), sorted.end());
+    std::vector<hnswlib::labeltype> got = labels_of(reranked);
+    std::reverse(got.begin(), got.end());
+    for (size_t i = 0; i < k; i++)
+        assert(got[i] == sorted[i].second);
+}
+
+void test_concurrent_add_and_search() {
+    size_t d = 8;
+    size_t n = 20000;
+    hnswlib::L2Space space(d);
+    std::vector<float> data(n * d);
+    for (size_t i = 0; i < n; i++)
+        for (size_t j = 0; j < d; j++)
+            data[i * d + j] = (float) i;
+
+    hnswlib::BruteforceSearch<float> alg(&space, n);
+    std::atomic<bool> done{false};
+    std::thread writer([&]() {
+        for (size_t i = 0; i < n; i++)
+            alg.addPoint(data.data() + i * d, i);
+        done = true;
+    });
+    // Any published element must be complete: its distance to the query
+    // matches its label exactly
+    size_t searches = 0;
+    while (!done || searches == 0) {
+        Result res = alg.searchKnn(data.data(), 3);
+        while (!res.empty()) {
+            float expected = (float) (res.top().second * res.top().second * d);
+            assert(res.top().first == expected);
+            res.pop();
+        }
+        searches++;
+    }
+    writer.join();
+    assert(alg.cur_element_count == n);
+}
+
+void benchmark(size_t d, size_t n, size_t threads) {
+    hnswlib::L2Space space(d);
+    std::mt19937 rng(3);
+    std::uniform_real_distribution<float> distrib;
+    std::vector<float> vec(d);
+    hnswlib::BruteforceSearch<float> alg(&space, n);
+    for (size_t i = 0; i < n; i++) {
+        for (auto &v : vec) v = distrib(rng);
+        alg.addPoint(vec.data(), i);
+    }
+    alg.setNumThreads(threads);
+    size_t nq = 20;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t q = 0; q < nq; q++)
+        alg.searchKnn(vec.data(), 10);
+    double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / nq;
+    std::cout << "dim " << d << ", " << n << " elements, " << threads << " thread(s): " << us << " us/query\n";
+}
+
+}  // namespace
+
+int main() {
+    for (size_t d : {3, 13, 16, 100, 128}) {
+        hnswlib::L2Space l2(d);
+        hnswlib::InnerProductSpace ip(d);
+        check_batch_kernel(l2, d);
+        check_batch_kernel(ip, d);
+    }
+    std::cout << "Batched kernels match the pairwise distance\n";
+
+    for (size_t d : {13, 16}) {
+        hnswlib::L2Space l2(d);
+        hnswlib::InnerProductSpace ip(d);
+        test_matches_naive(l2, d, 1000, 1);
+        test_matches_naive(ip, d, 1000, 1);
+        // Large enough to be split over 4 threads
+        test_matches_naive(l2, d, 70000, 4);
+        test_matches_naive(ip, d, 70000, 4);
+    }
+    std::cout << "Single and multi-threaded scans match the naive scan\n";
+
+    test_remove_and_save_load();
+    std::cout << "Remove and save/load work\n";
+
+    test_rerank();
+    std::cout << "Rerank works\n";
+
+    test_concurrent_add_and_search();
+    std::cout << "Searches running next to adds see complete elements\n";
+
+    benchmark(128, 200000, 1);
+    benchmark(128, 200000, 4);
+    return 0;
+}
@@ -0,0 +1,160 @@
+#include "assert.h"
+#include "../../../disk_index.h"
+
+#include <chrono>
+#include <iostream>
+#include <iterator>
+
+// Builds a DiskIndex, saves it, loads it into a fresh instance and checks
+// recall@10 against brute force, with the page cache dropped before the
+// cold pass. Also checks that a failed read is reported to the caller
+// instead of terminating the I/O thread, that two indexes with different
+// dimensions can be searched alternately from one thread, and that a broken
+// .pq file fails the load.
+
+static std::vector<float> random_data(size_t n, size_t dim, unsigned seed) {
+    std::mt19937 rng(seed);
+    std::normal_distribution<float> distrib;
+    std::vector<float> data(n * dim);
+    for (float &v : data)
+        v = distrib(rng);
+    return data;
+}
+
+static std::vector<std::pair<float, uint32_t>> drain(std::priority_queue<std::pair<float, uint32_t>> q) {
+    std::vector<std::pair<float, uint32_t>> out;
+    for (; !q.empty(); q.pop())
+        out.push_back(q.top());
+    return out;
+}
+
+static float recall_at_k(DiskIndex &index, hnswlib::L2Space &space, const std::vector<float> &base,
+                         const std::vector<float> &queries, size_t n, size_t dim, size_t nq, size_t k,
+                         double *qps) {
+    hnswlib::DISTFUNC<float> dist = space.get_dist_func();
+    size_t hits = 0;
+    double search_sec = 0;
+    for (size_t q = 0; q < nq; q++) {
+        const float *query = queries.data() + q * dim;
+        std::vector<std::pair<float, size_t>> exact(n);
+        for (size_t i = 0; i < n; i++)
+            exact[i] = std::make_pair(dist(query, base.data() + i * dim, space.get_dist_func_param()), i);
+        std::partial_sort(exact.begin(), exact.begin() + k, exact.end());
+        std::unordered_set<size_t> truth;
+        for (size_t i = 0; i < k; i++)
+            truth.insert(exact[i].second);
+
+        auto start = std::chrono::steady_clock::now();
+        auto res = index.search(query, k, 100, 4);
+        search_sec += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        assert(res.size() == k);
+        while (!res.empty()) {
+            hits += truth.count(res.top().second);
+            res.pop();
+        }
+    }
+    if (qps)
+        *qps = nq / search_sec;
+    return (float) hits / (nq * k);
+}
+
+int main() {
+    const size_t n = 20000, dim = 32, nq = 200, k = 10;
+    std::vector<float> base = random_data(n, dim, 47);
+    std::vector<float> queries = random_data(nq, dim, 48);
+    hnswlib::L2Space space(dim);
+    const std::string path = "disk_index_test.index";
+
+    {
+        DiskIndex built(&space, false);
+        built.build(base.data(), n, dim, path, 32, 64, 1.2f, 8);
+    }
+
+    DiskIndex index(&space, false);
+    index.load(path);
+    index.drop_page_cache();
+    double cold_qps, warm_qps;
+    float cold_recall = recall_at_k(index, space, base, queries, n, dim, nq, k, &cold_qps);
+    float warm_recall = recall_at_k(index, space, base, queries, n, dim, nq, k, &warm_qps);
+    std::cout << "recall@10 " << cold_recall << ", QPS with page cache dropped " << cold_qps
+              << ", warm " << warm_qps << std::endl;
+    assert(cold_recall >= 0.9f);
+    assert(warm_recall == cold_recall);
+    std::cout << "Round trip is OK\n";
+
+    // A second index with a different dimension and sector count, searched
+    // alternately with the first one from the same thread.
+    const size_t dim2 = 1200, n2 = 2000;
+    std::vector<float> base2 = random_data(n2, dim2, 49);
+    hnswlib::L2Space space2(dim2);
+    const std::string path2 = "disk_index_test2.index";
+    {
+        DiskIndex built(&space2, false);
+        built.build(base2.data(), n2, dim2, path2, 16, 32, 1.2f, 100);
+    }
+    DiskIndex index2(&space2, false);
+    index2.load(path2);
+    std::vector<std::vector<std::pair<float, uint32_t>>> alone, alone2;
+    for (size_t q = 0; q < 20; q++)
+        alone.push_back(drain(index.search(queries.data() + q * dim, k, 100, 4)));
+    for (size_t q = 0; q < 20; q++)
+        alone2.push_back(drain(index2.search(base2.data() + q * dim2, k, 100, 8)));
+    for (size_t q = 0; q < 20; q++) {
+        assert(drain(index.search(queries.data() + q * dim, k, 100, 4)) == alone[q]);
+        assert(drain(index2.search(base2.data() + q * dim2, k, 100, 8)) == alone2[q]);
+    }
+    std::cout << "Per-index scratch is OK\n";
+
+    // A read past the end of the file fails on a pool thread; the error
+    // must come back to read_batch and the pool must stay usable.
+    int fd = open(path.c_str(), O_RDONLY);
+    assert(fd >= 0);
+    {
+        ThreadPoolReader reader(fd, 2);
+        std::vector<char> buf(4 * DISK_SECTOR_LEN);
+        std::vector<SectorRead> bad = {{0, DISK_SECTOR_LEN, buf.data()},
+                                       {(uint64_t) 1 << 40, DISK_SECTOR_LEN, buf.data() + DISK_SECTOR_LEN},
+                                       {DISK_SECTOR_LEN, DISK_SECTOR_LEN, buf.data() + 2 * DISK_SECTOR_LEN}};
+        bool thrown = false;
+        try {
+            reader.read_batch(bad);
+        } catch (const std::runtime_error &) {
+            thrown = true;
+        }
+        assert(thrown);
+        std::vector<SectorRead> good = {{0, DISK_SECTOR_LEN, buf.data()}};
+        reader.read_batch(good);
+    }
+    close(fd);
+    std::cout << "Read errors are OK\n";
+
+    // A .pq file that is truncated, has no subspaces or belongs to another
+    // index must fail the load instead of leaving garbage codes
+    std::string pq;
+    {
+        std::ifstream in(path + ".pq", std::ios::binary);
+        pq.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+    std::string zero_m = pq;
+    memset(&zero_m[sizeof(uint64_t)], 0, sizeof(uint64_t));
+    std::ifstream other_in(path2 + ".pq", std::ios::binary);
+    std::string other((std::istreambuf_iterator<char>(other_in)), std::istreambuf_iterator<char>());
+    for (const std::string &bad : {pq.substr(0, pq.size() / 2), zero_m, other}) {
+        std::ofstream(path + ".pq", std::ios::binary).write(bad.data(), bad.size());
+        DiskIndex broken(&space, false);
+        bool thrown = false;
+        try {
+            broken.load(path);
+        } catch (const std::runtime_error &) {
+            thrown = true;
+        }
+        assert(thrown);
+    }
+    std::cout << "PQ load errors are OK\n";
+
+    remove(path.c_str());
+    remove((path + ".pq").c_str());
+    remove(path2.c_str());
+    remove((path2 + ".pq").c_str());
+    return 0;
+}
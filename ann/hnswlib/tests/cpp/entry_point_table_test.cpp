@@ -0,0 +1,113 @@
+#include "assert.h"
+#include "../../hnswlib/hnswlib.h"
+#include <chrono>
+#include <unordered_set>
+
+// Compares recall, upper-layer work and latency of searches seeded from the
+// entry point table against the regular upper layer descent.
+
+static float recall_at(hnswlib::HierarchicalNSW<float> &alg, hnswlib::BruteforceSearch<float> &brute,
+                       const std::vector<float> &queries, size_t dim, size_t k, double &us) {
+    size_t num_queries = queries.size() / dim;
+    float correct = 0;
+    us = 0;
+    for (size_t q = 0; q < num_queries; q++) {
+        auto gt = brute.searchKnn(queries.data() + q * dim, k);
+        std::unordered_set<hnswlib::labeltype> gt_labels;
+        while (!gt.empty()) {
+            gt_labels.insert(gt.top().second);
+            gt.pop();
+        }
+        auto start = std::chrono::steady_clock::now();
+        auto res = alg.searchKnn(queries.data() + q * dim, k);
+        us += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+        while (!res.empty()) {
+            correct += gt_labels.count(res.top().second);
+            res.pop();
+        }
+    }
+    us /= num_queries;
+    return correct / (num_queries * k);
+}
+
+int main() {
+    size_t dim = 32;
+    size_t max_elements = 20000;
+    size_t num_clusters = 64;
+    size_t num_queries = 300;
+    size_t k = 10;
+
+    std::mt19937 rng(47);
+    std::normal_distribution<float> gauss;
+    std::vector<float> centers(num_clusters * dim);
+    for (float &v : centers)
+        v = 4 * gauss(rng);
+    auto gen = [&](std::vector<float> &out, size_t n) {
+        out.resize(n * dim);
+        for (size_t i = 0; i < n; i++) {
+            size_t c = rng() % num_clusters;
+            for (size_t j = 0; j < dim; j++)
+                out[i * dim + j] = centers[c * dim + j] + gauss(rng);
+        }
+    };
+    std::vector<float> data, queries;
+    gen(data, max_elements);
+    gen(queries, num_queries);
+
+    hnswlib::L2Space space(dim);
+    hnswlib::BruteforceSearch<float> brute(&space, max_elements);
+    hnswlib::HierarchicalNSW<float> alg(&space, max_elements, 16, 100);
+    for (size_t i = 0; i < max_elements; i++) {
+        brute.addPoint(data.data() + i * dim, i);
+        alg.addPoint(data.data() + i * dim, i);
+    }
+
+    alg.buildEntryPointTable(256);
+    assert(alg.getEntryPointTableSize() == 256);
+    std::vector<hnswlib::tableint> table = alg.entry_point_nodes_;
+    std::vector<char> table_data = alg.entry_point_data_;
+
+    for (size_t ef : {10, 20, 40}) {
+        alg.setEf(ef);
+        double us_descent, us_table;
+
+        alg.clearEntryPointTable();
+        alg.metric_hops = 0;
+        alg.metric_distance_computations = 0;
+        float recall_descent = recall_at(alg, brute, queries, dim, k, us_descent);
+        long hops_descent = alg.metric_hops;
+        long dist_descent = alg.metric_distance_computations;
+
+        alg.entry_point_nodes_ = table;
+        alg.entry_point_data_ = table_data;
+        alg.metric_hops = 0;
+        alg.metric_distance_computations = 0;
+        float recall_table = recall_at(alg, brute, queries, dim, k, us_table);
+        long hops_table = alg.metric_hops;
+        long dist_table = alg.metric_distance_computations;
+
+        std::cout << "ef " << ef
+                  << "  descent: recall " << recall_descent << ", upper hops/q " << (double) hops_descent / num_queries
+                  << ", upper dists/q " << (double) dist_descent / num_queries << ", " << us_descent << " us"
+                  << "  table: recall " << recall_table << ", upper hops/q " << (double) hops_table / num_queries
+                  << ", table dists/q " << (double) dist_table / num_queries << ", " << us_table << " us\n";
+        assert(hops_table == 0);
+        assert(dist_table == (long) (num_queries * table.size()));
+        assert(recall_table >= recall_descent - 0.05f);
+    }
+
+    // explicit table by labels
+    alg.setEntryPointTable({1, 2, 3});
+    assert(alg.getEntryPointTableSize() == 3);
+    auto res = alg.searchKnn(data.data() + 100 * dim, 1);
+    assert(res.top().second == 100);
+
+    // the table is not persisted
+    std::string path = "entry_point_table_test.bin";
+    alg.saveIndex(path);
+    alg.loadIndex(path, &space);
+    remove(path.c_str());
+    assert(alg.getEntryPointTableSize() == 0);
+    std::cout << "Entry point table is OK\n";
+    return 0;
+}
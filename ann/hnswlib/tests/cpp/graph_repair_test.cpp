@@ -0,0 +1,133 @@
+// Cuts elements off the level 0 graph, checks that analyzeGraph() finds
+// them and that repairConnectivity() makes them searchable again, reporting
+// recall before and after.
+
+#include "../../hnswlib/hnswlib.h"
+
+#include <assert.h>
+
+#include <algorithm>
+#include <iostream>
+#include <random>
+#include <vector>
+
+namespace {
+
+// Fraction of elements that are their own nearest neighbour
+float self_recall(hnswlib::HierarchicalNSW<float> &alg, const std::vector<float> &data, size_t d,
+                  const std::vector<hnswlib::tableint> &ids) {
+    size_t hits = 0;
+    for (hnswlib::tableint id : ids) {
+        auto res = alg.searchKnn(data.data() + id * d, 1);
+        if (!res.empty() && res.top().second == id)
+            hits++;
+    }
+    return (float) hits / ids.size();
+}
+
+float knn_recall(hnswlib::HierarchicalNSW<float> &alg, hnswlib::BruteforceSearch<float> &brute,
+                 const std::vector<float> &queries, size_t d, size_t k) {
+    size_t nq = queries.size() / d;
+    size_t hits = 0;
+    for (size_t q = 0; q < nq; q++) {
+        auto gt = brute.searchKnn(queries.data() + q * d, k);
+        auto res = alg.searchKnn(queries.data() + q * d, k);
+        std::vector<hnswlib::labeltype> expected;
+        while (!gt.empty()) {
+            expected.push_back(gt.top().second);
+            gt.pop();
+        }
+        while (!res.empty()) {
+            if (std::find(expected.begin(), expected.end(), res.top().second) != expected.end())
+                hits++;
+            res.pop();
+        }
+    }
+    return (float) hits / (nq * k);
+}
+
+}  // namespace
+
+int main() {
+    size_t d = 16;
+    size_t n = 5000;
+    size_t nq = 200;
+    size_t k = 10;
+    std::mt19937 rng(47);
+    std::uniform_real_distribution<float> distrib;
+    std::vector<float> data(n * d), queries(nq * d);
+    for (auto &v : data) v = distrib(rng);
+    for (auto &v : queries) v = distrib(rng);
+
+    hnswlib::L2Space space(d);
+    hnswlib::HierarchicalNSW<float> alg(&space, n, 8, 100);
+    hnswlib::BruteforceSearch<float> brute(&space, n);
+    for (size_t i = 0; i < n; i++) {
+        alg.addPoint(data.data() + i * d, i);
+        brute.addPoint(data.data() + i * d, i);
+    }
+    alg.setEf(50);
+
+    hnswlib::GraphStats stats = alg.analyzeGraph();
+    stats.report(std::cout);
+    assert(stats.levels[0].nodes == n);
+    assert(stats.levels[0].unreachable == 0);
+
+    // Cut a set of level 0 only elements off: drop every link pointing at
+    // them, and also clear the own links of half of them
+    std::vector<hnswlib::tableint> orphans;
+    for (hnswlib::tableint i = 0; i < n && orphans.size() < 100; i += 37) {
+        if (alg.element_levels_[i] == 0 && i != alg.enterpoint_node_)
+            orphans.push_back(i);
+    }
+    std::vector<char> is_orphan(n, 0);
+    for (hnswlib::tableint id : orphans)
+        is_orphan[id] = 1;
+    for (hnswlib::tableint i = 0; i < n; i++) {
+        hnswlib::linklistsizeint *ll = alg.get_linklist0(i);
+        hnswlib::tableint *links = (hnswlib::tableint *) (ll + 1);
+        size_t size = alg.getListCount(ll), kept = 0;
+        for (size_t j = 0; j < size; j++) {
+            if (!is_orphan[links[j]])
+                links[kept++] = links[j];
+        }
+        alg.setListCount(ll, kept);
+    }
+    for (size_t j = 0; j < orphans.size(); j += 2)
+        alg.setListCount(alg.get_linklist0(orphans[j]), 0);
+
+    stats = alg.analyzeGraph();
+    assert(stats.levels[0].unreachable >= orphans.size());
+    for (hnswlib::tableint id : orphans)
+        assert(std::find(stats.unreachable_nodes.begin(), stats.unreachable_nodes.end(), id) != stats.unreachable_nodes.end());
+    assert(stats.levels[0].zero_in_degree >= orphans.size());
+
+    float self_before = self_recall(alg, data, d, orphans);
+    float recall_before = knn_recall(alg, brute, queries, d, k);
+    assert(self_before == 0);
+
+    size_t added = alg.repairConnectivity();
+    stats = alg.analyzeGraph();
+    assert(stats.levels[0].unreachable == 0);
+    assert(added >= orphans.size());
+    for (hnswlib::tableint id : orphans)
+        assert(alg.getListCount(alg.get_linklist0(id)) > 0);
+
+    float self_after = self_recall(alg, data, d, orphans);
+    float recall_after = knn_recall(alg, brute, queries, d, k);
+    std::cout << orphans.size() << " orphaned elements, " << added << " links added\n";
+    std::cout << "self recall of orphans: " << self_before << " -> " << self_after << "\n";
+    std::cout << "recall@" << k << ": " << recall_before << " -> " << recall_after << "\n";
+    assert(self_after > 0.95f);
+    assert(recall_after > recall_before);
+
+    // Deleted elements are counted separately, never as unreachable
+    alg.markDelete(orphans[0]);
+    stats = alg.analyzeGraph();
+    assert(stats.levels[0].deleted == 1);
+    assert(stats.levels[0].unreachable == 0);
+
+    alg.checkIntegrity();
+    std::cout << "All tests passed\n";
+    return 0;
+}
@@ -0,0 +1,113 @@
+#include "assert.h"
+#include "../../hnswlib/hnswlib.h"
+#include <cmath>
+#include <unordered_set>
+
+// Checks fp16 / bf16 conversion, the SIMD kernels against the scalar fallbacks,
+// and the recall of an fp16 HNSW index against fp32 brute force.
+
+static void test_conversion() {
+    float values[] = {0.0f, -0.0f, 1.0f, -2.5f, 0.333333f, 65504.0f, 1e-6f, 3.14159f};
+    for (float v : values) {
+        float h = hnswlib::fp16_to_fp32(hnswlib::fp32_to_fp16(v));
+        assert(std::fabs(h - v) <= std::fabs(v) * 1e-3f + 1e-7f);
+        float b = hnswlib::bf16_to_fp32(hnswlib::fp32_to_bf16(v));
+        assert(std::fabs(b - v) <= std::fabs(v) * 1e-2f);
+    }
+    assert(hnswlib::fp32_to_fp16(1e6f) == 0x7c00);  // overflow to inf
+    std::cout << "Conversion is OK\n";
+}
+
+static void test_kernels(size_t dim) {
+    std::mt19937 rng(dim);
+    std::uniform_real_distribution<> distrib_real(-1, 1);
+    std::vector<float> a(dim), b(dim);
+    for (size_t i = 0; i < dim; i++) {
+        a[i] = distrib_real(rng);
+        b[i] = distrib_real(rng);
+    }
+    std::vector<hnswlib::fp16_t> a16(dim), b16(dim);
+    std::vector<hnswlib::bf16_t> abf(dim), bbf(dim);
+    hnswlib::fp32_to_fp16_array(a.data(), a16.data(), dim);
+    hnswlib::fp32_to_fp16_array(b.data(), b16.data(), dim);
+    hnswlib::fp32_to_bf16_array(a.data(), abf.data(), dim);
+    hnswlib::fp32_to_bf16_array(b.data(), bbf.data(), dim);
+    for (size_t i = 0; i < dim; i++)
+        assert(a16[i] == hnswlib::fp32_to_fp16(a[i]));
+
+    hnswlib::InnerProductSpaceFP16 ip16(dim);
+    hnswlib::L2SpaceFP16 l216(dim);
+    hnswlib::InnerProductSpaceBF16 ipbf(dim);
+    hnswlib::L2SpaceBF16 l2bf(dim);
+
+    float eps = 1e-3f * dim;
+    assert(std::fabs(ip16.get_dist_func()(a16.data(), b16.data(), &dim) -
+                     (1.0f - hnswlib::InnerProductFP16(a16.data(), b16.data(), &dim))) < eps);
+    assert(std::fabs(l216.get_dist_func()(a16.data(), b16.data(), &dim) -
+                     hnswlib::L2SqrFP16(a16.data(), b16.data(), &dim)) < eps);
+    assert(std::fabs(ipbf.get_dist_func()(abf.data(), bbf.data(), &dim) -
+                     (1.0f - hnswlib::InnerProductBF16(abf.data(), bbf.data(), &dim))) < eps);
+    assert(std::fabs(l2bf.get_dist_func()(abf.data(), bbf.data(), &dim) -
+                     hnswlib::L2SqrBF16(abf.data(), bbf.data(), &dim)) < eps);
+}
+
+int main() {
+    test_conversion();
+    for (size_t dim : {1, 7, 16, 33, 96, 100})
+        test_kernels(dim);
+    std::cout << "Kernels are OK\n";
+
+    size_t dim = 96;
+    int max_elements = 5000;
+    int num_queries = 100;
+    int k = 10;
+
+    std::mt19937 rng;
+    rng.seed(47);
+    std::normal_distribution<> distrib;
+    std::vector<float> data(dim * max_elements);
+    for (int i = 0; i < max_elements; i++) {
+        float norm = 0;
+        for (size_t j = 0; j < dim; j++) {
+            data[i * dim + j] = distrib(rng);
+            norm += data[i * dim + j] * data[i * dim + j];
+        }
+        for (size_t j = 0; j < dim; j++)
+            data[i * dim + j] /= std::sqrt(norm);
+    }
+    std::vector<hnswlib::fp16_t> data16(dim * max_elements);
+    hnswlib::fp32_to_fp16_array(data.data(), data16.data(), data.size());
+
+    hnswlib::InnerProductSpace space(dim);
+    hnswlib::InnerProductSpaceFP16 space16(dim);
+    hnswlib::BruteforceSearch<float> alg_brute(&space, max_elements);
+    hnswlib::HierarchicalNSW<float> alg_hnsw(&space16, max_elements, 16, 200);
+    for (int i = 0; i < max_elements; i++) {
+        alg_brute.addPoint(data.data() + i * dim, i);
+        alg_hnsw.addPoint(data16.data() + i * dim, i);
+    }
+    alg_hnsw.setEf(200);
+
+    float correct = 0;
+    for (int q = 0; q < num_queries; q++) {
+        const float *query = data.data() + (q * 37 % max_elements) * dim;
+        std::vector<hnswlib::fp16_t> query16(dim);
+        hnswlib::fp32_to_fp16_array(query, query16.data(), dim);
+
+        auto gt = alg_brute.searchKnn(query, k);
+        std::unordered_set<hnswlib::labeltype> gt_labels;
+        while (!gt.empty()) {
+            gt_labels.insert(gt.top().second);
+            gt.pop();
+        }
+        auto res = alg_hnsw.searchKnn(query16.data(), k);
+        while (!res.empty()) {
+            correct += gt_labels.count(res.top().second);
+            res.pop();
+        }
+    }
+    float recall = correct / (num_queries * k);
+    std::cout << "fp16 recall: " << recall << "\n";
+    assert(recall > 0.9);
+    return 0;
+}
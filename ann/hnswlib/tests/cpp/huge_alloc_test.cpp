@@ -0,0 +1,90 @@
+#include "assert.h"
+#include "../../hnswlib/hnswlib.h"
+
+// Checks huge_malloc / huge_realloc / huge_free for every mode and that an
+// index backed by huge pages behaves exactly like the malloc-backed one,
+// including resizeIndex and save/load.
+
+static void test_alloc(hnswlib::HugePageMode mode) {
+    hnswlib::HugeAllocStats &stats = hnswlib::huge_alloc_stats();
+    size_t before = stats.malloc_bytes + stats.transparent_bytes + stats.explicit_bytes;
+
+    for (size_t size : {(size_t) 1, (size_t) 4096, hnswlib::HUGE_PAGE_SIZE + 1, 3 * hnswlib::HUGE_PAGE_SIZE}) {
+        unsigned char *p = (unsigned char *) hnswlib::huge_malloc(size, mode);
+        assert(p != nullptr);
+        assert((uintptr_t) p % 64 == 0);
+        for (size_t i = 0; i < size; i++)
+            p[i] = (unsigned char) (i * 31);
+
+        p = (unsigned char *) hnswlib::huge_realloc(p, 2 * size + 100, mode);
+        assert(p != nullptr);
+        for (size_t i = 0; i < size; i++)
+            assert(p[i] == (unsigned char) (i * 31));
+        p = (unsigned char *) hnswlib::huge_realloc(p, size / 2 + 1, mode);
+        for (size_t i = 0; i < size / 2 + 1; i++)
+            assert(p[i] == (unsigned char) (i * 31));
+        hnswlib::huge_free(p);
+    }
+    hnswlib::huge_free(nullptr);
+
+    size_t after = stats.malloc_bytes + stats.transparent_bytes + stats.explicit_bytes;
+    assert(before == after);
+}
+
+int main() {
+    for (hnswlib::HugePageMode mode : {hnswlib::HUGEPAGE_OFF, hnswlib::HUGEPAGE_TRANSPARENT, hnswlib::HUGEPAGE_EXPLICIT})
+        test_alloc(mode);
+    std::cout << "Allocation is OK\n";
+
+    int dim = 32;
+    int max_elements = 20000;
+    std::mt19937 rng;
+    rng.seed(47);
+    std::uniform_real_distribution<> distrib_real;
+    std::vector<float> data(dim * max_elements);
+    for (float &v : data)
+        v = distrib_real(rng);
+
+    hnswlib::L2Space space(dim);
+    hnswlib::HierarchicalNSW<float> plain(&space, max_elements / 2, 16, 100);
+    hnswlib::HierarchicalNSW<float> huge(&space, max_elements / 2, 16, 100, 100, false,
+                                         hnswlib::HUGEPAGE_TRANSPARENT);
+    for (int i = 0; i < max_elements; i++) {
+        if (i == max_elements / 2) {
+            plain.resizeIndex(max_elements);
+            huge.resizeIndex(max_elements);
+        }
+        plain.addPoint(data.data() + i * dim, i);
+        huge.addPoint(data.data() + i * dim, i);
+    }
+    hnswlib::HugeAllocStats &stats = hnswlib::huge_alloc_stats();
+    std::cout << "huge page backed bytes: " << stats.transparent_bytes + stats.explicit_bytes << "\n";
+
+    std::string path = "huge_alloc_test.bin";
+    huge.saveIndex(path);
+    hnswlib::HierarchicalNSW<float> loaded(&space, path, false, 0, false, hnswlib::HUGEPAGE_EXPLICIT);
+    remove(path.c_str());
+
+    for (int q = 0; q < 200; q++) {
+        const float *query = data.data() + (q * 97 % max_elements) * dim;
+        auto a = plain.searchKnn(query, 10);
+        auto b = huge.searchKnn(query, 10);
+        auto c = loaded.searchKnn(query, 10);
+        assert(a.size() == b.size() && a.size() == c.size());
+        while (!a.empty()) {
+            assert(a.top() == b.top());
+            assert(a.top() == c.top());
+            a.pop();
+            b.pop();
+            c.pop();
+        }
+    }
+    std::cout << "Search is OK\n";
+
+    // A small index still gets chunks of at least one huge page
+    hnswlib::HierarchicalNSW<float> small(&space, 100, 16, 100, 100, false, hnswlib::HUGEPAGE_TRANSPARENT);
+    assert((small.size_data_per_element_ << small.data_level0_memory_.chunkShift()) >= hnswlib::HUGE_PAGE_SIZE);
+    assert(small.linkLists_.capacity() * sizeof(char *) >= hnswlib::HUGE_PAGE_SIZE);
+    std::cout << "Chunk size is OK\n";
+    return 0;
+}
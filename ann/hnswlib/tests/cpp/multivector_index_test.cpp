@@ -0,0 +1,225 @@
+// Checks MaxSim scoring and recall of MultiVectorIndex, and compares it with
+// the stop-condition based multi-vector search of example_multivector_search.cpp
+// (doc id stored in every vector, one searchStopConditionClosest per query
+// token, candidates rescored through per-document lookups).
+
+#include "../../hnswlib/hnswlib.h"
+
+#include <assert.h>
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <set>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+typedef unsigned int docidtype;
+typedef std::priority_queue<std::pair<float, hnswlib::labeltype>> Result;
+
+void normalize(float *v, size_t dim) {
+    float norm = 0;
+    for (size_t i = 0; i < dim; i++) norm += v[i] * v[i];
+    norm = std::sqrt(norm) + 1e-30f;
+    for (size_t i = 0; i < dim; i++) v[i] /= norm;
+}
+
+// Documents share a small set of topics; each has its own center near its
+// topic and token vectors scattered around that center
+struct Corpus {
+    size_t dim;
+    std::vector<std::vector<float>> docs;
+
+    Corpus(size_t dim, size_t num_docs, size_t num_topics, size_t min_tokens, size_t max_tokens, unsigned seed)
+        : dim(dim) {
+        std::mt19937 rng(seed);
+        std::normal_distribution<float> gauss;
+        std::uniform_int_distribution<size_t> tokens(min_tokens, max_tokens);
+        std::vector<float> topics(num_topics * dim);
+        for (auto &v : topics) v = gauss(rng);
+        for (size_t d = 0; d < num_docs; d++) {
+            const float *topic = topics.data() + (d % num_topics) * dim;
+            std::vector<float> center(dim);
+            for (size_t j = 0; j < dim; j++)
+                center[j] = topic[j] + 0.5f * gauss(rng);
+            size_t n = tokens(rng);
+            std::vector<float> doc(n * dim);
+            for (size_t t = 0; t < n; t++) {
+                for (size_t j = 0; j < dim; j++)
+                    doc[t * dim + j] = center[j] + 0.8f * gauss(rng);
+                normalize(doc.data() + t * dim, dim);
+            }
+            docs.push_back(doc);
+        }
+    }
+
+    // Query tokens are noisy copies of some tokens of document `doc`
+    std::vector<float> query(size_t doc, size_t query_tokens, std::mt19937 &rng) const {
+        std::normal_distribution<float> gauss;
+        const std::vector<float> &src = docs[doc];
+        size_t n = src.size() / dim;
+        std::vector<float> q(query_tokens * dim);
+        for (size_t i = 0; i < query_tokens; i++) {
+            size_t t = rng() % n;
+            for (size_t j = 0; j < dim; j++)
+                q[i * dim + j] = src[t * dim + j] + 0.3f * gauss(rng);
+            normalize(q.data() + i * dim, dim);
+        }
+        return q;
+    }
+};
+
+float naive_maxsim(const std::vector<float> &query, const std::vector<float> &doc, size_t dim) {
+    double score = 0;
+    for (size_t i = 0; i < query.size() / dim; i++) {
+        double best = -1e30;
+        for (size_t t = 0; t < doc.size() / dim; t++) {
+            double dot = 0;
+            for (size_t j = 0; j < dim; j++)
+                dot += query[i * dim + j] * doc[t * dim + j];
+            best = std::max(best, dot);
+        }
+        score += best;
+    }
+    return score;
+}
+
+std::vector<hnswlib::labeltype> labels_of(Result res) {
+    std::vector<hnswlib::labeltype> labels;
+    while (!res.empty()) {
+        labels.push_back(res.top().second);
+        res.pop();
+    }
+    return labels;
+}
+
+size_t overlap(const std::vector<hnswlib::labeltype> &a, const std::vector<hnswlib::labeltype> &b) {
+    size_t hits = 0;
+    for (auto x : a)
+        hits += std::find(b.begin(), b.end(), x) != b.end();
+    return hits;
+}
+
+}  // namespace
+
+int main() {
+    size_t dim = 32;
+    size_t num_docs = 2000;
+    size_t query_tokens = 8;
+    size_t num_queries = 100;
+    size_t k = 10;
+    Corpus corpus(dim, num_docs, 50, 8, 40, 47);
+    size_t total_tokens = 0;
+    for (auto &doc : corpus.docs)
+        total_tokens += doc.size() / dim;
+
+    // Two writers add documents concurrently; label = 1000 + position in the corpus
+    hnswlib::MultiVectorIndex index(dim, num_docs, total_tokens, 16, 100);
+    std::vector<std::thread> writers;
+    for (size_t w = 0; w < 2; w++) {
+        writers.emplace_back([&, w]() {
+            for (size_t d = w; d < num_docs; d += 2)
+                index.addDocument(corpus.docs[d].data(), corpus.docs[d].size() / dim, 1000 + d);
+        });
+    }
+    for (auto &t : writers)
+        t.join();
+    assert(index.size() == num_docs);
+    assert(index.numTokens() == total_tokens);
+    index.setEf(64);
+
+    std::mt19937 rng(7);
+    std::vector<std::vector<float>> queries;
+    for (size_t q = 0; q < num_queries; q++)
+        queries.push_back(corpus.query(rng() % num_docs, query_tokens, rng));
+
+    // Exhaustive MaxSim matches a naive double precision evaluation
+    for (size_t q = 0; q < 5; q++) {
+        Result res = index.searchExhaustive(queries[q].data(), query_tokens, k);
+        while (!res.empty()) {
+            float expected = naive_maxsim(queries[q], corpus.docs[res.top().second - 1000], dim);
+            assert(std::abs(-res.top().first - expected) < 1e-3f);
+            res.pop();
+        }
+    }
+
+    std::vector<std::vector<hnswlib::labeltype>> truth;
+    auto start = std::chrono::steady_clock::now();
+    for (auto &q : queries)
+        truth.push_back(labels_of(index.searchExhaustive(q.data(), query_tokens, k)));
+    double us_exhaustive = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+    size_t hits = 0, scored = 0;
+    start = std::chrono::steady_clock::now();
+    for (size_t q = 0; q < num_queries; q++) {
+        size_t candidates = 0;
+        Result res = index.searchKnn(queries[q].data(), query_tokens, k, 32, &candidates);
+        hits += overlap(labels_of(res), truth[q]);
+        scored += candidates;
+    }
+    double us_engine = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    float recall_engine = (float) hits / (num_queries * k);
+
+    // Baseline: doc id stored inside each vector, document collection through
+    // MultiVectorSearchStopCondition, rescoring through a doc -> vectors map
+    hnswlib::MultiVectorInnerProductSpace<docidtype> mv_space(dim);
+    hnswlib::HierarchicalNSW<float> mv_hnsw(&mv_space, total_tokens, 16, 100);
+    std::unordered_map<docidtype, std::vector<hnswlib::labeltype>> doc_tokens;
+    std::vector<char> point(mv_space.get_data_size());
+    hnswlib::labeltype label = 0;
+    for (size_t d = 0; d < num_docs; d++) {
+        for (size_t t = 0; t < corpus.docs[d].size() / dim; t++) {
+            memcpy(point.data(), corpus.docs[d].data() + t * dim, dim * sizeof(float));
+            mv_space.set_doc_id(point.data(), d);
+            mv_hnsw.addPoint(point.data(), label);
+            doc_tokens[d].push_back(label++);
+        }
+    }
+    mv_hnsw.setEf(64);
+    hits = 0;
+    start = std::chrono::steady_clock::now();
+    for (size_t q = 0; q < num_queries; q++) {
+        std::vector<char> query_point(mv_space.get_data_size());
+        std::set<docidtype> candidates;
+        for (size_t i = 0; i < query_tokens; i++) {
+            memcpy(query_point.data(), queries[q].data() + i * dim, dim * sizeof(float));
+            hnswlib::MultiVectorSearchStopCondition<docidtype, float> stop_condition(mv_space, k, 32);
+            auto result = mv_hnsw.searchStopConditionClosest(query_point.data(), stop_condition);
+            for (auto &r : result)
+                candidates.insert(mv_space.get_doc_id(mv_hnsw.getDataByInternalId(mv_hnsw.label_lookup_[r.second])));
+        }
+        Result res;
+        for (docidtype c : candidates) {
+            float score = 0;
+            for (size_t i = 0; i < query_tokens; i++) {
+                float best = -1e30f;
+                for (hnswlib::labeltype t : doc_tokens[c]) {
+                    const char *data = mv_hnsw.getDataByInternalId(mv_hnsw.label_lookup_[t]);
+                    best = std::max(best, 1.0f - mv_space.get_dist_func()(queries[q].data() + i * dim, data,
+                                                                          mv_space.get_dist_func_param()));
+                }
+                score += best;
+            }
+            res.emplace(-score, 1000 + c);
+            if (res.size() > k)
+                res.pop();
+        }
+        hits += overlap(labels_of(res), truth[q]);
+    }
+    double us_baseline = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    float recall_baseline = (float) hits / (num_queries * k);
+
+    std::cout << num_docs << " documents, " << total_tokens << " vectors, " << query_tokens << " query tokens\n";
+    std::cout << "exhaustive MaxSim:     " << us_exhaustive / num_queries << " us/query\n";
+    std::cout << "MultiVectorIndex:      " << us_engine / num_queries << " us/query, recall@" << k << " "
+              << recall_engine << ", " << (double) scored / num_queries << " documents scored\n";
+    std::cout << "stop-condition search: " << us_baseline / num_queries << " us/query, recall@" << k << " "
+              << recall_baseline << "\n";
+    assert(recall_engine > 0.9f);
+    std::cout << "All tests passed\n";
+    return 0;
+}
@@ -0,0 +1,117 @@
+#include "assert.h"
+#include "../../hnswlib/hnswlib.h"
+#include <cmath>
+#include <unordered_set>
+
+// Checks that the PCA rotation preserves distances, that the bounded distance
+// never abandons a candidate that would have beaten the bound, and the recall
+// of an early-abandoning HNSW index against exact brute force.
+
+static std::vector<float> gen_data(size_t dim, size_t n, bool normalize) {
+    std::mt19937 rng(47);
+    std::normal_distribution<> distrib;
+    std::vector<float> data(dim * n);
+    for (size_t i = 0; i < n; i++) {
+        float norm = 0;
+        for (size_t j = 0; j < dim; j++) {
+            // decaying per-dimension scale so that PCA has something to find
+            data[i * dim + j] = distrib(rng) / (1.0f + 0.2f * j);
+            norm += data[i * dim + j] * data[i * dim + j];
+        }
+        if (normalize)
+            for (size_t j = 0; j < dim; j++)
+                data[i * dim + j] /= std::sqrt(norm);
+    }
+    return data;
+}
+
+static void test_bounds(size_t dim, bool ip) {
+    size_t n = 500;
+    std::vector<float> data = gen_data(dim, n, ip);
+    hnswlib::PcaRotatedSpace space(dim, data.data(), n, ip, 8);
+    hnswlib::InnerProductSpace ip_space(dim);
+    hnswlib::L2Space l2_space(dim);
+    hnswlib::DISTFUNC<float> ref = ip ? ip_space.get_dist_func() : l2_space.get_dist_func();
+    void *ref_param = ip ? ip_space.get_dist_func_param() : l2_space.get_dist_func_param();
+
+    const std::vector<float> &variance = space.get_variance();
+    for (size_t i = 1; i < dim; i++)
+        assert(variance[i - 1] >= variance[i]);
+
+    size_t stride = space.get_data_size() / sizeof(float);
+    std::vector<float> rotated(n * stride);
+    for (size_t i = 0; i < n; i++)
+        space.transform(data.data() + i * dim, rotated.data() + i * stride);
+
+    hnswlib::DISTFUNC<float> dist = space.get_dist_func();
+    hnswlib::BOUNDEDDISTFUNC<float> bounded = space.get_bounded_dist_func();
+    void *param = space.get_dist_func_param();
+    for (size_t i = 0; i < 50; i++) {
+        const float *q = rotated.data() + i * stride;
+        for (size_t j = 0; j < n; j++) {
+            const float *x = rotated.data() + j * stride;
+            float exact = dist(q, x, param);
+            float expected = ref(data.data() + i * dim, data.data() + j * dim, ref_param);
+            assert(std::fabs(exact - expected) < 1e-3f);
+            for (float bound : {exact - 0.5f, exact - 1e-3f, exact + 1e-3f, exact + 1.0f}) {
+                float d = bounded(q, x, param, bound);
+                if (exact + 1e-4f < bound)
+                    assert(std::fabs(d - exact) < 1e-4f);  // must not abandon
+                else
+                    assert(d > bound || std::fabs(d - exact) < 1e-4f);
+                assert(d <= exact + 1e-4f);  // always a lower bound
+            }
+        }
+    }
+}
+
+int main() {
+    for (size_t dim : {1, 7, 16, 33, 96})
+        for (bool ip : {true, false})
+            test_bounds(dim, ip);
+    std::cout << "Bounds are OK\n";
+
+    size_t dim = 96;
+    int max_elements = 5000;
+    int num_queries = 100;
+    int k = 10;
+    std::vector<float> data = gen_data(dim, max_elements, true);
+
+    hnswlib::InnerProductSpace space(dim);
+    hnswlib::PcaRotatedSpace space_pca(dim, data.data(), max_elements);
+    size_t stride = space_pca.get_data_size() / sizeof(float);
+    std::vector<float> rotated(max_elements * stride);
+    for (int i = 0; i < max_elements; i++)
+        space_pca.transform(data.data() + i * dim, rotated.data() + i * stride);
+
+    hnswlib::BruteforceSearch<float> alg_brute(&space, max_elements);
+    hnswlib::HierarchicalNSW<float> alg_hnsw(&space_pca, max_elements, 16, 200);
+    for (int i = 0; i < max_elements; i++) {
+        alg_brute.addPoint(data.data() + i * dim, i);
+        alg_hnsw.addPoint(rotated.data() + i * stride, i);
+    }
+    alg_hnsw.setEf(200);
+
+    float correct = 0;
+    std::vector<float> query(stride);
+    for (int q = 0; q < num_queries; q++) {
+        const float *raw = data.data() + (q * 37 % max_elements) * dim;
+        space_pca.transform(raw, query.data());
+
+        auto gt = alg_brute.searchKnn(raw, k);
+        std::unordered_set<hnswlib::labeltype> gt_labels;
+        while (!gt.empty()) {
+            gt_labels.insert(gt.top().second);
+            gt.pop();
+        }
+        auto res = alg_hnsw.searchKnn(query.data(), k);
+        while (!res.empty()) {
+            correct += gt_labels.count(res.top().second);
+            res.pop();
+        }
+    }
+    float recall = correct / (num_queries * k);
+    std::cout << "pca recall: " << recall << "\n";
+    assert(recall > 0.9);
+    return 0;
+}
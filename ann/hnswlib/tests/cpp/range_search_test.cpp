@@ -0,0 +1,182 @@
+// Range search through HierarchicalNSW::searchRange and
+// BruteforceSearch::searchRange: correctness against the exact scan,
+// early stop, chunked delivery, filtering and deletions, plus throughput
+// at several radii compared with EpsilonSearchStopCondition.
+
+#include "../../hnswlib/hnswlib.h"
+
+#include <assert.h>
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <unordered_set>
+#include <vector>
+
+namespace {
+
+typedef std::vector<std::pair<float, hnswlib::labeltype>> Matches;
+
+class CollectAll : public hnswlib::BaseRangeCallback<float> {
+ public:
+    Matches matches;
+    bool operator()(hnswlib::labeltype label, float dist) override {
+        matches.emplace_back(dist, label);
+        return true;
+    }
+};
+
+class StopAfter : public hnswlib::BaseRangeCallback<float> {
+ public:
+    size_t limit;
+    size_t seen = 0;
+    explicit StopAfter(size_t limit) : limit(limit) {}
+    bool operator()(hnswlib::labeltype label, float dist) override {
+        return ++seen < limit;
+    }
+};
+
+class PickOdd : public hnswlib::BaseFilterFunctor {
+ public:
+    bool operator()(hnswlib::labeltype label) override {
+        return label % 2 == 1;
+    }
+};
+
+double seconds_since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+}  // namespace
+
+int main() {
+    size_t d = 16;
+    size_t n = 20000;
+    size_t nq = 50;
+    std::mt19937 rng(47);
+    std::uniform_real_distribution<float> distrib;
+    std::vector<float> data(n * d), queries(nq * d);
+    for (auto &v : data) v = distrib(rng);
+    for (auto &v : queries) v = distrib(rng);
+
+    hnswlib::L2Space space(d);
+    hnswlib::HierarchicalNSW<float> alg(&space, n, 16, 200);
+    hnswlib::BruteforceSearch<float> brute(&space, n);
+    for (size_t i = 0; i < n; i++) {
+        alg.addPoint(data.data() + i * d, i);
+        brute.addPoint(data.data() + i * d, i);
+    }
+    alg.setEf(32);
+
+    // Radii chosen so that a query has about 10, 100, 1000 and 5000 matches
+    std::vector<float> all_dists;
+    for (size_t i = 0; i < n; i++)
+        all_dists.push_back(space.get_dist_func()(queries.data(), data.data() + i * d, space.get_dist_func_param()));
+    std::sort(all_dists.begin(), all_dists.end());
+    std::vector<size_t> targets = {10, 100, 1000, 5000};
+
+    for (size_t target : targets) {
+        float radius = all_dists[target - 1];
+        size_t exact_total = 0, hnsw_total = 0, hits = 0;
+        double hnsw_s = 0, flat_s = 0, eps_s = 0;
+        size_t eps_total = 0;
+        for (size_t q = 0; q < nq; q++) {
+            const float *query = queries.data() + q * d;
+
+            CollectAll exact;
+            auto start = std::chrono::steady_clock::now();
+            brute.searchRange(query, radius, exact);
+            flat_s += seconds_since(start);
+
+            CollectAll approx;
+            start = std::chrono::steady_clock::now();
+            size_t delivered = alg.searchRange(query, radius, approx);
+            hnsw_s += seconds_since(start);
+            assert(delivered == approx.matches.size());
+
+            std::unordered_set<hnswlib::labeltype> expected;
+            for (auto &m : exact.matches) {
+                assert(m.first <= radius);
+                expected.insert(m.second);
+            }
+            std::unordered_set<hnswlib::labeltype> unique;
+            for (auto &m : approx.matches) {
+                assert(m.first <= radius);
+                assert(unique.insert(m.second).second);
+                hits += expected.count(m.second);
+            }
+            exact_total += exact.matches.size();
+            hnsw_total += approx.matches.size();
+
+            // The stop-condition route needs an upper bound on the result size
+            start = std::chrono::steady_clock::now();
+            hnswlib::EpsilonSearchStopCondition<float> stop_condition(radius, std::min<size_t>(32, target), 2 * target);
+            eps_total += alg.searchStopConditionClosest(query, stop_condition).size();
+            eps_s += seconds_since(start);
+        }
+        float recall = exact_total ? (float) hits / exact_total : 1.0f;
+        std::cout << "radius " << radius << " (~" << target << " matches): recall " << recall
+                  << ", HNSW " << nq / hnsw_s << " QPS / " << hnsw_total / hnsw_s << " matches/s"
+                  << ", flat " << nq / flat_s << " QPS"
+                  << ", epsilon stop condition " << nq / eps_s << " QPS (recall "
+                  << (exact_total ? (float) eps_total / exact_total : 1.0f) << " upper bound)\n";
+        assert(recall > 0.9f);
+    }
+
+    const float *query = queries.data();
+    float radius = all_dists[999];
+
+    // Returning false from the callback stops both searches right away
+    StopAfter stop_hnsw(25), stop_flat(25);
+    assert(alg.searchRange(query, radius, stop_hnsw) == 25);
+    assert(brute.searchRange(query, radius, stop_flat) == 25);
+
+    // Chunked delivery never holds more than chunk_size matches
+    size_t chunks = 0, delivered = 0;
+    hnswlib::RangeChunkBuffer<float> buffer(64, [&](const Matches &chunk) {
+        assert(chunk.size() <= 64);
+        chunks++;
+        delivered += chunk.size();
+        return true;
+    });
+    size_t found = alg.searchRange(query, radius, buffer);
+    buffer.finish();
+    assert(delivered == found);
+    assert(chunks == (found + 63) / 64);
+
+    // A chunk consumer can stop the search too
+    size_t consumed = 0;
+    hnswlib::RangeChunkBuffer<float> first_chunk(64, [&](const Matches &chunk) {
+        consumed += chunk.size();
+        return false;
+    });
+    assert(brute.searchRange(query, radius, first_chunk) == 64);
+    assert(consumed == 64);
+
+    // Filtered and deleted elements are skipped but still bridge the region
+    PickOdd odd;
+    CollectAll odd_hnsw, odd_flat;
+    alg.searchRange(query, radius, odd_hnsw, &odd);
+    brute.searchRange(query, radius, odd_flat, &odd);
+    for (auto &m : odd_hnsw.matches)
+        assert(m.second % 2 == 1);
+    assert(odd_hnsw.matches.size() > 0.9 * odd_flat.matches.size());
+
+    CollectAll before;
+    alg.searchRange(query, radius, before);
+    for (size_t i = 0; i < before.matches.size(); i += 2)
+        alg.markDelete(before.matches[i].second);
+    CollectAll after;
+    alg.searchRange(query, radius, after);
+    for (auto &m : after.matches)
+        assert(!alg.isMarkedDeleted(alg.label_lookup_[m.second]));
+    assert(after.matches.size() >= before.matches.size() / 2 - 1);
+
+    // Nothing within a radius below the nearest distance
+    CollectAll none;
+    assert(alg.searchRange(query, all_dists[0] * 0.5f, none) == 0);
+
+    std::cout << "All tests passed\n";
+    return 0;
+}
@@ -0,0 +1,157 @@
+// Chunked element storage of HierarchicalNSW: resizeIndex appends chunks
+// without moving existing elements, and the index keeps serving searches
+// while one thread grows it and keeps inserting.
+
+#include "../../hnswlib/hnswlib.h"
+
+#include <assert.h>
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+
+int main() {
+    size_t d = 16;
+    size_t n = 40000;
+    size_t initial = 1000;  // first chunk holds 1024 elements
+    std::mt19937 rng(47);
+    std::uniform_real_distribution<float> distrib;
+    std::vector<float> data(n * d);
+    for (auto &v : data) v = distrib(rng);
+
+    hnswlib::L2Space space(d);
+    hnswlib::HierarchicalNSW<float> alg(&space, initial, 16, 100);
+    assert(alg.data_level0_memory_.chunkShift() == 10);
+
+    for (size_t i = 0; i < initial; i++)
+        alg.addPoint(data.data() + i * d, i);
+    bool thrown = false;
+    try {
+        alg.addPoint(data.data() + initial * d, initial);
+    } catch (const std::runtime_error &) {
+        thrown = true;
+    }
+    assert(thrown);
+
+    // Growing keeps every element in place
+    const char *first = alg.getDataByInternalId(0);
+    const char *last = alg.getDataByInternalId(initial - 1);
+    alg.resizeIndex(5000);
+    assert(alg.getMaxElements() == 5000);
+    assert(alg.getDataByInternalId(0) == first);
+    assert(alg.getDataByInternalId(initial - 1) == last);
+    for (size_t i = initial; i < 5000; i++)
+        alg.addPoint(data.data() + i * d, i);
+
+    thrown = false;
+    try {
+        alg.resizeIndex(4999);
+    } catch (const std::runtime_error &) {
+        thrown = true;
+    }
+    assert(thrown);
+    alg.resizeIndex(5000);
+
+    // Resizing from inside a search would wait for the caller's own visited
+    // list, so it is refused instead of deadlocking
+    struct ResizingFilter : public hnswlib::BaseFilterFunctor {
+        hnswlib::HierarchicalNSW<float> &alg;
+        bool thrown = false;
+        explicit ResizingFilter(hnswlib::HierarchicalNSW<float> &alg) : alg(alg) {}
+        bool operator()(hnswlib::labeltype id) {
+            if (!thrown) {
+                try {
+                    alg.resizeIndex(6000);
+                } catch (const std::runtime_error &) {
+                    thrown = true;
+                }
+            }
+            return true;
+        }
+    } resizing(alg);
+    assert(alg.searchKnn(data.data(), 5, &resizing).size() == 5);
+    assert(resizing.thrown);
+    assert(alg.getMaxElements() == 5000);
+    alg.resizeIndex(5000);
+
+    // One writer grows the index whenever it is full while readers search
+    std::atomic<size_t> inserted{5000};
+    std::atomic<bool> done{false};
+    std::atomic<size_t> searches{0};
+    double max_resize_us = 0;
+    size_t resizes = 0;
+    std::thread writer([&]() {
+        for (size_t i = 5000; i < n; i++) {
+            if (alg.getCurrentElementCount() == alg.getMaxElements()) {
+                auto start = std::chrono::steady_clock::now();
+                alg.resizeIndex(alg.getMaxElements() + 3000);
+                double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+                max_resize_us = std::max(max_resize_us, us);
+                resizes++;
+            }
+            alg.addPoint(data.data() + i * d, i);
+            inserted.store(i + 1, std::memory_order_release);
+        }
+        done = true;
+    });
+    std::vector<std::thread> readers;
+    for (size_t r = 0; r < 2; r++) {
+        readers.emplace_back([&, r]() {
+            std::mt19937 gen(r);
+            while (!done) {
+                size_t visible = inserted.load(std::memory_order_acquire);
+                size_t target = gen() % visible;
+                // An element that is still being linked in can cut a search
+                // short, so only the validity of the results is checked
+                auto res = alg.searchKnn(data.data() + target * d, 5);
+                assert(!res.empty());
+                while (!res.empty()) {
+                    assert(res.top().second < alg.getCurrentElementCount());
+                    res.pop();
+                }
+                searches++;
+            }
+        });
+    }
+    writer.join();
+    for (auto &t : readers)
+        t.join();
+    assert(alg.getCurrentElementCount() == n);
+    assert(alg.data_level0_memory_.capacity() >= alg.getMaxElements());
+    assert(alg.getDataByInternalId(0) == first);
+
+    alg.setEf(50);
+    size_t hits = 0;
+    for (size_t i = 0; i < n; i += 7) {
+        auto res = alg.searchKnn(data.data() + i * d, 1);
+        hits += res.top().second == i;
+    }
+    float recall = (float) hits / ((n + 6) / 7);
+
+    // Save and load go chunk by chunk
+    std::string path = "segmented_storage_test.bin";
+    alg.saveIndex(path);
+    hnswlib::HierarchicalNSW<float> loaded(&space, path);
+    remove(path.c_str());
+    assert(loaded.getCurrentElementCount() == n);
+    loaded.setEf(50);
+    for (size_t i = 0; i < n; i += 101) {
+        auto a = alg.searchKnn(data.data() + i * d, 10);
+        auto b = loaded.searchKnn(data.data() + i * d, 10);
+        assert(a.size() == b.size());
+        while (!a.empty()) {
+            assert(a.top() == b.top());
+            a.pop();
+            b.pop();
+        }
+    }
+
+    std::cout << resizes << " resizes during ingestion, longest " << max_resize_us << " us, "
+              << searches << " concurrent searches, self recall " << recall << "\n";
+    assert(recall > 0.95f);
+    std::cout << "All tests passed\n";
+    return 0;
+}
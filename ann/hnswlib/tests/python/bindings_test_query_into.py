@@ -0,0 +1,54 @@
+import unittest
+
+import numpy as np
+
+import hnswlib
+
+
+class QueryIntoTestCase(unittest.TestCase):
+    def testQueryInto(self):
+        dim = 16
+        num_elements = 5000
+        k = 10
+
+        data = np.float32(np.random.random((num_elements, dim)))
+
+        for space in ['l2', 'cosine']:
+            p = hnswlib.Index(space=space, dim=dim)
+            p.init_index(max_elements=num_elements, ef_construction=100, M=16)
+            p.set_ef(50)
+            p.add_items(data)
+
+            # Batches of every size, including fewer queries than threads
+            for rows in [1, 3, 7, 100, 1000]:
+                queries = data[:rows]
+                labels = np.empty((rows, k), dtype=np.uint64)
+                distances = np.empty((rows, k), dtype=np.float32)
+                p.knn_query_into(queries, labels, distances, num_threads=4)
+
+                expected_labels, expected_distances = p.knn_query(queries, k=k, num_threads=1)
+                np.testing.assert_array_equal(labels, expected_labels)
+                np.testing.assert_allclose(distances, expected_distances, rtol=1e-6)
+
+            # The buffers are reused, not replaced
+            labels = np.zeros((10, k), dtype=np.uint64)
+            distances = np.zeros((10, k), dtype=np.float32)
+            labels_ptr = labels.__array_interface__['data'][0]
+            p.knn_query_into(data[:10], labels, distances)
+            self.assertEqual(labels.__array_interface__['data'][0], labels_ptr)
+            self.assertTrue(np.all(labels[:, 0] == np.arange(10)))
+
+    def testWrongBuffers(self):
+        dim = 8
+        data = np.float32(np.random.random((100, dim)))
+        p = hnswlib.Index(space='l2', dim=dim)
+        p.init_index(max_elements=100)
+        p.add_items(data)
+
+        distances = np.empty((10, 5), dtype=np.float32)
+        with self.assertRaises(RuntimeError):
+            p.knn_query_into(data[:10], np.empty((10, 5), dtype=np.int32), distances)
+        with self.assertRaises(RuntimeError):
+            p.knn_query_into(data[:10], np.empty((9, 5), dtype=np.uint64), distances)
+        with self.assertRaises(RuntimeError):
+            p.knn_query_into(data[:10], np.empty((5, 10), dtype=np.uint64).T, distances)
@@ -11,6 +11,13 @@
 #include <omp.h>
 #include "hnswlib/hnswlib/hnswlib.h"
 #include "flat_scan.h"
+#include "flat_scan_half.h"
+#include "flat_scan_pca.h"
+#include "query_cache.h"
+#include "numa_index.h"
+#include "perf_counter.h"
+#include "shard_server.h"
+#include "disk_index.h"
 // 可以自行添加需要的头文件
 
 using namespace hnswlib;
@@ -35,6 +42,50 @@ T *LoadData(std::string data_path, size_t& n, size_t& d)
     return data;
 }
 
+// 与 LoadData 相同，但数据放在 2MB 大页上（不支持时退化为普通分配），减少暴力扫描和随机访问时的 dTLB miss
+template<typename T>
+T *LoadDataHuge(std::string data_path, size_t& n, size_t& d, HugePageMode mode = HUGEPAGE_TRANSPARENT)
+{
+    std::ifstream fin;
+    fin.open(data_path, std::ios::in | std::ios::binary);
+    fin.read((char*)&n,4);
+    fin.read((char*)&d,4);
+    T* data = (T*)huge_malloc(n*d*sizeof(T), mode);
+    fin.read((char*)data, n*d*sizeof(T));
+    fin.close();
+
+    std::cerr<<"load data "<<data_path<<" on huge pages\n";
+    std::cerr<<"dimension: "<<d<<"  number:"<<n<<"  size_per_element:"<<sizeof(T)<<"\n";
+
+    return data;
+}
+
+// 读取 .fbin 后转换为 fp16（bf16 = false）或 bf16 存储，内存和带宽减半
+uint16_t *LoadDataHalf(std::string data_path, size_t& n, size_t& d, bool bf16 = false)
+{
+    float* data = LoadData<float>(data_path, n, d);
+    uint16_t* half = new uint16_t[n*d];
+    if (bf16) {
+        fp32_to_bf16_array(data, half, n*d);
+    } else {
+        fp32_to_fp16_array(data, half, n*d);
+    }
+    delete[] data;
+    return half;
+}
+
+// 用 base 拟合 PCA，并把 data 转成旋转后的存储格式（按方差降序的维度 + 各检查点的尾部范数）
+float *RotateData(PcaRotatedSpace& space, float* data, size_t n, size_t d)
+{
+    size_t stride = space.get_data_size() / sizeof(float);
+    float* rotated = new float[n*stride];
+    #pragma omp parallel for
+    for(size_t i = 0; i < n; ++i) {
+        space.transform(data + i*d, rotated + i*stride);
+    }
+    return rotated;
+}
+
 struct SearchResult
 {
     float recall;
@@ -60,6 +111,18 @@ void build_index(float* base, size_t base_number, size_t vecdim)
     appr_alg->saveIndex(path_index);
 }
 
+// 构建基于 SSD 的图索引（Vamana + PQ），完整向量和邻接表写入 files/disk.index
+void build_disk_index(float* base, size_t base_number, size_t vecdim)
+{
+    const size_t R = 32;    // 最大出度
+    const size_t L = 64;    // 构建时的候选列表长度
+    const float alpha = 1.2f;
+
+    InnerProductSpace ipspace(vecdim);
+    DiskIndex disk_index(&ipspace, true);
+    disk_index.build(base, base_number, vecdim, "files/disk.index", R, L, alpha);
+}
+
 
 int main(int argc, char *argv[])
 {
@@ -84,8 +147,46 @@ int main(int argc, char *argv[])
     // 不建议在正式测试查询时同时构建索引，否则性能波动会较大
     // 下面是一个构建hnsw索引的示例
     // build_index(base, base_number, vecdim);
+    // build_disk_index(base, base_number, vecdim);
+
+    // 磁盘索引查询：内存中只保留 PQ 编码，测试前丢弃索引文件的页缓存
+    // InnerProductSpace disk_space(vecdim);
+    // DiskIndex disk_index(&disk_space, true);
+    // disk_index.load("files/disk.index");
+    // disk_index.drop_page_cache();
+
+    // NUMA：每个节点加载一份 files/hnsw.index 副本（NUMA_INTERLEAVE 则只加载一份并交错分布），批量查询并按 socket 报告 QPS
+    // InnerProductSpace numa_space(vecdim);
+    // NumaIndex numa_index(&numa_space, "files/hnsw.index", NUMA_REPLICATE);
+    // std::vector<NumaIndex::Result> numa_results;
+    // NumaIndex::report(numa_index.search_batch(test_query, test_number, vecdim, k, numa_results), std::cout);
+
+    // 大页：base 改用 LoadDataHuge<float> 读取；HNSW 加载时传入 HUGEPAGE_TRANSPARENT（或需要预留大页的 HUGEPAGE_EXPLICIT）
+    // InnerProductSpace huge_space(vecdim);
+    // HierarchicalNSW<float> hnsw(&huge_space, "files/hnsw.index", false, 0, false, HUGEPAGE_TRANSPARENT);
+
+    // 图连通性诊断：报告各层从入口点不可达的节点数、出入度分布和 hubness；repairConnectivity 原地补边后
+    // 可再 saveIndex，分别用修复前后的索引跑下面的查询对比 recall
+    // InnerProductSpace repair_space(vecdim);
+    // HierarchicalNSW<float> repair_hnsw(&repair_space, "files/hnsw.index");
+    // repair_hnsw.analyzeGraph().report(std::cout);
+    // std::cout << "links added: " << repair_hnsw.repairConnectivity() << "\n";
+    // repair_hnsw.saveIndex("files/hnsw_repaired.index");
+
+    // 分片服务：build_shards 先把 base 切成 S 片（SHARD_RANDOM / SHARD_KMEANS）分别建索引，再由 S 个 worker 进程加载，
+    // 查询时并发发往所有分片并合并 top-k，结束后 shard_coordinator.report(std::cout) 输出各分位延迟
+    // InnerProductSpace shard_space(vecdim);
+    // build_shards(&shard_space, base, base_number, vecdim, 4, SHARD_KMEANS, "files/hnsw");
+    // ShardCoordinator shard_coordinator(&shard_space, "files/hnsw", 4, vecdim);
+
+    // 查询缓存：容量 10000 条，近重复阈值为 L2 平方距离 1e-4（0 表示只做精确命中）
+    // QueryCache<> cache(vecdim, 10000, 1e-4);
 
     
+    // dTLB miss 计数（对比大页前后），机器不支持 perf_event 时不输出；连同下面的 stop 和输出一起取消注释
+    // PerfCounter dtlb_miss(PerfCounter::DTLB_LOAD_MISS);
+    // dtlb_miss.start();
+
     // 查询测试代码
     for(int i = 0; i < test_number; ++i) {
         const unsigned long Converter = 1000 * 1000;
@@ -95,6 +196,13 @@ int main(int argc, char *argv[])
         // 该文件已有代码中你只能修改该函数的调用方式
         // 可以任意修改函数名，函数参数或者改为调用成员函数，但是不能修改函数返回值。
         auto res = flat_search(base, test_query + i*vecdim, base_number, vecdim, k);
+        // auto res = disk_index.search(test_query + i*vecdim, k, 64, 4);
+        // 半精度：base 和 test_query 改用 LoadDataHalf 读取
+        // auto res = flat_search_half(base, test_query + i*vecdim, base_number, vecdim, k);
+        // PCA 提前终止：PcaRotatedSpace pca_space(vecdim, base, base_number); 再用 RotateData 转换 base 和 test_query
+        // auto res = flat_search_pca(pca_base, pca_query + i*pca_stride, base_number, pca_space, k);
+        // auto res = shard_coordinator.search(test_query + i*vecdim, k);
+        // 带缓存：auto res = cache.search(test_query + i*vecdim, k, [&](const float* q, size_t kk) { return flat_search(base, (float*)q, base_number, vecdim, kk); });
 
         struct timeval newVal;
         ret = gettimeofday(&newVal, NULL);
@@ -119,6 +227,8 @@ int main(int argc, char *argv[])
         results[i] = {recall, diff};
     }
 
+    // uint64_t dtlb_misses = dtlb_miss.stop();
+
     float avg_recall = 0, avg_latency = 0;
     for(int i = 0; i < test_number; ++i) {
         avg_recall += results[i].recall;
@@ -128,5 +238,9 @@ int main(int argc, char *argv[])
     // 浮点误差可能导致一些精确算法平均recall不是1
     std::cout << "average recall: "<<avg_recall / test_number<<"\n";
     std::cout << "average latency (us): "<<avg_latency / test_number<<"\n";
+    // if (dtlb_miss.ok()) {
+    //     std::cout << "dTLB load misses per query: "<<(double)dtlb_misses / test_number<<"\n";
+    // }
+    // cache.stats().report(std::cout);
     return 0;
 }
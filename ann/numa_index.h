@@ -0,0 +1,321 @@
+#pragma once
+// NUMA 感知的 HNSW 索引放置和查询路由
+//
+// 默认情况下 data_level0_memory_ 由插入线程 first-touch，双路机器上另一个 socket 的查询全部访问远端内存。
+// 这里提供两种放置方式，索引都从 saveIndex 写出的文件加载：
+//   NUMA_REPLICATE   每个节点一份只读副本：在绑定到该节点 CPU 的线程里以 MPOL_BIND 策略加载，
+//                    查询路由到发起线程所在节点的副本
+//   NUMA_INTERLEAVE  只加载一份，页面按 MPOL_INTERLEAVE 在所有节点间交错分布，内存不翻倍，
+//                    平均一半访问是远端，但不会集中压在一个节点的内存控制器上
+// search_batch 在每个节点启动绑核的工作线程，按各节点线程数分配查询，分别统计每个 socket 的 QPS。
+// 内存策略直接走 set_mempolicy 系统调用，拓扑从 /sys/devices/system/node 读取，不依赖 libnuma；
+// 单节点或非 Linux 机器上退化为普通加载。
+
+#include <vector>
+#include <queue>
+#include <thread>
+#include <atomic>
+#include <string>
+#include <memory>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <sys/time.h>
+#include "hnswlib/hnswlib/hnswlib.h"
+#ifdef __linux__
+#include <sched.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <pthread.h>
+#include <sys/syscall.h>
+#define NUMA_INDEX_USE_SYSCALL
+#endif
+
+enum NumaMode
+{
+    NUMA_NONE,
+    NUMA_REPLICATE,
+    NUMA_INTERLEAVE,
+};
+
+// 每个节点的 CPU 列表，下标即节点号在 nodes 中的位置
+struct NumaTopology
+{
+    std::vector<int> node_ids;
+    std::vector<std::vector<int> > cpus;
+    std::vector<int> cpu_to_node;   // cpu 编号 -> nodes 下标
+
+    static std::vector<int> parse_cpulist(const std::string& list)
+    {
+        // 形如 "0-3,8-11"
+        std::vector<int> res;
+        std::stringstream ss(list);
+        std::string range;
+        while (std::getline(ss, range, ',')) {
+            if (range.empty() || range == "\n")
+                continue;
+            size_t dash = range.find('-');
+            int lo = atoi(range.c_str());
+            int hi = dash == std::string::npos ? lo : atoi(range.c_str() + dash + 1);
+            for (int c = lo; c <= hi; ++c)
+                res.push_back(c);
+        }
+        return res;
+    }
+
+    static NumaTopology detect()
+    {
+        NumaTopology topo;
+#ifdef NUMA_INDEX_USE_SYSCALL
+        DIR* dir = opendir("/sys/devices/system/node");
+        if (dir) {
+            std::vector<int> ids;
+            while (struct dirent* ent = readdir(dir)) {
+                if (strncmp(ent->d_name, "node", 4) == 0 && isdigit(ent->d_name[4]))
+                    ids.push_back(atoi(ent->d_name + 4));
+            }
+            closedir(dir);
+            std::sort(ids.begin(), ids.end());
+            for (int id : ids) {
+                std::ifstream fin("/sys/devices/system/node/node" + std::to_string(id) + "/cpulist");
+                std::string list;
+                std::getline(fin, list);
+                std::vector<int> cpus = parse_cpulist(list);
+                if (cpus.empty())
+                    continue;   // 只有内存没有 CPU 的节点（如 CXL / HBM）不参与路由
+                topo.node_ids.push_back(id);
+                topo.cpus.push_back(cpus);
+            }
+        }
+#endif
+        if (topo.node_ids.empty()) {
+            unsigned n = std::max(1u, std::thread::hardware_concurrency());
+            std::vector<int> all(n);
+            for (unsigned i = 0; i < n; ++i)
+                all[i] = i;
+            topo.node_ids.push_back(0);
+            topo.cpus.push_back(all);
+        }
+        int max_cpu = 0;
+        for (auto& list : topo.cpus)
+            for (int c : list)
+                max_cpu = std::max(max_cpu, c);
+        topo.cpu_to_node.assign(max_cpu + 1, 0);
+        for (size_t n = 0; n < topo.cpus.size(); ++n)
+            for (int c : topo.cpus[n])
+                topo.cpu_to_node[c] = n;
+        return topo;
+    }
+
+    size_t num_nodes() const
+    {
+        return node_ids.size();
+    }
+
+    // 当前线程所在节点（nodes 下标）
+    size_t current_node() const
+    {
+#ifdef NUMA_INDEX_USE_SYSCALL
+        int cpu = sched_getcpu();
+        if (cpu >= 0 && (size_t)cpu < cpu_to_node.size())
+            return cpu_to_node[cpu];
+#endif
+        return 0;
+    }
+
+    // 把当前线程绑定到节点的所有 CPU（cpu_index < 0）或其中一个 CPU
+    bool pin_current_thread(size_t node, int cpu_index = -1) const
+    {
+#ifdef NUMA_INDEX_USE_SYSCALL
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        if (cpu_index < 0) {
+            for (int c : cpus[node])
+                CPU_SET(c, &set);
+        } else {
+            CPU_SET(cpus[node][cpu_index % cpus[node].size()], &set);
+        }
+        return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+        return false;
+#endif
+    }
+};
+
+// 内存策略系统调用，常量与 <numaif.h> 一致
+static const int NUMA_MPOL_DEFAULT = 0;
+static const int NUMA_MPOL_BIND = 2;
+static const int NUMA_MPOL_INTERLEAVE = 3;
+static const size_t NUMA_MAX_NODES = 1024;
+
+// 设置当前线程之后分配的内存策略，nodes 为系统节点号
+inline bool numa_set_thread_policy(int mode, const std::vector<int>& nodes)
+{
+#ifdef NUMA_INDEX_USE_SYSCALL
+    unsigned long mask[NUMA_MAX_NODES / (8 * sizeof(unsigned long))] = {0};
+    for (int id : nodes) {
+        if (id >= 0 && (size_t)id < NUMA_MAX_NODES)
+            mask[id / (8 * sizeof(unsigned long))] |= 1ul << (id % (8 * sizeof(unsigned long)));
+    }
+    if (mode == NUMA_MPOL_DEFAULT)
+        return syscall(SYS_set_mempolicy, mode, nullptr, 0) == 0;
+    // 内核会先把 maxnode 减一，所以多传一位
+    return syscall(SYS_set_mempolicy, mode, mask, NUMA_MAX_NODES + 1) == 0;
+#else
+    (void)mode;
+    (void)nodes;
+    return false;
+#endif
+}
+
+struct NumaNodeStats
+{
+    int node;
+    size_t threads;
+    size_t queries;
+    double seconds;
+
+    double qps() const
+    {
+        return seconds > 0 ? queries / seconds : 0;
+    }
+};
+
+class NumaIndex
+{
+public:
+    typedef std::priority_queue<std::pair<float, hnswlib::labeltype> > Result;
+
+    // threads_per_node = 0 表示使用节点上的全部 CPU
+    NumaIndex(hnswlib::SpaceInterface<float>* space, const std::string& path, NumaMode mode,
+              size_t threads_per_node = 0)
+        : topo_(NumaTopology::detect()), mode_(mode)
+    {
+        size_t replicas = (mode == NUMA_REPLICATE) ? topo_.num_nodes() : 1;
+        replicas_.resize(replicas);
+        std::vector<std::thread> loaders;
+        for (size_t n = 0; n < replicas; ++n) {
+            loaders.emplace_back([this, n, space, &path]() {
+                // set_mempolicy 只影响当前线程，在单独的线程里加载不会改变调用者的策略
+                if (mode_ == NUMA_REPLICATE) {
+                    topo_.pin_current_thread(n);
+                    numa_set_thread_policy(NUMA_MPOL_BIND, {topo_.node_ids[n]});
+                } else if (mode_ == NUMA_INTERLEAVE) {
+                    numa_set_thread_policy(NUMA_MPOL_INTERLEAVE, topo_.node_ids);
+                }
+                replicas_[n].reset(new hnswlib::HierarchicalNSW<float>(space, path));
+            });
+        }
+        for (auto& t : loaders)
+            t.join();
+
+        threads_per_node_.resize(topo_.num_nodes());
+        for (size_t n = 0; n < topo_.num_nodes(); ++n) {
+            size_t cpus = topo_.cpus[n].size();
+            threads_per_node_[n] = threads_per_node ? std::min(threads_per_node, cpus) : cpus;
+        }
+        std::cerr << "numa nodes: " << topo_.num_nodes() << "  replicas: " << replicas << "\n";
+    }
+
+    size_t num_nodes() const
+    {
+        return topo_.num_nodes();
+    }
+
+    void setEf(size_t ef)
+    {
+        for (auto& r : replicas_)
+            r->setEf(ef);
+    }
+
+    // 使用调用线程所在节点的副本
+    Result searchKnn(const float* query, size_t k) const
+    {
+        return replica(topo_.current_node()).searchKnn(query, k);
+    }
+
+    // 各节点按线程数分担查询，工作线程绑核后只访问本地副本；results 按查询下标写回
+    std::vector<NumaNodeStats> search_batch(const float* queries, size_t query_number, size_t dim, size_t k,
+                                            std::vector<Result>& results) const
+    {
+        results.resize(query_number);
+        size_t nodes = topo_.num_nodes();
+        size_t total_threads = 0;
+        for (size_t t : threads_per_node_)
+            total_threads += t;
+
+        // 按线程数比例切分查询区间，每个节点内部用原子游标动态分配
+        std::vector<size_t> begin(nodes + 1, 0);
+        size_t acc = 0;
+        for (size_t n = 0; n < nodes; ++n) {
+            acc += threads_per_node_[n];
+            begin[n + 1] = query_number * acc / total_threads;
+        }
+        std::vector<std::atomic<size_t> > cursor(nodes);
+        for (size_t n = 0; n < nodes; ++n)
+            cursor[n] = begin[n];
+
+        std::vector<NumaNodeStats> stats(nodes);
+        std::vector<std::vector<std::thread> > workers(nodes);
+        std::vector<double> start(nodes), finish(nodes);
+        std::vector<std::atomic<size_t> > running(nodes);
+        for (size_t n = 0; n < nodes; ++n) {
+            running[n] = threads_per_node_[n];
+            start[n] = now_seconds();
+            for (size_t t = 0; t < threads_per_node_[n]; ++t) {
+                workers[n].emplace_back([&, n, t]() {
+                    topo_.pin_current_thread(n, t);
+                    const hnswlib::HierarchicalNSW<float>& index = replica(n);
+                    size_t i;
+                    while ((i = cursor[n].fetch_add(1)) < begin[n + 1])
+                        results[i] = index.searchKnn(queries + i * dim, k);
+                    if (running[n].fetch_sub(1) == 1)
+                        finish[n] = now_seconds();
+                });
+            }
+        }
+        for (auto& list : workers)
+            for (auto& t : list)
+                t.join();
+
+        for (size_t n = 0; n < nodes; ++n) {
+            stats[n].node = topo_.node_ids[n];
+            stats[n].threads = threads_per_node_[n];
+            stats[n].queries = begin[n + 1] - begin[n];
+            stats[n].seconds = finish[n] - start[n];
+        }
+        return stats;
+    }
+
+    static void report(const std::vector<NumaNodeStats>& stats, std::ostream& out)
+    {
+        double total = 0;
+        for (auto& s : stats) {
+            out << "node " << s.node << "  threads: " << s.threads << "  queries: " << s.queries
+                << "  QPS: " << s.qps() << "\n";
+            total += s.qps();
+        }
+        out << "total QPS: " << total << "\n";
+    }
+
+private:
+    const hnswlib::HierarchicalNSW<float>& replica(size_t node) const
+    {
+        return *replicas_[mode_ == NUMA_REPLICATE ? node : 0];
+    }
+
+    static double now_seconds()
+    {
+        struct timeval val;
+        gettimeofday(&val, NULL);
+        return val.tv_sec + val.tv_usec * 1e-6;
+    }
+
+    NumaTopology topo_;
+    NumaMode mode_;
+    std::vector<std::unique_ptr<hnswlib::HierarchicalNSW<float> > > replicas_;
+    std::vector<size_t> threads_per_node_;
+};
@@ -0,0 +1,90 @@
+#pragma once
+// 基于 perf_event_open 的硬件计数器，用于在测试输出里报告 dTLB miss 等指标
+// 只统计用户态、只统计调用线程；内核不允许（perf_event_paranoid 过高）或虚拟机没有 PMU 时 ok() 返回 false
+
+#include <cstdint>
+#include <cstring>
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+class PerfCounter
+{
+public:
+    enum Event
+    {
+        DTLB_LOAD_MISS,
+        DTLB_LOAD,
+        CYCLES,
+    };
+
+    explicit PerfCounter(Event event)
+    {
+#ifdef __linux__
+        struct perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        if (event == CYCLES) {
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_CPU_CYCLES;
+        } else {
+            attr.type = PERF_TYPE_HW_CACHE;
+            attr.config = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                          ((event == DTLB_LOAD_MISS ? PERF_COUNT_HW_CACHE_RESULT_MISS
+                                                    : PERF_COUNT_HW_CACHE_RESULT_ACCESS) << 16);
+        }
+        fd_ = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+#else
+        (void)event;
+#endif
+    }
+
+    ~PerfCounter()
+    {
+#ifdef __linux__
+        if (fd_ >= 0)
+            close(fd_);
+#endif
+    }
+
+    bool ok() const
+    {
+        return fd_ >= 0;
+    }
+
+    void start()
+    {
+#ifdef __linux__
+        if (fd_ >= 0) {
+            ioctl(fd_, PERF_EVENT_IOC_RESET, 0);
+            ioctl(fd_, PERF_EVENT_IOC_ENABLE, 0);
+        }
+#endif
+    }
+
+    // 停止计数并返回 start() 以来的计数值
+    uint64_t stop()
+    {
+        uint64_t value = 0;
+#ifdef __linux__
+        if (fd_ >= 0) {
+            ioctl(fd_, PERF_EVENT_IOC_DISABLE, 0);
+            if (read(fd_, &value, sizeof(value)) != sizeof(value))
+                value = 0;
+        }
+#endif
+        return value;
+    }
+
+private:
+    PerfCounter(const PerfCounter&);
+    PerfCounter& operator=(const PerfCounter&);
+
+    int fd_ = -1;
+};
@@ -0,0 +1,265 @@
+#pragma once
+// 查询结果缓存，放在 HierarchicalNSW::searchKnn / flat_search 前面
+//
+// 两级查找共用同一份条目：
+//   精确命中   以 (k, 查询向量字节) 的哈希为键，命中后再逐字节比较，返回的结果与原查询完全一致
+//   近重复命中 以 SimHash（随机超平面 LSH）签名为键，命中后检查两条查询的 L2 平方距离
+//              不超过 near_eps 才复用结果，near_eps = 0 时关闭
+// 按 LSH 签名分片（相同向量签名必然相同，所以精确查找也落在同一分片），每个分片一把锁；
+// 每个分片固定 capacity / shards 个槽位，满了以后用 CLOCK 淘汰，内存上界约为
+// capacity * (dim * 4 + k * sizeof(结果元素)) 字节
+
+#include <vector>
+#include <queue>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <memory>
+#include <cstring>
+#include <cstdint>
+#include <iostream>
+#include <unordered_map>
+
+struct QueryCacheStats
+{
+    uint64_t lookups;
+    uint64_t exact_hits;
+    uint64_t near_hits;
+    uint64_t misses;
+    uint64_t evictions;
+    double lookup_us;   // 查缓存（含插入）累计耗时
+    double search_us;   // 未命中时实际搜索累计耗时
+
+    void report(std::ostream& out) const
+    {
+        double n = lookups ? (double)lookups : 1.0;
+        out << "cache lookups: " << lookups
+            << "  exact hit rate: " << exact_hits / n
+            << "  near hit rate: " << near_hits / n
+            << "  evictions: " << evictions << "\n";
+        out << "cache overhead (us/query): " << lookup_us / n
+            << "  search on miss (us/miss): " << (misses ? search_us / misses : 0.0) << "\n";
+    }
+};
+
+template<typename Result = std::priority_queue<std::pair<float, uint32_t> > >
+class QueryCache
+{
+public:
+    QueryCache(size_t dim, size_t capacity, float near_eps = 0, size_t num_shards = 16, size_t lsh_bits = 16)
+        : dim_(dim), near_eps_(near_eps), lsh_bits_(lsh_bits > 64 ? 64 : lsh_bits)
+    {
+        if (num_shards == 0)
+            num_shards = 1;
+        size_t slots = (capacity + num_shards - 1) / num_shards;
+        if (slots == 0)
+            slots = 1;
+        for (size_t i = 0; i < num_shards; ++i)
+            shards_.emplace_back(new Shard(slots, dim));
+
+        std::mt19937 rng(2024);
+        std::normal_distribution<float> gauss;
+        planes_.resize(lsh_bits_ * dim);
+        for (auto& v : planes_)
+            v = gauss(rng);
+    }
+
+    // 命中时把缓存的结果写入 out 并返回 true
+    bool lookup(const float* query, size_t k, Result& out)
+    {
+        uint64_t sig = signature(query, k);
+        uint64_t h = exact_hash(query, k);
+        Shard& shard = *shards_[sig % shards_.size()];
+        lookups_.fetch_add(1, std::memory_order_relaxed);
+
+        std::lock_guard<std::mutex> lock(shard.mu);
+        auto it = shard.exact.find(h);
+        if (it != shard.exact.end()) {
+            Entry& e = shard.entries[it->second];
+            if (e.k == k && memcmp(e.query.data(), query, dim_ * sizeof(float)) == 0) {
+                e.referenced = true;
+                out = e.result;
+                exact_hits_.fetch_add(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+        if (near_eps_ > 0) {
+            auto nit = shard.near.find(sig);
+            if (nit != shard.near.end()) {
+                Entry& e = shard.entries[nit->second];
+                if (e.k == k && l2_sqr(e.query.data(), query) <= near_eps_) {
+                    e.referenced = true;
+                    out = e.result;
+                    near_hits_.fetch_add(1, std::memory_order_relaxed);
+                    return true;
+                }
+            }
+        }
+        misses_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    void insert(const float* query, size_t k, const Result& result)
+    {
+        uint64_t sig = signature(query, k);
+        uint64_t h = exact_hash(query, k);
+        Shard& shard = *shards_[sig % shards_.size()];
+
+        std::lock_guard<std::mutex> lock(shard.mu);
+        if (shard.exact.count(h))
+            return;  // 另一个线程已经插入
+
+        // CLOCK：跳过最近被引用过的槽位并清掉引用位
+        size_t slot;
+        while (true) {
+            slot = shard.hand;
+            shard.hand = (shard.hand + 1) % shard.entries.size();
+            Entry& e = shard.entries[slot];
+            if (!e.valid)
+                break;
+            if (e.referenced) {
+                e.referenced = false;
+                continue;
+            }
+            auto it = shard.exact.find(e.hash);
+            if (it != shard.exact.end() && it->second == slot)
+                shard.exact.erase(it);
+            auto nit = shard.near.find(e.signature);
+            if (nit != shard.near.end() && nit->second == slot)
+                shard.near.erase(nit);
+            evictions_.fetch_add(1, std::memory_order_relaxed);
+            break;
+        }
+
+        Entry& e = shard.entries[slot];
+        e.valid = true;
+        e.referenced = false;
+        e.k = k;
+        e.hash = h;
+        e.signature = sig;
+        memcpy(e.query.data(), query, dim_ * sizeof(float));
+        e.result = result;
+        shard.exact[h] = slot;
+        shard.near[sig] = slot;  // 同一签名只保留最新的代表
+    }
+
+    // 先查缓存，未命中时调用 search(query, k) 并把结果放入缓存
+    template<typename SearchFn>
+    Result search(const float* query, size_t k, SearchFn search)
+    {
+        auto t0 = std::chrono::steady_clock::now();
+        Result res;
+        if (lookup(query, k, res)) {
+            add_time(lookup_ns_, t0, std::chrono::steady_clock::now());
+            return res;
+        }
+        auto t1 = std::chrono::steady_clock::now();
+        res = search(query, k);
+        auto t2 = std::chrono::steady_clock::now();
+        insert(query, k, res);
+        auto t3 = std::chrono::steady_clock::now();
+        add_time(lookup_ns_, t0, t1);
+        add_time(lookup_ns_, t2, t3);
+        add_time(search_ns_, t1, t2);
+        return res;
+    }
+
+    QueryCacheStats stats() const
+    {
+        QueryCacheStats s;
+        s.lookups = lookups_.load();
+        s.exact_hits = exact_hits_.load();
+        s.near_hits = near_hits_.load();
+        s.misses = misses_.load();
+        s.evictions = evictions_.load();
+        s.lookup_us = lookup_ns_.load() / 1000.0;
+        s.search_us = search_ns_.load() / 1000.0;
+        return s;
+    }
+
+private:
+    struct Entry
+    {
+        bool valid = false;
+        bool referenced = false;
+        size_t k = 0;
+        uint64_t hash = 0;
+        uint64_t signature = 0;
+        std::vector<float> query;
+        Result result;
+    };
+
+    struct Shard
+    {
+        std::mutex mu;
+        std::vector<Entry> entries;
+        size_t hand = 0;
+        std::unordered_map<uint64_t, size_t> exact;
+        std::unordered_map<uint64_t, size_t> near;
+
+        Shard(size_t slots, size_t dim) : entries(slots)
+        {
+            for (auto& e : entries)
+                e.query.resize(dim);
+        }
+    };
+
+    // FNV-1a 按字节哈希
+    uint64_t exact_hash(const float* query, size_t k) const
+    {
+        uint64_t h = 1469598103934665603ull ^ k;
+        const unsigned char* p = (const unsigned char*)query;
+        for (size_t i = 0; i < dim_ * sizeof(float); ++i) {
+            h ^= p[i];
+            h *= 1099511628211ull;
+        }
+        return h;
+    }
+
+    // SimHash 签名，k 混入高位使不同 k 的查询互不干扰
+    uint64_t signature(const float* query, size_t k) const
+    {
+        uint64_t sig = 0;
+        for (size_t b = 0; b < lsh_bits_; ++b) {
+            const float* plane = planes_.data() + b * dim_;
+            float dot = 0;
+            for (size_t i = 0; i < dim_; ++i)
+                dot += plane[i] * query[i];
+            if (dot >= 0)
+                sig |= 1ull << b;
+        }
+        return sig ^ ((uint64_t)k * 0x9e3779b97f4a7c15ull);
+    }
+
+    float l2_sqr(const float* a, const float* b) const
+    {
+        float res = 0;
+        for (size_t i = 0; i < dim_; ++i) {
+            float t = a[i] - b[i];
+            res += t * t;
+        }
+        return res;
+    }
+
+    static void add_time(std::atomic<uint64_t>& acc, std::chrono::steady_clock::time_point from,
+                         std::chrono::steady_clock::time_point to)
+    {
+        acc.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(to - from).count(),
+                      std::memory_order_relaxed);
+    }
+
+    size_t dim_;
+    float near_eps_;
+    size_t lsh_bits_;
+    std::vector<float> planes_;
+    std::vector<std::unique_ptr<Shard> > shards_;
+
+    std::atomic<uint64_t> lookups_{0};
+    std::atomic<uint64_t> exact_hits_{0};
+    std::atomic<uint64_t> near_hits_{0};
+    std::atomic<uint64_t> misses_{0};
+    std::atomic<uint64_t> evictions_{0};
+    std::atomic<uint64_t> lookup_ns_{0};
+    std::atomic<uint64_t> search_ns_{0};
+};
@@ -0,0 +1,392 @@
+#pragma once
+// 分片多进程服务：把 base 切成 S 个分片（随机或 k-means），每个分片单独建 HNSW 索引，
+// 由本机独立的 worker 进程加载并通过 Unix socket 提供查询，协调者并发发出请求后合并 top-k。
+//
+// 协议（本机进程间通信，按主机字节序）：
+//   请求  ShardRequest 头 + dim 个 float；dim 须等于分片索引的维度，0 < k <= 分片容量，否则 worker 关闭连接
+//   响应  ShardResponse 头 + count 个 ShardHit，按距离从近到远
+// 每条连接串行处理请求，worker 为每个连接开一个线程，多个协调者可以连接同一组 worker。
+// 分片索引的 label 直接使用全局 id，合并时不需要再做映射。
+
+#include <vector>
+#include <queue>
+#include <thread>
+#include <string>
+#include <random>
+#include <limits>
+#include <iostream>
+#include <algorithm>
+#include <stdexcept>
+#include <cstring>
+#include <cstdint>
+#include <cerrno>
+#include <csignal>
+#include <unistd.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "hnswlib/hnswlib/hnswlib.h"
+
+static const uint32_t SHARD_MAGIC = 0x44524853; // "SHRD"
+
+struct ShardRequest
+{
+    uint32_t magic;
+    uint32_t k;
+    uint32_t dim;
+};
+
+struct ShardResponse
+{
+    uint32_t count;
+};
+
+struct ShardHit
+{
+    float dist;
+    uint32_t label;
+};
+
+enum ShardPartition
+{
+    SHARD_RANDOM,
+    SHARD_KMEANS,
+};
+
+inline bool shard_write_all(int fd, const void* buf, size_t len)
+{
+    const char* p = (const char*)buf;
+    while (len > 0) {
+        ssize_t r = send(fd, p, len, MSG_NOSIGNAL);  // 对端进程退出时返回错误而不是触发 SIGPIPE
+        if (r < 0 && errno == EINTR)
+            continue;
+        if (r <= 0)
+            return false;
+        p += r;
+        len -= r;
+    }
+    return true;
+}
+
+inline bool shard_read_all(int fd, void* buf, size_t len)
+{
+    char* p = (char*)buf;
+    while (len > 0) {
+        ssize_t r = read(fd, p, len);
+        if (r < 0 && errno == EINTR)
+            continue;
+        if (r <= 0)
+            return false;
+        p += r;
+        len -= r;
+    }
+    return true;
+}
+
+// 返回每个分片包含的全局 id
+inline std::vector<std::vector<uint32_t> > partition_base(const float* base, size_t n, size_t dim, size_t shards,
+                                                          ShardPartition mode, size_t iters = 10, unsigned seed = 1)
+{
+    std::vector<std::vector<uint32_t> > parts(shards);
+    std::mt19937 rng(seed);
+    if (mode == SHARD_RANDOM || shards == 1) {
+        std::vector<uint32_t> perm(n);
+        for (size_t i = 0; i < n; ++i)
+            perm[i] = i;
+        std::shuffle(perm.begin(), perm.end(), rng);
+        for (size_t i = 0; i < n; ++i)
+            parts[i % shards].push_back(perm[i]);
+        for (auto& p : parts)
+            std::sort(p.begin(), p.end());
+        return parts;
+    }
+
+    // k-means（L2），初始中心从 base 中随机抽取；空簇重新随机抽一个点
+    std::vector<float> centroids(shards * dim);
+    std::uniform_int_distribution<size_t> pick(0, n - 1);
+    for (size_t s = 0; s < shards; ++s)
+        memcpy(centroids.data() + s * dim, base + pick(rng) * dim, dim * sizeof(float));
+
+    std::vector<uint32_t> assign(n);
+    for (size_t it = 0; it <= iters; ++it) {
+        #pragma omp parallel for
+        for (long long i = 0; i < (long long)n; ++i) {
+            const float* x = base + i * dim;
+            float best = std::numeric_limits<float>::max();
+            for (size_t s = 0; s < shards; ++s) {
+                const float* c = centroids.data() + s * dim;
+                float dis = 0;
+                for (size_t j = 0; j < dim; ++j)
+                    dis += (x[j] - c[j]) * (x[j] - c[j]);
+                if (dis < best) {
+                    best = dis;
+                    assign[i] = s;
+                }
+            }
+        }
+        if (it == iters)
+            break;
+        std::vector<double> sum(shards * dim, 0);
+        std::vector<size_t> cnt(shards, 0);
+        for (size_t i = 0; i < n; ++i) {
+            cnt[assign[i]]++;
+            for (size_t j = 0; j < dim; ++j)
+                sum[assign[i] * dim + j] += base[i * dim + j];
+        }
+        for (size_t s = 0; s < shards; ++s) {
+            if (cnt[s] == 0) {
+                memcpy(centroids.data() + s * dim, base + pick(rng) * dim, dim * sizeof(float));
+                continue;
+            }
+            for (size_t j = 0; j < dim; ++j)
+                centroids[s * dim + j] = sum[s * dim + j] / cnt[s];
+        }
+    }
+    for (size_t i = 0; i < n; ++i)
+        parts[assign[i]].push_back(i);
+    return parts;
+}
+
+inline std::string shard_index_path(const std::string& prefix, size_t shard)
+{
+    return prefix + ".shard" + std::to_string(shard);
+}
+
+// 为每个分片构建 HNSW 并保存到 <prefix>.shard<i>，label 为全局 id
+inline void build_shards(hnswlib::SpaceInterface<float>* space, const float* base, size_t n, size_t dim,
+                         size_t shards, ShardPartition mode, const std::string& prefix,
+                         size_t M = 16, size_t ef_construction = 150)
+{
+    auto parts = partition_base(base, n, dim, shards, mode);
+    for (size_t s = 0; s < shards; ++s) {
+        const std::vector<uint32_t>& ids = parts[s];
+        hnswlib::HierarchicalNSW<float> index(space, std::max<size_t>(ids.size(), 1), M, ef_construction);
+        #pragma omp parallel for
+        for (long long i = 0; i < (long long)ids.size(); ++i)
+            index.addPoint(base + 1ll * ids[i] * dim, ids[i]);
+        index.saveIndex(shard_index_path(prefix, s));
+        std::cerr << "shard " << s << ": " << ids.size() << " points\n";
+    }
+}
+
+// worker 进程主循环：加载分片索引，在 socket_path 上接受连接，直到被 SIGTERM 结束
+inline void run_shard_worker(hnswlib::SpaceInterface<float>* space, const std::string& index_path,
+                             const std::string& socket_path, size_t ef)
+{
+    hnswlib::HierarchicalNSW<float> index(space, index_path);
+    index.setEf(ef);
+    // searchKnn 按索引的维度读取查询，请求的 dim 必须与之相同；k 不超过分片的容量
+    const size_t dim = index.data_size_ / sizeof(float);
+    const size_t max_k = index.getMaxElements();
+
+    int listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, socket_path.c_str(), sizeof(addr.sun_path) - 1);
+    unlink(socket_path.c_str());
+    if (listen_fd < 0 || bind(listen_fd, (sockaddr*)&addr, sizeof(addr)) != 0 || listen(listen_fd, 64) != 0) {
+        std::cerr << "shard worker: cannot listen on " << socket_path << ": " << strerror(errno) << "\n";
+        _exit(1);
+    }
+
+    while (true) {
+        int fd = accept(listen_fd, nullptr, nullptr);
+        if (fd < 0) {
+            if (errno == EINTR)
+                continue;
+            break;
+        }
+        std::thread([&index, fd, dim, max_k]() {
+            ShardRequest req;
+            std::vector<float> query;
+            std::vector<ShardHit> hits;
+            // 不合法的请求直接关闭连接，协调者那边表现为收发失败
+            while (shard_read_all(fd, &req, sizeof(req)) && req.magic == SHARD_MAGIC && req.dim == dim &&
+                   req.k > 0 && req.k <= max_k) {
+                query.resize(req.dim);
+                if (!shard_read_all(fd, query.data(), req.dim * sizeof(float)))
+                    break;
+                auto res = index.searchKnn(query.data(), req.k);
+                hits.resize(res.size());
+                for (size_t i = hits.size(); i-- > 0;) {
+                    hits[i] = {res.top().first, (uint32_t)res.top().second};
+                    res.pop();
+                }
+                ShardResponse resp = {(uint32_t)hits.size()};
+                if (!shard_write_all(fd, &resp, sizeof(resp)) ||
+                    !shard_write_all(fd, hits.data(), hits.size() * sizeof(ShardHit)))
+                    break;
+            }
+            close(fd);
+        }).detach();
+    }
+    _exit(0);
+}
+
+struct ShardLatencyStats
+{
+    size_t queries;
+    double mean_us;
+    double p50_us;
+    double p95_us;
+    double p99_us;
+    double max_us;
+};
+
+class ShardCoordinator
+{
+public:
+    // 启动 shards 个 worker 进程，分别加载 <prefix>.shard<i>
+    ShardCoordinator(hnswlib::SpaceInterface<float>* space, const std::string& prefix, size_t shards, size_t dim,
+                     size_t ef = 100)
+        : dim_(dim)
+    {
+        try {
+            for (size_t s = 0; s < shards; ++s) {
+                std::string socket_path = "/tmp/ann_shard_" + std::to_string(getpid()) + "_" + std::to_string(s) + ".sock";
+                unlink(socket_path.c_str());
+                pid_t pid = fork();
+                if (pid < 0)
+                    throw std::runtime_error("ShardCoordinator: fork failed");
+                if (pid == 0) {
+                    // 子进程不能把异常抛回调用者的代码里（那样会多出一份继续运行的父进程），无论如何都 _exit
+                    try {
+                        run_shard_worker(space, shard_index_path(prefix, s), socket_path, ef);
+                    } catch (const std::exception& e) {
+                        std::cerr << "shard worker " << s << ": " << e.what() << "\n";
+                    } catch (...) {
+                        std::cerr << "shard worker " << s << ": unknown exception\n";
+                    }
+                    _exit(1);
+                }
+                pids_.push_back(pid);
+                socket_paths_.push_back(socket_path);
+            }
+            for (size_t s = 0; s < shards; ++s)
+                fds_.push_back(connect_shard(socket_paths_[s], pids_[s]));
+        } catch (...) {
+            // 构造失败时析构函数不会运行，先结束并回收已经启动的 worker
+            stop_workers();
+            throw;
+        }
+    }
+
+    ~ShardCoordinator()
+    {
+        stop_workers();
+    }
+
+    size_t num_shards() const
+    {
+        return fds_.size();
+    }
+
+    // 先向所有分片发出请求，worker 进程并行搜索，再依次收回结果合并 top-k；记录端到端延迟
+    std::priority_queue<std::pair<float, uint32_t> > search(const float* query, size_t k)
+    {
+        struct timeval t0;
+        gettimeofday(&t0, NULL);
+
+        ShardRequest req = {SHARD_MAGIC, (uint32_t)k, (uint32_t)dim_};
+        for (int fd : fds_) {
+            if (!shard_write_all(fd, &req, sizeof(req)) || !shard_write_all(fd, query, dim_ * sizeof(float)))
+                throw std::runtime_error("ShardCoordinator: send failed");
+        }
+
+        std::priority_queue<std::pair<float, uint32_t> > merged;
+        std::vector<ShardHit> hits;
+        for (int fd : fds_) {
+            ShardResponse resp;
+            if (!shard_read_all(fd, &resp, sizeof(resp)))
+                throw std::runtime_error("ShardCoordinator: receive failed");
+            hits.resize(resp.count);
+            if (!shard_read_all(fd, hits.data(), resp.count * sizeof(ShardHit)))
+                throw std::runtime_error("ShardCoordinator: receive failed");
+            for (const ShardHit& h : hits) {
+                if (merged.size() < k) {
+                    merged.push({h.dist, h.label});
+                } else if (h.dist < merged.top().first) {
+                    merged.push({h.dist, h.label});
+                    merged.pop();
+                } else {
+                    break;  // 每个分片的结果按距离升序，后面的更远
+                }
+            }
+        }
+
+        struct timeval t1;
+        gettimeofday(&t1, NULL);
+        latencies_.push_back((t1.tv_sec - t0.tv_sec) * 1e6 + (t1.tv_usec - t0.tv_usec));
+        return merged;
+    }
+
+    ShardLatencyStats latency_stats() const
+    {
+        ShardLatencyStats stats = {latencies_.size(), 0, 0, 0, 0, 0};
+        if (latencies_.empty())
+            return stats;
+        std::vector<double> sorted = latencies_;
+        std::sort(sorted.begin(), sorted.end());
+        double sum = 0;
+        for (double v : sorted)
+            sum += v;
+        auto pct = [&](double p) { return sorted[std::min(sorted.size() - 1, (size_t)(p * sorted.size()))]; };
+        stats.mean_us = sum / sorted.size();
+        stats.p50_us = pct(0.50);
+        stats.p95_us = pct(0.95);
+        stats.p99_us = pct(0.99);
+        stats.max_us = sorted.back();
+        return stats;
+    }
+
+    void report(std::ostream& out) const
+    {
+        ShardLatencyStats s = latency_stats();
+        out << "shards: " << num_shards() << "  queries: " << s.queries << "  mean (us): " << s.mean_us
+            << "  p50: " << s.p50_us << "  p95: " << s.p95_us << "  p99: " << s.p99_us << "  max: " << s.max_us << "\n";
+    }
+
+private:
+    void stop_workers()
+    {
+        for (int fd : fds_)
+            close(fd);
+        for (pid_t pid : pids_)
+            kill(pid, SIGTERM);
+        for (pid_t pid : pids_)
+            waitpid(pid, nullptr, 0);
+        for (auto& path : socket_paths_)
+            unlink(path.c_str());
+        fds_.clear();
+        pids_.clear();
+        socket_paths_.clear();
+    }
+
+    // worker 加载索引需要时间，重试连接直到 socket 就绪或进程退出
+    static int connect_shard(const std::string& socket_path, pid_t pid)
+    {
+        sockaddr_un addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        strncpy(addr.sun_path, socket_path.c_str(), sizeof(addr.sun_path) - 1);
+        while (true) {
+            int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+            if (fd < 0)
+                throw std::runtime_error("ShardCoordinator: socket failed");
+            if (connect(fd, (sockaddr*)&addr, sizeof(addr)) == 0)
+                return fd;
+            close(fd);
+            if (waitpid(pid, nullptr, WNOHANG) == pid)
+                throw std::runtime_error("ShardCoordinator: worker for " + socket_path + " exited");
+            usleep(10000);
+        }
+    }
+
+    size_t dim_;
+    std::vector<pid_t> pids_;
+    std::vector<std::string> socket_paths_;
+    std::vector<int> fds_;
+    std::vector<double> latencies_;
+};
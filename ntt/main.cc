@@ -3,6 +3,9 @@
 #include "src/include/CRT/ntt.h"
 #include "src/include/pthread_crt/ntt.h"
 #include "src/include/pthread_simple/ntt.h"
+#include "src/include/radix4/ntt.h"
+#include "src/include/fourstep/ntt.h"
+#include "src/include/fixed/ntt.h"
 
 #include <chrono>
 #include <cstring>
@@ -121,6 +124,9 @@ int _main(int argc, char *argv[])
     // poly_multiply_ntt_crt(a, b, ab, n_, p_);
     // poly_multiply_ntt_pthread_crt(a, b, ab, n_, p_);
     // poly_multiply_ntt_pthread_simple(a, b, ab, n_, p_);
+    // poly_multiply_ntt_radix4(a, b, ab, n_, p_);
+    // poly_multiply_ntt_fourstep(a, b, ab, n_, p_);
+    // poly_multiply_ntt_fixed(a, b, ab, n_, p_);
 
     auto End = std::chrono::high_resolution_clock::now();
     std::chrono::duration<double, std::ratio<1, 1000>> elapsed = End - Start;
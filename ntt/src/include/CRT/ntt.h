@@ -7,6 +7,7 @@
 #include "../general/utils.h"
 #include "../general/op.h"
 #include "../ntt.h"
+#include "../fixed/ntt.h"
 
 #include "const.h"
 #include "crt.h"
@@ -29,7 +30,7 @@ inline void poly_multiply_ntt_crt(u64 *a, u64 *b, u64 *ab, u64 n, u64 p)
     for (u64 i = 0; i < CRT_NUMS; i++)
     {
         ab_crt[i] = new u64[n_expanded]{};
-        poly_multiply_ntt(a, b, ab_crt[i], n, CRT_MODS[i], CRT_ROOTS[i]);
+        poly_multiply_ntt_fixed(a, b, ab_crt[i], n, CRT_MODS[i], CRT_ROOTS[i]);
     }
 
     for (u64 i = 0; i < n_expanded; ++i)
@@ -11,15 +11,13 @@ inline void poly_multiply_ntt_omp(T *a, T *b, T *ab, T n, T p)
 {
     using T_mont = T;
 
-    MontMod<T> montMod(p);
-
     T n_expanded = expand_n(2 * n - 1);
+    const NttPlan<T> &plan = get_ntt_plan<T>(n_expanded, p, (T)OMEGA);
+    const MontMod<T> &montMod = plan.mont();
+
     T *a_expanded = expand_a((T *)a, n, n_expanded);
     T *b_expanded = expand_a((T *)b, n, n_expanded);
 
-    bit_reverse_permute(a_expanded, n_expanded);
-    bit_reverse_permute(b_expanded, n_expanded);
-
     T_mont *a_mont = new T_mont[n_expanded];
     T_mont *b_mont = new T_mont[n_expanded];
     T_mont *ab_mont = new T_mont[n_expanded];
@@ -27,18 +25,23 @@ inline void poly_multiply_ntt_omp(T *a, T *b, T *ab, T n, T p)
         a_mont[i] = montMod.from_T(a_expanded[i]);
     for (T i = 0; i < n_expanded; ++i)
         b_mont[i] = montMod.from_T(b_expanded[i]);
-    T_mont omega_mont = montMod.from_T(OMEGA);
 
-    ntt_forward_mont_omp(a_mont, n_expanded, p, omega_mont);
-    ntt_forward_mont_omp(b_mont, n_expanded, p, omega_mont);
+    // DIF 正变换 + DIT 逆变换，不需要 bit-reverse 置换
+    ntt_forward_dif_mont_omp(a_mont, plan);
+    ntt_forward_dif_mont_omp(b_mont, plan);
 
+#pragma omp parallel for
     for (T i = 0; i < n_expanded; ++i)
         ab_mont[i] = montMod.mul(a_mont[i], b_mont[i]);
 
-    ntt_inverse_mont_omp(ab_mont, n_expanded, p, montMod.inv(omega_mont));
+    ntt_inverse_dit_mont_omp(ab_mont, plan);
 
     for (T i = 0; i < n_expanded; ++i)
         ab[i] = montMod.to_T(ab_mont[i]);
 
-    bit_reverse_permute((T *)ab, n_expanded);
-}
\ No newline at end of file
+    delete[] a_expanded;
+    delete[] b_expanded;
+    delete[] a_mont;
+    delete[] b_mont;
+    delete[] ab_mont;
+}
@@ -1,9 +1,10 @@
 #pragma once
 
 #include "../general/op.h"
+#include "../general/plan.h"
 
 template <typename T>
-inline void ntt_forward_mont_omp(T_mont *a_mont, T n, T p, T_mont omega_mont)
+inline void ntt_forward_mont_omp(T *a_mont, T n, T p, T omega_mont)
 {
     using T_mont = T;
 
@@ -28,7 +29,7 @@ inline void ntt_forward_mont_omp(T_mont *a_mont, T n, T p, T_mont omega_mont)
 }
 
 template <typename T>
-inline void ntt_inverse_mont_omp(T_mont *a_mont, T n, T p, T_mont omega_mont)
+inline void ntt_inverse_mont_omp(T *a_mont, T n, T p, T omega_mont)
 {
     using T_mont = T;
 
@@ -54,4 +55,67 @@ inline void ntt_inverse_mont_omp(T_mont *a_mont, T n, T p, T_mont omega_mont)
     T_mont inv_n = montMod.inv(montMod.from_T(n));
     for (T i = 0; i < n; ++i)
         a_mont[i] = montMod.mul(a_mont[i], inv_n);
-}
\ No newline at end of file
+}
+
+/**
+ * @brief ntt_forward_dif_mont 的 OpenMP 版本：自然顺序输入，bit-reversed 输出。
+ *
+ * 前几层只有很少的块（第一层只有一块），所以把块和块内的蝴蝶一起分给线程。
+ */
+template <typename T>
+inline void ntt_forward_dif_mont_omp(T *a_mont, const NttPlan<T> &plan)
+{
+    using T_mont = T;
+
+    const MontMod<T> &montMod = plan.mont();
+    T n = plan.size();
+
+    for (T mid = n >> 1; mid > 0; mid >>= 1)
+    {
+        const T_mont *w_mont = plan.stage_twiddles(mid);
+#pragma omp parallel for collapse(2)
+        for (T j = 0; j < n; j += (mid << 1))
+        {
+            for (T k = 0; k < mid; ++k)
+            {
+                T_mont x_mont = a_mont[j + k];
+                T_mont y_mont = a_mont[j + k + mid];
+                a_mont[j + k] = montMod.add(x_mont, y_mont);
+                a_mont[j + k + mid] = montMod.mul(w_mont[k], montMod.sub(x_mont, y_mont));
+            }
+        }
+    }
+}
+
+/**
+ * @brief ntt_inverse_dit_mont 的 OpenMP 版本：bit-reversed 输入，自然顺序输出。
+ */
+template <typename T>
+inline void ntt_inverse_dit_mont_omp(T *a_mont, const NttPlan<T> &plan)
+{
+    using T_mont = T;
+
+    const MontMod<T> &montMod = plan.mont();
+    T n = plan.size();
+
+    for (T mid = 1; mid < n; mid <<= 1)
+    {
+        const T_mont *w_mont = plan.stage_inv_twiddles(mid);
+#pragma omp parallel for collapse(2)
+        for (T j = 0; j < n; j += (mid << 1))
+        {
+            for (T k = 0; k < mid; ++k)
+            {
+                T_mont x_mont = a_mont[j + k];
+                T_mont y_mont = montMod.mul(w_mont[k], a_mont[j + k + mid]);
+                a_mont[j + k] = montMod.add(x_mont, y_mont);
+                a_mont[j + k + mid] = montMod.sub(x_mont, y_mont);
+            }
+        }
+    }
+
+    T_mont inv_n = plan.inv_n();
+#pragma omp parallel for
+    for (T i = 0; i < n; ++i)
+        a_mont[i] = montMod.mul(a_mont[i], inv_n);
+}
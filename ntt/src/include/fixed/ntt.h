@@ -0,0 +1,134 @@
+#pragma once
+
+#include "../general/utils.h"
+#include "../general/workspace.h"
+#include "../ntt.h"
+#include "transform.h"
+
+/** n_expanded = N <= fixed_codelet_size：整个乘法在栈上的两个数组里完成，不用工作区 */
+template <u32 P, u32 G, u32 N, typename T>
+inline void poly_multiply_ntt_fixed_small(const T *a, const T *b, T *ab, u32 n, u32 scale, u32 scale_shoup)
+{
+  u32 a_buf[N], b_buf[N];
+  for (u32 i = 0; i < N; ++i)
+  {
+    a_buf[i] = i < n ? NttFixed<P, G>::reduce_input(a[i]) : 0;
+    b_buf[i] = i < n ? NttFixed<P, G>::reduce_input(b[i]) : 0;
+  }
+  NttFixed<P, G>::template pointwise_codelet<N>(a_buf, b_buf, scale, scale_shoup);
+  for (u32 i = 0; i < N; ++i)
+    ab[i] = (T)ShoupModFixed<P>::reduce_p(ShoupModFixed<P>::reduce_2p(a_buf[i]));
+}
+
+/**
+ * @brief 编译期固定模数的 NTT 多项式乘法，见 NttFixed
+ *
+ * @tparam P 模数（P < 2^30）
+ * @tparam G 原根
+ * @param a 多项式系数（u32 或 u64）
+ * @param b 多项式系数（u32 或 u64）
+ * @param ab 结果，长度至少为 expand_n(2n - 1)
+ * @param n 多项式长度
+ * @param workspace 工作区，n_expanded 超过 fixed_codelet_size 时使用
+ */
+template <u32 P, u32 G, typename T>
+inline void poly_multiply_ntt_fixed(const T *a, const T *b, T *ab, u32 n, NttWorkspace &workspace)
+{
+  u32 n_expanded = expand_n(2 * n - 1);
+  // 点乘时补上 Montgomery 乘法除掉的 R，同时乘上 1/n：n 整除 P - 1，所以 1/n = P - (P - 1) / n
+  constexpr u32 r_mod_p = (u32)(((u64)1 << 32) % P);
+  u32 scale = (u32)((u64)r_mod_p * (P - (P - 1) / n_expanded) % P);
+  u32 scale_shoup = ShoupModFixed<P>::quotient(scale);
+
+  switch (n_expanded)
+  {
+  case 1:
+    ab[0] = (T)((u64)NttFixed<P, G>::reduce_input(a[0]) * NttFixed<P, G>::reduce_input(b[0]) % P);
+    return;
+  case 4:
+    poly_multiply_ntt_fixed_small<P, G, 4>(a, b, ab, n, scale, scale_shoup);
+    return;
+  case 8:
+    poly_multiply_ntt_fixed_small<P, G, 8>(a, b, ab, n, scale, scale_shoup);
+    return;
+  case 16:
+    poly_multiply_ntt_fixed_small<P, G, 16>(a, b, ab, n, scale, scale_shoup);
+    return;
+  case 32:
+    poly_multiply_ntt_fixed_small<P, G, 32>(a, b, ab, n, scale, scale_shoup);
+    return;
+  case 64:
+    poly_multiply_ntt_fixed_small<P, G, 64>(a, b, ab, n, scale, scale_shoup);
+    return;
+  }
+
+  const NttPlan<u32> &plan = get_ntt_plan<u32>(n_expanded, P, G);
+  workspace.reserve(n_expanded * sizeof(u32));
+  u32 *a_buf = workspace.buffer<u32>(0);
+  u32 *b_buf = workspace.buffer<u32>(1);
+  NttFixed<P, G>::forward_from_input(a_buf, a, n, plan);
+  NttFixed<P, G>::forward_from_input(b_buf, b, n, plan);
+  for (u32 i = 0; i < n_expanded; i += fixed_codelet_size)
+    NttFixed<P, G>::template pointwise_codelet<fixed_codelet_size>(a_buf + i, b_buf + i, scale, scale_shoup);
+  NttFixed<P, G>::inverse_to_output(a_buf, ab, plan);
+}
+
+/**
+ * @brief 使用NTT优化的多项式乘法：已知的模数走编译期特化的版本（使用调用者提供的工作区）
+ *
+ * 模数为 main.cc 的输入模数或 CRT_MODS 之一、原根为 3 时，分派到 poly_multiply_ntt_fixed<P, G>；
+ * 其他情况退回 poly_multiply_ntt。
+ *
+ * @param a 多项式系数
+ * @param b 多项式系数
+ * @param ab 结果，长度至少为 expand_n(2n - 1)
+ * @param n 多项式长度
+ * @param p 模数（质数）
+ * @param workspace 工作区
+ */
+template <typename T>
+inline void poly_multiply_ntt_fixed(T *a, T *b, T *ab, T n, T p, T OMEGA, NttWorkspace &workspace)
+{
+  if (OMEGA == 3)
+  {
+    switch (p)
+    {
+    case 7340033:
+      poly_multiply_ntt_fixed<7340033, 3>(a, b, ab, (u32)n, workspace);
+      return;
+    case 104857601:
+      poly_multiply_ntt_fixed<104857601, 3>(a, b, ab, (u32)n, workspace);
+      return;
+    case 469762049:
+      poly_multiply_ntt_fixed<469762049, 3>(a, b, ab, (u32)n, workspace);
+      return;
+    case 998244353:
+      poly_multiply_ntt_fixed<998244353, 3>(a, b, ab, (u32)n, workspace);
+      return;
+    case 1004535809:
+      poly_multiply_ntt_fixed<1004535809, 3>(a, b, ab, (u32)n, workspace);
+      return;
+    case 167772161:
+      poly_multiply_ntt_fixed<167772161, 3>(a, b, ab, (u32)n, workspace);
+      return;
+    }
+  }
+  poly_multiply_ntt(a, b, ab, n, p, OMEGA, workspace);
+}
+
+/**
+ * @brief 使用NTT优化的多项式乘法：已知的模数走编译期特化的版本
+ *
+ * 使用当前线程的工作区，见 thread_local_workspace。
+ *
+ * @param a 多项式系数
+ * @param b 多项式系数
+ * @param ab 结果
+ * @param n 多项式长度
+ * @param p 模数（质数）
+ */
+template <typename T>
+inline void poly_multiply_ntt_fixed(T *a, T *b, T *ab, T n, T p, T OMEGA = 3)
+{
+  poly_multiply_ntt_fixed(a, b, ab, n, p, OMEGA, thread_local_workspace());
+}
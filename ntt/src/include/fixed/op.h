@@ -0,0 +1,93 @@
+#pragma once
+
+#include "../general/type.h"
+
+// === 编译期固定模数的模运算 ===
+// 模数作为模板参数，MontMod / ShoupMod 在构造函数里算的常量在这里都是 constexpr，
+// 乘法里直接作为立即数，不需要从对象里读取；结果与 MontMod<u32> / ShoupMod<u32> 一致。
+
+/** a^e mod p（普通整数），供编译期计算单位根使用；C++11 的 constexpr 函数只能有一条 return，所以写成递归 */
+constexpr u32 pow_mod_constexpr(u32 a, u64 e, u32 p)
+{
+  return e == 0 ? 1 % p
+                : (u32)((e & 1 ? a % p : 1) * (u64)pow_mod_constexpr((u32)((u64)(a % p) * (a % p) % p), e >> 1, p) % p);
+}
+
+/** p^{-1} mod 2^32 的牛顿迭代，从 inv 开始再迭代 steps 次，每次把正确的位数翻倍 */
+constexpr u32 inv_mod_2_32_constexpr(u32 p, u32 inv, int steps)
+{
+  return steps == 0 ? inv : inv_mod_2_32_constexpr(p, inv * (2 - p * inv), steps - 1);
+}
+
+/**
+ * @brief 编译期固定模数的 Montgomery 模运算（R = 2^32）
+ *
+ * @tparam P 模数（奇质数，P < 2^31）
+ */
+template <u32 P>
+class MontModFixed
+{
+  static_assert(P % 2 == 1 && P < (1u << 31), "MontModFixed 要求奇数模数且 P < 2^31");
+
+public:
+  static constexpr u32 mod = P;
+  /** -P^{-1} mod 2^32，1 对奇数 P 已有 1 位正确，迭代 5 次得到 32 位 */
+  static constexpr u32 neg_r_inv = 0u - inv_mod_2_32_constexpr(P, 1, 5);
+  /** R^2 mod P */
+  static constexpr u32 r2 = (u32)((((u64)1 << 32) % P) * (((u64)1 << 32) % P) % P);
+
+  /** [0, 2P) → [0, P) */
+  static constexpr u32_mont reduce_p(u32 x) { return x >= P ? x - P : x; }
+
+  /** t·R^{-1} mod P，要求 t < P·R，结果在 [0, P) */
+  static constexpr u32_mont reduce(u64 t)
+  {
+    return reduce_p((u32)((t + (u64)((u32)t * neg_r_inv) * P) >> 32));
+  }
+
+  static constexpr u32_mont from_T(u32 a) { return reduce((u64)a * r2); }
+  static constexpr u32 to_T(u32_mont a_mont) { return reduce(a_mont); }
+  static constexpr u32_mont mul(u32_mont a_mont, u32_mont b_mont) { return reduce((u64)a_mont * b_mont); }
+};
+
+// C++11 里被 ODR 使用的 static constexpr 成员还需要类外定义
+template <u32 P>
+constexpr u32 MontModFixed<P>::mod;
+template <u32 P>
+constexpr u32 MontModFixed<P>::neg_r_inv;
+template <u32 P>
+constexpr u32 MontModFixed<P>::r2;
+
+/**
+ * @brief 编译期固定模数的 Shoup 模乘与惰性规约，见 ShoupMod
+ *
+ * @tparam P 模数，P < 2^30
+ */
+template <u32 P>
+class ShoupModFixed
+{
+  static_assert(P < (1u << 30), "ShoupModFixed 要求 P < 2^30");
+
+public:
+  static constexpr u32 mod = P;
+  static constexpr u32 mod2 = P << 1;
+
+  /** w 的 Shoup 商，要求 w < P */
+  static constexpr u32 quotient(u32 w) { return (u32)(((u64)w << 32) / P); }
+
+  /** x·w mod P，结果在 [0, 2P)；x 可以是任意 u32 */
+  static constexpr u32 mul(u32 x, u32 w, u32 w_shoup)
+  {
+    return x * w - (u32)(((u64)x * w_shoup) >> 32) * P;
+  }
+
+  /** [0, 4P) → [0, 2P) */
+  static constexpr u32 reduce_2p(u32 x) { return x >= mod2 ? x - mod2 : x; }
+  /** [0, 2P) → [0, P) */
+  static constexpr u32 reduce_p(u32 x) { return x >= P ? x - P : x; }
+};
+
+template <u32 P>
+constexpr u32 ShoupModFixed<P>::mod;
+template <u32 P>
+constexpr u32 ShoupModFixed<P>::mod2;
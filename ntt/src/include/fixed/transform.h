@@ -0,0 +1,337 @@
+#pragma once
+
+#include "../general/plan.h"
+#include "op.h"
+
+#include <type_traits>
+
+/**
+ * @brief 依次以 std::integral_constant<u32, I>、…、<u32, I + N - 1> 调用 f，展开成顺序代码，下标是编译期常量
+ *
+ * 每次对半递归，嵌套只有 log N 层，编译器能把整段内联进来（逐个递归时内联到一定深度就会停下）。
+ */
+template <u32 I, u32 N>
+struct Unroll
+{
+  template <typename F>
+  static inline void run(F &f)
+  {
+    Unroll<I, N / 2>::run(f);
+    Unroll<I + N / 2, N - N / 2>::run(f);
+  }
+};
+
+template <u32 I>
+struct Unroll<I, 1>
+{
+  template <typename F>
+  static inline void run(F &f) { f(std::integral_constant<u32, I>()); }
+};
+
+template <u32 I>
+struct Unroll<I, 0>
+{
+  template <typename F>
+  static inline void run(F &) {}
+};
+
+/** 以下标 0、…、N - 1 调用 f，见 Unroll */
+template <u32 N, typename F>
+inline void unroll(F f)
+{
+  Unroll<0, N>::run(f);
+}
+
+/** 展开的 codelet 的最大长度：mid < fixed_codelet_size 的层在编译期展开，旋转因子是立即数 */
+constexpr u32 fixed_codelet_size = 64;
+
+/**
+ * @brief 编译期的旋转因子表（普通整数）及其 Shoup 商
+ *
+ * 布局同 NttPlan 的 stage_lazy_twiddles：第 mid 层（mid < fixed_codelet_size）的 ω_{2mid}^k 在 [mid, 2mid)。
+ */
+struct FixedTwiddles
+{
+  u32 w[fixed_codelet_size];
+  u32 w_shoup[fixed_codelet_size];
+  u32 inv_w[fixed_codelet_size];
+  u32 inv_w_shoup[fixed_codelet_size];
+};
+
+/** 编译期的下标序列 0, 1, …, N - 1，用来按下标逐个生成表项 */
+template <u32... I>
+struct IndexList
+{
+};
+
+template <u32 N, u32... I>
+struct MakeIndexList : MakeIndexList<N - 1, N - 1, I...>
+{
+};
+
+template <u32... I>
+struct MakeIndexList<0, I...>
+{
+  typedef IndexList<I...> type;
+};
+
+/** 不超过 i 的最大的 2 的幂，即下标 i 所在的层 mid；i = 0 时为 0 */
+constexpr u32 fixed_twiddle_mid(u32 i)
+{
+  return i <= 1 ? i : 2 * fixed_twiddle_mid(i >> 1);
+}
+
+/** 表中下标 i 处的 ω_{2mid}^k（inverse 时为其逆），k = i - mid；下标 0 不属于任何一层，为 0 */
+template <u32 P, u32 G>
+constexpr u32 fixed_twiddle(u32 i, bool inverse)
+{
+  return i == 0 ? 0
+                : pow_mod_constexpr(pow_mod_constexpr(G, inverse ? (P - 1) - (P - 1) / (fixed_twiddle_mid(i) << 1) : (P - 1) / (fixed_twiddle_mid(i) << 1), P),
+                                    i - fixed_twiddle_mid(i), P);
+}
+
+template <u32 P, u32 G, u32... I>
+constexpr FixedTwiddles make_fixed_twiddles(IndexList<I...>)
+{
+  return FixedTwiddles{{fixed_twiddle<P, G>(I, false)...},
+                       {ShoupModFixed<P>::quotient(fixed_twiddle<P, G>(I, false))...},
+                       {fixed_twiddle<P, G>(I, true)...},
+                       {ShoupModFixed<P>::quotient(fixed_twiddle<P, G>(I, true))...}};
+}
+
+/** 模数 P、原根 G 的旋转因子表，每个 (P, G) 在编译期生成一份 */
+template <u32 P, u32 G>
+struct FixedTwiddleTable
+{
+  static constexpr FixedTwiddles value = make_fixed_twiddles<P, G>(typename MakeIndexList<fixed_codelet_size>::type());
+};
+
+template <u32 P, u32 G>
+constexpr FixedTwiddles FixedTwiddleTable<P, G>::value;
+
+/**
+ * @brief 编译期固定模数和原根的惰性规约 NTT
+ *
+ * 流水线与 ntt_forward_dif_lazy_from_input 等三步相同，区别在于：
+ * - 模数、Montgomery 常量、Shoup 模乘都是编译期常量（见 MontModFixed / ShoupModFixed）；
+ * - mid < fixed_codelet_size 的层按长为 fixed_codelet_size 的块完全展开，旋转因子是编译期的表，
+ *   旋转因子为 1 的蝴蝶在编译期就省掉了乘法；两个序列这几层的正变换、点乘、逆变换在同一个块上连续做完；
+ * - 只有 mid >= fixed_codelet_size 的层用 NttPlan 里的表和运行时的循环。
+ *
+ * 长度超过 fixed_codelet_size 时依次调用 forward_from_input（a、b 各一次）、
+ * 对每个长为 fixed_codelet_size 的块调用 pointwise_codelet、最后 inverse_to_output。
+ *
+ * @tparam P 模数（P < 2^30）
+ * @tparam G 原根
+ */
+template <u32 P, u32 G>
+class NttFixed
+{
+  using Mont = MontModFixed<P>;
+  using Shoup = ShoupModFixed<P>;
+
+  /** 第 MID 层的第 T 个 DIF 蝴蝶（在第 T / MID 组，组内下标 K = T % MID），供 unroll 逐个展开 */
+  template <u32 MID>
+  struct DifButterfly
+  {
+    u32 *a;
+
+    template <u32 T>
+    void operator()(std::integral_constant<u32, T>) const
+    {
+      constexpr u32 K = T % MID;
+      constexpr u32 i = T / MID * (2 * MID) + K;
+      constexpr u32 w = FixedTwiddleTable<P, G>::value.w[MID + K];
+      constexpr u32 w_shoup = FixedTwiddleTable<P, G>::value.w_shoup[MID + K];
+      u32 x = a[i];
+      u32 y = a[i + MID];
+      a[i] = Shoup::reduce_2p(x + y);
+      // K 是常量，分支在编译期就确定了
+      if (K == 0)
+        a[i + MID] = Shoup::reduce_2p(x - y + Shoup::mod2);
+      else
+        a[i + MID] = Shoup::mul(x - y + Shoup::mod2, w, w_shoup);
+    }
+  };
+
+  /** 第 MID 层的第 T 个 DIT 蝴蝶，见 DifButterfly */
+  template <u32 MID>
+  struct DitButterfly
+  {
+    u32 *a;
+
+    template <u32 T>
+    void operator()(std::integral_constant<u32, T>) const
+    {
+      constexpr u32 K = T % MID;
+      constexpr u32 i = T / MID * (2 * MID) + K;
+      constexpr u32 w = FixedTwiddleTable<P, G>::value.inv_w[MID + K];
+      constexpr u32 w_shoup = FixedTwiddleTable<P, G>::value.inv_w_shoup[MID + K];
+      u32 x = Shoup::reduce_2p(a[i]);
+      u32 y = K == 0 ? Shoup::reduce_2p(a[i + MID]) : Shoup::mul(a[i + MID], w, w_shoup);
+      a[i] = x + y;
+      a[i + MID] = x - y + Shoup::mod2;
+    }
+  };
+
+  /** 第 1 层的第 J 对：a、b 的最后一层正变换、点乘并乘上 scale、a 的第一层逆变换 */
+  struct PointwisePair
+  {
+    u32 *a;
+    u32 *b;
+    u32 scale;
+    u32 scale_shoup;
+
+    template <u32 J>
+    void operator()(std::integral_constant<u32, J>) const
+    {
+      constexpr u32 i = 2 * J;
+      u32 a0 = Shoup::reduce_2p(a[i] + a[i + 1]);
+      u32 a1 = Shoup::reduce_2p(a[i] - a[i + 1] + Shoup::mod2);
+      u32 b0 = Shoup::reduce_2p(b[i] + b[i + 1]);
+      u32 b1 = Shoup::reduce_2p(b[i] - b[i + 1] + Shoup::mod2);
+      u32 c0 = Shoup::mul(Mont::mul(a0, b0), scale, scale_shoup);
+      u32 c1 = Shoup::mul(Mont::mul(a1, b1), scale, scale_shoup);
+      a[i] = c0 + c1;
+      a[i + 1] = c0 - c1 + Shoup::mod2;
+    }
+  };
+
+  template <u32 N, u32 MID>
+  static void dif_codelet(u32 *, std::false_type) {}
+
+  template <u32 N, u32 MID>
+  static void dif_codelet(u32 *a, std::true_type)
+  {
+    unroll<N / 2>(DifButterfly<MID>{a});
+    dif_codelet<N, MID / 2>(a);
+  }
+
+  template <u32 N, u32 MID>
+  static void dit_codelet(u32 *, std::false_type) {}
+
+  template <u32 N, u32 MID>
+  static void dit_codelet(u32 *a, std::true_type)
+  {
+    unroll<N / 2>(DitButterfly<MID>{a});
+    dit_codelet<N, MID * 2>(a);
+  }
+
+public:
+  /** 把输入系数规约到 [0, P)：输入不一定小于 P（CRT 传入的是更大模数下的系数），P 是常量，取模会编译成乘法 */
+  template <typename T>
+  static u32 reduce_input(T x) { return (u32)((u64)x % P); }
+
+  /**
+   * @brief 长为 N 的块上从第 MID 层到第 2 层的惰性 DIF 蝴蝶，完全展开
+   *
+   * 与 ntt_forward_dif_lazy_stage 相同，数值停留在 [0, 2P)。第 1 层留给 pointwise_codelet。
+   */
+  template <u32 N, u32 MID>
+  static void dif_codelet(u32 *a)
+  {
+    dif_codelet<N, MID>(a, std::integral_constant<bool, (MID >= 2)>());
+  }
+
+  /**
+   * @brief 长为 N 的块上从第 MID 层到第 N / 2 层的惰性 DIT 蝴蝶，完全展开
+   *
+   * 与 ntt_inverse_dit_lazy_stage 相同，数值停留在 [0, 4P)。
+   */
+  template <u32 N, u32 MID>
+  static void dit_codelet(u32 *a)
+  {
+    dit_codelet<N, MID>(a, std::integral_constant<bool, (MID < N)>());
+  }
+
+  /**
+   * @brief 长为 N（N <= fixed_codelet_size）的块：a、b 正变换 mid < N 的几层，点乘并乘上 scale，逆变换 mid < N 的几层
+   *
+   * 见 ntt_pointwise_lazy_fused。b 的内容会被改写。
+   */
+  template <u32 N>
+  static void pointwise_codelet(u32 *a, u32 *b, u32 scale, u32 scale_shoup)
+  {
+    dif_codelet<N, N / 2>(a);
+    dif_codelet<N, N / 2>(b);
+    unroll<N / 2>(PointwisePair{a, b, scale, scale_shoup});
+    dit_codelet<N, 2>(a);
+  }
+
+  /**
+   * @brief 见 ntt_forward_dif_lazy_from_input，只做到 mid = fixed_codelet_size 层，其余留给 pointwise_codelet
+   *
+   * @param input 多项式系数（u32 或 u64），长度 len，len <= plan.size() / 2
+   */
+  template <typename T>
+  static void forward_from_input(u32 *a, const T *input, u32 len, const NttPlan<u32> &plan)
+  {
+    u32 n = plan.size();
+    u32 mid = n >> 1;
+
+    const u32 *w = plan.stage_lazy_twiddles(mid);
+    const u32 *w_shoup = plan.stage_lazy_twiddles_shoup(mid);
+    for (u32 k = 0; k < len; ++k)
+    {
+      u32 x = reduce_input(input[k]);
+      a[k] = x;
+      a[k + mid] = Shoup::mul(x, w[k], w_shoup[k]);
+    }
+    for (u32 k = len; k < mid; ++k)
+      a[k] = a[k + mid] = 0;
+
+    for (mid >>= 1; mid >= fixed_codelet_size; mid >>= 1)
+    {
+      w = plan.stage_lazy_twiddles(mid);
+      w_shoup = plan.stage_lazy_twiddles_shoup(mid);
+      for (u32 j = 0; j < n; j += (mid << 1))
+      {
+        for (u32 k = 0; k < mid; ++k)
+        {
+          u32 x = a[j + k];
+          u32 y = a[j + k + mid];
+          a[j + k] = Shoup::reduce_2p(x + y);
+          a[j + k + mid] = Shoup::mul(x - y + Shoup::mod2, w[k], w_shoup[k]);
+        }
+      }
+    }
+  }
+
+  /**
+   * @brief 见 ntt_inverse_dit_lazy_to_output，从 mid = fixed_codelet_size 层开始
+   *
+   * @param out 结果（[0, P)），长度 plan.size()
+   */
+  template <typename T>
+  static void inverse_to_output(u32 *a, T *out, const NttPlan<u32> &plan)
+  {
+    u32 n = plan.size();
+    u32 last = n >> 1;
+
+    for (u32 mid = fixed_codelet_size; mid < last; mid <<= 1)
+    {
+      const u32 *w = plan.stage_lazy_inv_twiddles(mid);
+      const u32 *w_shoup = plan.stage_lazy_inv_twiddles_shoup(mid);
+      for (u32 j = 0; j < n; j += (mid << 1))
+      {
+        for (u32 k = 0; k < mid; ++k)
+        {
+          u32 x = Shoup::reduce_2p(a[j + k]);
+          u32 y = Shoup::mul(a[j + k + mid], w[k], w_shoup[k]);
+          a[j + k] = x + y;
+          a[j + k + mid] = x - y + Shoup::mod2;
+        }
+      }
+    }
+
+    const u32 *w = plan.stage_lazy_inv_twiddles(last);
+    const u32 *w_shoup = plan.stage_lazy_inv_twiddles_shoup(last);
+    for (u32 k = 0; k < last; ++k)
+    {
+      u32 x = Shoup::reduce_2p(a[k]);
+      u32 y = Shoup::mul(a[k + last], w[k], w_shoup[k]);
+      out[k] = (T)Shoup::reduce_p(Shoup::reduce_2p(x + y));
+      out[k + last] = (T)Shoup::reduce_p(Shoup::reduce_2p(x - y + Shoup::mod2));
+    }
+  }
+};
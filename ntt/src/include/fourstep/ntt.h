@@ -0,0 +1,130 @@
+#pragma once
+
+#include "../general/utils.h"
+#include "../general/workspace.h"
+#include "../radix4/ntt.h"
+#include "transform.h"
+
+/**
+ * @brief 使用四步 / 六步 NTT 的多项式乘法，面向 n_expanded 超出 L2 缓存的情况（2^18 到 2^26）
+ *
+ * 频域系数的布局见 FourStepPlan；逐点相乘不关心顺序，所以正变换之后不需要转置回来。
+ * n_expanded < 4 或模数不满足惰性规约的要求时退回 poly_multiply_ntt_radix4。
+ *
+ * @param six_step true 使用显式转置的六步变换，false 使用按列块搬运的四步变换
+ * @param workspace 工作区
+ */
+template <typename T>
+inline void poly_multiply_ntt_blocked(T *a, T *b, T *ab, T n, T p, T OMEGA, bool six_step, NttWorkspace &workspace)
+{
+  using T_mont = T;
+
+  T n_expanded = expand_n(2 * n - 1);
+  if (n_expanded < 4 || !ShoupMod<T>::supports(p))
+  {
+    poly_multiply_ntt_radix4(a, b, ab, n, p, OMEGA, workspace);
+    return;
+  }
+  const FourStepPlan<T> &plan = get_fourstep_plan(n_expanded, p, OMEGA);
+  const MontMod<T> &montMod = plan.mont();
+
+  workspace.reserve(n_expanded * sizeof(T_mont));
+  T_mont *a_mont = workspace.buffer<T_mont>(0);
+  T_mont *b_mont = workspace.buffer<T_mont>(1);
+#pragma omp parallel for schedule(static)
+  for (T i = 0; i < n_expanded; ++i)
+  {
+    a_mont[i] = i < n ? montMod.from_T(a[i]) : 0;
+    b_mont[i] = i < n ? montMod.from_T(b[i]) : 0;
+  }
+
+  if (six_step)
+  {
+    ntt_forward_sixstep(a_mont, plan);
+    ntt_forward_sixstep(b_mont, plan);
+  }
+  else
+  {
+    ntt_forward_fourstep(a_mont, plan);
+    ntt_forward_fourstep(b_mont, plan);
+  }
+
+#pragma omp parallel for schedule(static)
+  for (T i = 0; i < n_expanded; ++i)
+    a_mont[i] = montMod.mul(a_mont[i], b_mont[i]);
+
+  if (six_step)
+    ntt_inverse_sixstep(a_mont, plan);
+  else
+    ntt_inverse_fourstep(a_mont, plan);
+
+#pragma omp parallel for schedule(static)
+  for (T i = 0; i < n_expanded; ++i)
+    ab[i] = montMod.to_T(a_mont[i]);
+}
+
+/**
+ * @brief 使用四步 NTT 的多项式乘法（使用调用者提供的工作区）
+ *
+ * @param a 多项式系数
+ * @param b 多项式系数
+ * @param ab 结果
+ * @param n 多项式长度
+ * @param p 模数（质数）
+ * @param workspace 工作区
+ */
+template <typename T>
+inline void poly_multiply_ntt_fourstep(T *a, T *b, T *ab, T n, T p, T OMEGA, NttWorkspace &workspace)
+{
+  poly_multiply_ntt_blocked(a, b, ab, n, p, OMEGA, false, workspace);
+}
+
+/**
+ * @brief 使用四步 NTT 的多项式乘法
+ *
+ * 使用当前线程的工作区，见 thread_local_workspace。
+ *
+ * @param a 多项式系数
+ * @param b 多项式系数
+ * @param ab 结果
+ * @param n 多项式长度
+ * @param p 模数（质数）
+ */
+template <typename T>
+inline void poly_multiply_ntt_fourstep(T *a, T *b, T *ab, T n, T p, T OMEGA = 3)
+{
+  poly_multiply_ntt_fourstep(a, b, ab, n, p, OMEGA, thread_local_workspace());
+}
+
+/**
+ * @brief 使用六步 NTT 的多项式乘法（使用调用者提供的工作区）
+ *
+ * @param a 多项式系数
+ * @param b 多项式系数
+ * @param ab 结果
+ * @param n 多项式长度
+ * @param p 模数（质数）
+ * @param workspace 工作区
+ */
+template <typename T>
+inline void poly_multiply_ntt_sixstep(T *a, T *b, T *ab, T n, T p, T OMEGA, NttWorkspace &workspace)
+{
+  poly_multiply_ntt_blocked(a, b, ab, n, p, OMEGA, true, workspace);
+}
+
+/**
+ * @brief 使用六步 NTT 的多项式乘法
+ *
+ * 使用当前线程的工作区，见 thread_local_workspace。
+ *
+ * @param a 多项式系数
+ * @param b 多项式系数
+ * @param ab 结果
+ * @param n 多项式长度
+ * @param p 模数（质数）
+ */
+template <typename T>
+inline void poly_multiply_ntt_sixstep(T *a, T *b, T *ab, T n, T p, T OMEGA = 3)
+{
+  poly_multiply_ntt_sixstep(a, b, ab, n, p, OMEGA, thread_local_workspace());
+}
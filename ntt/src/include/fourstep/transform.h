@@ -0,0 +1,312 @@
+#pragma once
+
+#include "../general/op.h"
+#include "../general/plan.h"
+#include "../radix4/transform.h"
+
+#include <algorithm>
+#include <memory>
+
+/**
+ * @brief 四步 / 六步 NTT 的计划
+ *
+ * 把长度 n 的序列看成 n1 行 n2 列的矩阵 M[j1][j2] = a[j1·n2 + j2]（n1 ≤ n2，都是 2 的幂，n1·n2 = n），
+ * 变换拆成：
+ *   1. 每一列做长度 n1 的 NTT；
+ *   2. 位置 (k1, j2) 乘以 ω_n^{j2·k1}；
+ *   3. 每一行做长度 n2 的 NTT。
+ * 子变换的长度只有 √n 左右，能放进缓存；n = 2^26 时每行 8192 个元素。
+ *
+ * 子变换都是 DIF（bit-reversed 输出），所以频域系数 X[k1 + n1·k2] 存放在 rev1[k1]·n2 + rev2[k2]：
+ * 卷积只需要逐点相乘，不需要最后的转置；逆变换按相反的顺序消费这个布局，输出自然顺序。
+ *
+ * 子变换的旋转因子取自长度 n1、n2 的 NttPlan（同样缓存），这里只额外保存每一列的 ω_n^{j2}。
+ */
+template <typename T>
+class FourStepPlan
+{
+  using T_mont = T;
+
+public:
+  /**
+   * @param _n 变换长度（2 的幂，至少为 4）
+   * @param _p 模数（质数，需满足 ShoupMod::supports）
+   * @param _root 原根（普通整数）
+   */
+  FourStepPlan(T _n, T _p, T _root) : n(_n)
+  {
+    T lg_n = 0;
+    while (((T)1 << lg_n) < n)
+      ++lg_n;
+    n1 = (T)1 << (lg_n / 2);
+    n2 = n / n1;
+
+    col_plan_ptr = &get_ntt_plan(n1, _p, _root);
+    row_plan_ptr = &get_ntt_plan(n2, _p, _root);
+
+    const MontMod<T> &montMod = mont();
+    T_mont omega_mont = montMod.pow(montMod.from_T(_root), (_p - 1) / n);
+    T_mont inv_omega_mont = montMod.inv(omega_mont);
+    col_roots.reset(new T_mont[n2]);
+    inv_col_roots.reset(new T_mont[n2]);
+    col_roots[0] = inv_col_roots[0] = montMod.from_T(1);
+    for (T j2 = 1; j2 < n2; ++j2)
+    {
+      col_roots[j2] = montMod.mul(col_roots[j2 - 1], omega_mont);
+      inv_col_roots[j2] = montMod.mul(inv_col_roots[j2 - 1], inv_omega_mont);
+    }
+  }
+
+  FourStepPlan(const FourStepPlan &) = delete;
+  FourStepPlan &operator=(const FourStepPlan &) = delete;
+
+  T size() const { return n; }
+  /** 行数，也是列变换的长度 */
+  T rows() const { return n1; }
+  /** 列数，也是行变换的长度 */
+  T cols() const { return n2; }
+  const NttPlan<T> &col_plan() const { return *col_plan_ptr; }
+  const NttPlan<T> &row_plan() const { return *row_plan_ptr; }
+  const MontMod<T> &mont() const { return col_plan_ptr->mont(); }
+
+  /**
+   * @brief 给第 j2 = c0 .. c0 + count - 1 列乘上旋转因子（Montgomery 数域）
+   *
+   * 列变换的输出是 bit-reversed 的，所以第 j2 列位置 rev1[k1] 上乘 ω_n^{±j2·k1}。
+   * ω_n^{j2·k1} 按 k1 累乘得到；几列交错着乘，累乘链互不依赖。
+   *
+   * @param cols 第 c0 列的起始位置，列内连续，列与列之间相距 stride
+   * @param c0 第一列的列号
+   * @param count 列数，不超过 fourstep_block_cols()
+   * @param stride 相邻两列的距离
+   * @param inverse 是否为逆变换的旋转因子
+   */
+  void apply_column_twiddles(T_mont *cols, T c0, T count, T stride, bool inverse) const
+  {
+    const MontMod<T> &montMod = mont();
+    const T *rev = col_plan_ptr->bit_reverse_table();
+    T_mont w_mont[64];
+    T_mont step_mont[64];
+    for (T c = 0; c < count; ++c)
+    {
+      w_mont[c] = montMod.from_T(1);
+      step_mont[c] = inverse ? inv_col_roots[c0 + c] : col_roots[c0 + c];
+    }
+    for (T k1 = 0; k1 < n1; ++k1)
+    {
+      T pos = rev[k1];
+      for (T c = 0; c < count; ++c)
+      {
+        T_mont &x = cols[c * stride + pos];
+        x = montMod.mul(x, w_mont[c]); // [0, 2p) · [0, p) → [0, p)
+        w_mont[c] = montMod.mul(w_mont[c], step_mont[c]);
+      }
+    }
+  }
+
+private:
+  T n;
+  T n1;
+  T n2;
+  const NttPlan<T> *col_plan_ptr;
+  const NttPlan<T> *row_plan_ptr;
+
+  std::unique_ptr<T_mont[]> col_roots;     // ω_n^{j2}
+  std::unique_ptr<T_mont[]> inv_col_roots; // ω_n^{-j2}
+};
+
+/**
+ * @brief 获取 (n, p, root) 对应的四步 NTT 计划，第一次使用时构造，之后一直缓存。
+ */
+template <typename T>
+inline const FourStepPlan<T> &get_fourstep_plan(T n, T p, T root)
+{
+  static std::mutex cache_mutex;
+  static std::map<std::tuple<T, T, T>, std::unique_ptr<FourStepPlan<T>>> cache;
+
+  std::lock_guard<std::mutex> lock(cache_mutex);
+  std::unique_ptr<FourStepPlan<T>> &plan = cache[std::make_tuple(n, p, root)];
+  if (!plan)
+    plan.reset(new FourStepPlan<T>(n, p, root));
+  return *plan;
+}
+
+/** 一次搬运的列数：一个缓存行 */
+template <typename T>
+constexpr T fourstep_block_cols() { return 64 / sizeof(T); }
+
+/** 转置的分块边长 */
+constexpr int TRANSPOSE_TILE = 32;
+
+/**
+ * @brief 分块转置：dst[c·rows + r] = src[r·cols + c]
+ *
+ * 按 TRANSPOSE_TILE × TRANSPOSE_TILE 的小块读写，读和写都留在缓存里。
+ */
+template <typename T>
+inline void transpose_blocked(const T *src, T *dst, T rows, T cols)
+{
+#pragma omp parallel for schedule(static)
+  for (T r0 = 0; r0 < rows; r0 += TRANSPOSE_TILE)
+  {
+    T r1 = std::min(r0 + (T)TRANSPOSE_TILE, rows);
+    for (T c0 = 0; c0 < cols; c0 += TRANSPOSE_TILE)
+    {
+      T c1 = std::min(c0 + (T)TRANSPOSE_TILE, cols);
+      for (T r = r0; r < r1; ++r)
+        for (T c = c0; c < c1; ++c)
+          dst[c * rows + r] = src[r * cols + c];
+    }
+  }
+}
+
+/**
+ * @brief 四步 NTT 正变换（Bailey）
+ *
+ * 列变换不转置整个矩阵，而是每次把一个缓存行宽的若干列搬进连续的小缓冲区，
+ * 在缓冲区里做列变换、乘旋转因子，再搬回去；之后就地做行变换。列块和行都分给 OpenMP 线程。
+ * 要求 plan.row_plan().supports_lazy()。
+ *
+ * @param a 多项式系数（[0, 2p)，自然顺序，位于 Montgomery 数域），变换后为频域系数（[0, 2p)，布局见 FourStepPlan）
+ * @param plan 四步 NTT 计划
+ */
+template <typename T>
+inline void ntt_forward_fourstep(T *a, const FourStepPlan<T> &plan)
+{
+  const T n1 = plan.rows(), n2 = plan.cols();
+  const T block_cols = std::min(fourstep_block_cols<T>(), n2);
+
+#pragma omp parallel
+  {
+    std::unique_ptr<T[]> block_buf(new T[block_cols * n1]);
+    T *block = block_buf.get();
+
+#pragma omp for schedule(static)
+    for (T c0 = 0; c0 < n2; c0 += block_cols)
+    {
+      for (T r = 0; r < n1; ++r)
+        for (T c = 0; c < block_cols; ++c)
+          block[c * n1 + r] = a[r * n2 + c0 + c];
+
+      for (T c = 0; c < block_cols; ++c)
+        ntt_forward_dif_radix4_lazy(block + c * n1, plan.col_plan());
+      plan.apply_column_twiddles(block, c0, block_cols, n1, false);
+
+      for (T r = 0; r < n1; ++r)
+        for (T c = 0; c < block_cols; ++c)
+          a[r * n2 + c0 + c] = block[c * n1 + r];
+    }
+
+#pragma omp for schedule(static)
+    for (T r = 0; r < n1; ++r)
+      ntt_forward_dif_radix4_lazy(a + r * n2, plan.row_plan());
+  }
+}
+
+/**
+ * @brief 四步 NTT 逆变换（Bailey）
+ *
+ * ntt_forward_fourstep 的逆：先做行逆变换，再按列块做旋转因子和列逆变换。
+ * 两次子逆变换各自乘了 1/n2、1/n1，合起来正好是 1/n。
+ *
+ * @param a 频域系数（[0, 4p)，布局见 FourStepPlan），变换后为多项式系数（[0, p)，自然顺序）
+ * @param plan 四步 NTT 计划
+ */
+template <typename T>
+inline void ntt_inverse_fourstep(T *a, const FourStepPlan<T> &plan)
+{
+  const T n1 = plan.rows(), n2 = plan.cols();
+  const T block_cols = std::min(fourstep_block_cols<T>(), n2);
+
+#pragma omp parallel
+  {
+    std::unique_ptr<T[]> block_buf(new T[block_cols * n1]);
+    T *block = block_buf.get();
+
+#pragma omp for schedule(static)
+    for (T r = 0; r < n1; ++r)
+      ntt_inverse_dit_radix4_lazy(a + r * n2, plan.row_plan());
+
+#pragma omp for schedule(static)
+    for (T c0 = 0; c0 < n2; c0 += block_cols)
+    {
+      for (T r = 0; r < n1; ++r)
+        for (T c = 0; c < block_cols; ++c)
+          block[c * n1 + r] = a[r * n2 + c0 + c];
+
+      plan.apply_column_twiddles(block, c0, block_cols, n1, true);
+      for (T c = 0; c < block_cols; ++c)
+        ntt_inverse_dit_radix4_lazy(block + c * n1, plan.col_plan());
+
+      for (T r = 0; r < n1; ++r)
+        for (T c = 0; c < block_cols; ++c)
+          a[r * n2 + c0 + c] = block[c * n1 + r];
+    }
+  }
+}
+
+/**
+ * @brief 六步 NTT 正变换
+ *
+ * 与 ntt_forward_fourstep 结果相同，但用两次显式的分块转置代替按列块搬运：
+ * 转置后列变成连续的行，列变换和行变换都是对连续内存做的。需要一块长度为 n 的临时缓冲区。
+ *
+ * @param a 多项式系数（[0, 2p)，自然顺序，位于 Montgomery 数域），变换后为频域系数（[0, 2p)，布局见 FourStepPlan）
+ * @param plan 四步 NTT 计划
+ */
+template <typename T>
+inline void ntt_forward_sixstep(T *a, const FourStepPlan<T> &plan)
+{
+  const T n1 = plan.rows(), n2 = plan.cols();
+  const T block_cols = std::min(fourstep_block_cols<T>(), n2);
+  std::unique_ptr<T[]> tmp_buf(new T[plan.size()]);
+  T *tmp = tmp_buf.get();
+
+  transpose_blocked(a, tmp, n1, n2); // tmp 是 n2 行 n1 列
+
+#pragma omp parallel for schedule(static)
+  for (T c0 = 0; c0 < n2; c0 += block_cols)
+  {
+    for (T c = c0; c < c0 + block_cols; ++c)
+      ntt_forward_dif_radix4_lazy(tmp + c * n1, plan.col_plan());
+    plan.apply_column_twiddles(tmp + c0 * n1, c0, block_cols, n1, false);
+  }
+
+  transpose_blocked(tmp, a, n2, n1);
+  tmp_buf.reset();
+
+#pragma omp parallel for schedule(static)
+  for (T r = 0; r < n1; ++r)
+    ntt_forward_dif_radix4_lazy(a + r * n2, plan.row_plan());
+}
+
+/**
+ * @brief 六步 NTT 逆变换
+ *
+ * @param a 频域系数（[0, 4p)，布局见 FourStepPlan），变换后为多项式系数（[0, p)，自然顺序）
+ * @param plan 四步 NTT 计划
+ */
+template <typename T>
+inline void ntt_inverse_sixstep(T *a, const FourStepPlan<T> &plan)
+{
+  const T n1 = plan.rows(), n2 = plan.cols();
+  const T block_cols = std::min(fourstep_block_cols<T>(), n2);
+
+#pragma omp parallel for schedule(static)
+  for (T r = 0; r < n1; ++r)
+    ntt_inverse_dit_radix4_lazy(a + r * n2, plan.row_plan());
+
+  std::unique_ptr<T[]> tmp_buf(new T[plan.size()]);
+  T *tmp = tmp_buf.get();
+  transpose_blocked(a, tmp, n1, n2);
+
+#pragma omp parallel for schedule(static)
+  for (T c0 = 0; c0 < n2; c0 += block_cols)
+  {
+    plan.apply_column_twiddles(tmp + c0 * n1, c0, block_cols, n1, true);
+    for (T c = c0; c < c0 + block_cols; ++c)
+      ntt_inverse_dit_radix4_lazy(tmp + c * n1, plan.col_plan());
+  }
+
+  transpose_blocked(tmp, a, n2, n1);
+}
@@ -134,3 +134,52 @@ private:
   T r2;        // R^2 mod mod (where R = 2^mont_word_bits)
   T neg_r_inv; // -mod^(-1) mod R (where R = 2^mont_word_bits)
 };
+
+// === Shoup 模乘（配合 Harvey 惰性规约） ===
+/**
+ * 乘数 w 固定时，预先算好 Shoup 商 w' = ⌊w·R / mod⌋（R = 2^word_bits），
+ * 之后 x·w mod mod 只需要两次乘法和一次高位乘法，不做除法也不做条件减法，结果落在 [0, 2·mod)。
+ *
+ * 惰性规约的蝴蝶让数值停留在 [0, 2·mod) 或 [0, 4·mod)，所以要求 4·mod < R，
+ * 即 u32 的模数小于 2^30、u64 的模数小于 2^62。
+ *
+ * 乘法是线性的，x 在不在 Montgomery 数域都可以，w 是普通整数。
+ */
+template <typename T>
+class ShoupMod
+{
+  using T2 = t_widen<T>;
+  static constexpr int word_bits = sizeof(T) * 8;
+
+public:
+  ShoupMod(T _mod) : mod(_mod), mod2(_mod << 1) {}
+  ShoupMod(const ShoupMod &) = delete;
+  ShoupMod &operator=(const ShoupMod &) = delete;
+
+  /** 模数是否满足惰性规约的要求 */
+  static bool supports(T mod)
+  {
+    return (std::is_same<T, u32>::value || std::is_same<T, u64>::value) && mod < ((T)1 << (word_bits - 2));
+  }
+
+  /** w 的 Shoup 商，要求 w < mod */
+  T quotient(T w) const { return (T)(((T2)w << word_bits) / mod); }
+
+  /** x·w mod mod，结果在 [0, 2·mod)；x 可以是任意 T */
+  T mul(T x, T w, T w_shoup) const
+  {
+    T q = (T)(((T2)x * w_shoup) >> word_bits);
+    return x * w - q * mod;
+  }
+
+  /** [0, 4·mod) → [0, 2·mod) */
+  T reduce_2p(T x) const { return (x >= mod2) ? (x - mod2) : x; }
+  /** [0, 2·mod) → [0, mod) */
+  T reduce_p(T x) const { return (x >= mod) ? (x - mod) : x; }
+
+  T mod_2p() const { return mod2; }
+
+private:
+  T mod;
+  T mod2; // 2·mod
+};
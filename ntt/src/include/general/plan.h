@@ -0,0 +1,219 @@
+#pragma once
+
+#include "op.h"
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <tuple>
+
+/**
+ * @brief NTT 计划：对固定的 (n, p, 原根) 预先计算好变换要用的表。
+ *
+ * - 旋转因子表：第 mid 层（蝴蝶跨度为 mid）用到的 ω_{2mid}^k (k < mid) 连续存放在 [mid, 2mid)，
+ *   整张表共 n 个元素，每层按单位步长访问；正变换和逆变换各一张，都在 Montgomery 数域。
+ * - bit-reverse 表：rev[i] 为 i 的 log2(n) 位反转。
+ * - n 的逆元（Montgomery 数域）。
+ * - 模数满足 ShoupMod::supports 时，另有一份普通整数形式的旋转因子及其 Shoup 商，
+ *   布局与上面相同，供惰性规约的蝴蝶使用；
+ *   以及 radix-4 蝴蝶额外需要的 ω_{4q}^{3k}（k < q，存放在 [q, 2q)）和 ω_4。
+ *
+ * 计划构造一次即可被反复使用，通过 get_ntt_plan 获取缓存的实例。
+ */
+template <typename T>
+class NttPlan
+{
+  using T_mont = T;
+
+public:
+  /**
+   * @param _n 变换长度（2 的幂）
+   * @param _p 模数（质数）
+   * @param _root 原根（普通整数）
+   */
+  NttPlan(T _n, T _p, T _root) : n(_n), p(_p), root(_root), montMod(_p), shoupMod(_p)
+  {
+    lg_n = 0;
+    while (((T)1 << lg_n) < n)
+      ++lg_n;
+
+    twiddles.reset(new T_mont[n]);
+    inv_twiddles.reset(new T_mont[n]);
+    T_mont root_mont = montMod.from_T(root);
+    T_mont inv_root_mont = montMod.inv(root_mont);
+    for (T mid = 1; mid < n; mid <<= 1)
+    {
+      T_mont Wn_mont = montMod.pow(root_mont, (p - 1) / (mid << 1));
+      T_mont inv_Wn_mont = montMod.pow(inv_root_mont, (p - 1) / (mid << 1));
+      twiddles[mid] = montMod.from_T(1);
+      inv_twiddles[mid] = montMod.from_T(1);
+      for (T k = 1; k < mid; ++k)
+      {
+        twiddles[mid + k] = montMod.mul(twiddles[mid + k - 1], Wn_mont);
+        inv_twiddles[mid + k] = montMod.mul(inv_twiddles[mid + k - 1], inv_Wn_mont);
+      }
+    }
+
+    rev.reset(new T[n]);
+    rev[0] = 0;
+    for (T i = 1; i < n; ++i)
+      rev[i] = (rev[i >> 1] >> 1) | ((i & 1) << (lg_n - 1));
+
+    inv_n_mont = montMod.inv(montMod.from_T(n));
+
+    if (ShoupMod<T>::supports(p))
+    {
+      lazy_twiddles.reset(new T[n]);
+      lazy_twiddles_shoup.reset(new T[n]);
+      lazy_inv_twiddles.reset(new T[n]);
+      lazy_inv_twiddles_shoup.reset(new T[n]);
+      for (T i = 1; i < n; ++i)
+      {
+        lazy_twiddles[i] = montMod.to_T(twiddles[i]);
+        lazy_twiddles_shoup[i] = shoupMod.quotient(lazy_twiddles[i]);
+        lazy_inv_twiddles[i] = montMod.to_T(inv_twiddles[i]);
+        lazy_inv_twiddles_shoup[i] = shoupMod.quotient(lazy_inv_twiddles[i]);
+      }
+      lazy_inv_n_plain = montMod.to_T(inv_n_mont);
+      lazy_inv_n_plain_shoup = shoupMod.quotient(lazy_inv_n_plain);
+      lazy_pointwise_scale_plain = inv_n_mont; // Montgomery 形式的 1/n 即普通整数 R/n
+      lazy_pointwise_scale_plain_shoup = shoupMod.quotient(lazy_pointwise_scale_plain);
+
+      if (n >= 4)
+      {
+        // ω_{4q}^{3k} = ω_{4q}^k · ω_{2q}^k
+        lazy_twiddles3.reset(new T[n >> 1]);
+        lazy_twiddles3_shoup.reset(new T[n >> 1]);
+        lazy_inv_twiddles3.reset(new T[n >> 1]);
+        lazy_inv_twiddles3_shoup.reset(new T[n >> 1]);
+        for (T q = 1; q < (n >> 1); q <<= 1)
+        {
+          for (T k = 0; k < q; ++k)
+          {
+            lazy_twiddles3[q + k] = montMod.to_T(montMod.mul(twiddles[(q << 1) + k], twiddles[q + k]));
+            lazy_twiddles3_shoup[q + k] = shoupMod.quotient(lazy_twiddles3[q + k]);
+            lazy_inv_twiddles3[q + k] = montMod.to_T(montMod.mul(inv_twiddles[(q << 1) + k], inv_twiddles[q + k]));
+            lazy_inv_twiddles3_shoup[q + k] = shoupMod.quotient(lazy_inv_twiddles3[q + k]);
+          }
+        }
+        lazy_imag_plain = lazy_twiddles[3]; // ω_4，第 mid = 2 层的 k = 1
+        lazy_imag_plain_shoup = lazy_twiddles_shoup[3];
+        lazy_inv_imag_plain = lazy_inv_twiddles[3];
+        lazy_inv_imag_plain_shoup = lazy_inv_twiddles_shoup[3];
+      }
+    }
+  }
+
+  NttPlan(const NttPlan &) = delete;
+  NttPlan &operator=(const NttPlan &) = delete;
+
+  T size() const { return n; }
+  T mod() const { return p; }
+  const MontMod<T> &mont() const { return montMod; }
+
+  /** 第 mid 层的正变换旋转因子，共 mid 个 */
+  const T_mont *stage_twiddles(T mid) const { return twiddles.get() + mid; }
+  /** 第 mid 层的逆变换旋转因子，共 mid 个 */
+  const T_mont *stage_inv_twiddles(T mid) const { return inv_twiddles.get() + mid; }
+  const T *bit_reverse_table() const { return rev.get(); }
+  T_mont inv_n() const { return inv_n_mont; }
+
+  /** 是否可以使用惰性规约的变换（见 ShoupMod） */
+  bool supports_lazy() const { return lazy_twiddles != nullptr; }
+  const ShoupMod<T> &shoup() const { return shoupMod; }
+  /** 第 mid 层的正变换旋转因子（普通整数）及其 Shoup 商，共 mid 个 */
+  const T *stage_lazy_twiddles(T mid) const { return lazy_twiddles.get() + mid; }
+  const T *stage_lazy_twiddles_shoup(T mid) const { return lazy_twiddles_shoup.get() + mid; }
+  /** 第 mid 层的逆变换旋转因子（普通整数）及其 Shoup 商，共 mid 个 */
+  const T *stage_lazy_inv_twiddles(T mid) const { return lazy_inv_twiddles.get() + mid; }
+  const T *stage_lazy_inv_twiddles_shoup(T mid) const { return lazy_inv_twiddles_shoup.get() + mid; }
+  /** n 的逆元（普通整数）及其 Shoup 商 */
+  T lazy_inv_n() const { return lazy_inv_n_plain; }
+  T lazy_inv_n_shoup() const { return lazy_inv_n_plain_shoup; }
+  /** R/n（普通整数）及其 Shoup 商：融合的点乘里补上 Montgomery 乘法除掉的 R，同时乘上逆变换的 1/n */
+  T lazy_pointwise_scale() const { return lazy_pointwise_scale_plain; }
+  T lazy_pointwise_scale_shoup() const { return lazy_pointwise_scale_plain_shoup; }
+
+  /** radix-4 层（块长 4q）的 ω_{4q}^{3k}（普通整数）及其 Shoup 商，共 q 个；要求 supports_lazy() 且 n >= 4 */
+  const T *stage_lazy_twiddles3(T q) const { return lazy_twiddles3.get() + q; }
+  const T *stage_lazy_twiddles3_shoup(T q) const { return lazy_twiddles3_shoup.get() + q; }
+  /** 同上，逆变换的 ω_{4q}^{-3k} */
+  const T *stage_lazy_inv_twiddles3(T q) const { return lazy_inv_twiddles3.get() + q; }
+  const T *stage_lazy_inv_twiddles3_shoup(T q) const { return lazy_inv_twiddles3_shoup.get() + q; }
+  /** ω_4 和 ω_4^{-1}（普通整数）及其 Shoup 商 */
+  T lazy_imag() const { return lazy_imag_plain; }
+  T lazy_imag_shoup() const { return lazy_imag_plain_shoup; }
+  T lazy_inv_imag() const { return lazy_inv_imag_plain; }
+  T lazy_inv_imag_shoup() const { return lazy_inv_imag_plain_shoup; }
+
+private:
+  T n;
+  T lg_n;
+  T p;
+  T root;
+  MontMod<T> montMod;
+
+  std::unique_ptr<T_mont[]> twiddles;
+  std::unique_ptr<T_mont[]> inv_twiddles;
+  std::unique_ptr<T[]> rev;
+  T_mont inv_n_mont;
+
+  ShoupMod<T> shoupMod;
+  std::unique_ptr<T[]> lazy_twiddles;
+  std::unique_ptr<T[]> lazy_twiddles_shoup;
+  std::unique_ptr<T[]> lazy_inv_twiddles;
+  std::unique_ptr<T[]> lazy_inv_twiddles_shoup;
+  T lazy_inv_n_plain;
+  T lazy_inv_n_plain_shoup;
+  T lazy_pointwise_scale_plain;
+  T lazy_pointwise_scale_plain_shoup;
+
+  std::unique_ptr<T[]> lazy_twiddles3;
+  std::unique_ptr<T[]> lazy_twiddles3_shoup;
+  std::unique_ptr<T[]> lazy_inv_twiddles3;
+  std::unique_ptr<T[]> lazy_inv_twiddles3_shoup;
+  T lazy_imag_plain;
+  T lazy_imag_plain_shoup;
+  T lazy_inv_imag_plain;
+  T lazy_inv_imag_plain_shoup;
+};
+
+/**
+ * @brief 获取 (n, p, root) 对应的 NTT 计划，第一次使用时构造，之后一直缓存。
+ *
+ * 线程安全：CRT 的 pthread 版本会在多个线程里同时调用。
+ */
+template <typename T>
+inline const NttPlan<T> &get_ntt_plan(T n, T p, T root)
+{
+  static std::mutex cache_mutex;
+  static std::map<std::tuple<T, T, T>, std::unique_ptr<NttPlan<T>>> cache;
+
+  std::lock_guard<std::mutex> lock(cache_mutex);
+  std::unique_ptr<NttPlan<T>> &plan = cache[std::make_tuple(n, p, root)];
+  if (!plan)
+    plan.reset(new NttPlan<T>(n, p, root));
+  return *plan;
+}
+
+/**
+ * @brief 用计划中的表就地做 bit-reverse 置换。
+ *
+ * @param a 输入序列（是不是 Montgomery 数域无所谓）
+ * @param plan 长度与 a 相同的 NTT 计划
+ */
+template <typename T>
+inline void bit_reverse_permute(T *a, const NttPlan<T> &plan)
+{
+  const T *rev = plan.bit_reverse_table();
+  for (T i = 0; i < plan.size(); ++i)
+  {
+    T j = rev[i];
+    if (i < j)
+    {
+      auto tmp = a[i];
+      a[i] = a[j];
+      a[j] = tmp;
+    }
+  }
+}
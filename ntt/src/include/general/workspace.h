@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include <stdlib.h>
+
+/**
+ * @brief 多项式乘法的工作区：两块按缓存行对齐的缓冲区，跨调用复用。
+ *
+ * 一次乘法只需要两块长为 n_expanded 的缓冲区：a、b 分别扩展、转换、正变换，
+ * 点乘的结果写回第一块，在第一块上做逆变换。容量只增不减，同样长度的乘法反复调用时不再分配内存。
+ *
+ * 工作区不是线程安全的，每个线程用自己的一份（见 thread_local_workspace）。
+ */
+class NttWorkspace
+{
+public:
+  static constexpr std::size_t alignment = 64;
+
+  NttWorkspace() = default;
+  ~NttWorkspace() { std::free(data); }
+
+  NttWorkspace(const NttWorkspace &) = delete;
+  NttWorkspace &operator=(const NttWorkspace &) = delete;
+
+  /**
+   * @brief 保证每块缓冲区至少有 bytes 字节；不够时重新分配，原有内容不保留。
+   */
+  void reserve(std::size_t bytes)
+  {
+    if (bytes <= buffer_bytes)
+      return;
+    std::size_t rounded = (bytes + alignment - 1) / alignment * alignment;
+    void *new_data = nullptr;
+    if (posix_memalign(&new_data, alignment, 2 * rounded) != 0)
+      throw std::bad_alloc();
+    std::free(data);
+    data = static_cast<unsigned char *>(new_data);
+    buffer_bytes = rounded;
+  }
+
+  /** 第 i 块（0 或 1）缓冲区，按 V 的数组使用 */
+  template <typename V>
+  V *buffer(int i) const { return reinterpret_cast<V *>(data + i * buffer_bytes); }
+
+  /** 每块缓冲区的字节数 */
+  std::size_t capacity() const { return buffer_bytes; }
+
+private:
+  unsigned char *data = nullptr;
+  std::size_t buffer_bytes = 0;
+};
+
+/**
+ * @brief 当前线程的工作区：不传工作区的 poly_multiply_* 默认使用它。
+ */
+inline NttWorkspace &thread_local_workspace()
+{
+  thread_local NttWorkspace workspace;
+  return workspace;
+}
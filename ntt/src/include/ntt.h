@@ -1,52 +1,91 @@
 #pragma once
 
 #include "general/utils.h"
+#include "general/workspace.h"
 #include "transform.h"
 
 /**
- * @brief 使用NTT优化的多项式乘法
+ * @brief 使用NTT优化的多项式乘法（使用调用者提供的工作区）
+ *
+ * 模数支持惰性规约时（见 ShoupMod::supports），扩展、点乘、缩放都并进了变换的第一层或最后一层，
+ * 除蝴蝶本身外没有单独遍历整个数组的循环，见 ntt_forward_dif_lazy_from_input。
+ * 否则扩展和 Montgomery 转换在写入工作区时一起完成，点乘结果写回第一块缓冲区。
+ * 全程只用工作区的两块缓冲区，工作区足够大时不分配内存。
  *
  * @param a 多项式系数
  * @param b 多项式系数
- * @param ab 结果
+ * @param ab 结果，长度至少为 expand_n(2n - 1)
  * @param n 多项式长度
  * @param p 模数（质数）
+ * @param workspace 工作区
  */
 template <typename T>
-inline void poly_multiply_ntt(T *a, T *b, T *ab, T n, T p, T OMEGA = 3)
+inline void poly_multiply_ntt(T *a, T *b, T *ab, T n, T p, T OMEGA, NttWorkspace &workspace)
 {
   using T_mont = T;
 
-  MontMod<T> montMod(p);
-
   T n_expanded = expand_n(2 * n - 1);
-  T *a_expanded = expand_a((T *)a, n, n_expanded);
-  T *b_expanded = expand_a((T *)b, n, n_expanded);
-
-  bit_reverse_permute(a_expanded, n_expanded);
-  bit_reverse_permute(b_expanded, n_expanded);
+  const NttPlan<T> &plan = get_ntt_plan(n_expanded, p, OMEGA);
+  const MontMod<T> &montMod = plan.mont();
 
-  T_mont *a_mont = new T_mont[n_expanded]{};
-  T_mont *b_mont = new T_mont[n_expanded]{};
-  T_mont *ab_mont = new T_mont[n_expanded]{};
-  for (T i = 0; i < n_expanded; ++i)
-    a_mont[i] = montMod.from_T(a_expanded[i]);
-  for (T i = 0; i < n_expanded; ++i)
-    b_mont[i] = montMod.from_T(b_expanded[i]);
-  T_mont omega_mont = montMod.from_T(OMEGA);
+  workspace.reserve(n_expanded * sizeof(T_mont));
+  T_mont *a_mont = workspace.buffer<T_mont>(0);
+  T_mont *b_mont = workspace.buffer<T_mont>(1);
 
-  ntt_forward_mont(a_mont, n_expanded, p, omega_mont);
-  ntt_forward_mont(b_mont, n_expanded, p, omega_mont);
+  // DIF 正变换输出 bit-reversed 的频域系数，DIT 逆变换直接接收，不需要置换
+  if (plan.supports_lazy() && n_expanded >= 4)
+  {
+    ntt_forward_dif_lazy_from_input(a_mont, a, n, plan);
+    ntt_forward_dif_lazy_from_input(b_mont, b, n, plan);
+    ntt_pointwise_lazy_fused(a_mont, b_mont, plan);
+    ntt_inverse_dit_lazy_to_output(a_mont, ab, plan);
+    return;
+  }
 
-  for (T i = 0; i < n_expanded; ++i)
-    ab_mont[i] = montMod.mul(a_mont[i], b_mont[i]);
+  for (T i = 0; i < n; ++i)
+    a_mont[i] = montMod.from_T(a[i]);
+  for (T i = 0; i < n; ++i)
+    b_mont[i] = montMod.from_T(b[i]);
+  for (T i = n; i < n_expanded; ++i)
+    a_mont[i] = b_mont[i] = 0; // 0 在 Montgomery 数域里还是 0
 
-  ntt_inverse_mont(ab_mont, n_expanded, p, montMod.inv(omega_mont));
+  if (plan.supports_lazy())
+  {
+    // 频域系数在 [0, 2p)，Montgomery 乘法的结果仍然完全规约
+    ntt_forward_dif_mont_lazy(a_mont, plan);
+    ntt_forward_dif_mont_lazy(b_mont, plan);
+    for (T i = 0; i < n_expanded; ++i)
+      a_mont[i] = montMod.mul(a_mont[i], b_mont[i]);
+    ntt_inverse_dit_mont_lazy(a_mont, plan);
+  }
+  else
+  {
+    ntt_forward_dif_mont(a_mont, plan);
+    ntt_forward_dif_mont(b_mont, plan);
+    for (T i = 0; i < n_expanded; ++i)
+      a_mont[i] = montMod.mul(a_mont[i], b_mont[i]);
+    ntt_inverse_dit_mont(a_mont, plan);
+  }
 
   for (T i = 0; i < n_expanded; ++i)
-    ab[i] = montMod.to_T(ab_mont[i]);
+    ab[i] = montMod.to_T(a_mont[i]);
+}
 
-  bit_reverse_permute((T *)ab, n_expanded);
+/**
+ * @brief 使用NTT优化的多项式乘法
+ *
+ * 使用当前线程的工作区，见 thread_local_workspace。
+ *
+ * @param a 多项式系数
+ * @param b 多项式系数
+ * @param ab 结果
+ * @param n 多项式长度
+ * @param p 模数（质数）
+ */
+template <typename T>
+inline void poly_multiply_ntt(T *a, T *b, T *ab, T n, T p, T OMEGA = 3)
+{
+  poly_multiply_ntt(a, b, ab, n, p, OMEGA, thread_local_workspace());
 }
 
 inline void poly_multiply_naive(int *a, int *b, int *ab, int n, int p)
@@ -7,6 +7,7 @@
 #include "../general/utils.h"
 #include "../general/op.h"
 #include "../ntt.h"
+#include "../fixed/ntt.h"
 #include <pthread.h>
 
 #include "../CRT/const.h"
@@ -23,12 +24,12 @@ struct PthreadNttArgs
     u64 current_root;     // The primitive root for the current_mod
 };
 
-// Thread worker function: performs poly_multiply_ntt for a single CRT modulus
+// Thread worker function: performs poly_multiply_ntt_fixed for a single CRT modulus
 static void *poly_multiply_ntt_thread_worker(void *arg)
 {
     PthreadNttArgs *params = (PthreadNttArgs *)arg;
-    poly_multiply_ntt(params->a_poly, params->b_poly, params->result_poly_crt,
-                      params->n_poly_len, params->current_mod, params->current_root);
+    poly_multiply_ntt_fixed(params->a_poly, params->b_poly, params->result_poly_crt,
+                            params->n_poly_len, params->current_mod, params->current_root);
     return NULL;
 }
 
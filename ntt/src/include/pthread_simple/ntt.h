@@ -2,68 +2,13 @@
 
 #include "../general/utils.h"
 #include "../general/op.h"
+#include "../general/plan.h"
 #include <pthread.h>
 #include <vector>
 #include <queue>
 #include <functional>
 #include <unistd.h>
 
-/**
- * @brief 使用NTT优化的多项式乘法
- *
- * @param a 多项式系数
- * @param b 多项式系数
- * @param ab 结果
- * @param n 多项式长度
- * @param p 模数（质数）
- */
-template <typename T>
-inline void poly_multiply_ntt_pthread_simple(T *a, T *b, T *ab, T n, T p, T OMEGA = 3)
-{
-  // num_threads is now implicitly handled by the global thread pool size.
-  // No longer need to pass num_threads to ntt_forward/inverse_mont_pthread.
-
-  using T_mont = T;
-  MontMod<T> montMod(p);
-
-  T n_expanded = expand_n(2 * n - 1);
-  T *a_expanded = expand_a(a, n, n_expanded);
-  T *b_expanded = expand_a(b, n, n_expanded);
-
-  bit_reverse_permute(a_expanded, n_expanded);
-  bit_reverse_permute(b_expanded, n_expanded);
-
-  T_mont *a_mont = new T_mont[n_expanded]{};
-  T_mont *b_mont = new T_mont[n_expanded]{};
-  T_mont *ab_mont = new T_mont[n_expanded]{};
-  for (T i = 0; i < n_expanded; ++i)
-    a_mont[i] = montMod.from_T(a_expanded[i]);
-  for (T i = 0; i < n_expanded; ++i)
-    b_mont[i] = montMod.from_T(b_expanded[i]);
-
-  T_mont omega_mont_primitive_root = montMod.from_T(OMEGA);
-
-  ntt_forward_mont_pthread(a_mont, n_expanded, p, omega_mont_primitive_root, montMod);
-  ntt_forward_mont_pthread(b_mont, n_expanded, p, omega_mont_primitive_root, montMod);
-
-  for (T i = 0; i < n_expanded; ++i)
-    ab_mont[i] = montMod.mul(a_mont[i], b_mont[i]);
-
-  T_mont inv_omega_mont_primitive_root = montMod.inv(omega_mont_primitive_root);
-  ntt_inverse_mont_pthread(ab_mont, n_expanded, p, inv_omega_mont_primitive_root, montMod);
-
-  for (T i = 0; i < n_expanded; ++i)
-    ab[i] = montMod.to_T(ab_mont[i]);
-
-  delete[] a_expanded;
-  delete[] b_expanded;
-  delete[] a_mont;
-  delete[] b_mont;
-  delete[] ab_mont;
-
-  bit_reverse_permute(ab, n_expanded);
-}
-
 // Forward declaration for the ThreadPool's static worker function
 static void *thread_pool_worker_function(void *context);
 
@@ -94,6 +39,7 @@ public:
     {
       pthread_mutex_lock(&task_queue_mutex);
       stop_pool_flag = true;
+      pthread_mutex_unlock(&task_queue_mutex);
     }
     pthread_cond_broadcast(&notify_new_task_condition); // Wake up all worker threads
     for (pthread_t tid : worker_pthread_ids)
@@ -313,4 +259,143 @@ void ntt_inverse_mont_pthread(T *a_mont_arr, T n_len, T p_mod, T inv_omega_mont_
       a_mont_arr[i] = montMod.mul(a_mont_arr[i], n_inv_mont);
     }
   }
-}
\ No newline at end of file
+}
+
+// Splits the n/2 butterflies of one stage into contiguous ranges, one per pool
+// thread. Unlike the per-j-block split above this also parallelizes the
+// stages with only a few large blocks (the first DIF / last DIT stages).
+template <typename T, typename F>
+void run_ntt_stage_pthread(T n_len, F stage_range)
+{
+  T butterflies = n_len >> 1;
+  T num_tasks = NTT_GLOBAL_POOL_THREADS;
+  if (num_tasks < 2 || butterflies < (T)4096)
+  { // Serial execution, not worth the task overhead
+    stage_range((T)0, butterflies);
+    return;
+  }
+  T per_task = (butterflies + num_tasks - 1) / num_tasks;
+  for (T begin = 0; begin < butterflies; begin += per_task)
+  {
+    T end = begin + per_task < butterflies ? begin + per_task : butterflies;
+    g_ntt_thread_pool.enqueue_task([&stage_range, begin, end]()
+                                   { stage_range(begin, end); });
+  }
+  g_ntt_thread_pool.wait_all_current_tasks_completed();
+}
+
+// Pthread version of ntt_forward_dif_mont: natural order in, bit-reversed out
+template <typename T>
+void ntt_forward_dif_mont_pthread(T *a_mont_arr, const NttPlan<T> &plan)
+{
+  const MontMod<T> &montMod = plan.mont();
+  T n_len = plan.size();
+
+  for (T mid = n_len >> 1; mid > 0; mid >>= 1)
+  {
+    const T *w_mont = plan.stage_twiddles(mid);
+    run_ntt_stage_pthread(n_len, [&](T begin, T end)
+                          {
+      T j = (begin / mid) * (mid << 1);
+      T k = begin % mid;
+      for (T t = begin; t < end; ++t)
+      {
+        T x_mont = a_mont_arr[j + k];
+        T y_mont = a_mont_arr[j + k + mid];
+        a_mont_arr[j + k] = montMod.add(x_mont, y_mont);
+        a_mont_arr[j + k + mid] = montMod.mul(w_mont[k], montMod.sub(x_mont, y_mont));
+        if (++k == mid)
+        {
+          k = 0;
+          j += (mid << 1);
+        }
+      } });
+  }
+}
+
+// Pthread version of ntt_inverse_dit_mont: bit-reversed in, natural order out
+template <typename T>
+void ntt_inverse_dit_mont_pthread(T *a_mont_arr, const NttPlan<T> &plan)
+{
+  const MontMod<T> &montMod = plan.mont();
+  T n_len = plan.size();
+
+  for (T mid = 1; mid < n_len; mid <<= 1)
+  {
+    const T *w_mont = plan.stage_inv_twiddles(mid);
+    run_ntt_stage_pthread(n_len, [&](T begin, T end)
+                          {
+      T j = (begin / mid) * (mid << 1);
+      T k = begin % mid;
+      for (T t = begin; t < end; ++t)
+      {
+        T x_mont = a_mont_arr[j + k];
+        T y_mont = montMod.mul(w_mont[k], a_mont_arr[j + k + mid]);
+        a_mont_arr[j + k] = montMod.add(x_mont, y_mont);
+        a_mont_arr[j + k + mid] = montMod.sub(x_mont, y_mont);
+        if (++k == mid)
+        {
+          k = 0;
+          j += (mid << 1);
+        }
+      } });
+  }
+
+  // Final scaling for inverse NTT
+  T n_inv_mont = plan.inv_n();
+  for (T i = 0; i < n_len; ++i)
+  {
+    a_mont_arr[i] = montMod.mul(a_mont_arr[i], n_inv_mont);
+  }
+}
+
+/**
+ * @brief 使用NTT优化的多项式乘法
+ *
+ * DIF 正变换输出 bit-reversed 的频域系数，DIT 逆变换直接接收，全程不需要 bit-reverse 置换。
+ *
+ * @param a 多项式系数
+ * @param b 多项式系数
+ * @param ab 结果
+ * @param n 多项式长度
+ * @param p 模数（质数）
+ */
+template <typename T>
+inline void poly_multiply_ntt_pthread_simple(T *a, T *b, T *ab, T n, T p, T OMEGA = 3)
+{
+  // num_threads is now implicitly handled by the global thread pool size.
+
+  using T_mont = T;
+
+  T n_expanded = expand_n(2 * n - 1);
+  const NttPlan<T> &plan = get_ntt_plan(n_expanded, p, OMEGA);
+  const MontMod<T> &montMod = plan.mont();
+
+  T *a_expanded = expand_a(a, n, n_expanded);
+  T *b_expanded = expand_a(b, n, n_expanded);
+
+  T_mont *a_mont = new T_mont[n_expanded]{};
+  T_mont *b_mont = new T_mont[n_expanded]{};
+  T_mont *ab_mont = new T_mont[n_expanded]{};
+  for (T i = 0; i < n_expanded; ++i)
+    a_mont[i] = montMod.from_T(a_expanded[i]);
+  for (T i = 0; i < n_expanded; ++i)
+    b_mont[i] = montMod.from_T(b_expanded[i]);
+
+  ntt_forward_dif_mont_pthread(a_mont, plan);
+  ntt_forward_dif_mont_pthread(b_mont, plan);
+
+  for (T i = 0; i < n_expanded; ++i)
+    ab_mont[i] = montMod.mul(a_mont[i], b_mont[i]);
+
+  ntt_inverse_dit_mont_pthread(ab_mont, plan);
+
+  for (T i = 0; i < n_expanded; ++i)
+    ab[i] = montMod.to_T(ab_mont[i]);
+
+  delete[] a_expanded;
+  delete[] b_expanded;
+  delete[] a_mont;
+  delete[] b_mont;
+  delete[] ab_mont;
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "../general/utils.h"
+#include "../general/workspace.h"
+#include "../transform.h"
+#include "transform.h"
+
+/**
+ * @brief 使用 radix-4 NTT 优化的多项式乘法（使用调用者提供的工作区）
+ *
+ * 模数不满足惰性规约的要求（见 ShoupMod）时退回 radix-2 的 DIF/DIT。
+ * 只用工作区的两块缓冲区，见 poly_multiply_ntt。
+ *
+ * @param a 多项式系数
+ * @param b 多项式系数
+ * @param ab 结果
+ * @param n 多项式长度
+ * @param p 模数（质数）
+ * @param workspace 工作区
+ */
+template <typename T>
+inline void poly_multiply_ntt_radix4(T *a, T *b, T *ab, T n, T p, T OMEGA, NttWorkspace &workspace)
+{
+  using T_mont = T;
+
+  T n_expanded = expand_n(2 * n - 1);
+  const NttPlan<T> &plan = get_ntt_plan(n_expanded, p, OMEGA);
+  const MontMod<T> &montMod = plan.mont();
+
+  workspace.reserve(n_expanded * sizeof(T_mont));
+  T_mont *a_mont = workspace.buffer<T_mont>(0);
+  T_mont *b_mont = workspace.buffer<T_mont>(1);
+  for (T i = 0; i < n; ++i)
+    a_mont[i] = montMod.from_T(a[i]);
+  for (T i = 0; i < n; ++i)
+    b_mont[i] = montMod.from_T(b[i]);
+  for (T i = n; i < n_expanded; ++i)
+    a_mont[i] = b_mont[i] = 0;
+
+  if (plan.supports_lazy())
+  {
+    ntt_forward_dif_radix4_lazy(a_mont, plan);
+    ntt_forward_dif_radix4_lazy(b_mont, plan);
+    for (T i = 0; i < n_expanded; ++i)
+      a_mont[i] = montMod.mul(a_mont[i], b_mont[i]);
+    ntt_inverse_dit_radix4_lazy(a_mont, plan);
+  }
+  else
+  {
+    ntt_forward_dif_mont(a_mont, plan);
+    ntt_forward_dif_mont(b_mont, plan);
+    for (T i = 0; i < n_expanded; ++i)
+      a_mont[i] = montMod.mul(a_mont[i], b_mont[i]);
+    ntt_inverse_dit_mont(a_mont, plan);
+  }
+
+  for (T i = 0; i < n_expanded; ++i)
+    ab[i] = montMod.to_T(a_mont[i]);
+}
+
+/**
+ * @brief 使用 radix-4 NTT 优化的多项式乘法
+ *
+ * 使用当前线程的工作区，见 thread_local_workspace。
+ *
+ * @param a 多项式系数
+ * @param b 多项式系数
+ * @param ab 结果
+ * @param n 多项式长度
+ * @param p 模数（质数）
+ */
+template <typename T>
+inline void poly_multiply_ntt_radix4(T *a, T *b, T *ab, T n, T p, T OMEGA = 3)
+{
+  poly_multiply_ntt_radix4(a, b, ab, n, p, OMEGA, thread_local_workspace());
+}
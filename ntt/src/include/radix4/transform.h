@@ -0,0 +1,154 @@
+#pragma once
+
+#include "../general/op.h"
+#include "../general/plan.h"
+
+/**
+ * @brief radix-4 惰性规约的 DIF 正变换：a(x) → A(ω)
+ *
+ * 把 ntt_forward_dif_mont_lazy 中相邻的两层（mid = 2q 和 mid = q）合并成一次 radix-4 蝴蝶，
+ * 每次读写 4 个相距 q 的元素，遍历数组的次数减半。log2(n) 为奇数时，最后剩下的 mid = 1 一层用 radix-2 做。
+ *
+ * 结果与 ntt_forward_dif_mont_lazy 完全相同：自然顺序输入，bit-reversed 输出，数值在 [0, 2p)。
+ * 要求 plan.supports_lazy()。
+ *
+ * 记 W = ω_{4q}，I = ω_4 = W^q，块内第 k 组 (a0, a1, a2, a3) = (a[k], a[k + q], a[k + 2q], a[k + 3q])：
+ *   a0 ← (a0 + a2) + (a1 + a3)
+ *   a1 ← ((a0 + a2) - (a1 + a3)) · W^{2k}
+ *   a2 ← ((a0 - a2) + I(a1 - a3)) · W^k
+ *   a3 ← ((a0 - a2) - I(a1 - a3)) · W^{3k}
+ *
+ * @param a 多项式系数（[0, 2p)，自然顺序），变换后表示频域系数（[0, 2p)，bit-reversed 顺序）
+ * @param plan NTT 计划
+ */
+template <typename T>
+inline void ntt_forward_dif_radix4_lazy(T *a, const NttPlan<T> &plan)
+{
+  const ShoupMod<T> &shoupMod = plan.shoup();
+  const T p2 = shoupMod.mod_2p();
+  T n = plan.size();
+
+  T mid = n >> 1;
+  if (mid >= 2)
+  {
+    const T imag = plan.lazy_imag();
+    const T imag_shoup = plan.lazy_imag_shoup();
+    for (; mid >= 2; mid >>= 2)
+    {
+      T q = mid >> 1;
+      const T *w1 = plan.stage_lazy_twiddles(mid);
+      const T *w1_shoup = plan.stage_lazy_twiddles_shoup(mid);
+      const T *w2 = plan.stage_lazy_twiddles(q);
+      const T *w2_shoup = plan.stage_lazy_twiddles_shoup(q);
+      const T *w3 = plan.stage_lazy_twiddles3(q);
+      const T *w3_shoup = plan.stage_lazy_twiddles3_shoup(q);
+      for (T j = 0; j < n; j += (mid << 1))
+      {
+        T *a0 = a + j, *a1 = a0 + q, *a2 = a1 + q, *a3 = a2 + q;
+        for (T k = 0; k < q; ++k)
+        {
+          T s02 = shoupMod.reduce_2p(a0[k] + a2[k]);
+          T d02 = shoupMod.reduce_2p(a0[k] - a2[k] + p2);
+          T s13 = shoupMod.reduce_2p(a1[k] + a3[k]);
+          T d13 = shoupMod.mul(a1[k] - a3[k] + p2, imag, imag_shoup);
+          a0[k] = shoupMod.reduce_2p(s02 + s13);
+          a1[k] = shoupMod.mul(s02 - s13 + p2, w2[k], w2_shoup[k]);
+          a2[k] = shoupMod.mul(d02 + d13, w1[k], w1_shoup[k]);
+          a3[k] = shoupMod.mul(d02 - d13 + p2, w3[k], w3_shoup[k]);
+        }
+      }
+    }
+  }
+
+  if (mid == 1) // log2(n) 为奇数，最后一层 radix-2，旋转因子为 1
+  {
+    for (T j = 0; j < n; j += 2)
+    {
+      T x = a[j];
+      T y = a[j + 1];
+      a[j] = shoupMod.reduce_2p(x + y);
+      a[j + 1] = shoupMod.reduce_2p(x - y + p2);
+    }
+  }
+}
+
+/**
+ * @brief radix-4 惰性规约的 DIT 逆变换：A(ω) → a(x)
+ *
+ * ntt_inverse_dit_mont_lazy 的 radix-4 版本：log2(n) 为奇数时先做 mid = 1 一层 radix-2，
+ * 之后每次合并 mid = q 和 mid = 2q 两层。中间结果在 [0, 4p)，最后乘 n 的逆元时完全规约。
+ * 要求 plan.supports_lazy()。
+ *
+ * 记 W = ω_{4q}^{-1}，J = ω_4^{-1}，A1 = a1·W^{2k}，A2 = a2·W^k，A3 = a3·W^{3k}：
+ *   a0 ← (a0 + A1) + (A2 + A3)
+ *   a1 ← (a0 - A1) + J(A2 - A3)
+ *   a2 ← (a0 + A1) - (A2 + A3)
+ *   a3 ← (a0 - A1) - J(A2 - A3)
+ *
+ * @param a 频域系数（[0, 4p)，bit-reversed 顺序），变换后表示多项式系数（[0, p)，自然顺序）
+ * @param plan NTT 计划
+ */
+template <typename T>
+inline void ntt_inverse_dit_radix4_lazy(T *a, const NttPlan<T> &plan)
+{
+  const ShoupMod<T> &shoupMod = plan.shoup();
+  const T p2 = shoupMod.mod_2p();
+  T n = plan.size();
+
+  T lg_n = 0;
+  while (((T)1 << lg_n) < n)
+    ++lg_n;
+
+  T mid = 1;
+  if (lg_n & 1) // log2(n) 为奇数，第一层 radix-2，旋转因子为 1
+  {
+    for (T j = 0; j < n; j += 2)
+    {
+      T x = shoupMod.reduce_2p(a[j]);
+      T y = shoupMod.reduce_2p(a[j + 1]);
+      a[j] = x + y;
+      a[j + 1] = x - y + p2;
+    }
+    mid = 2;
+  }
+
+  if (mid < n)
+  {
+    const T inv_imag = plan.lazy_inv_imag();
+    const T inv_imag_shoup = plan.lazy_inv_imag_shoup();
+    for (; mid < n; mid <<= 2)
+    {
+      T q = mid;
+      const T *w1 = plan.stage_lazy_inv_twiddles(q << 1);
+      const T *w1_shoup = plan.stage_lazy_inv_twiddles_shoup(q << 1);
+      const T *w2 = plan.stage_lazy_inv_twiddles(q);
+      const T *w2_shoup = plan.stage_lazy_inv_twiddles_shoup(q);
+      const T *w3 = plan.stage_lazy_inv_twiddles3(q);
+      const T *w3_shoup = plan.stage_lazy_inv_twiddles3_shoup(q);
+      for (T j = 0; j < n; j += (q << 2))
+      {
+        T *a0 = a + j, *a1 = a0 + q, *a2 = a1 + q, *a3 = a2 + q;
+        for (T k = 0; k < q; ++k)
+        {
+          T x0 = shoupMod.reduce_2p(a0[k]);
+          T x1 = shoupMod.mul(a1[k], w2[k], w2_shoup[k]);
+          T x2 = shoupMod.mul(a2[k], w1[k], w1_shoup[k]);
+          T x3 = shoupMod.mul(a3[k], w3[k], w3_shoup[k]);
+          T s01 = shoupMod.reduce_2p(x0 + x1);
+          T d01 = shoupMod.reduce_2p(x0 - x1 + p2);
+          T s23 = shoupMod.reduce_2p(x2 + x3);
+          T d23 = shoupMod.mul(x2 - x3 + p2, inv_imag, inv_imag_shoup);
+          a0[k] = s01 + s23;
+          a1[k] = d01 + d23;
+          a2[k] = s01 - s23 + p2;
+          a3[k] = d01 - d23 + p2;
+        }
+      }
+    }
+  }
+
+  T inv_n = plan.lazy_inv_n();
+  T inv_n_shoup = plan.lazy_inv_n_shoup();
+  for (T i = 0; i < n; ++i)
+    a[i] = shoupMod.reduce_p(shoupMod.mul(a[i], inv_n, inv_n_shoup));
+}
@@ -1,72 +1,85 @@
 #pragma once
 
 #include "../general/utils.h"
+#include "../general/workspace.h"
+#include "../ntt.h"
 #include "utils.h"
 #include "transform.h"
 
 /**
- * @brief 使用NTT优化的多项式乘法
+ * @brief 使用NTT优化的多项式乘法（使用调用者提供的工作区）
  *
- * 进一步实现了SIMD优化。
+ * 进一步实现了SIMD优化，后端（NEON / AVX2 / AVX-512）见 type.h。
+ * 没有可用的后端，或者 n_expanded 不足两个向量时，退回 poly_multiply_ntt。
+ * 只用工作区的两块缓冲区；模数支持惰性规约时各步的融合方式见 poly_multiply_ntt。
  *
  * @param a 多项式系数
  * @param b 多项式系数
  * @param ab 结果
  * @param n 多项式长度
  * @param p 模数（质数）
+ * @param workspace 工作区
  */
-inline void poly_multiply_ntt_simd(int *a, int *b, int *ab, int n, int p, int OMEGA = 3)
+inline void poly_multiply_ntt_simd(int *a, int *b, int *ab, int n, int p, int OMEGA, NttWorkspace &workspace)
 {
-    MontModNeon montModNeon(p);
-    MontMod<u32> montMod(p);
-
+#ifdef NTT_SIMD_NONE
+    poly_multiply_ntt<u32>((u32 *)a, (u32 *)b, (u32 *)ab, (u32)n, (u32)p, (u32)OMEGA, workspace);
+#else
     u32 n_expanded = expand_n(2 * n - 1);
-    u32 *a_expanded = expand_a<u32>((u32 *)a, (u32)n, n_expanded);
-    u32 *b_expanded = expand_a<u32>((u32 *)b, (u32)n, n_expanded);
+    if (n_expanded < 2 * SIMD_LANES)
+    {
+        poly_multiply_ntt<u32>((u32 *)a, (u32 *)b, (u32 *)ab, (u32)n, (u32)p, (u32)OMEGA, workspace);
+        return;
+    }
 
-    bit_reverse_permute(a_expanded, n_expanded);
-    bit_reverse_permute(b_expanded, n_expanded);
+    MontModSimd montModSimd(p);
 
-    u32x4 *a_simd = new u32x4[n_expanded / 4];
-    u32x4 *b_simd = new u32x4[n_expanded / 4];
-    u32x4 *ab_simd = new u32x4[n_expanded / 4];
-    to_simd(a_expanded, a_simd, n_expanded);
-    to_simd(b_expanded, b_simd, n_expanded);
-    to_simd(new u32[n_expanded], ab_simd, n_expanded);
-    u32 n_simd = n_expanded / 4;
+    const NttPlan<u32> &plan = get_ntt_plan<u32>(n_expanded, p, OMEGA);
 
-    u32x4_mont *a_mont_simd = new u32x4_mont[n_simd];
-    u32x4_mont *b_mont_simd = new u32x4_mont[n_simd];
-    u32x4_mont *ab_mont_simd = new u32x4_mont[n_simd];
-    for (u32 i = 0; i < n_simd; ++i)
-        a_mont_simd[i] = montModNeon.from_u32x4(a_simd[i]);
-    for (u32 i = 0; i < n_simd; ++i)
-        b_mont_simd[i] = montModNeon.from_u32x4(b_simd[i]);
-    u32_mont omega_mont = montMod.from_T(OMEGA);
+    u32 n_simd = n_expanded / SIMD_LANES;
+    workspace.reserve(n_simd * sizeof(u32xN_mont));
+    u32xN_mont *a_mont_simd = workspace.buffer<u32xN_mont>(0);
+    u32xN_mont *b_mont_simd = workspace.buffer<u32xN_mont>(1);
 
-    ntt_forward_mont_simd(a_mont_simd, n_expanded, p, omega_mont);
-    ntt_forward_mont_simd(b_mont_simd, n_expanded, p, omega_mont);
+    // DIF 正变换输出 bit-reversed 的频域系数，DIT 逆变换直接接收，不需要置换
+    if (plan.supports_lazy())
+    {
+        // 扩展、点乘、缩放都并进了变换里，见 ntt_forward_dif_lazy_from_input
+        ntt_forward_dif_simd_lazy_from_input(a_mont_simd, (u32 *)a, n, plan);
+        ntt_forward_dif_simd_lazy_from_input(b_mont_simd, (u32 *)b, n, plan);
+        ntt_pointwise_simd_lazy_fused(a_mont_simd, b_mont_simd, plan);
+        ntt_inverse_dit_simd_lazy_to_output(a_mont_simd, (u32 *)ab, plan);
+        return;
+    }
 
     for (u32 i = 0; i < n_simd; ++i)
-        ab_mont_simd[i] = montModNeon.mul(a_mont_simd[i], b_mont_simd[i]);
-
-    ntt_inverse_mont_simd(ab_mont_simd, n_expanded, p, montMod.inv(omega_mont));
-
+        a_mont_simd[i] = montModSimd.from_u32xN(load_padded_simd((u32 *)a, n, i));
     for (u32 i = 0; i < n_simd; ++i)
-        ab_simd[i] = montModNeon.to_u32x4(ab_mont_simd[i]); // 消除 mont
-
-    u32 *ab_result = new u32[n_expanded];
-    from_simd(ab_result, ab_simd, n_expanded); // 消除 simd
-
-    bit_reverse_permute((u32 *)ab_result, n_expanded); // 消除 bit reversion
+        b_mont_simd[i] = montModSimd.from_u32xN(load_padded_simd((u32 *)b, n, i));
+    ntt_forward_dif_mont_simd(a_mont_simd, plan);
+    ntt_forward_dif_mont_simd(b_mont_simd, plan);
+    for (u32 i = 0; i < n_simd; ++i)
+        a_mont_simd[i] = montModSimd.mul(a_mont_simd[i], b_mont_simd[i]);
+    ntt_inverse_dit_mont_simd(a_mont_simd, plan);
 
-    for (u32 i = 0; i < n_expanded; ++i)
-        ab[i] = ab_result[i]; // TODO: 这里可以跟上面的from simd合并。
+    // 消除 mont，直接写回 ab（长度至少为 n_expanded）
+    for (u32 i = 0; i < n_simd; ++i)
+        simd_store((u32 *)ab + i * SIMD_LANES, montModSimd.to_u32xN(a_mont_simd[i]));
+#endif
+}
 
-    delete[] a_expanded;
-    delete[] b_expanded;
-    delete[] ab_result;
-    delete[] a_mont_simd;
-    delete[] b_mont_simd;
-    delete[] ab_mont_simd;
-}
\ No newline at end of file
+/**
+ * @brief 使用NTT优化的多项式乘法
+ *
+ * 进一步实现了SIMD优化，使用当前线程的工作区，见 thread_local_workspace。
+ *
+ * @param a 多项式系数
+ * @param b 多项式系数
+ * @param ab 结果
+ * @param n 多项式长度
+ * @param p 模数（质数）
+ */
+inline void poly_multiply_ntt_simd(int *a, int *b, int *ab, int n, int p, int OMEGA = 3)
+{
+    poly_multiply_ntt_simd(a, b, ab, n, p, OMEGA, thread_local_workspace());
+}
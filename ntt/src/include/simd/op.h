@@ -2,6 +2,13 @@
 
 #include "../general/type.h"
 #include "type.h"
+#include "vec.h"
+
+// 每个后端提供 MontModSimd（Montgomery 模运算）和 ShoupModSimd（Shoup 模乘），接口相同：
+// MontModSimd：from_u32xN / to_u32xN / add / sub / mul，输入输出都完全规约；
+// ShoupModSimd：mul / reduce_2p / reduce_p / mod_2p，与 ShoupMod<u32> 一致，要求 mod < 2^30。
+
+#if defined(NTT_SIMD_NEON)
 
 // === Montgomery 模运算（NEON） ===
 class MontModNeon
@@ -41,6 +48,9 @@ public:
         return reduce_pair(t0, t1);
     }
 
+    u32xN_mont from_u32xN(u32xN a) const { return from_u32x4(a); }
+    u32xN to_u32xN(u32xN_mont a_mont) const { return to_u32x4(a_mont); }
+
     u32x4_mont reduce_pair(u64x2 t0, u64x2 t1) const
     {
         // m = (t mod 2^32) * neg_r_inv mod 2^32
@@ -110,4 +120,159 @@ private:
 
     u32x4 mod_vec;       // 向量化的模数
     u32x4 neg_r_inv_vec; // 向量化的 -r^(-1) mod 2^32
-};
\ No newline at end of file
+};
+// === Shoup 模乘（NEON，配合 Harvey 惰性规约） ===
+// ShoupMod<u32> 的 SIMD 版本，要求 mod < 2^30。
+class ShoupModNeon
+{
+public:
+    ShoupModNeon(u32 _mod)
+    {
+        mod_vec = vdupq_n_u32(_mod);
+        mod2_vec = vdupq_n_u32(_mod << 1);
+    }
+
+    ShoupModNeon(const ShoupModNeon &) = delete;
+    ShoupModNeon &operator=(const ShoupModNeon &) = delete;
+
+    /** x·w mod mod，结果在 [0, 2·mod)；w_shoup 是 w 的 Shoup 商 */
+    u32x4 mul(u32x4 x, u32x4 w, u32x4 w_shoup) const
+    {
+        // q = (x·w_shoup) >> 32
+        u64x2 q0 = vmull_u32(vget_low_u32(x), vget_low_u32(w_shoup));
+        u64x2 q1 = vmull_u32(vget_high_u32(x), vget_high_u32(w_shoup));
+        u32x4 q = vcombine_u32(vshrn_n_u64(q0, 32), vshrn_n_u64(q1, 32));
+
+        // x·w - q·mod，只需要低 32 位
+        return vmlsq_u32(vmulq_u32(x, w), q, mod_vec);
+    }
+
+    /** [0, 4·mod) → [0, 2·mod)：x < 2·mod 时 x - 2·mod 回绕成很大的数，取较小者即可 */
+    u32x4 reduce_2p(u32x4 x) const { return vminq_u32(x, vsubq_u32(x, mod2_vec)); }
+    /** [0, 2·mod) → [0, mod) */
+    u32x4 reduce_p(u32x4 x) const { return vminq_u32(x, vsubq_u32(x, mod_vec)); }
+
+    u32x4 mod_2p() const { return mod2_vec; }
+
+private:
+    u32x4 mod_vec;  // 向量化的模数
+    u32x4 mod2_vec; // 向量化的 2·mod
+};
+
+using MontModSimd = MontModNeon;
+using ShoupModSimd = ShoupModNeon;
+
+#elif defined(NTT_SIMD_AVX512) || defined(NTT_SIMD_AVX2)
+
+// === Montgomery 模运算（AVX2 / AVX-512） ===
+// 32×32→64 的乘法（_mm256_mul_epu32 / _mm512_mul_epu32）一次只算偶数通道，
+// 奇数通道右移 32 位后再算一次，两半的高 32 位拼回一个向量。要求 mod < 2^31。
+class MontModAvx
+{
+public:
+    MontModAvx(u32 _mod) : mod(_mod)
+    {
+        // 计算 r^2 mod mod，这里 r = 2^32
+        u64 r2_temp = 1;
+        for (int i = 0; i < 32; ++i)
+            r2_temp = (r2_temp << 1) % mod;
+        u32 r2 = (u64)r2_temp * r2_temp % mod;
+
+        u32 inv = 1;
+        for (int i = 0; i < 5; ++i)
+            inv = (u32)((u64)inv * (2 - (u64)mod * inv));
+
+        mod_vec = simd_dup(mod);
+        r_inv_vec = simd_dup(inv);
+        r2_vec = simd_dup(r2);
+        one_vec = simd_dup(1);
+    }
+
+    MontModAvx(const MontModAvx &) = delete;
+    MontModAvx &operator=(const MontModAvx &) = delete;
+
+    u32xN_mont from_u32xN(u32xN a) const { return mul(a, r2_vec); }
+    u32xN to_u32xN(u32xN_mont a_mont) const { return mul(a_mont, one_vec); }
+
+    u32xN_mont add(u32xN_mont a, u32xN_mont b) const
+    {
+        // a + b < 2·mod < 2^32，不小于 mod 时 a + b - mod 更小
+        u32xN res = simd_add(a, b);
+        return simd_min(res, simd_sub(res, mod_vec));
+    }
+
+    u32xN_mont sub(u32xN_mont a, u32xN_mont b) const
+    {
+        // a < b 时 a - b 回绕成很大的数，加上 mod 后更小
+        u32xN res = simd_sub(a, b);
+        return simd_min(res, simd_add(res, mod_vec));
+    }
+
+    /**
+     * a·b·r^(-1) mod mod，要求 a·b < mod·r（a < 2·mod 且 b < mod；或 mod < 2^30 时 a, b < 2·mod）
+     *
+     * m = (t mod r)·mod^(-1) mod r，则 t 与 m·mod 的低 32 位相同，
+     * (t - m·mod) / r 就是两者高 32 位之差，落在 (-mod, mod)，为负时加上 mod。
+     */
+    u32xN_mont mul(u32xN_mont a, u32xN_mont b) const
+    {
+        u32xN t_even = simd_mul_even(a, b);
+        u32xN t_odd = simd_mul_even(simd_odd_to_even(a), simd_odd_to_even(b));
+        u32xN m_even = simd_mul_even(t_even, r_inv_vec);
+        u32xN m_odd = simd_mul_even(t_odd, r_inv_vec);
+        u32xN mp_even = simd_mul_even(m_even, mod_vec);
+        u32xN mp_odd = simd_mul_even(m_odd, mod_vec);
+
+        u32xN t_hi = simd_blend_odd(simd_odd_to_even(t_even), t_odd);
+        u32xN mp_hi = simd_blend_odd(simd_odd_to_even(mp_even), mp_odd);
+        u32xN res = simd_sub(t_hi, mp_hi);
+        return simd_min(res, simd_add(res, mod_vec));
+    }
+
+private:
+    u32 mod;
+
+    u32xN mod_vec;   // 向量化的模数
+    u32xN r_inv_vec; // 向量化的 mod^(-1) mod 2^32
+    u32xN r2_vec;    // 向量化的 r^2 mod mod
+    u32xN one_vec;
+};
+
+// === Shoup 模乘（AVX2 / AVX-512，配合 Harvey 惰性规约） ===
+// ShoupMod<u32> 的 SIMD 版本，要求 mod < 2^30。
+class ShoupModAvx
+{
+public:
+    ShoupModAvx(u32 _mod)
+    {
+        mod_vec = simd_dup(_mod);
+        mod2_vec = simd_dup(_mod << 1);
+    }
+
+    ShoupModAvx(const ShoupModAvx &) = delete;
+    ShoupModAvx &operator=(const ShoupModAvx &) = delete;
+
+    /** x·w mod mod，结果在 [0, 2·mod)；w_shoup 是 w 的 Shoup 商 */
+    u32xN mul(u32xN x, u32xN w, u32xN w_shoup) const
+    {
+        // q = (x·w_shoup) >> 32；x·w - q·mod 只需要低 32 位
+        u32xN q = simd_mulhi(x, w_shoup);
+        return simd_sub(simd_mullo(x, w), simd_mullo(q, mod_vec));
+    }
+
+    /** [0, 4·mod) → [0, 2·mod) */
+    u32xN reduce_2p(u32xN x) const { return simd_min(x, simd_sub(x, mod2_vec)); }
+    /** [0, 2·mod) → [0, mod) */
+    u32xN reduce_p(u32xN x) const { return simd_min(x, simd_sub(x, mod_vec)); }
+
+    u32xN mod_2p() const { return mod2_vec; }
+
+private:
+    u32xN mod_vec;  // 向量化的模数
+    u32xN mod2_vec; // 向量化的 2·mod
+};
+
+using MontModSimd = MontModAvx;
+using ShoupModSimd = ShoupModAvx;
+
+#endif
@@ -2,9 +2,12 @@
 
 #include "type.h"
 #include "../general/type.h"
+#include "utils.h"
 
 #include <iostream>
 
+#ifndef NTT_SIMD_NONE
+
 /**
  * @brief 调试打印SIMD向量数组内容
  *
@@ -12,19 +15,23 @@
  * @param n_simd 向量数组长度
  * @param prefix 打印前缀信息
  */
-inline void debug_print_simd_array(u32x4 *a_simd, u32 n_simd, const char *prefix = "")
+inline void debug_print_simd_array(u32xN *a_simd, u32 n_simd, const char *prefix = "")
 {
     std::cout << prefix;
     for (u32 i = 0; i < n_simd; ++i)
     {
         std::cout << "[";
-        std::cout << vgetq_lane_u32(a_simd[i], 0) << ", "
-                  << vgetq_lane_u32(a_simd[i], 1) << ", "
-                  << vgetq_lane_u32(a_simd[i], 2) << ", "
-                  << vgetq_lane_u32(a_simd[i], 3);
+        for (u32 lane = 0; lane < SIMD_LANES; ++lane)
+        {
+            std::cout << get_lane(a_simd[i], lane);
+            if (lane < SIMD_LANES - 1)
+                std::cout << ", ";
+        }
         std::cout << "]";
         if (i < n_simd - 1)
             std::cout << ", ";
     }
     std::cout << std::endl;
-}
\ No newline at end of file
+}
+
+#endif
@@ -1,264 +1,528 @@
 #pragma once
 
 #include "../general/op.h"
+#include "../general/plan.h"
 #include "op.h"
 #include "utils.h"
+
+#ifndef NTT_SIMD_NONE
+
+/**
+ * @brief 第 mid 层（mid < SIMD_LANES）的旋转因子 Wn^k（k < mid），按 simd_repeat 排好
+ *
+ * @param Wn_mont 该层的单位根（位于 Montgomery 数域）
+ */
+inline u32xN_mont small_stage_twiddles_simd(const MontMod<u32> &montMod, u32_mont Wn_mont, u32 mid)
+{
+    u32_mont w_monts[SIMD_LANES];
+    w_monts[0] = montMod.from_T(1);
+    for (u32 k = 1; k < mid; ++k)
+        w_monts[k] = montMod.mul(w_monts[k - 1], Wn_mont);
+    return simd_repeat(w_monts, mid);
+}
+
 /**
  * @brief NTT 正变换：a(x) → A(ω)
  *
- * ntt_forward_mont 的 SIMD 版本。
+ * ntt_forward_mont 的 SIMD 版本。mid < SIMD_LANES 的层蝴蝶落在同一个向量里，
+ * 相邻两个向量按块转置后在寄存器里做完这几层，不经过标量。
  *
  * @param a_mont_simd 多项式系数（位于 Montgomery 数域），变换后表示频域系数（位于 Montgomery 数域）
- * @param n 多项式长度（普通整数）
+ * @param n 多项式长度（普通整数），不小于 2·SIMD_LANES
  * @param p 模数（普通整数）
  * @param omega_mont 原根（位于 Montgomery 数域）
  */
-inline void ntt_forward_mont_simd(u32x4_mont *a_mont_simd, u32 n, u32 p, u32_mont omega_mont)
+inline void ntt_forward_mont_simd(u32xN_mont *a_mont_simd, u32 n, u32 p, u32_mont omega_mont)
 {
     MontMod<u32> montMod(p);
-    MontModNeon montModNeon(p);
-
-    bool is_serial = false;
-    u32_mont *a_mont = new u32_mont[n];
+    MontModSimd montModSimd(p);
 
-    for (u32 mid = 1; mid < n; mid <<= 1)
+    u32xN_mont w_monts_small_simd[SIMD_LANES];
+    for (u32 m = 1; m < SIMD_LANES; m <<= 1)
+        w_monts_small_simd[m] = small_stage_twiddles_simd(montMod, montMod.pow(omega_mont, (p - 1) / (m << 1)), m);
+    for (u32 i = 0; i < n / SIMD_LANES; i += 2)
     {
-        switch (mid)
+        u32xN_mont x_monts_simd = a_mont_simd[i];
+        u32xN_mont y_monts_simd = a_mont_simd[i + 1];
+        for (u32 m = 1; m < SIMD_LANES; m <<= 1)
         {
-        case 1:
-        {
-            if (!is_serial)
-            {
-                from_simd(a_mont, a_mont_simd, n);
-                is_serial = true;
-            }
-            for (u32 j = 0; j < n; j += (mid << 1))
-            {
-                u32_mont w_mont = montMod.from_T(1);
-                u32_mont x_mont = a_mont[j];
-                u32_mont y_mont = montMod.mul(w_mont, a_mont[j + 1]);
-                a_mont[j] = montMod.add(x_mont, y_mont);
-                a_mont[j + 1] = montMod.sub(x_mont, y_mont);
-            }
-            break;
+            simd_transpose_blocks(x_monts_simd, y_monts_simd, m);
+            u32xN_mont wy_simd = montModSimd.mul(w_monts_small_simd[m], y_monts_simd);
+            y_monts_simd = montModSimd.sub(x_monts_simd, wy_simd);
+            x_monts_simd = montModSimd.add(x_monts_simd, wy_simd);
+            simd_transpose_blocks(x_monts_simd, y_monts_simd, m);
         }
+        a_mont_simd[i] = x_monts_simd;
+        a_mont_simd[i + 1] = y_monts_simd;
+    }
 
-        case 2:
-        {
-            if (!is_serial) // 实际上这不可能发生
-            {
-                from_simd(a_mont, a_mont_simd, n);
-                is_serial = true;
-            }
-            u32_mont Wn_mont = montMod.pow(omega_mont, (p - 1) / (mid << 1));
-            for (u32 j = 0; j < n; j += (mid << 1))
-            {
-                u32_mont w_mont_0 = montMod.from_T(1);
-                u32_mont w_mont_1 = montMod.mul(w_mont_0, Wn_mont);
-                u32_mont x_mont_0 = a_mont[j + 0];
-                u32_mont x_mont_1 = a_mont[j + 1];
-                u32_mont y_mont_0 = montMod.mul(w_mont_0, a_mont[j + 2]);
-                u32_mont y_mont_1 = montMod.mul(w_mont_1, a_mont[j + 3]);
-                a_mont[j + 0] = montMod.add(x_mont_0, y_mont_0);
-                a_mont[j + 1] = montMod.add(x_mont_1, y_mont_1);
-                a_mont[j + 2] = montMod.sub(x_mont_0, y_mont_0);
-                a_mont[j + 3] = montMod.sub(x_mont_1, y_mont_1);
-            }
-            break;
-        }
+    for (u32 mid = SIMD_LANES; mid < n; mid <<= 1) // 一组 SIMD_LANES 个蝴蝶互不相关
+    {
+        u32_mont Wn_mont = montMod.pow(omega_mont, (p - 1) / (mid << 1));
+        // w_monts_simd 的第 i 个通道是 Wn^(k + i)，每组之后整体乘 Wn^SIMD_LANES
+        u32_mont w_monts[SIMD_LANES];
+        w_monts[0] = montMod.from_T(1);
+        for (u32 i = 1; i < SIMD_LANES; ++i)
+            w_monts[i] = montMod.mul(w_monts[i - 1], Wn_mont);
+        u32xN_mont Wn_mont_lanes_simd = simd_dup(montMod.pow(Wn_mont, SIMD_LANES));
 
-        default: // mid >= 4, parallelizable
+        for (u32 j = 0; j < n; j += (mid << 1))
         {
-            if (is_serial)
-            {
-                to_simd(a_mont, a_mont_simd, n);
-                is_serial = false;
-            }
-            u32_mont Wn_mont = montMod.pow(omega_mont, (p - 1) / (mid << 1));
-            for (u32 j = 0; j < n; j += (mid << 1))
+            u32xN_mont w_monts_simd = simd_load(w_monts);
+            for (u32 k = 0; k < mid; k += SIMD_LANES)
             {
-                u32_mont w_mont_0 = montMod.from_T(1);
-                u32_mont w_mont_1 = montMod.mul(w_mont_0, Wn_mont);
-                u32_mont w_mont_2 = montMod.mul(w_mont_1, Wn_mont);
-                u32_mont w_mont_3 = montMod.mul(w_mont_2, Wn_mont);
-                u32_mont w_monts[4] = {w_mont_0, w_mont_1, w_mont_2, w_mont_3};
-                u32x4_mont w_monts_simd = vld1q_u32(w_monts);
-
-                u32_mont Wn_mont_4 = montMod.pow(Wn_mont, 4);
-                u32x4_mont Wn_mont_4_simd = vdupq_n_u32(Wn_mont_4);
-
-                for (u32 k = 0; k < mid; k += 4)
-                {
-                    // u32_mont x_mont_0 = a_mont[j + k + 0];
-                    // u32_mont x_mont_1 = a_mont[j + k + 1];
-                    // u32_mont x_mont_2 = a_mont[j + k + 2];
-                    // u32_mont x_mont_3 = a_mont[j + k + 3];
-                    u32x4_mont x_monts_simd = a_mont_simd[(j + k) / 4];
-
-                    // u32_mont y_mont_0 = montMod.mul(w_mont_0, a_mont[j + k + mid + 0]);
-                    // u32_mont y_mont_1 = montMod.mul(w_mont_1, a_mont[j + k + mid + 1]);
-                    // u32_mont y_mont_2 = montMod.mul(w_mont_2, a_mont[j + k + mid + 2]);
-                    // u32_mont y_mont_3 = montMod.mul(w_mont_3, a_mont[j + k + mid + 3]);
-                    u32x4_mont y_monts_simd = montModNeon.mul(w_monts_simd, a_mont_simd[(j + k + mid) / 4]);
-
-                    // a_mont[j + k + 0] = montMod.add(x_mont_0, y_mont_0);
-                    // a_mont[j + k + 1] = montMod.add(x_mont_1, y_mont_1);
-                    // a_mont[j + k + 2] = montMod.add(x_mont_2, y_mont_2);
-                    // a_mont[j + k + 3] = montMod.add(x_mont_3, y_mont_3);
-                    a_mont_simd[(j + k) / 4] = montModNeon.add(x_monts_simd, y_monts_simd);
-
-                    // a_mont[j + k + mid + 0] = montMod.sub(x_mont_0, y_mont_0);
-                    // a_mont[j + k + mid + 1] = montMod.sub(x_mont_1, y_mont_1);
-                    // a_mont[j + k + mid + 2] = montMod.sub(x_mont_2, y_mont_2);
-                    // a_mont[j + k + mid + 3] = montMod.sub(x_mont_3, y_mont_3);
-                    a_mont_simd[(j + k + mid) / 4] = montModNeon.sub(x_monts_simd, y_monts_simd);
-
-                    // w_mont_0 = montMod.mul(w_mont_0, Wn_mont_4);
-                    // w_mont_1 = montMod.mul(w_mont_1, Wn_mont_4);
-                    // w_mont_2 = montMod.mul(w_mont_2, Wn_mont_4);
-                    // w_mont_3 = montMod.mul(w_mont_3, Wn_mont_4);
-                    w_monts_simd = montModNeon.mul(w_monts_simd, Wn_mont_4_simd);
-                }
+                u32xN_mont x_monts_simd = a_mont_simd[(j + k) / SIMD_LANES];
+                u32xN_mont y_monts_simd = montModSimd.mul(w_monts_simd, a_mont_simd[(j + k + mid) / SIMD_LANES]);
+                a_mont_simd[(j + k) / SIMD_LANES] = montModSimd.add(x_monts_simd, y_monts_simd);
+                a_mont_simd[(j + k + mid) / SIMD_LANES] = montModSimd.sub(x_monts_simd, y_monts_simd);
+                w_monts_simd = montModSimd.mul(w_monts_simd, Wn_mont_lanes_simd);
             }
-            break;
-        }
         }
     }
-
-    if (is_serial)
-        to_simd(a_mont, a_mont_simd, n);
-
-    delete[] a_mont;
 }
 
 /**
  * @brief NTT 逆变换：A(ω) → a_mont(x)
  *
- * ntt_inverse_mont 的 SIMD 版本。
+ * ntt_inverse_mont 的 SIMD 版本。mid < SIMD_LANES 的层在最后，在寄存器里做。
  *
  * @param a_mont_simd 频域系数，变换后表示多项式系数
- * @param n 多项式长度（普通整数）
+ * @param n 多项式长度（普通整数），不小于 2·SIMD_LANES
  * @param p 模数（普通整数）
  * @param omega_mont 原根（位于 Montgomery 数域）
  */
-inline void ntt_inverse_mont_simd(u32x4_mont *a_mont_simd, u32 n, u32 p, u32_mont omega_mont)
+inline void ntt_inverse_mont_simd(u32xN_mont *a_mont_simd, u32 n, u32 p, u32_mont omega_mont)
 {
     MontMod<u32> montMod(p);
-    MontModNeon montModNeon(p);
+    MontModSimd montModSimd(p);
 
-    bool is_serial = false;
-    u32_mont *a_mont = new u32_mont[n];
-
-    for (u32 mid = n >> 1; mid > 0; mid >>= 1)
+    for (u32 mid = n >> 1; mid >= SIMD_LANES; mid >>= 1) // 一组 SIMD_LANES 个蝴蝶互不相关
     {
         u32_mont Wn_mont = montMod.pow(omega_mont, (p - 1) / (mid << 1)); // Wn = ω⁻¹^((p-1)/(2*mid))
-        switch (mid)
-        {
-        case 1:
+        u32_mont w_monts[SIMD_LANES];
+        w_monts[0] = montMod.from_T(1);
+        for (u32 i = 1; i < SIMD_LANES; ++i)
+            w_monts[i] = montMod.mul(w_monts[i - 1], Wn_mont);
+        u32xN_mont Wn_mont_lanes_simd = simd_dup(montMod.pow(Wn_mont, SIMD_LANES));
+
+        for (u32 j = 0; j < n; j += (mid << 1))
         {
-            if (!is_serial)
-            {
-                from_simd(a_mont, a_mont_simd, n);
-                is_serial = true;
-            }
-            for (u32 j = 0; j < n; j += (mid << 1))
+            u32xN_mont w_monts_simd = simd_load(w_monts);
+            for (u32 k = 0; k < mid; k += SIMD_LANES)
             {
-                u32_mont w_mont = montMod.from_T(1);
-                u32_mont x_mont = a_mont[j + 0];
-                u32_mont y_mont = a_mont[j + 1];
-                a_mont[j + 0] = montMod.add(x_mont, y_mont);
-                a_mont[j + 1] = montMod.mul(w_mont, montMod.sub(x_mont, y_mont));
+                u32xN_mont x_monts_simd = a_mont_simd[(j + k) / SIMD_LANES];
+                u32xN_mont y_monts_simd = a_mont_simd[(j + k + mid) / SIMD_LANES];
+                a_mont_simd[(j + k) / SIMD_LANES] = montModSimd.add(x_monts_simd, y_monts_simd);
+                a_mont_simd[(j + k + mid) / SIMD_LANES] = montModSimd.mul(w_monts_simd, montModSimd.sub(x_monts_simd, y_monts_simd));
+                w_monts_simd = montModSimd.mul(w_monts_simd, Wn_mont_lanes_simd);
             }
-            break;
         }
+    }
 
-        case 2:
+    u32xN_mont w_monts_small_simd[SIMD_LANES];
+    for (u32 m = 1; m < SIMD_LANES; m <<= 1)
+        w_monts_small_simd[m] = small_stage_twiddles_simd(montMod, montMod.pow(omega_mont, (p - 1) / (m << 1)), m);
+    for (u32 i = 0; i < n / SIMD_LANES; i += 2)
+    {
+        u32xN_mont x_monts_simd = a_mont_simd[i];
+        u32xN_mont y_monts_simd = a_mont_simd[i + 1];
+        for (u32 m = SIMD_LANES >> 1; m > 0; m >>= 1)
         {
-            if (!is_serial)
-            {
-                from_simd(a_mont, a_mont_simd, n);
-                is_serial = true;
-            }
-            for (u32 j = 0; j < n; j += (mid << 1))
-            {
-                u32_mont w_mont_0 = montMod.from_T(1);
-                u32_mont w_mont_1 = montMod.mul(w_mont_0, Wn_mont);
-                u32_mont x_mont_0 = a_mont[j + 0];
-                u32_mont x_mont_1 = a_mont[j + 1];
-                u32_mont y_mont_0 = a_mont[j + 2];
-                u32_mont y_mont_1 = a_mont[j + 3];
-                a_mont[j + 0] = montMod.add(x_mont_0, y_mont_0);
-                a_mont[j + 1] = montMod.add(x_mont_1, y_mont_1);
-                a_mont[j + 2] = montMod.mul(w_mont_0, montMod.sub(x_mont_0, y_mont_0));
-                a_mont[j + 3] = montMod.mul(w_mont_1, montMod.sub(x_mont_1, y_mont_1));
-            }
-            break;
+            simd_transpose_blocks(x_monts_simd, y_monts_simd, m);
+            u32xN_mont sum_simd = montModSimd.add(x_monts_simd, y_monts_simd);
+            y_monts_simd = montModSimd.mul(w_monts_small_simd[m], montModSimd.sub(x_monts_simd, y_monts_simd));
+            x_monts_simd = sum_simd;
+            simd_transpose_blocks(x_monts_simd, y_monts_simd, m);
         }
+        a_mont_simd[i] = x_monts_simd;
+        a_mont_simd[i + 1] = y_monts_simd;
+    }
+
+    u32_mont inv_n = montMod.inv(montMod.from_T(n));
+    u32xN_mont inv_n_simd = simd_dup(inv_n);
+    for (u32 i = 0; i < n; i += SIMD_LANES)
+        a_mont_simd[i / SIMD_LANES] = montModSimd.mul(a_mont_simd[i / SIMD_LANES], inv_n_simd);
+}
 
-        default: // mid >= 4, parallelizable
+/**
+ * @brief NTT 正变换（DIF）：a(x) → A(ω)
+ *
+ * ntt_forward_dif_mont 的 SIMD 版本，自然顺序输入，bit-reversed 输出。
+ * mid >= SIMD_LANES 的层按 SIMD_LANES 个一组从计划的旋转因子表中读取；
+ * 更小的层在最后，相邻两个向量按块转置后在寄存器里做，不经过标量。
+ *
+ * @param a_mont_simd 多项式系数（位于 Montgomery 数域），变换后表示频域系数（bit-reversed 顺序）
+ * @param plan NTT 计划，长度不小于 2·SIMD_LANES
+ */
+inline void ntt_forward_dif_mont_simd(u32xN_mont *a_mont_simd, const NttPlan<u32> &plan)
+{
+    MontModSimd montModSimd(plan.mod());
+    u32 n = plan.size();
+
+    u32 mid = n >> 1;
+    for (; mid >= SIMD_LANES; mid >>= 1)
+    {
+        const u32_mont *w_mont = plan.stage_twiddles(mid);
+        for (u32 j = 0; j < n; j += (mid << 1))
         {
-            if (is_serial)
+            for (u32 k = 0; k < mid; k += SIMD_LANES)
             {
-                to_simd(a_mont, a_mont_simd, n);
-                is_serial = false;
+                u32xN_mont w_monts_simd = simd_load(w_mont + k);
+                u32xN_mont x_monts_simd = a_mont_simd[(j + k) / SIMD_LANES];
+                u32xN_mont y_monts_simd = a_mont_simd[(j + k + mid) / SIMD_LANES];
+                a_mont_simd[(j + k) / SIMD_LANES] = montModSimd.add(x_monts_simd, y_monts_simd);
+                a_mont_simd[(j + k + mid) / SIMD_LANES] = montModSimd.mul(w_monts_simd, montModSimd.sub(x_monts_simd, y_monts_simd));
             }
-            for (u32 j = 0; j < n; j += (mid << 1))
+        }
+    }
+
+    // mid < SIMD_LANES：蝴蝶的两端在同一个向量里。相邻两个向量按块转置后 x、y 各占一个向量，
+    // 蝴蝶做完再转置回去；剩下的几层在寄存器里连续做完
+    u32xN_mont w_monts_simd[SIMD_LANES];
+    for (u32 m = mid; m > 0; m >>= 1)
+        w_monts_simd[m] = simd_repeat(plan.stage_twiddles(m), m);
+    for (u32 i = 0; i < n / SIMD_LANES; i += 2)
+    {
+        u32xN_mont x_monts_simd = a_mont_simd[i];
+        u32xN_mont y_monts_simd = a_mont_simd[i + 1];
+        for (u32 m = mid; m > 0; m >>= 1)
+        {
+            simd_transpose_blocks(x_monts_simd, y_monts_simd, m);
+            u32xN_mont sum_simd = montModSimd.add(x_monts_simd, y_monts_simd);
+            y_monts_simd = montModSimd.mul(w_monts_simd[m], montModSimd.sub(x_monts_simd, y_monts_simd));
+            x_monts_simd = sum_simd;
+            simd_transpose_blocks(x_monts_simd, y_monts_simd, m);
+        }
+        a_mont_simd[i] = x_monts_simd;
+        a_mont_simd[i + 1] = y_monts_simd;
+    }
+}
+
+/**
+ * @brief NTT 逆变换（DIT）：A(ω) → a_mont(x)
+ *
+ * ntt_inverse_dit_mont 的 SIMD 版本，bit-reversed 输入，自然顺序输出。
+ * mid < SIMD_LANES 的层在最前，在寄存器里做；之后的层按 SIMD_LANES 个一组做。
+ *
+ * @param a_mont_simd 频域系数（bit-reversed 顺序），变换后表示多项式系数（自然顺序）
+ * @param plan NTT 计划，长度不小于 2·SIMD_LANES
+ */
+inline void ntt_inverse_dit_mont_simd(u32xN_mont *a_mont_simd, const NttPlan<u32> &plan)
+{
+    MontModSimd montModSimd(plan.mod());
+    u32 n = plan.size();
+
+    // mid < SIMD_LANES 的几层：相邻两个向量按块转置，在寄存器里做完（见 ntt_forward_dif_mont_simd）
+    u32xN_mont w_monts_simd[SIMD_LANES];
+    for (u32 m = 1; m < SIMD_LANES; m <<= 1)
+        w_monts_simd[m] = simd_repeat(plan.stage_inv_twiddles(m), m);
+    for (u32 i = 0; i < n / SIMD_LANES; i += 2)
+    {
+        u32xN_mont x_monts_simd = a_mont_simd[i];
+        u32xN_mont y_monts_simd = a_mont_simd[i + 1];
+        for (u32 m = 1; m < SIMD_LANES; m <<= 1)
+        {
+            simd_transpose_blocks(x_monts_simd, y_monts_simd, m);
+            u32xN_mont wy_simd = montModSimd.mul(w_monts_simd[m], y_monts_simd);
+            y_monts_simd = montModSimd.sub(x_monts_simd, wy_simd);
+            x_monts_simd = montModSimd.add(x_monts_simd, wy_simd);
+            simd_transpose_blocks(x_monts_simd, y_monts_simd, m);
+        }
+        a_mont_simd[i] = x_monts_simd;
+        a_mont_simd[i + 1] = y_monts_simd;
+    }
+
+    for (u32 mid = SIMD_LANES; mid < n; mid <<= 1)
+    {
+        const u32_mont *w_mont = plan.stage_inv_twiddles(mid);
+        for (u32 j = 0; j < n; j += (mid << 1))
+        {
+            for (u32 k = 0; k < mid; k += SIMD_LANES)
             {
-                u32_mont w_mont_0 = montMod.from_T(1);
-                u32_mont w_mont_1 = montMod.mul(w_mont_0, Wn_mont);
-                u32_mont w_mont_2 = montMod.mul(w_mont_1, Wn_mont);
-                u32_mont w_mont_3 = montMod.mul(w_mont_2, Wn_mont);
-                u32_mont w_monts[4] = {w_mont_0, w_mont_1, w_mont_2, w_mont_3};
-                u32x4_mont w_monts_simd = vld1q_u32(w_monts);
-
-                u32_mont Wn_mont_4 = montMod.pow(Wn_mont, 4);
-                u32x4_mont Wn_mont_4_simd = vdupq_n_u32(Wn_mont_4);
-
-                for (u32 k = 0; k < mid; k += 4)
-                {
-                    // u32_mont x_mont_0 = a_mont[j + k + 0];
-                    // u32_mont x_mont_1 = a_mont[j + k + 1];
-                    // u32_mont x_mont_2 = a_mont[j + k + 2];
-                    // u32_mont x_mont_3 = a_mont[j + k + 3];
-                    u32x4_mont x_monts_simd = a_mont_simd[(j + k) / 4];
-
-                    // u32_mont y_mont_0 = a_mont[j + k + mid + 0];
-                    // u32_mont y_mont_1 = a_mont[j + k + mid + 1];
-                    // u32_mont y_mont_2 = a_mont[j + k + mid + 2];
-                    // u32_mont y_mont_3 = a_mont[j + k + mid + 3];
-                    u32x4_mont y_monts_simd = a_mont_simd[(j + k + mid) / 4];
-
-                    // a_mont[j + k + 0] = montMod.add(x_mont_0, y_mont_0);
-                    // a_mont[j + k + 1] = montMod.add(x_mont_1, y_mont_1);
-                    // a_mont[j + k + 2] = montMod.add(x_mont_2, y_mont_2);
-                    // a_mont[j + k + 3] = montMod.add(x_mont_3, y_mont_3);
-                    a_mont_simd[(j + k) / 4] = montModNeon.add(x_monts_simd, y_monts_simd);
-
-                    // a_mont[j + k + mid + 0] = montMod.mul(w_mont_0, montMod.sub(x_mont_0, y_mont_0));
-                    // a_mont[j + k + mid + 1] = montMod.mul(w_mont_1, montMod.sub(x_mont_1, y_mont_1));
-                    // a_mont[j + k + mid + 2] = montMod.mul(w_mont_2, montMod.sub(x_mont_2, y_mont_2));
-                    // a_mont[j + k + mid + 3] = montMod.mul(w_mont_3, montMod.sub(x_mont_3, y_mont_3));
-                    a_mont_simd[(j + k + mid) / 4] = montModNeon.mul(w_monts_simd, montModNeon.sub(x_monts_simd, y_monts_simd));
-
-                    // w_mont_0 = montMod.mul(w_mont_0, Wn_mont_4);
-                    // w_mont_1 = montMod.mul(w_mont_1, Wn_mont_4);
-                    // w_mont_2 = montMod.mul(w_mont_2, Wn_mont_4);
-                    // w_mont_3 = montMod.mul(w_mont_3, Wn_mont_4);
-                    w_monts_simd = montModNeon.mul(w_monts_simd, Wn_mont_4_simd);
-                }
+                u32xN_mont w_monts_simd = simd_load(w_mont + k);
+                u32xN_mont x_monts_simd = a_mont_simd[(j + k) / SIMD_LANES];
+                u32xN_mont y_monts_simd = montModSimd.mul(w_monts_simd, a_mont_simd[(j + k + mid) / SIMD_LANES]);
+                a_mont_simd[(j + k) / SIMD_LANES] = montModSimd.add(x_monts_simd, y_monts_simd);
+                a_mont_simd[(j + k + mid) / SIMD_LANES] = montModSimd.sub(x_monts_simd, y_monts_simd);
             }
-            break;
         }
+    }
+
+    u32xN_mont inv_n_simd = simd_dup(plan.inv_n());
+    for (u32 i = 0; i < n; i += SIMD_LANES)
+        a_mont_simd[i / SIMD_LANES] = montModSimd.mul(a_mont_simd[i / SIMD_LANES], inv_n_simd);
+}
+
+/**
+ * @brief 惰性规约的 DIF 正变换中蝴蝶跨度为 mid（mid >= SIMD_LANES）的一层
+ */
+inline void ntt_forward_dif_simd_lazy_stage(u32xN *a_simd, const NttPlan<u32> &plan, u32 mid, const ShoupModSimd &shoupModSimd)
+{
+    u32xN p2_simd = shoupModSimd.mod_2p();
+    u32 n = plan.size();
+
+    const u32 *w = plan.stage_lazy_twiddles(mid);
+    const u32 *w_shoup = plan.stage_lazy_twiddles_shoup(mid);
+    for (u32 j = 0; j < n; j += (mid << 1))
+    {
+        for (u32 k = 0; k < mid; k += SIMD_LANES)
+        {
+            u32xN x_simd = a_simd[(j + k) / SIMD_LANES];
+            u32xN y_simd = a_simd[(j + k + mid) / SIMD_LANES];
+            a_simd[(j + k) / SIMD_LANES] = shoupModSimd.reduce_2p(simd_add(x_simd, y_simd));
+            a_simd[(j + k + mid) / SIMD_LANES] = shoupModSimd.mul(simd_add(simd_sub(x_simd, y_simd), p2_simd),
+                                                                  simd_load(w + k), simd_load(w_shoup + k));
+        }
+    }
+}
+
+/**
+ * @brief 惰性规约的 DIT 逆变换中蝴蝶跨度为 mid（mid >= SIMD_LANES）的一层
+ */
+inline void ntt_inverse_dit_simd_lazy_stage(u32xN *a_simd, const NttPlan<u32> &plan, u32 mid, const ShoupModSimd &shoupModSimd)
+{
+    u32xN p2_simd = shoupModSimd.mod_2p();
+    u32 n = plan.size();
+
+    const u32 *w = plan.stage_lazy_inv_twiddles(mid);
+    const u32 *w_shoup = plan.stage_lazy_inv_twiddles_shoup(mid);
+    for (u32 j = 0; j < n; j += (mid << 1))
+    {
+        for (u32 k = 0; k < mid; k += SIMD_LANES)
+        {
+            u32xN x_simd = shoupModSimd.reduce_2p(a_simd[(j + k) / SIMD_LANES]);
+            u32xN y_simd = shoupModSimd.mul(a_simd[(j + k + mid) / SIMD_LANES], simd_load(w + k), simd_load(w_shoup + k));
+            a_simd[(j + k) / SIMD_LANES] = simd_add(x_simd, y_simd);
+            a_simd[(j + k + mid) / SIMD_LANES] = simd_add(simd_sub(x_simd, y_simd), p2_simd);
+        }
+    }
+}
+
+/**
+ * @brief 相邻两个向量 x、y 上第 m 层（m < SIMD_LANES）的惰性 DIF 蝴蝶，见 ntt_forward_dif_mont_simd
+ *
+ * @param w_simd 该层的旋转因子，按 simd_repeat 排好
+ * @param w_shoup_simd 对应的 Shoup 商
+ */
+inline void dif_small_stage_simd_lazy(u32xN &x_simd, u32xN &y_simd, u32 m, u32xN w_simd, u32xN w_shoup_simd,
+                                      const ShoupModSimd &shoupModSimd)
+{
+    simd_transpose_blocks(x_simd, y_simd, m);
+    u32xN sum_simd = shoupModSimd.reduce_2p(simd_add(x_simd, y_simd));
+    y_simd = shoupModSimd.mul(simd_add(simd_sub(x_simd, y_simd), shoupModSimd.mod_2p()), w_simd, w_shoup_simd);
+    x_simd = sum_simd;
+    simd_transpose_blocks(x_simd, y_simd, m);
+}
+
+/**
+ * @brief 相邻两个向量 x、y 上第 m 层（m < SIMD_LANES）的惰性 DIT 蝴蝶，参数同 dif_small_stage_simd_lazy
+ */
+inline void dit_small_stage_simd_lazy(u32xN &x_simd, u32xN &y_simd, u32 m, u32xN w_simd, u32xN w_shoup_simd,
+                                      const ShoupModSimd &shoupModSimd)
+{
+    simd_transpose_blocks(x_simd, y_simd, m);
+    u32xN x_reduced_simd = shoupModSimd.reduce_2p(x_simd);
+    u32xN wy_simd = shoupModSimd.mul(y_simd, w_simd, w_shoup_simd);
+    x_simd = simd_add(x_reduced_simd, wy_simd);
+    y_simd = simd_add(simd_sub(x_reduced_simd, wy_simd), shoupModSimd.mod_2p());
+    simd_transpose_blocks(x_simd, y_simd, m);
+}
+
+/**
+ * @brief 惰性规约的 DIF 正变换
+ *
+ * ntt_forward_dif_mont_lazy 的 SIMD 版本，数值停留在 [0, 2p)。要求 plan.supports_lazy()。
+ *
+ * @param a_simd 多项式系数（[0, 2p)，自然顺序），变换后表示频域系数（[0, 2p)，bit-reversed 顺序）
+ * @param plan NTT 计划，长度不小于 2·SIMD_LANES
+ */
+inline void ntt_forward_dif_mont_simd_lazy(u32xN *a_simd, const NttPlan<u32> &plan)
+{
+    ShoupModSimd shoupModSimd(plan.mod());
+    u32 n = plan.size();
+
+    for (u32 mid = n >> 1; mid >= SIMD_LANES; mid >>= 1)
+        ntt_forward_dif_simd_lazy_stage(a_simd, plan, mid, shoupModSimd);
+
+    // mid < SIMD_LANES 的几层：相邻两个向量按块转置，在寄存器里做完（见 ntt_forward_dif_mont_simd）
+    u32xN w_simd[SIMD_LANES];
+    u32xN w_shoup_simd[SIMD_LANES];
+    for (u32 m = 1; m < SIMD_LANES; m <<= 1)
+    {
+        w_simd[m] = simd_repeat(plan.stage_lazy_twiddles(m), m);
+        w_shoup_simd[m] = simd_repeat(plan.stage_lazy_twiddles_shoup(m), m);
+    }
+    for (u32 i = 0; i < n / SIMD_LANES; i += 2)
+    {
+        u32xN x_simd = a_simd[i];
+        u32xN y_simd = a_simd[i + 1];
+        for (u32 m = SIMD_LANES >> 1; m > 0; m >>= 1)
+            dif_small_stage_simd_lazy(x_simd, y_simd, m, w_simd[m], w_shoup_simd[m], shoupModSimd);
+        a_simd[i] = x_simd;
+        a_simd[i + 1] = y_simd;
+    }
+}
+
+/**
+ * @brief 惰性规约的 DIT 逆变换
+ *
+ * ntt_inverse_dit_mont_lazy 的 SIMD 版本，中间结果停留在 [0, 4p)。要求 plan.supports_lazy()。
+ *
+ * @param a_simd 频域系数（[0, 4p)，bit-reversed 顺序），变换后表示多项式系数（[0, p)，自然顺序）
+ * @param plan NTT 计划，长度不小于 2·SIMD_LANES
+ */
+inline void ntt_inverse_dit_mont_simd_lazy(u32xN *a_simd, const NttPlan<u32> &plan)
+{
+    ShoupModSimd shoupModSimd(plan.mod());
+    u32 n = plan.size();
+
+    // mid < SIMD_LANES 的几层：相邻两个向量按块转置，在寄存器里做完（见 ntt_forward_dif_mont_simd）
+    u32xN w_simd[SIMD_LANES];
+    u32xN w_shoup_simd[SIMD_LANES];
+    for (u32 m = 1; m < SIMD_LANES; m <<= 1)
+    {
+        w_simd[m] = simd_repeat(plan.stage_lazy_inv_twiddles(m), m);
+        w_shoup_simd[m] = simd_repeat(plan.stage_lazy_inv_twiddles_shoup(m), m);
+    }
+    for (u32 i = 0; i < n / SIMD_LANES; i += 2)
+    {
+        u32xN x_simd = a_simd[i];
+        u32xN y_simd = a_simd[i + 1];
+        for (u32 m = 1; m < SIMD_LANES; m <<= 1)
+            dit_small_stage_simd_lazy(x_simd, y_simd, m, w_simd[m], w_shoup_simd[m], shoupModSimd);
+        a_simd[i] = x_simd;
+        a_simd[i + 1] = y_simd;
+    }
+
+    for (u32 mid = SIMD_LANES; mid < n; mid <<= 1)
+        ntt_inverse_dit_simd_lazy_stage(a_simd, plan, mid, shoupModSimd);
+
+    u32xN inv_n_simd = simd_dup(plan.lazy_inv_n());
+    u32xN inv_n_shoup_simd = simd_dup(plan.lazy_inv_n_shoup());
+    for (u32 i = 0; i < n; i += SIMD_LANES)
+        a_simd[i / SIMD_LANES] = shoupModSimd.reduce_p(shoupModSimd.mul(a_simd[i / SIMD_LANES], inv_n_simd, inv_n_shoup_simd));
+}
+
+// === 卷积流水线的融合版本 ===
+// 与 transform.h 中 ntt_forward_dif_lazy_from_input 等三步相同，要求 plan.supports_lazy()，长度不小于 2·SIMD_LANES。
+// 点乘所在的一趟把两个序列 mid < SIMD_LANES 的几层正变换、点乘、逆变换的同样几层都放在寄存器里做完。
+
+/**
+ * @brief 扩展 + 惰性规约的 DIF 正变换，只做 mid >= SIMD_LANES 的几层，其余留给 ntt_pointwise_simd_lazy_fused
+ *
+ * @param a_simd 长度为 plan.size() 的缓冲区
+ * @param input 多项式系数（普通整数，可以不小于 p），长度 len，len <= plan.size() / 2
+ * @param len 多项式长度
+ * @param plan NTT 计划
+ */
+inline void ntt_forward_dif_simd_lazy_from_input(u32xN *a_simd, const u32 *input, u32 len, const NttPlan<u32> &plan)
+{
+    ShoupModSimd shoupModSimd(plan.mod());
+    u32 n = plan.size();
+    u32 mid = n >> 1;
+
+    // 第一层的下半部分全是补上的 0，蝴蝶退化为 (x, x·w)；乘 1 的 Shoup 模乘把输入规约到 [0, 2p)
+    u32xN one_simd = simd_dup(1);
+    u32xN one_shoup_simd = simd_dup(plan.shoup().quotient(1));
+    const u32 *w = plan.stage_lazy_twiddles(mid);
+    const u32 *w_shoup = plan.stage_lazy_twiddles_shoup(mid);
+    u32 k = 0;
+    for (; k < len; k += SIMD_LANES)
+    {
+        u32xN x_simd = load_padded_simd(input, len, k / SIMD_LANES);
+        a_simd[k / SIMD_LANES] = shoupModSimd.mul(x_simd, one_simd, one_shoup_simd);
+        a_simd[(k + mid) / SIMD_LANES] = shoupModSimd.mul(x_simd, simd_load(w + k), simd_load(w_shoup + k));
+    }
+    for (; k < mid; k += SIMD_LANES)
+        a_simd[k / SIMD_LANES] = a_simd[(k + mid) / SIMD_LANES] = simd_dup(0);
+
+    for (mid >>= 1; mid >= SIMD_LANES; mid >>= 1)
+        ntt_forward_dif_simd_lazy_stage(a_simd, plan, mid, shoupModSimd);
+}
+
+/**
+ * @brief 两个序列正变换 mid < SIMD_LANES 的几层 + 点乘 + 逆变换 mid < SIMD_LANES 的几层
+ *
+ * 见 ntt_pointwise_lazy_fused。mid = 1 层的旋转因子为 1；
+ * 正变换这一层之后和逆变换这一层之前的转置互相抵消，点乘直接在转置后的排列上做。
+ *
+ * @param a_simd ntt_forward_dif_simd_lazy_from_input 的结果，变换后为逆变换 mid = SIMD_LANES 层之前的中间结果
+ * @param b_simd ntt_forward_dif_simd_lazy_from_input 的结果，只读
+ * @param plan NTT 计划
+ */
+inline void ntt_pointwise_simd_lazy_fused(u32xN *a_simd, const u32xN *b_simd, const NttPlan<u32> &plan)
+{
+    MontModSimd montModSimd(plan.mod());
+    ShoupModSimd shoupModSimd(plan.mod());
+    u32xN p2_simd = shoupModSimd.mod_2p();
+    u32xN scale_simd = simd_dup(plan.lazy_pointwise_scale());
+    u32xN scale_shoup_simd = simd_dup(plan.lazy_pointwise_scale_shoup());
+    u32 n = plan.size();
+
+    u32xN w_simd[SIMD_LANES], w_shoup_simd[SIMD_LANES];
+    u32xN inv_w_simd[SIMD_LANES], inv_w_shoup_simd[SIMD_LANES];
+    for (u32 m = 2; m < SIMD_LANES; m <<= 1)
+    {
+        w_simd[m] = simd_repeat(plan.stage_lazy_twiddles(m), m);
+        w_shoup_simd[m] = simd_repeat(plan.stage_lazy_twiddles_shoup(m), m);
+        inv_w_simd[m] = simd_repeat(plan.stage_lazy_inv_twiddles(m), m);
+        inv_w_shoup_simd[m] = simd_repeat(plan.stage_lazy_inv_twiddles_shoup(m), m);
+    }
+    for (u32 i = 0; i < n / SIMD_LANES; i += 2)
+    {
+        u32xN ax_simd = a_simd[i], ay_simd = a_simd[i + 1];
+        u32xN bx_simd = b_simd[i], by_simd = b_simd[i + 1];
+        for (u32 m = SIMD_LANES >> 1; m > 1; m >>= 1)
+        {
+            dif_small_stage_simd_lazy(ax_simd, ay_simd, m, w_simd[m], w_shoup_simd[m], shoupModSimd);
+            dif_small_stage_simd_lazy(bx_simd, by_simd, m, w_simd[m], w_shoup_simd[m], shoupModSimd);
         }
+
+        simd_transpose_blocks(ax_simd, ay_simd, 1);
+        simd_transpose_blocks(bx_simd, by_simd, 1);
+        u32xN a0_simd = shoupModSimd.reduce_2p(simd_add(ax_simd, ay_simd));
+        u32xN a1_simd = shoupModSimd.reduce_2p(simd_add(simd_sub(ax_simd, ay_simd), p2_simd));
+        u32xN b0_simd = shoupModSimd.reduce_2p(simd_add(bx_simd, by_simd));
+        u32xN b1_simd = shoupModSimd.reduce_2p(simd_add(simd_sub(bx_simd, by_simd), p2_simd));
+        u32xN c0_simd = shoupModSimd.mul(montModSimd.mul(a0_simd, b0_simd), scale_simd, scale_shoup_simd);
+        u32xN c1_simd = shoupModSimd.mul(montModSimd.mul(a1_simd, b1_simd), scale_simd, scale_shoup_simd);
+        ax_simd = simd_add(c0_simd, c1_simd);
+        ay_simd = simd_add(simd_sub(c0_simd, c1_simd), p2_simd);
+        simd_transpose_blocks(ax_simd, ay_simd, 1);
+
+        for (u32 m = 2; m < SIMD_LANES; m <<= 1)
+            dit_small_stage_simd_lazy(ax_simd, ay_simd, m, inv_w_simd[m], inv_w_shoup_simd[m], shoupModSimd);
+        a_simd[i] = ax_simd;
+        a_simd[i + 1] = ay_simd;
     }
+}
+
+/**
+ * @brief 惰性规约的 DIT 逆变换（从 mid = SIMD_LANES 层开始），最后一层直接把完全规约的结果写到 out
+ *
+ * @param a_simd ntt_pointwise_simd_lazy_fused 的结果，变换后内容不再有意义
+ * @param out 结果（[0, p)，普通整数，自然顺序），长度 plan.size()
+ * @param plan NTT 计划
+ */
+inline void ntt_inverse_dit_simd_lazy_to_output(u32xN *a_simd, u32 *out, const NttPlan<u32> &plan)
+{
+    ShoupModSimd shoupModSimd(plan.mod());
+    u32xN p2_simd = shoupModSimd.mod_2p();
+    u32 n = plan.size();
+    u32 mid = n >> 1;
 
-    if (is_serial)
-        to_simd(a_mont, a_mont_simd, n);
+    for (u32 m = SIMD_LANES; m < mid; m <<= 1)
+        ntt_inverse_dit_simd_lazy_stage(a_simd, plan, m, shoupModSimd);
 
-    delete[] a_mont;
+    const u32 *w = plan.stage_lazy_inv_twiddles(mid);
+    const u32 *w_shoup = plan.stage_lazy_inv_twiddles_shoup(mid);
+    for (u32 k = 0; k < mid; k += SIMD_LANES)
+    {
+        u32xN x_simd = shoupModSimd.reduce_2p(a_simd[k / SIMD_LANES]);
+        u32xN y_simd = shoupModSimd.mul(a_simd[(k + mid) / SIMD_LANES], simd_load(w + k), simd_load(w_shoup + k));
+        simd_store(out + k, shoupModSimd.reduce_p(shoupModSimd.reduce_2p(simd_add(x_simd, y_simd))));
+        simd_store(out + k + mid, shoupModSimd.reduce_p(shoupModSimd.reduce_2p(simd_add(simd_sub(x_simd, y_simd), p2_simd))));
+    }
+}
 
-    u32_mont inv_n = montMod.inv(montMod.from_T(n));
-    u32x4_mont inv_n_simd = vdupq_n_u32(inv_n);
-    for (u32 i = 0; i < n; i += 4)
-        a_mont_simd[i / 4] = montModNeon.mul(a_mont_simd[i / 4], inv_n_simd);
-}
\ No newline at end of file
+#endif
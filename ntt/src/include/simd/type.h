@@ -1,5 +1,18 @@
 #pragma once
 
+#include "../general/type.h"
+
+// === SIMD 后端（编译期选择） ===
+// - NEON：ARM 平台（__ARM_NEON），4 个 u32 通道；在其他平台上测试 NEON 路径时以 -DNTT_SIMD_FORCE_NEON 编译，
+//   并在包含路径里提供 arm_neon.h 的替身
+// - AVX-512：以 -mavx512f（或 -march=native）编译时，16 个 u32 通道
+// - AVX2：以 -mavx2 编译时，8 个 u32 通道
+// - 都没有时定义 NTT_SIMD_NONE，poly_multiply_ntt_simd 退回标量实现
+// 变换代码只使用 u32xN、SIMD_LANES 和 vec.h 中的操作，不直接写某个指令集的 intrinsic。
+
+#if defined(__ARM_NEON) || defined(NTT_SIMD_FORCE_NEON)
+
+#define NTT_SIMD_NEON
 #include <arm_neon.h>
 
 using u32x4 = uint32x4_t;
@@ -7,4 +20,33 @@ using u32x2 = uint32x2_t;
 using u64x2 = uint64x2_t;
 
 using u32x4_mont = u32x4;
-using u64x2_mont = u64x2;
\ No newline at end of file
+using u64x2_mont = u64x2;
+
+using u32xN = u32x4;
+constexpr u32 SIMD_LANES = 4;
+
+#elif defined(__AVX512F__)
+
+#define NTT_SIMD_AVX512
+#include <immintrin.h>
+
+using u32xN = __m512i;
+constexpr u32 SIMD_LANES = 16;
+
+#elif defined(__AVX2__)
+
+#define NTT_SIMD_AVX2
+#include <immintrin.h>
+
+using u32xN = __m256i;
+constexpr u32 SIMD_LANES = 8;
+
+#else
+
+#define NTT_SIMD_NONE
+
+#endif
+
+#ifndef NTT_SIMD_NONE
+using u32xN_mont = u32xN;
+#endif
@@ -2,51 +2,48 @@
 
 #include "../general/type.h"
 #include "type.h"
+#include "vec.h"
+
+#ifndef NTT_SIMD_NONE
 
 /** 将 a 转换成 SIMD 类型。 */
-inline void to_simd(u32 *a, u32x4 *a_simd, u32 n_expanded)
+inline void to_simd(u32 *a, u32xN *a_simd, u32 n_expanded)
 {
-    for (u32 i = 0; i < n_expanded / 4; ++i)
-        a_simd[i] = vld1q_u32(&a[i * 4]);
+    for (u32 i = 0; i < n_expanded / SIMD_LANES; ++i)
+        a_simd[i] = simd_load(&a[i * SIMD_LANES]);
 }
 
 /** 将 a_simd 转换成普通类型。 */
-inline void from_simd(u32 *a, u32x4 *a_simd, u32 n_expanded)
+inline void from_simd(u32 *a, u32xN *a_simd, u32 n_expanded)
+{
+    for (u32 i = 0; i < n_expanded / SIMD_LANES; ++i)
+        simd_store(&a[i * SIMD_LANES], a_simd[i]);
+}
+
+/** a 的第 i 个向量：超出 n 的部分补 0，不会读到 a[n] 之后。 */
+inline u32xN load_padded_simd(const u32 *a, u32 n, u32 i)
 {
-    for (u32 i = 0; i < n_expanded / 4; ++i)
-        vst1q_u32(&a[i * 4], a_simd[i]);
+    if ((i + 1) * SIMD_LANES <= n)
+        return simd_load(&a[i * SIMD_LANES]);
+    u32 lanes[SIMD_LANES] = {};
+    for (u32 t = i * SIMD_LANES; t < n; ++t)
+        lanes[t - i * SIMD_LANES] = a[t];
+    return simd_load(lanes);
 }
 
-inline u32 get_lane(u32x4 v, int lane)
+inline u32 get_lane(u32xN v, int lane)
 {
-    switch (lane)
-    {
-    case 0:
-        return vgetq_lane_u32(v, 0);
-    case 1:
-        return vgetq_lane_u32(v, 1);
-    case 2:
-        return vgetq_lane_u32(v, 2);
-    case 3:
-        return vgetq_lane_u32(v, 3);
-    default:
-        __builtin_unreachable();
-    }
+    u32 lanes[SIMD_LANES];
+    simd_store(lanes, v);
+    return lanes[lane];
 }
 
-inline u32x4 set_lane(u32x4 v, u32 val, int lane)
+inline u32xN set_lane(u32xN v, u32 val, int lane)
 {
-    switch (lane)
-    {
-    case 0:
-        return vsetq_lane_u32(val, v, 0);
-    case 1:
-        return vsetq_lane_u32(val, v, 1);
-    case 2:
-        return vsetq_lane_u32(val, v, 2);
-    case 3:
-        return vsetq_lane_u32(val, v, 3);
-    default:
-        __builtin_unreachable();
-    }
-}
\ No newline at end of file
+    u32 lanes[SIMD_LANES];
+    simd_store(lanes, v);
+    lanes[lane] = val;
+    return simd_load(lanes);
+}
+
+#endif
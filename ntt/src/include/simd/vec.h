@@ -0,0 +1,145 @@
+#pragma once
+
+#include "type.h"
+
+// === 向量的基本操作 ===
+// 每个后端各自实现一遍，变换代码通过这些函数使用 u32xN。
+
+#if defined(NTT_SIMD_NEON)
+
+inline u32xN simd_load(const u32 *p) { return vld1q_u32(p); }
+inline void simd_store(u32 *p, u32xN a) { vst1q_u32(p, a); }
+inline u32xN simd_dup(u32 x) { return vdupq_n_u32(x); }
+inline u32xN simd_add(u32xN a, u32xN b) { return vaddq_u32(a, b); }
+inline u32xN simd_sub(u32xN a, u32xN b) { return vsubq_u32(a, b); }
+inline u32xN simd_min(u32xN a, u32xN b) { return vminq_u32(a, b); }
+
+/**
+ * 把 a、b 看成长为 m 的块，按 2×2 的块矩阵转置：a = [a0 a1 ...]、b = [b0 b1 ...] 变为
+ * a = [a0 b0 a2 b2 ...]、b = [a1 b1 a3 b3 ...]。m < SIMD_LANES，再做一次就变回原样。
+ */
+inline void simd_transpose_blocks(u32xN &a, u32xN &b, u32 m)
+{
+    u32xN a_new, b_new;
+    if (m == 1)
+    {
+        a_new = vtrn1q_u32(a, b);
+        b_new = vtrn2q_u32(a, b);
+    }
+    else // m == 2
+    {
+        a_new = vcombine_u32(vget_low_u32(a), vget_low_u32(b));
+        b_new = vcombine_u32(vget_high_u32(a), vget_high_u32(b));
+    }
+    a = a_new;
+    b = b_new;
+}
+
+#elif defined(NTT_SIMD_AVX512)
+
+inline u32xN simd_load(const u32 *p) { return _mm512_loadu_si512((const void *)p); }
+inline void simd_store(u32 *p, u32xN a) { _mm512_storeu_si512((void *)p, a); }
+inline u32xN simd_dup(u32 x) { return _mm512_set1_epi32((int)x); }
+inline u32xN simd_add(u32xN a, u32xN b) { return _mm512_add_epi32(a, b); }
+inline u32xN simd_sub(u32xN a, u32xN b) { return _mm512_sub_epi32(a, b); }
+inline u32xN simd_min(u32xN a, u32xN b) { return _mm512_min_epu32(a, b); }
+/** 每个 64 位通道的低 32 位相乘，得到 64 位的积 */
+inline u32xN simd_mul_even(u32xN a, u32xN b) { return _mm512_mul_epu32(a, b); }
+/** 每个 64 位通道右移 32 位：奇数位置的 u32 移到偶数位置 */
+inline u32xN simd_odd_to_even(u32xN a) { return _mm512_srli_epi64(a, 32); }
+/** 偶数位置取 even，奇数位置取 odd */
+inline u32xN simd_blend_odd(u32xN even, u32xN odd) { return _mm512_mask_blend_epi32(0xAAAA, even, odd); }
+inline u32xN simd_mullo(u32xN a, u32xN b) { return _mm512_mullo_epi32(a, b); }
+
+/** 见 NEON 版本 */
+inline void simd_transpose_blocks(u32xN &a, u32xN &b, u32 m)
+{
+    u32xN a_new, b_new;
+    switch (m)
+    {
+    case 1:
+        a_new = _mm512_mask_blend_epi32(0xAAAA, a, _mm512_slli_epi64(b, 32));
+        b_new = _mm512_mask_blend_epi32(0xAAAA, _mm512_srli_epi64(a, 32), b);
+        break;
+    case 2:
+        a_new = _mm512_unpacklo_epi64(a, b);
+        b_new = _mm512_unpackhi_epi64(a, b);
+        break;
+    case 4:
+        a_new = _mm512_permutex2var_epi64(a, _mm512_setr_epi64(0, 1, 8, 9, 4, 5, 12, 13), b);
+        b_new = _mm512_permutex2var_epi64(a, _mm512_setr_epi64(2, 3, 10, 11, 6, 7, 14, 15), b);
+        break;
+    default: // m == 8
+        a_new = _mm512_shuffle_i64x2(a, b, _MM_SHUFFLE(1, 0, 1, 0));
+        b_new = _mm512_shuffle_i64x2(a, b, _MM_SHUFFLE(3, 2, 3, 2));
+        break;
+    }
+    a = a_new;
+    b = b_new;
+}
+
+#elif defined(NTT_SIMD_AVX2)
+
+inline u32xN simd_load(const u32 *p) { return _mm256_loadu_si256((const __m256i *)p); }
+inline void simd_store(u32 *p, u32xN a) { _mm256_storeu_si256((__m256i *)p, a); }
+inline u32xN simd_dup(u32 x) { return _mm256_set1_epi32((int)x); }
+inline u32xN simd_add(u32xN a, u32xN b) { return _mm256_add_epi32(a, b); }
+inline u32xN simd_sub(u32xN a, u32xN b) { return _mm256_sub_epi32(a, b); }
+inline u32xN simd_min(u32xN a, u32xN b) { return _mm256_min_epu32(a, b); }
+/** 每个 64 位通道的低 32 位相乘，得到 64 位的积 */
+inline u32xN simd_mul_even(u32xN a, u32xN b) { return _mm256_mul_epu32(a, b); }
+/** 每个 64 位通道右移 32 位：奇数位置的 u32 移到偶数位置 */
+inline u32xN simd_odd_to_even(u32xN a) { return _mm256_srli_epi64(a, 32); }
+/** 偶数位置取 even，奇数位置取 odd */
+inline u32xN simd_blend_odd(u32xN even, u32xN odd) { return _mm256_blend_epi32(even, odd, 0xAA); }
+inline u32xN simd_mullo(u32xN a, u32xN b) { return _mm256_mullo_epi32(a, b); }
+
+/** 见 NEON 版本 */
+inline void simd_transpose_blocks(u32xN &a, u32xN &b, u32 m)
+{
+    u32xN a_new, b_new;
+    switch (m)
+    {
+    case 1:
+        a_new = _mm256_blend_epi32(a, _mm256_slli_epi64(b, 32), 0xAA);
+        b_new = _mm256_blend_epi32(_mm256_srli_epi64(a, 32), b, 0xAA);
+        break;
+    case 2:
+        a_new = _mm256_unpacklo_epi64(a, b);
+        b_new = _mm256_unpackhi_epi64(a, b);
+        break;
+    default: // m == 4
+        a_new = _mm256_permute2x128_si256(a, b, 0x20);
+        b_new = _mm256_permute2x128_si256(a, b, 0x31);
+        break;
+    }
+    a = a_new;
+    b = b_new;
+}
+
+#endif
+
+#if defined(NTT_SIMD_AVX512) || defined(NTT_SIMD_AVX2)
+
+/** 每个通道 a·b 的高 32 位：偶数、奇数通道各做一次 32×32→64 的乘法再拼起来 */
+inline u32xN simd_mulhi(u32xN a, u32xN b)
+{
+    u32xN prod_even = simd_mul_even(a, b);
+    u32xN prod_odd = simd_mul_even(simd_odd_to_even(a), simd_odd_to_even(b));
+    return simd_blend_odd(simd_odd_to_even(prod_even), prod_odd);
+}
+
+#endif
+
+#ifndef NTT_SIMD_NONE
+
+/** 第 t 个通道为 w[t % m]（m < SIMD_LANES）：转置后同一层的旋转因子按通道排好 */
+inline u32xN simd_repeat(const u32 *w, u32 m)
+{
+    u32 lanes[SIMD_LANES];
+    for (u32 t = 0; t < SIMD_LANES; ++t)
+        lanes[t] = w[t % m];
+    return simd_load(lanes);
+}
+
+#endif
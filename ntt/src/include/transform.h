@@ -1,6 +1,7 @@
 #pragma once
 
 #include "general/op.h"
+#include "general/plan.h"
 
 /**
  * @brief NTT 正变换：a(x) → A(ω)
@@ -89,6 +90,39 @@ inline void ntt_forward_mont(T *a_mont, T n, T p, T omega_mont)
   }
 }
 
+/**
+ * @brief NTT 正变换：a(x) → A(ω)
+ *
+ * 与 ntt_forward_mont 相同，但旋转因子直接从计划的表中按单位步长读取，
+ * 不再逐层求幂、逐块累乘。
+ *
+ * @param a_mont 多项式系数（位于 Montgomery 数域，bit-reversed 顺序），变换后表示频域系数（自然顺序）
+ * @param plan NTT 计划
+ */
+template <typename T>
+inline void ntt_forward_mont(T *a_mont, const NttPlan<T> &plan)
+{
+  using T_mont = T;
+
+  const MontMod<T> &montMod = plan.mont();
+  T n = plan.size();
+
+  for (T mid = 1; mid < n; mid <<= 1)
+  {
+    const T_mont *w_mont = plan.stage_twiddles(mid);
+    for (T j = 0; j < n; j += (mid << 1))
+    {
+      for (T k = 0; k < mid; ++k)
+      {
+        T_mont x_mont = a_mont[j + k];
+        T_mont y_mont = montMod.mul(w_mont[k], a_mont[j + k + mid]);
+        a_mont[j + k] = montMod.add(x_mont, y_mont);
+        a_mont[j + k + mid] = montMod.sub(x_mont, y_mont);
+      }
+    }
+  }
+}
+
 template <typename T>
 inline void ntt_forward_mont_before_simd(T *a_mont, T n, T p, T omega_mont)
 {
@@ -214,6 +248,42 @@ inline void ntt_inverse_mont(T *a_mont, T n, T p, T omega_mont)
     a_mont[i] = montMod.mul(a_mont[i], inv_n);
 }
 
+/**
+ * @brief NTT 逆变换：A(ω) → a_mont(x)
+ *
+ * 与 ntt_inverse_mont 相同，旋转因子和 n 的逆元取自计划。
+ *
+ * @param a_mont 频域系数（自然顺序），变换后表示多项式系数（bit-reversed 顺序）
+ * @param plan NTT 计划
+ */
+template <typename T>
+inline void ntt_inverse_mont(T *a_mont, const NttPlan<T> &plan)
+{
+  using T_mont = T;
+
+  const MontMod<T> &montMod = plan.mont();
+  T n = plan.size();
+
+  for (T mid = n >> 1; mid > 0; mid >>= 1)
+  {
+    const T_mont *w_mont = plan.stage_inv_twiddles(mid);
+    for (T j = 0; j < n; j += (mid << 1))
+    {
+      for (T k = 0; k < mid; ++k)
+      {
+        T_mont x_mont = a_mont[j + k];
+        T_mont y_mont = a_mont[j + k + mid];
+        a_mont[j + k] = montMod.add(x_mont, y_mont);
+        a_mont[j + k + mid] = montMod.mul(w_mont[k], montMod.sub(x_mont, y_mont));
+      }
+    }
+  }
+
+  T_mont inv_n = plan.inv_n();
+  for (T i = 0; i < n; ++i)
+    a_mont[i] = montMod.mul(a_mont[i], inv_n);
+}
+
 template <typename T>
 inline void ntt_inverse_mont_before_simd(T *a_mont, T n, T p, T omega_mont)
 {
@@ -303,3 +373,269 @@ inline void ntt_inverse_mont_before_simd(T *a_mont, T n, T p, T omega_mont)
   for (T i = 0; i < n; ++i)
     a_mont[i] = montMod.mul(a_mont[i], inv_n);
 }
+
+/**
+ * @brief NTT 正变换（DIF，Gentleman-Sande）：a(x) → A(ω)
+ *
+ * 输入的顺序是自然顺序，输出的顺序是 bit-reversed。
+ * 与 ntt_inverse_dit_mont 配对使用时，卷积全程不需要 bit-reverse 置换：
+ * 点乘不关心顺序，逆变换直接接收 bit-reversed 的频域系数。
+ *
+ * @param a_mont 多项式系数（位于 Montgomery 数域，自然顺序），变换后表示频域系数（bit-reversed 顺序）
+ * @param plan NTT 计划
+ */
+template <typename T>
+inline void ntt_forward_dif_mont(T *a_mont, const NttPlan<T> &plan)
+{
+  using T_mont = T;
+
+  const MontMod<T> &montMod = plan.mont();
+  T n = plan.size();
+
+  for (T mid = n >> 1; mid > 0; mid >>= 1)
+  {
+    const T_mont *w_mont = plan.stage_twiddles(mid);
+    for (T j = 0; j < n; j += (mid << 1))
+    {
+      for (T k = 0; k < mid; ++k)
+      {
+        T_mont x_mont = a_mont[j + k];
+        T_mont y_mont = a_mont[j + k + mid];
+        a_mont[j + k] = montMod.add(x_mont, y_mont);
+        a_mont[j + k + mid] = montMod.mul(w_mont[k], montMod.sub(x_mont, y_mont));
+      }
+    }
+  }
+}
+
+/**
+ * @brief NTT 逆变换（DIT，Cooley-Tukey）：A(ω) → a_mont(x)
+ *
+ * 输入的顺序是 bit-reversed（即 ntt_forward_dif_mont 的输出），输出的顺序是自然顺序。
+ *
+ * @param a_mont 频域系数（bit-reversed 顺序），变换后表示多项式系数（自然顺序）
+ * @param plan NTT 计划
+ */
+template <typename T>
+inline void ntt_inverse_dit_mont(T *a_mont, const NttPlan<T> &plan)
+{
+  using T_mont = T;
+
+  const MontMod<T> &montMod = plan.mont();
+  T n = plan.size();
+
+  for (T mid = 1; mid < n; mid <<= 1)
+  {
+    const T_mont *w_mont = plan.stage_inv_twiddles(mid);
+    for (T j = 0; j < n; j += (mid << 1))
+    {
+      for (T k = 0; k < mid; ++k)
+      {
+        T_mont x_mont = a_mont[j + k];
+        T_mont y_mont = montMod.mul(w_mont[k], a_mont[j + k + mid]);
+        a_mont[j + k] = montMod.add(x_mont, y_mont);
+        a_mont[j + k + mid] = montMod.sub(x_mont, y_mont);
+      }
+    }
+  }
+
+  T_mont inv_n = plan.inv_n();
+  for (T i = 0; i < n; ++i)
+    a_mont[i] = montMod.mul(a_mont[i], inv_n);
+}
+
+/**
+ * @brief 惰性规约的 DIF 正变换中蝴蝶跨度为 mid 的一层，数值停留在 [0, 2p)
+ */
+template <typename T>
+inline void ntt_forward_dif_lazy_stage(T *a, const NttPlan<T> &plan, T mid)
+{
+  const ShoupMod<T> &shoupMod = plan.shoup();
+  const T p2 = shoupMod.mod_2p();
+  T n = plan.size();
+
+  const T *w = plan.stage_lazy_twiddles(mid);
+  const T *w_shoup = plan.stage_lazy_twiddles_shoup(mid);
+  for (T j = 0; j < n; j += (mid << 1))
+  {
+    for (T k = 0; k < mid; ++k)
+    {
+      T x = a[j + k];
+      T y = a[j + k + mid];
+      a[j + k] = shoupMod.reduce_2p(x + y);
+      a[j + k + mid] = shoupMod.mul(x - y + p2, w[k], w_shoup[k]);
+    }
+  }
+}
+
+/**
+ * @brief 惰性规约的 DIT 逆变换中蝴蝶跨度为 mid 的一层，数值停留在 [0, 4p)
+ */
+template <typename T>
+inline void ntt_inverse_dit_lazy_stage(T *a, const NttPlan<T> &plan, T mid)
+{
+  const ShoupMod<T> &shoupMod = plan.shoup();
+  const T p2 = shoupMod.mod_2p();
+  T n = plan.size();
+
+  const T *w = plan.stage_lazy_inv_twiddles(mid);
+  const T *w_shoup = plan.stage_lazy_inv_twiddles_shoup(mid);
+  for (T j = 0; j < n; j += (mid << 1))
+  {
+    for (T k = 0; k < mid; ++k)
+    {
+      T x = shoupMod.reduce_2p(a[j + k]);
+      T y = shoupMod.mul(a[j + k + mid], w[k], w_shoup[k]);
+      a[j + k] = x + y;
+      a[j + k + mid] = x - y + p2;
+    }
+  }
+}
+
+/**
+ * @brief 惰性规约的 DIF 正变换（Harvey 蝴蝶 + Shoup 模乘）
+ *
+ * 与 ntt_forward_dif_mont 相同（自然顺序输入，bit-reversed 输出），但数值始终停留在 [0, 2p)：
+ * 和只需把 [0, 4p) 减回 [0, 2p)，差加上 2p 后直接交给 Shoup 模乘，省掉了每个蝴蝶里的大部分条件减法。
+ * 要求 plan.supports_lazy()。
+ *
+ * 旋转因子是普通整数，Shoup 模乘不改变数域，所以 a 可以在 Montgomery 数域。
+ *
+ * @param a 多项式系数（[0, 2p)，自然顺序），变换后表示频域系数（[0, 2p)，bit-reversed 顺序）
+ * @param plan NTT 计划
+ */
+template <typename T>
+inline void ntt_forward_dif_mont_lazy(T *a, const NttPlan<T> &plan)
+{
+  for (T mid = plan.size() >> 1; mid > 0; mid >>= 1)
+    ntt_forward_dif_lazy_stage(a, plan, mid);
+}
+
+/**
+ * @brief 惰性规约的 DIT 逆变换（Harvey 蝴蝶 + Shoup 模乘）
+ *
+ * 与 ntt_inverse_dit_mont 相同（bit-reversed 输入，自然顺序输出）。
+ * 中间结果停留在 [0, 4p)，最后乘 n 的逆元时才完全规约。要求 plan.supports_lazy()。
+ *
+ * @param a 频域系数（[0, 4p)，bit-reversed 顺序），变换后表示多项式系数（[0, p)，自然顺序）
+ * @param plan NTT 计划
+ */
+template <typename T>
+inline void ntt_inverse_dit_mont_lazy(T *a, const NttPlan<T> &plan)
+{
+  const ShoupMod<T> &shoupMod = plan.shoup();
+  T n = plan.size();
+
+  for (T mid = 1; mid < n; mid <<= 1)
+    ntt_inverse_dit_lazy_stage(a, plan, mid);
+
+  T inv_n = plan.lazy_inv_n();
+  T inv_n_shoup = plan.lazy_inv_n_shoup();
+  for (T i = 0; i < n; ++i)
+    a[i] = shoupMod.reduce_p(shoupMod.mul(a[i], inv_n, inv_n_shoup));
+}
+
+// === 卷积流水线的融合版本 ===
+// 以下三步依次调用即完成一次卷积，每一步都把相邻的逐元素处理并进了一层蝴蝶里：
+// 扩展并入正变换的第一层，两个序列正变换的最后一层、点乘、缩放和逆变换的第一层合成一趟，
+// 逆变换的最后一层直接写出完全规约的结果。整个过程都是普通整数，不需要 Montgomery 转换。
+// 都要求 plan.supports_lazy() 且 plan.size() >= 4。
+
+/**
+ * @brief 扩展 + 惰性规约的 DIF 正变换，最后一层（mid = 1）留给 ntt_pointwise_lazy_fused
+ *
+ * 第一层（mid = n / 2）的下半部分全是补上的 0，蝴蝶退化为 (x, x·w)，直接从 input 读取并规约。
+ *
+ * @param a 长度为 plan.size() 的缓冲区，变换后为 mid = 1 层之前的中间结果（[0, 2p)）
+ * @param input 多项式系数（普通整数，可以不小于 p），长度 len，len <= plan.size() / 2
+ * @param len 多项式长度
+ * @param plan NTT 计划
+ */
+template <typename T>
+inline void ntt_forward_dif_lazy_from_input(T *a, const T *input, T len, const NttPlan<T> &plan)
+{
+  const ShoupMod<T> &shoupMod = plan.shoup();
+  T n = plan.size();
+  T mid = n >> 1;
+
+  // 输入不一定小于 p（CRT 传入的是更大模数下的系数），乘 1 的 Shoup 模乘把它规约到 [0, 2p)
+  const T one_shoup = shoupMod.quotient(1);
+  const T *w = plan.stage_lazy_twiddles(mid);
+  const T *w_shoup = plan.stage_lazy_twiddles_shoup(mid);
+  for (T k = 0; k < len; ++k)
+  {
+    T x = input[k];
+    a[k] = shoupMod.mul(x, 1, one_shoup);
+    a[k + mid] = shoupMod.mul(x, w[k], w_shoup[k]);
+  }
+  for (T k = len; k < mid; ++k)
+    a[k] = a[k + mid] = 0;
+
+  for (mid >>= 1; mid > 1; mid >>= 1)
+    ntt_forward_dif_lazy_stage(a, plan, mid);
+}
+
+/**
+ * @brief 两个序列正变换的最后一层 + 点乘 + 逆变换的第一层
+ *
+ * mid = 1 层的旋转因子为 1，正、逆蝴蝶都只剩加减。点乘用 Montgomery 乘法得到 A·B/R，
+ * 再乘上 R/n（Shoup 模乘），逆变换结束时不再需要乘 n 的逆元。
+ *
+ * @param a ntt_forward_dif_lazy_from_input 的结果，变换后为逆变换 mid = 1 层之后的中间结果（[0, 4p)）
+ * @param b ntt_forward_dif_lazy_from_input 的结果，只读
+ * @param plan NTT 计划
+ */
+template <typename T>
+inline void ntt_pointwise_lazy_fused(T *a, const T *b, const NttPlan<T> &plan)
+{
+  const MontMod<T> &montMod = plan.mont();
+  const ShoupMod<T> &shoupMod = plan.shoup();
+  const T p2 = shoupMod.mod_2p();
+  const T scale = plan.lazy_pointwise_scale();
+  const T scale_shoup = plan.lazy_pointwise_scale_shoup();
+  T n = plan.size();
+
+  for (T j = 0; j < n; j += 2)
+  {
+    // 正变换 mid = 1 层，频域系数在 [0, 2p)
+    T a0 = shoupMod.reduce_2p(a[j] + a[j + 1]);
+    T a1 = shoupMod.reduce_2p(a[j] - a[j + 1] + p2);
+    T b0 = shoupMod.reduce_2p(b[j] + b[j + 1]);
+    T b1 = shoupMod.reduce_2p(b[j] - b[j + 1] + p2);
+    // 点乘
+    T c0 = shoupMod.mul(montMod.mul(a0, b0), scale, scale_shoup);
+    T c1 = shoupMod.mul(montMod.mul(a1, b1), scale, scale_shoup);
+    // 逆变换 mid = 1 层
+    a[j] = c0 + c1;
+    a[j + 1] = c0 - c1 + p2;
+  }
+}
+
+/**
+ * @brief 惰性规约的 DIT 逆变换（从 mid = 2 层开始），最后一层直接把完全规约的结果写到 out
+ *
+ * @param a ntt_pointwise_lazy_fused 的结果，变换后内容不再有意义
+ * @param out 结果（[0, p)，普通整数，自然顺序），长度 plan.size()；可以与 a 相同
+ * @param plan NTT 计划
+ */
+template <typename T>
+inline void ntt_inverse_dit_lazy_to_output(T *a, T *out, const NttPlan<T> &plan)
+{
+  const ShoupMod<T> &shoupMod = plan.shoup();
+  const T p2 = shoupMod.mod_2p();
+  T n = plan.size();
+  T mid = n >> 1;
+
+  for (T m = 2; m < mid; m <<= 1)
+    ntt_inverse_dit_lazy_stage(a, plan, m);
+
+  const T *w = plan.stage_lazy_inv_twiddles(mid);
+  const T *w_shoup = plan.stage_lazy_inv_twiddles_shoup(mid);
+  for (T k = 0; k < mid; ++k)
+  {
+    T x = shoupMod.reduce_2p(a[k]);
+    T y = shoupMod.mul(a[k + mid], w[k], w_shoup[k]);
+    out[k] = shoupMod.reduce_p(shoupMod.reduce_2p(x + y));
+    out[k + mid] = shoupMod.reduce_p(shoupMod.reduce_2p(x - y + p2));
+  }
+}
@@ -0,0 +1,87 @@
+#include "../include/ntt.h"
+#include "../include/simd/ntt.h"
+#include "../include/pthread_simple/ntt.h"
+#include "../include/OpenMP/ntt.h" // 定义了 OMEGA 宏，放在最后
+
+#include <cassert>
+#include <iostream>
+#include <random>
+#include <vector>
+
+// DIF 正变换 + DIT 逆变换：各个版本的乘法都不再做 bit-reverse 置换，结果与朴素乘法比较
+
+template <typename F>
+void check_against_naive(const char *name, u32 n, u32 p, std::mt19937 &rng, F poly_multiply)
+{
+  std::vector<u32> a(n), b(n), ab(expand_n(2 * n - 1));
+  std::vector<int> ai(n), bi(n), ab_naive(2 * n - 1, 0);
+  for (u32 i = 0; i < n; ++i)
+  {
+    a[i] = ai[i] = rng() % p;
+    b[i] = bi[i] = rng() % p;
+  }
+  poly_multiply(a.data(), b.data(), ab.data(), n, p);
+  poly_multiply_naive(ai.data(), bi.data(), ab_naive.data(), (int)n, (int)p);
+  for (u32 i = 0; i < 2 * n - 1; ++i)
+  {
+    if (ab[i] != (u32)ab_naive[i])
+    {
+      std::cout << "[✗] " << name << " n = " << n << ", p = " << p << " 第 " << i << " 项: 预期 " << ab_naive[i] << ", 实际 " << ab[i] << std::endl;
+      assert(false);
+    }
+  }
+}
+
+int main()
+{
+  std::mt19937 rng(42);
+
+  // DIF 的输出恰好是自然顺序频谱的 bit-reverse
+  {
+    u32 n = 64, p = 998244353;
+    const NttPlan<u32> &plan = get_ntt_plan<u32>(n, p, 3);
+    std::vector<u32> dit(n), dif(n);
+    for (u32 i = 0; i < n; ++i)
+      dit[i] = dif[i] = plan.mont().from_T(rng() % p);
+    bit_reverse_permute(dit.data(), plan);
+    ntt_forward_mont(dit.data(), plan);
+    ntt_forward_dif_mont(dif.data(), plan);
+    bit_reverse_permute(dif.data(), plan);
+    assert(dit == dif);
+  }
+
+  for (u32 p : {7340033u, 104857601u, 469762049u, 998244353u})
+  {
+    for (u32 n : {1u, 2u, 3u, 17u, 64u, 300u, 1000u})
+    {
+      check_against_naive("scalar", n, p, rng, [](u32 *a, u32 *b, u32 *ab, u32 n, u32 p)
+                          { poly_multiply_ntt(a, b, ab, n, p); });
+      check_against_naive("openmp", n, p, rng, [](u32 *a, u32 *b, u32 *ab, u32 n, u32 p)
+                          { poly_multiply_ntt_omp(a, b, ab, n, p); });
+      check_against_naive("pthread", n, p, rng, [](u32 *a, u32 *b, u32 *ab, u32 n, u32 p)
+                          { poly_multiply_ntt_pthread_simple(a, b, ab, n, p); });
+      if (n >= 2) // SIMD 版本要求 n_expanded >= 4
+        check_against_naive("simd", n, p, rng, [](u32 *a, u32 *b, u32 *ab, u32 n, u32 p)
+                            { poly_multiply_ntt_simd((int *)a, (int *)b, (int *)ab, (int)n, (int)p); });
+    }
+  }
+
+  // 多线程版本在长序列上才会真正分给多个线程
+  {
+    u32 n = 1 << 15, p = 998244353;
+    std::vector<u32> a(n), b(n), ab_scalar(2 * n), ab_omp(2 * n), ab_pthread(2 * n);
+    for (u32 i = 0; i < n; ++i)
+    {
+      a[i] = rng() % p;
+      b[i] = rng() % p;
+    }
+    poly_multiply_ntt(a.data(), b.data(), ab_scalar.data(), n, p);
+    poly_multiply_ntt_omp(a.data(), b.data(), ab_omp.data(), n, p);
+    poly_multiply_ntt_pthread_simple(a.data(), b.data(), ab_pthread.data(), n, p);
+    assert(ab_scalar == ab_omp);
+    assert(ab_scalar == ab_pthread);
+  }
+
+  std::cout << "[✓] DIF/DIT 乘法（scalar, simd, openmp, pthread）与朴素乘法一致" << std::endl;
+  return 0;
+}
@@ -0,0 +1,139 @@
+#include "../include/fixed/ntt.h"
+
+#include <cassert>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <vector>
+
+// 编译期固定模数的 NTT：常量与运行时的 MontMod / ShoupMod / NttPlan 一致，乘法结果与朴素算法一致，且不慢于运行时版本
+
+template <u32 P>
+void check_constants()
+{
+  MontMod<u32> montMod(P);
+  for (u32 x : {0u, 1u, 2u, 12345u, P / 2, P - 1})
+  {
+    assert(MontModFixed<P>::from_T(x) == montMod.from_T(x));
+    assert(MontModFixed<P>::to_T(montMod.from_T(x)) == x);
+    assert(MontModFixed<P>::mul(montMod.from_T(x), montMod.from_T(P - 1)) == montMod.mul(montMod.from_T(x), montMod.from_T(P - 1)));
+  }
+
+  // 编译期的旋转因子表与计划里的普通整数表相同
+  const NttPlan<u32> &plan = get_ntt_plan<u32>(fixed_codelet_size, P, 3u);
+  const FixedTwiddles &tw = FixedTwiddleTable<P, 3>::value;
+  for (u32 mid = 1; mid < fixed_codelet_size; mid <<= 1)
+  {
+    for (u32 k = 0; k < mid; ++k)
+    {
+      assert(tw.w[mid + k] == plan.stage_lazy_twiddles(mid)[k]);
+      assert(tw.w_shoup[mid + k] == plan.stage_lazy_twiddles_shoup(mid)[k]);
+      assert(tw.inv_w[mid + k] == plan.stage_lazy_inv_twiddles(mid)[k]);
+      assert(tw.inv_w_shoup[mid + k] == plan.stage_lazy_inv_twiddles_shoup(mid)[k]);
+    }
+  }
+}
+
+template <typename T>
+void check_against_naive(u32 n, u32 p, u32 omega, std::mt19937 &rng)
+{
+  std::vector<T> a(n), b(n), ab(expand_n(2 * n - 1));
+  std::vector<int> ai(n), bi(n), ab_naive(2 * n - 1, 0);
+  for (u32 i = 0; i < n; ++i)
+  {
+    // 第一组用 p - 1，中间结果都顶到上界
+    a[i] = n == 1000 ? p - 1 : rng() % p;
+    b[i] = n == 1000 ? p - 1 : rng() % p;
+    ai[i] = (int)a[i];
+    bi[i] = (int)b[i];
+  }
+  poly_multiply_ntt_fixed(a.data(), b.data(), ab.data(), (T)n, (T)p, (T)omega);
+  poly_multiply_naive(ai.data(), bi.data(), ab_naive.data(), (int)n, (int)p);
+  for (u32 i = 0; i < 2 * n - 1; ++i)
+  {
+    if (ab[i] != (T)ab_naive[i])
+    {
+      std::cout << "[✗] n = " << n << ", p = " << p << " 第 " << i << " 项: 预期 " << ab_naive[i] << ", 实际 " << ab[i] << std::endl;
+      assert(false);
+    }
+  }
+}
+
+template <typename F>
+double average_ms(int repeat, F f)
+{
+  f();
+  auto start = std::chrono::steady_clock::now();
+  for (int r = 0; r < repeat; ++r)
+    f();
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / repeat;
+}
+
+int main()
+{
+  std::mt19937 rng(50);
+
+  check_constants<7340033>();
+  check_constants<104857601>();
+  check_constants<469762049>();
+  check_constants<998244353>();
+  check_constants<1004535809>();
+  check_constants<167772161>();
+  std::cout << "[✓] 编译期常量与运行时的一致" << std::endl;
+
+  // n = 1 直接相乘；n <= 32 整个乘法在一个 codelet 里；n = 33 起走计划
+  for (u32 p : {7340033u, 104857601u, 469762049u, 998244353u, 1004535809u, 167772161u})
+  {
+    for (u32 n : {1000u, 1u, 2u, 3u, 5u, 17u, 32u, 33u, 64u, 65u, 300u, 4097u})
+    {
+      check_against_naive<u32>(n, p, 3, rng);
+      check_against_naive<u64>(n, p, 3, rng);
+    }
+  }
+  std::cout << "[✓] 固定模数的乘法与朴素算法一致" << std::endl;
+
+  // 不在分派表里的模数退回 poly_multiply_ntt
+  for (u32 n : {1u, 5u, 300u})
+    check_against_naive<u64>(n, 2013265921u, 31, rng);
+  std::cout << "[✓] 其他模数退回运行时的版本" << std::endl;
+
+  // 输入不小于 p（CRT 传入的是更大模数下的系数）
+  for (u64 n : {3ull, 20ull, 300ull})
+  {
+    const u64 p = 998244353, big_mod = 263882790666241ull;
+    std::vector<u64> a(n), b(n), ab(expand_n(2 * n - 1));
+    std::vector<int> ai(n), bi(n), ab_naive(2 * n - 1, 0);
+    for (u64 i = 0; i < n; ++i)
+    {
+      a[i] = (((u64)rng() << 32) | rng()) % big_mod;
+      b[i] = (((u64)rng() << 32) | rng()) % big_mod;
+      ai[i] = (int)(a[i] % p);
+      bi[i] = (int)(b[i] % p);
+    }
+    poly_multiply_ntt_fixed(a.data(), b.data(), ab.data(), n, p);
+    poly_multiply_naive(ai.data(), bi.data(), ab_naive.data(), (int)n, (int)p);
+    for (u64 i = 0; i < 2 * n - 1; ++i)
+      assert(ab[i] == (u64)ab_naive[i]);
+  }
+  std::cout << "[✓] 不小于 p 的输入先被规约" << std::endl;
+
+  // 性能：与运行时模数的版本比较
+  const u32 p = 998244353;
+  NttWorkspace workspace;
+  for (u32 n : {16u, 1024u, 131072u})
+  {
+    const int repeat = n >= 131072 ? 50 : 20000;
+    std::vector<u32> a(n), b(n), ab(2 * n);
+    for (u32 i = 0; i < n; ++i)
+    {
+      a[i] = rng() % p;
+      b[i] = rng() % p;
+    }
+    double runtime_ms = average_ms(repeat, [&]()
+                                   { poly_multiply_ntt(a.data(), b.data(), ab.data(), n, p, 3u, workspace); });
+    double fixed_ms = average_ms(repeat, [&]()
+                                 { poly_multiply_ntt_fixed(a.data(), b.data(), ab.data(), n, p, 3u, workspace); });
+    std::cout << "n = " << n << ", " << repeat << " 次乘法平均: 运行时模数 " << runtime_ms << " ms, 固定模数 " << fixed_ms << " ms" << std::endl;
+  }
+  return 0;
+}
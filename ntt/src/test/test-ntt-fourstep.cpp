@@ -0,0 +1,114 @@
+#include "../include/ntt.h"
+#include "../include/fourstep/ntt.h"
+
+#include <cassert>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+// 四步 / 六步 NTT：乘法与朴素乘法、radix-4 乘法一致；大 n 下与整块 radix-4 比较耗时
+// 编译时加 -fopenmp 启用多线程；第一个参数为计时用的最大 log2(n)，默认 22
+
+template <typename T>
+double time_ms(T f, int repeat)
+{
+  auto start = std::chrono::steady_clock::now();
+  for (int r = 0; r < repeat; ++r)
+    f();
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / repeat;
+}
+
+int main(int argc, char *argv[])
+{
+  std::mt19937 rng(45);
+
+  // 小规模：与朴素乘法比较，包括 n_expanded = 4, 8 等行列很少的情况
+  for (u32 p : {7340033u, 469762049u, 998244353u, 1004535809u})
+  {
+    for (u32 n : {1u, 2u, 3u, 5u, 17u, 64u, 300u, 1000u})
+    {
+      for (bool six_step : {false, true})
+      {
+        std::vector<u32> a(n), b(n), ab(expand_n(2 * n - 1));
+        std::vector<int> ai(n), bi(n), ab_naive(2 * n - 1, 0);
+        for (u32 i = 0; i < n; ++i)
+        {
+          a[i] = ai[i] = rng() % p;
+          b[i] = bi[i] = rng() % p;
+        }
+        if (six_step)
+          poly_multiply_ntt_sixstep(a.data(), b.data(), ab.data(), n, p);
+        else
+          poly_multiply_ntt_fourstep(a.data(), b.data(), ab.data(), n, p);
+        poly_multiply_naive(ai.data(), bi.data(), ab_naive.data(), (int)n, (int)p);
+        for (u32 i = 0; i < 2 * n - 1; ++i)
+        {
+          if (ab[i] != (u32)ab_naive[i])
+          {
+            std::cout << "[✗] " << (six_step ? "six-step" : "four-step") << " n = " << n << ", p = " << p << " 第 " << i << " 项: 预期 " << ab_naive[i] << ", 实际 " << ab[i] << std::endl;
+            assert(false);
+          }
+        }
+      }
+    }
+  }
+
+  // 大规模：与 radix-4 乘法比较（log2(n_expanded) 为奇数和偶数）
+  for (u32 n : {1u << 16, 3u << 15, 1u << 17})
+  {
+    u32 p = 998244353;
+    std::vector<u32> a(n), b(n), ab_radix4(expand_n(2 * n - 1)), ab_four(expand_n(2 * n - 1)), ab_six(expand_n(2 * n - 1));
+    for (u32 i = 0; i < n; ++i)
+    {
+      a[i] = rng() % p;
+      b[i] = rng() % p;
+    }
+    poly_multiply_ntt_radix4(a.data(), b.data(), ab_radix4.data(), n, p);
+    poly_multiply_ntt_fourstep(a.data(), b.data(), ab_four.data(), n, p);
+    poly_multiply_ntt_sixstep(a.data(), b.data(), ab_six.data(), n, p);
+    assert(ab_four == ab_radix4);
+    assert(ab_six == ab_radix4);
+  }
+
+  // u64
+  {
+    u64 n = 5000, p = 469762049;
+    std::vector<u64> a(n), b(n), ab_radix4(expand_n(2 * n - 1)), ab_four(expand_n(2 * n - 1));
+    for (u64 i = 0; i < n; ++i)
+    {
+      a[i] = rng() % p;
+      b[i] = rng() % p;
+    }
+    poly_multiply_ntt_radix4(a.data(), b.data(), ab_radix4.data(), n, p);
+    poly_multiply_ntt_fourstep(a.data(), b.data(), ab_four.data(), n, p);
+    assert(ab_four == ab_radix4);
+  }
+  std::cout << "[✓] 四步 / 六步乘法与朴素乘法、radix-4 乘法一致" << std::endl;
+
+  // 性能：正变换 + 逆变换
+  u32 max_lg = argc > 1 ? (u32)atoi(argv[1]) : 22;
+  for (u32 lg = 18; lg <= max_lg; lg += 2)
+  {
+    const u32 n = 1u << lg, p = 998244353;
+    const int repeat = lg <= 20 ? 10 : 3;
+    std::vector<u32> x(n);
+    for (u32 i = 0; i < n; ++i)
+      x[i] = rng() % p;
+    const NttPlan<u32> &plan = get_ntt_plan<u32>(n, p, 3);
+    const FourStepPlan<u32> &fourstep_plan = get_fourstep_plan<u32>(n, p, 3);
+
+    double radix4_ms = time_ms([&]()
+                               { ntt_forward_dif_radix4_lazy(x.data(), plan);
+                                 ntt_inverse_dit_radix4_lazy(x.data(), plan); }, repeat);
+    double four_ms = time_ms([&]()
+                             { ntt_forward_fourstep(x.data(), fourstep_plan);
+                               ntt_inverse_fourstep(x.data(), fourstep_plan); }, repeat);
+    double six_ms = time_ms([&]()
+                            { ntt_forward_sixstep(x.data(), fourstep_plan);
+                              ntt_inverse_sixstep(x.data(), fourstep_plan); }, repeat);
+    std::cout << "n = 2^" << lg << " 正变换 + 逆变换平均: radix-4 " << radix4_ms << " ms, 四步 " << four_ms << " ms, 六步 " << six_ms << " ms" << std::endl;
+  }
+  return 0;
+}
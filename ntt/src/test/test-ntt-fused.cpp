@@ -0,0 +1,174 @@
+#include "../include/ntt.h"
+#include "../include/simd/ntt.h"
+
+#include <cassert>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <vector>
+
+// 融合的卷积流水线：扩展、点乘、缩放并进变换的第一层 / 最后一层以后，结果与分开做的流水线一致，且更快
+
+// 分开做的流水线：Montgomery 转换、正变换、点乘、逆变换（含乘 n 的逆元）、转换回来各遍历一次数组
+void poly_multiply_unfused(u32 *a, u32 *b, u32 *ab, u32 n, u32 p, NttWorkspace &workspace)
+{
+  u32 n_expanded = expand_n(2 * n - 1);
+  const NttPlan<u32> &plan = get_ntt_plan<u32>(n_expanded, p, 3);
+  const MontMod<u32> &montMod = plan.mont();
+
+  workspace.reserve(n_expanded * sizeof(u32));
+  u32 *a_mont = workspace.buffer<u32>(0);
+  u32 *b_mont = workspace.buffer<u32>(1);
+  for (u32 i = 0; i < n_expanded; ++i)
+    a_mont[i] = i < n ? montMod.from_T(a[i]) : 0;
+  for (u32 i = 0; i < n_expanded; ++i)
+    b_mont[i] = i < n ? montMod.from_T(b[i]) : 0;
+  ntt_forward_dif_mont_lazy(a_mont, plan);
+  ntt_forward_dif_mont_lazy(b_mont, plan);
+  for (u32 i = 0; i < n_expanded; ++i)
+    a_mont[i] = montMod.mul(a_mont[i], b_mont[i]);
+  ntt_inverse_dit_mont_lazy(a_mont, plan);
+  for (u32 i = 0; i < n_expanded; ++i)
+    ab[i] = montMod.to_T(a_mont[i]);
+}
+
+#ifndef NTT_SIMD_NONE
+// SIMD 版本的分开做的流水线，要求 n_expanded >= 2·SIMD_LANES
+void poly_multiply_unfused_simd(u32 *a, u32 *b, u32 *ab, u32 n, u32 p, NttWorkspace &workspace)
+{
+  u32 n_expanded = expand_n(2 * n - 1);
+  const NttPlan<u32> &plan = get_ntt_plan<u32>(n_expanded, p, 3);
+  MontModSimd montModSimd(p);
+
+  u32 n_simd = n_expanded / SIMD_LANES;
+  workspace.reserve(n_simd * sizeof(u32xN));
+  u32xN *a_simd = workspace.buffer<u32xN>(0);
+  u32xN *b_simd = workspace.buffer<u32xN>(1);
+  for (u32 i = 0; i < n_simd; ++i)
+    a_simd[i] = montModSimd.from_u32xN(load_padded_simd(a, n, i));
+  for (u32 i = 0; i < n_simd; ++i)
+    b_simd[i] = montModSimd.from_u32xN(load_padded_simd(b, n, i));
+  ntt_forward_dif_mont_simd_lazy(a_simd, plan);
+  ntt_forward_dif_mont_simd_lazy(b_simd, plan);
+  for (u32 i = 0; i < n_simd; ++i)
+    a_simd[i] = montModSimd.mul(a_simd[i], b_simd[i]);
+  ntt_inverse_dit_mont_simd_lazy(a_simd, plan);
+  for (u32 i = 0; i < n_simd; ++i)
+    simd_store(ab + i * SIMD_LANES, montModSimd.to_u32xN(a_simd[i]));
+}
+#endif
+
+template <typename F>
+void check_against_unfused(const char *name, u32 n, u32 p, std::mt19937 &rng, F poly_multiply)
+{
+  NttWorkspace workspace;
+  std::vector<u32> a(n), b(n), ab(expand_n(2 * n - 1)), ab_unfused(expand_n(2 * n - 1));
+  for (u32 i = 0; i < n; ++i)
+  {
+    // 第一组用 p - 1，频域系数和中间结果都顶到上界
+    a[i] = n == 1000 ? p - 1 : rng() % p;
+    b[i] = n == 1000 ? p - 1 : rng() % p;
+  }
+  poly_multiply(a.data(), b.data(), ab.data(), n, p);
+  poly_multiply_unfused(a.data(), b.data(), ab_unfused.data(), n, p, workspace);
+  for (u32 i = 0; i < 2 * n - 1; ++i)
+  {
+    if (ab[i] != ab_unfused[i])
+    {
+      std::cout << "[✗] " << name << " n = " << n << ", p = " << p << " 第 " << i << " 项: 预期 " << ab_unfused[i] << ", 实际 " << ab[i] << std::endl;
+      assert(false);
+    }
+  }
+}
+
+template <typename F>
+double average_ms(int repeat, F f)
+{
+  f();
+  auto start = std::chrono::steady_clock::now();
+  for (int r = 0; r < repeat; ++r)
+    f();
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / repeat;
+}
+
+int main()
+{
+  std::mt19937 rng(49);
+
+  // n = 2、3 时 n_expanded = 4、8，是融合版本支持的最短长度；SIMD 版本在 2·SIMD_LANES 附近切换
+  for (u32 p : {7340033u, 104857601u, 469762049u, 998244353u})
+  {
+    for (u32 n : {1000u, 1u, 2u, 3u, 5u, 8u, 9u, 17u, 33u, 64u, 300u, 4097u})
+    {
+      check_against_unfused("scalar", n, p, rng, [](u32 *a, u32 *b, u32 *ab, u32 n, u32 p)
+                            { poly_multiply_ntt(a, b, ab, n, p); });
+      check_against_unfused("simd", n, p, rng, [](u32 *a, u32 *b, u32 *ab, u32 n, u32 p)
+                            { poly_multiply_ntt_simd((int *)a, (int *)b, (int *)ab, (int)n, (int)p); });
+    }
+  }
+  std::cout << "[✓] 融合的流水线与分开做的流水线结果一致" << std::endl;
+
+  // 输入不小于 p（CRT 传入的是更大模数下的系数）：第一层会先把输入规约
+  for (u64 p : {998244353ull, 1004535809ull, 469762049ull, 167772161ull})
+  {
+    const u64 n = 300, big_mod = 263882790666241ull;
+    std::vector<u64> a(n), b(n), ab(expand_n(2 * n - 1));
+    std::vector<int> ai(n), bi(n), ab_naive(2 * n - 1, 0);
+    for (u64 i = 0; i < n; ++i)
+    {
+      a[i] = (((u64)rng() << 32) | rng()) % big_mod;
+      b[i] = (((u64)rng() << 32) | rng()) % big_mod;
+      ai[i] = (int)(a[i] % p);
+      bi[i] = (int)(b[i] % p);
+    }
+    poly_multiply_ntt(a.data(), b.data(), ab.data(), n, p);
+    poly_multiply_naive(ai.data(), bi.data(), ab_naive.data(), (int)n, (int)p);
+    for (u64 i = 0; i < 2 * n - 1; ++i)
+      assert(ab[i] == (u64)ab_naive[i]);
+  }
+  std::cout << "[✓] 不小于 p 的输入先被规约" << std::endl;
+
+  // 直接检查三步的组合：输出可以写回 a 自己的缓冲区
+  {
+    const u32 n = 256, p = 998244353;
+    const NttPlan<u32> &plan = get_ntt_plan<u32>(2 * n, p, 3);
+    std::vector<u32> a(n), b(n), buf_a(2 * n), buf_b(2 * n), ab(2 * n), ab_unfused(2 * n);
+    for (u32 i = 0; i < n; ++i)
+    {
+      a[i] = rng() % p;
+      b[i] = rng() % p;
+    }
+    ntt_forward_dif_lazy_from_input(buf_a.data(), a.data(), n, plan);
+    ntt_forward_dif_lazy_from_input(buf_b.data(), b.data(), n, plan);
+    ntt_pointwise_lazy_fused(buf_a.data(), buf_b.data(), plan);
+    ntt_inverse_dit_lazy_to_output(buf_a.data(), buf_a.data(), plan);
+    NttWorkspace workspace;
+    poly_multiply_unfused(a.data(), b.data(), ab_unfused.data(), n, p, workspace);
+    assert(buf_a == ab_unfused);
+  }
+  std::cout << "[✓] 逆变换的最后一层可以就地写出结果" << std::endl;
+
+  // 性能：长度 131072 的乘法
+  const u32 n = 131072, p = 998244353;
+  const int repeat = 50;
+  std::vector<u32> a(n), b(n), ab(2 * n);
+  for (u32 i = 0; i < n; ++i)
+  {
+    a[i] = rng() % p;
+    b[i] = rng() % p;
+  }
+  NttWorkspace workspace;
+  double unfused_ms = average_ms(repeat, [&]()
+                                 { poly_multiply_unfused(a.data(), b.data(), ab.data(), n, p, workspace); });
+  double fused_ms = average_ms(repeat, [&]()
+                               { poly_multiply_ntt(a.data(), b.data(), ab.data(), n, p, 3u, workspace); });
+  std::cout << "n = " << n << ", " << repeat << " 次乘法平均: 分开 " << unfused_ms << " ms, 融合 " << fused_ms << " ms" << std::endl;
+#ifndef NTT_SIMD_NONE
+  double unfused_simd_ms = average_ms(repeat, [&]()
+                                      { poly_multiply_unfused_simd(a.data(), b.data(), ab.data(), n, p, workspace); });
+  double fused_simd_ms = average_ms(repeat, [&]()
+                                    { poly_multiply_ntt_simd((int *)a.data(), (int *)b.data(), (int *)ab.data(), (int)n, (int)p, 3, workspace); });
+  std::cout << "SIMD: 分开 " << unfused_simd_ms << " ms, 融合 " << fused_simd_ms << " ms" << std::endl;
+#endif
+  return 0;
+}
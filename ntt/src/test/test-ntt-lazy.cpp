@@ -0,0 +1,138 @@
+#include "../include/ntt.h"
+#include "../include/simd/ntt.h"
+
+#include <cassert>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <vector>
+
+// 惰性规约（Harvey 蝴蝶 + Shoup 模乘）的变换：与完全规约的版本、朴素乘法比较
+
+// u64 模数超出 poly_multiply_naive 的范围，这里单独写一个
+void poly_multiply_naive_u64(const u64 *a, const u64 *b, u64 *ab, u64 n, u64 p)
+{
+  for (u64 i = 0; i < n; ++i)
+    for (u64 j = 0; j < n; ++j)
+      ab[i + j] = (u64)(((u128)a[i] * b[j] + ab[i + j]) % p);
+}
+
+template <typename F>
+void check_u32(const char *name, u32 n, u32 p, bool worst_case, std::mt19937 &rng, F poly_multiply)
+{
+  std::vector<u32> a(n), b(n), ab(expand_n(2 * n - 1));
+  std::vector<int> ai(n), bi(n), ab_naive(2 * n - 1, 0);
+  for (u32 i = 0; i < n; ++i)
+  {
+    a[i] = ai[i] = worst_case ? p - 1 : rng() % p;
+    b[i] = bi[i] = worst_case ? p - 1 : rng() % p;
+  }
+  poly_multiply(a.data(), b.data(), ab.data(), n, p);
+  poly_multiply_naive(ai.data(), bi.data(), ab_naive.data(), (int)n, (int)p);
+  for (u32 i = 0; i < 2 * n - 1; ++i)
+  {
+    if (ab[i] != (u32)ab_naive[i])
+    {
+      std::cout << "[✗] " << name << " n = " << n << ", p = " << p << " 第 " << i << " 项: 预期 " << ab_naive[i] << ", 实际 " << ab[i] << std::endl;
+      assert(false);
+    }
+  }
+}
+
+void check_u64(u64 n, u64 p, u64 root, std::mt19937_64 &rng)
+{
+  std::vector<u64> a(n), b(n), ab(expand_n(2 * n - 1)), ab_naive(2 * n - 1, 0);
+  for (u64 i = 0; i < n; ++i)
+  {
+    a[i] = rng() % p;
+    b[i] = rng() % p;
+  }
+  poly_multiply_ntt(a.data(), b.data(), ab.data(), n, p, root);
+  poly_multiply_naive_u64(a.data(), b.data(), ab_naive.data(), n, p);
+  for (u64 i = 0; i < 2 * n - 1; ++i)
+    assert(ab[i] == ab_naive[i]);
+}
+
+int main()
+{
+  std::mt19937 rng(43);
+  std::mt19937_64 rng64(43);
+
+  assert(ShoupMod<u32>::supports(1004535809));
+  assert(!ShoupMod<u32>::supports(2013265921));
+
+  // 惰性 DIF 的结果规约后与完全规约的 DIF 一致，惰性 DIT 把它变回原序列
+  for (u32 p : {998244353u, 1004535809u})
+  {
+    u32 n = 256;
+    const NttPlan<u32> &plan = get_ntt_plan<u32>(n, p, 3);
+    assert(plan.supports_lazy());
+    std::vector<u32> x(n), exact(n), lazy(n);
+    for (u32 i = 0; i < n; ++i)
+      x[i] = exact[i] = lazy[i] = rng() % p;
+    ntt_forward_dif_mont(exact.data(), plan);
+    ntt_forward_dif_mont_lazy(lazy.data(), plan);
+    for (u32 i = 0; i < n; ++i)
+    {
+      assert(lazy[i] < 2 * p);
+      assert(plan.shoup().reduce_p(lazy[i]) == exact[i]);
+    }
+    ntt_inverse_dit_mont_lazy(lazy.data(), plan);
+    assert(lazy == x);
+  }
+
+  // u32：小于 2^30 的模数走惰性规约，2013265921 > 2^30 走完全规约；全为 p - 1 的输入检验上界
+  for (u32 p : {7340033u, 104857601u, 469762049u, 998244353u, 1004535809u})
+  {
+    for (u32 n : {1u, 2u, 3u, 17u, 64u, 300u, 1000u})
+    {
+      for (bool worst_case : {false, true})
+      {
+        check_u32("scalar", n, p, worst_case, rng, [](u32 *a, u32 *b, u32 *ab, u32 n, u32 p)
+                  { poly_multiply_ntt(a, b, ab, n, p); });
+        if (n >= 2) // SIMD 版本要求 n_expanded >= 4
+          check_u32("simd", n, p, worst_case, rng, [](u32 *a, u32 *b, u32 *ab, u32 n, u32 p)
+                    { poly_multiply_ntt_simd((int *)a, (int *)b, (int *)ab, (int)n, (int)p); });
+      }
+    }
+  }
+  for (u32 n : {5u, 300u})
+  {
+    check_u32("scalar", n, 2013265921u, true, rng, [](u32 *a, u32 *b, u32 *ab, u32 n, u32 p)
+              { poly_multiply_ntt(a, b, ab, n, p, 31u); });
+    check_u32("simd", n, 2013265921u, true, rng, [](u32 *a, u32 *b, u32 *ab, u32 n, u32 p)
+              { poly_multiply_ntt_simd((int *)a, (int *)b, (int *)ab, (int)n, (int)p, 31); });
+  }
+
+  // u64：模数小于 2^62 也走惰性规约
+  check_u64(500, 469762049, 3, rng64);
+  check_u64(500, 4179340454199820289ull, 3, rng64); // 29·2^57 + 1
+  std::cout << "[✓] 惰性规约的乘法与朴素乘法一致" << std::endl;
+
+  // 性能：长度 131072 的乘法所用的 2^18 点正变换 + 逆变换
+  const u32 n = 1 << 18, p = 998244353;
+  const int repeat = 20;
+  const NttPlan<u32> &plan = get_ntt_plan<u32>(n, p, 3);
+  std::vector<u32> x(n);
+  for (u32 i = 0; i < n; ++i)
+    x[i] = rng() % p;
+
+  auto start = std::chrono::steady_clock::now();
+  for (int r = 0; r < repeat; ++r)
+  {
+    ntt_forward_dif_mont(x.data(), plan);
+    ntt_inverse_dit_mont(x.data(), plan);
+  }
+  double exact_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / repeat;
+
+  start = std::chrono::steady_clock::now();
+  for (int r = 0; r < repeat; ++r)
+  {
+    ntt_forward_dif_mont_lazy(x.data(), plan);
+    ntt_inverse_dit_mont_lazy(x.data(), plan);
+  }
+  double lazy_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / repeat;
+
+  std::cout << "n = " << n << " 正变换 + 逆变换平均: 完全规约 " << exact_ms << " ms, 惰性规约 " << lazy_ms << " ms" << std::endl;
+  return 0;
+}
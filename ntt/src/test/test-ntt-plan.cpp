@@ -0,0 +1,110 @@
+#include "../include/ntt.h"
+
+#include <cassert>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <vector>
+
+// 不使用计划的旧流程：每次调用都新建 MontMod，逐层求幂生成旋转因子
+template <typename T>
+void poly_multiply_ntt_no_plan(T *a, T *b, T *ab, T n, T p, T OMEGA = 3)
+{
+  using T_mont = T;
+
+  MontMod<T> montMod(p);
+
+  T n_expanded = expand_n(2 * n - 1);
+  T *a_expanded = expand_a(a, n, n_expanded);
+  T *b_expanded = expand_a(b, n, n_expanded);
+
+  bit_reverse_permute(a_expanded, n_expanded);
+  bit_reverse_permute(b_expanded, n_expanded);
+
+  std::vector<T_mont> a_mont(n_expanded), b_mont(n_expanded), ab_mont(n_expanded);
+  for (T i = 0; i < n_expanded; ++i)
+    a_mont[i] = montMod.from_T(a_expanded[i]);
+  for (T i = 0; i < n_expanded; ++i)
+    b_mont[i] = montMod.from_T(b_expanded[i]);
+  T_mont omega_mont = montMod.from_T(OMEGA);
+
+  ntt_forward_mont(a_mont.data(), n_expanded, p, omega_mont);
+  ntt_forward_mont(b_mont.data(), n_expanded, p, omega_mont);
+
+  for (T i = 0; i < n_expanded; ++i)
+    ab_mont[i] = montMod.mul(a_mont[i], b_mont[i]);
+
+  ntt_inverse_mont(ab_mont.data(), n_expanded, p, montMod.inv(omega_mont));
+
+  for (T i = 0; i < n_expanded; ++i)
+    ab[i] = montMod.to_T(ab_mont[i]);
+
+  bit_reverse_permute(ab, n_expanded);
+
+  delete[] a_expanded;
+  delete[] b_expanded;
+}
+
+template <typename T>
+void check_against_naive(T n, T p, std::mt19937 &rng)
+{
+  std::vector<T> a(n), b(n), ab(expand_n(2 * n - 1));
+  std::vector<int> ai(n), bi(n), ab_naive(2 * n - 1, 0);
+  for (T i = 0; i < n; ++i)
+  {
+    a[i] = ai[i] = rng() % p;
+    b[i] = bi[i] = rng() % p;
+  }
+  poly_multiply_ntt(a.data(), b.data(), ab.data(), n, p);
+  poly_multiply_naive(ai.data(), bi.data(), ab_naive.data(), (int)n, (int)p);
+  for (T i = 0; i < 2 * n - 1; ++i)
+  {
+    if (ab[i] != (T)ab_naive[i])
+    {
+      std::cout << "[✗] n = " << n << ", p = " << p << " 第 " << i << " 项: 预期 " << ab_naive[i] << ", 实际 " << ab[i] << std::endl;
+      assert(false);
+    }
+  }
+}
+
+int main()
+{
+  std::mt19937 rng(41);
+
+  // 正确性：与朴素乘法比较，包括 n_expanded = 1, 2 的边界情况
+  for (u32 p : {7340033u, 104857601u, 469762049u, 998244353u})
+    for (u32 n : {1u, 2u, 3u, 17u, 64u, 300u, 1000u})
+      check_against_naive<u32>(n, p, rng);
+  for (u64 p : {7340033ull, 104857601ull, 469762049ull})
+    for (u64 n : {1ull, 5ull, 256ull, 777ull})
+      check_against_naive<u64>(n, p, rng);
+  std::cout << "[✓] 计划版 poly_multiply_ntt 与朴素乘法一致" << std::endl;
+
+  // 性能：重复做 n = 131072 的乘法
+  const u32 n = 131072, p = 998244353;
+  const int repeat = 20;
+  std::vector<u32> a(n), b(n), ab_plan(2 * n), ab_old(2 * n);
+  for (u32 i = 0; i < n; ++i)
+  {
+    a[i] = rng() % p;
+    b[i] = rng() % p;
+  }
+
+  poly_multiply_ntt(a.data(), b.data(), ab_plan.data(), n, p); // 构造并缓存计划
+  poly_multiply_ntt_no_plan(a.data(), b.data(), ab_old.data(), n, p);
+  for (u32 i = 0; i < 2 * n - 1; ++i)
+    assert(ab_plan[i] == ab_old[i]);
+
+  auto start = std::chrono::steady_clock::now();
+  for (int r = 0; r < repeat; ++r)
+    poly_multiply_ntt_no_plan(a.data(), b.data(), ab_old.data(), n, p);
+  double old_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / repeat;
+
+  start = std::chrono::steady_clock::now();
+  for (int r = 0; r < repeat; ++r)
+    poly_multiply_ntt(a.data(), b.data(), ab_plan.data(), n, p);
+  double plan_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / repeat;
+
+  std::cout << "n = " << n << ", " << repeat << " 次乘法平均: 无计划 " << old_ms << " ms, 使用计划 " << plan_ms << " ms" << std::endl;
+  return 0;
+}
@@ -0,0 +1,95 @@
+#include "../include/ntt.h"
+#include "../include/radix4/ntt.h"
+
+#include <cassert>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <vector>
+
+// radix-4 变换：结果与 radix-2 惰性规约的变换逐项相同，乘法与朴素乘法一致
+
+int main()
+{
+  std::mt19937 rng(44);
+
+  // log2(n) 为奇数和偶数两种情况，包括 n = 1, 2, 4, 8
+  for (u32 p : {998244353u, 1004535809u})
+  {
+    for (u32 n = 1; n <= (1u << 12); n <<= 1)
+    {
+      const NttPlan<u32> &plan = get_ntt_plan<u32>(n, p, 3);
+      std::vector<u32> x(n), radix2(n), radix4(n);
+      for (u32 i = 0; i < n; ++i)
+        x[i] = radix2[i] = radix4[i] = rng() % p;
+      ntt_forward_dif_mont_lazy(radix2.data(), plan);
+      ntt_forward_dif_radix4_lazy(radix4.data(), plan);
+      for (u32 i = 0; i < n; ++i)
+      {
+        assert(radix4[i] < 2 * p);
+        assert(plan.shoup().reduce_p(radix4[i]) == plan.shoup().reduce_p(radix2[i]));
+      }
+      ntt_inverse_dit_radix4_lazy(radix4.data(), plan);
+      assert(radix4 == x);
+    }
+  }
+
+  for (u32 p : {7340033u, 104857601u, 469762049u, 998244353u, 1004535809u, 2013265921u})
+  {
+    u32 root = p == 2013265921u ? 31 : 3;
+    for (u32 n : {1u, 2u, 3u, 5u, 17u, 64u, 300u, 1000u})
+    {
+      for (bool worst_case : {false, true})
+      {
+        std::vector<u32> a(n), b(n), ab(expand_n(2 * n - 1));
+        std::vector<int> ai(n), bi(n), ab_naive(2 * n - 1, 0);
+        for (u32 i = 0; i < n; ++i)
+        {
+          a[i] = ai[i] = worst_case ? p - 1 : rng() % p;
+          b[i] = bi[i] = worst_case ? p - 1 : rng() % p;
+        }
+        poly_multiply_ntt_radix4(a.data(), b.data(), ab.data(), n, p, root);
+        poly_multiply_naive(ai.data(), bi.data(), ab_naive.data(), (int)n, (int)p);
+        for (u32 i = 0; i < 2 * n - 1; ++i)
+        {
+          if (ab[i] != (u32)ab_naive[i])
+          {
+            std::cout << "[✗] n = " << n << ", p = " << p << " 第 " << i << " 项: 预期 " << ab_naive[i] << ", 实际 " << ab[i] << std::endl;
+            assert(false);
+          }
+        }
+      }
+    }
+  }
+  std::cout << "[✓] radix-4 变换与 radix-2 一致，乘法与朴素乘法一致" << std::endl;
+
+  // 性能：log2(n) 为偶数 (2^18) 和奇数 (2^17) 的正变换 + 逆变换
+  for (u32 n : {1u << 18, 1u << 17})
+  {
+    const u32 p = 998244353;
+    const int repeat = 20;
+    const NttPlan<u32> &plan = get_ntt_plan<u32>(n, p, 3);
+    std::vector<u32> x(n);
+    for (u32 i = 0; i < n; ++i)
+      x[i] = rng() % p;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < repeat; ++r)
+    {
+      ntt_forward_dif_mont_lazy(x.data(), plan);
+      ntt_inverse_dit_mont_lazy(x.data(), plan);
+    }
+    double radix2_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / repeat;
+
+    start = std::chrono::steady_clock::now();
+    for (int r = 0; r < repeat; ++r)
+    {
+      ntt_forward_dif_radix4_lazy(x.data(), plan);
+      ntt_inverse_dit_radix4_lazy(x.data(), plan);
+    }
+    double radix4_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / repeat;
+
+    std::cout << "n = " << n << " 正变换 + 逆变换平均: radix-2 " << radix2_ms << " ms, radix-4 " << radix4_ms << " ms" << std::endl;
+  }
+  return 0;
+}
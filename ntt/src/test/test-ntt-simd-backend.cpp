@@ -0,0 +1,173 @@
+#include "../include/ntt.h"
+#include "../include/simd/ntt.h"
+
+#include <cassert>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <vector>
+
+// SIMD 后端（NEON / AVX2 / AVX-512）：向量模运算与标量逐通道一致，变换和乘法与标量版本一致
+// 编译时用 -mavx2 或 -mavx512f（或 -march=native）选择 x86 后端
+
+#ifndef NTT_SIMD_NONE
+
+void check_ops(u32 p, std::mt19937 &rng)
+{
+  MontMod<u32> montMod(p);
+  MontModSimd montModSimd(p);
+  std::vector<u32> a(SIMD_LANES), b(SIMD_LANES), out(SIMD_LANES);
+  for (int round = 0; round < 1000; ++round)
+  {
+    for (u32 i = 0; i < SIMD_LANES; ++i)
+    {
+      // 前几轮用边界值
+      a[i] = round == 0 ? p - 1 : round == 1 ? 0 : rng() % p;
+      b[i] = round == 0 ? p - 1 : rng() % p;
+    }
+    u32xN a_mont = montModSimd.from_u32xN(simd_load(a.data()));
+    u32xN b_mont = montModSimd.from_u32xN(simd_load(b.data()));
+
+    simd_store(out.data(), a_mont);
+    for (u32 i = 0; i < SIMD_LANES; ++i)
+      assert(out[i] == montMod.from_T(a[i]));
+    simd_store(out.data(), montModSimd.to_u32xN(a_mont));
+    for (u32 i = 0; i < SIMD_LANES; ++i)
+      assert(out[i] == a[i]);
+    simd_store(out.data(), montModSimd.add(a_mont, b_mont));
+    for (u32 i = 0; i < SIMD_LANES; ++i)
+      assert(out[i] == montMod.add(montMod.from_T(a[i]), montMod.from_T(b[i])));
+    simd_store(out.data(), montModSimd.sub(a_mont, b_mont));
+    for (u32 i = 0; i < SIMD_LANES; ++i)
+      assert(out[i] == montMod.sub(montMod.from_T(a[i]), montMod.from_T(b[i])));
+    simd_store(out.data(), montModSimd.mul(a_mont, b_mont));
+    for (u32 i = 0; i < SIMD_LANES; ++i)
+      assert(out[i] == montMod.mul(montMod.from_T(a[i]), montMod.from_T(b[i])));
+  }
+
+  if (!ShoupMod<u32>::supports(p))
+    return;
+  ShoupMod<u32> shoupMod(p);
+  ShoupModSimd shoupModSimd(p);
+  std::vector<u32> w(SIMD_LANES), w_shoup(SIMD_LANES);
+  for (int round = 0; round < 1000; ++round)
+  {
+    for (u32 i = 0; i < SIMD_LANES; ++i)
+    {
+      a[i] = round == 0 ? 4 * p - 1 : rng() % (4 * p); // 惰性蝴蝶的输入可以到 [0, 4p)
+      w[i] = round == 0 ? p - 1 : rng() % p;
+      w_shoup[i] = shoupMod.quotient(w[i]);
+    }
+    simd_store(out.data(), shoupModSimd.mul(simd_load(a.data()), simd_load(w.data()), simd_load(w_shoup.data())));
+    for (u32 i = 0; i < SIMD_LANES; ++i)
+      assert(out[i] == shoupMod.mul(a[i], w[i], w_shoup[i]));
+    simd_store(out.data(), shoupModSimd.reduce_2p(simd_load(a.data())));
+    for (u32 i = 0; i < SIMD_LANES; ++i)
+      assert(out[i] == shoupMod.reduce_2p(a[i]));
+  }
+}
+
+template <typename F>
+void check_against_scalar(const char *name, u32 n, u32 p, u32 root, std::mt19937 &rng, F poly_multiply)
+{
+  std::vector<u32> a(n), b(n), ab(expand_n(2 * n - 1)), ab_scalar(expand_n(2 * n - 1));
+  for (u32 i = 0; i < n; ++i)
+  {
+    a[i] = rng() % p;
+    b[i] = rng() % p;
+  }
+  poly_multiply(a.data(), b.data(), ab.data(), n, p, root);
+  poly_multiply_ntt(a.data(), b.data(), ab_scalar.data(), n, p, root);
+  for (u32 i = 0; i < 2 * n - 1; ++i)
+  {
+    if (ab[i] != ab_scalar[i])
+    {
+      std::cout << "[✗] " << name << " n = " << n << ", p = " << p << " 第 " << i << " 项: 预期 " << ab_scalar[i] << ", 实际 " << ab[i] << std::endl;
+      assert(false);
+    }
+  }
+}
+
+int main()
+{
+  std::mt19937 rng(46);
+#if defined(NTT_SIMD_AVX512)
+  const char *backend = "AVX-512";
+#elif defined(NTT_SIMD_AVX2)
+  const char *backend = "AVX2";
+#else
+  const char *backend = "NEON";
+#endif
+  std::cout << "SIMD 后端: " << backend << "，" << SIMD_LANES << " 个通道" << std::endl;
+
+  for (u32 p : {7340033u, 104857601u, 469762049u, 998244353u, 2013265921u})
+    check_ops(p, rng);
+  std::cout << "[✓] 向量 Montgomery / Shoup 模运算与标量一致" << std::endl;
+
+  // 不足两个向量的长度退回标量；2013265921 > 2^30 走完全规约的变换
+  for (u32 p : {7340033u, 104857601u, 469762049u, 998244353u})
+    for (u32 n : {1u, 2u, 3u, 5u, 8u, 9u, 17u, 64u, 300u, 1000u, 5000u})
+      check_against_scalar("simd", n, p, 3, rng, [](u32 *a, u32 *b, u32 *ab, u32 n, u32 p, u32 root)
+                           { poly_multiply_ntt_simd((int *)a, (int *)b, (int *)ab, (int)n, (int)p, (int)root); });
+  for (u32 n : {9u, 300u, 5000u})
+    check_against_scalar("simd", n, 2013265921u, 31, rng, [](u32 *a, u32 *b, u32 *ab, u32 n, u32 p, u32 root)
+                         { poly_multiply_ntt_simd((int *)a, (int *)b, (int *)ab, (int)n, (int)p, (int)root); });
+
+  // 旧接口（逐层求旋转因子）：正变换与标量一致，逆变换还原输入
+  for (u32 n : {2 * SIMD_LANES, 1024u})
+  {
+    u32 p = 998244353;
+    MontMod<u32> montMod(p);
+    std::vector<u32> x(n), y(n), x_scalar(n);
+    for (u32 i = 0; i < n; ++i)
+      x[i] = x_scalar[i] = montMod.from_T(rng() % p);
+    // 向量要按 64 字节对齐，C++17 之前的 new 不保证，借用工作区的缓冲区
+    NttWorkspace workspace;
+    workspace.reserve(n * sizeof(u32));
+    u32xN_mont *x_simd = workspace.buffer<u32xN_mont>(0);
+    to_simd(x.data(), x_simd, n);
+    u32_mont omega_mont = montMod.from_T(3);
+    ntt_forward_mont_simd(x_simd, n, p, omega_mont);
+    ntt_forward_mont(x_scalar.data(), n, p, omega_mont);
+    from_simd(y.data(), x_simd, n);
+    assert(y == x_scalar);
+    ntt_inverse_mont_simd(x_simd, n, p, montMod.inv(omega_mont));
+    from_simd(y.data(), x_simd, n);
+    assert(x == y);
+  }
+  std::cout << "[✓] SIMD 乘法与标量乘法一致" << std::endl;
+
+  // 性能：长度 131072 的乘法
+  const u32 n = 131072, p = 998244353;
+  const int repeat = 20;
+  std::vector<u32> a(n), b(n), ab(2 * n);
+  for (u32 i = 0; i < n; ++i)
+  {
+    a[i] = rng() % p;
+    b[i] = rng() % p;
+  }
+  poly_multiply_ntt(a.data(), b.data(), ab.data(), n, p);
+
+  auto start = std::chrono::steady_clock::now();
+  for (int r = 0; r < repeat; ++r)
+    poly_multiply_ntt(a.data(), b.data(), ab.data(), n, p);
+  double scalar_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / repeat;
+
+  start = std::chrono::steady_clock::now();
+  for (int r = 0; r < repeat; ++r)
+    poly_multiply_ntt_simd((int *)a.data(), (int *)b.data(), (int *)ab.data(), (int)n, (int)p);
+  double simd_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / repeat;
+
+  std::cout << "n = " << n << ", " << repeat << " 次乘法平均: 标量 " << scalar_ms << " ms, " << backend << " " << simd_ms << " ms" << std::endl;
+  return 0;
+}
+
+#else
+
+int main()
+{
+  std::cout << "没有可用的 SIMD 后端（x86 上请用 -mavx2 或 -mavx512f 编译）" << std::endl;
+  return 0;
+}
+
+#endif
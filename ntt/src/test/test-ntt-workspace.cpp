@@ -0,0 +1,174 @@
+#include "../include/ntt.h"
+#include "../include/radix4/ntt.h"
+#include "../include/simd/ntt.h"
+
+#include <cassert>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+// 工作区版本的乘法：结果正确、工作区跨调用复用、线程各用各的；与每次分配内存的旧流程比较延迟和峰值内存
+
+// 旧流程：expand_a 两次，另外三个数组，每次调用都分配
+template <typename T>
+void poly_multiply_ntt_alloc(T *a, T *b, T *ab, T n, T p, T OMEGA = 3)
+{
+  T n_expanded = expand_n(2 * n - 1);
+  const NttPlan<T> &plan = get_ntt_plan(n_expanded, p, OMEGA);
+  const MontMod<T> &montMod = plan.mont();
+
+  T *a_expanded = expand_a(a, n, n_expanded);
+  T *b_expanded = expand_a(b, n, n_expanded);
+  T *a_mont = new T[n_expanded]{};
+  T *b_mont = new T[n_expanded]{};
+  T *ab_mont = new T[n_expanded]{};
+  for (T i = 0; i < n_expanded; ++i)
+    a_mont[i] = montMod.from_T(a_expanded[i]);
+  for (T i = 0; i < n_expanded; ++i)
+    b_mont[i] = montMod.from_T(b_expanded[i]);
+  ntt_forward_dif_mont_lazy(a_mont, plan);
+  ntt_forward_dif_mont_lazy(b_mont, plan);
+  for (T i = 0; i < n_expanded; ++i)
+    ab_mont[i] = montMod.mul(a_mont[i], b_mont[i]);
+  ntt_inverse_dit_mont_lazy(ab_mont, plan);
+  for (T i = 0; i < n_expanded; ++i)
+    ab[i] = montMod.to_T(ab_mont[i]);
+
+  delete[] a_expanded;
+  delete[] b_expanded;
+  delete[] a_mont;
+  delete[] b_mont;
+  delete[] ab_mont;
+}
+
+template <typename F>
+void check_against_naive(const char *name, u32 n, u32 p, std::mt19937 &rng, F poly_multiply)
+{
+  std::vector<u32> a(n), b(n), ab(expand_n(2 * n - 1));
+  std::vector<int> ai(n), bi(n), ab_naive(2 * n - 1, 0);
+  for (u32 i = 0; i < n; ++i)
+  {
+    a[i] = ai[i] = rng() % p;
+    b[i] = bi[i] = rng() % p;
+  }
+  poly_multiply(a.data(), b.data(), ab.data(), n, p);
+  poly_multiply_naive(ai.data(), bi.data(), ab_naive.data(), (int)n, (int)p);
+  for (u32 i = 0; i < 2 * n - 1; ++i)
+  {
+    if (ab[i] != (u32)ab_naive[i])
+    {
+      std::cout << "[✗] " << name << " n = " << n << ", p = " << p << " 第 " << i << " 项: 预期 " << ab_naive[i] << ", 实际 " << ab[i] << std::endl;
+      assert(false);
+    }
+  }
+}
+
+/** 在子进程里做一次长为 n 的乘法，返回子进程的峰值 RSS（KB）；variant = 0 只准备输入和 NTT 计划 */
+long peak_rss_kb(int variant, u32 n, u32 p)
+{
+  pid_t pid = fork();
+  if (pid == 0)
+  {
+    std::vector<u32> a(n, 1), b(n, 2), ab(2 * n);
+    get_ntt_plan<u32>(expand_n(2 * n - 1), p, 3);
+    if (variant == 1)
+      poly_multiply_ntt_alloc(a.data(), b.data(), ab.data(), n, p);
+    else if (variant == 2)
+      poly_multiply_ntt(a.data(), b.data(), ab.data(), n, p);
+    _exit(ab[1] == (variant == 0 ? 0 : 4) ? 0 : 1);
+  }
+  int status;
+  struct rusage usage;
+  wait4(pid, &status, 0, &usage);
+  assert(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+  return usage.ru_maxrss;
+}
+
+int main()
+{
+  std::mt19937 rng(48);
+
+  // 同一个工作区先后用于不同长度、不同模数和不同的乘法，旧内容不影响结果
+  NttWorkspace workspace;
+  for (u32 p : {7340033u, 104857601u, 469762049u, 998244353u})
+  {
+    for (u32 n : {1000u, 1u, 2u, 3u, 17u, 64u, 300u})
+    {
+      check_against_naive("scalar", n, p, rng, [&](u32 *a, u32 *b, u32 *ab, u32 n, u32 p)
+                          { poly_multiply_ntt(a, b, ab, n, p, 3u, workspace); });
+      check_against_naive("radix4", n, p, rng, [&](u32 *a, u32 *b, u32 *ab, u32 n, u32 p)
+                          { poly_multiply_ntt_radix4(a, b, ab, n, p, 3u, workspace); });
+      check_against_naive("simd", n, p, rng, [&](u32 *a, u32 *b, u32 *ab, u32 n, u32 p)
+                          { poly_multiply_ntt_simd((int *)a, (int *)b, (int *)ab, (int)n, (int)p, 3, workspace); });
+      check_against_naive("default", n, p, rng, [](u32 *a, u32 *b, u32 *ab, u32 n, u32 p)
+                          { poly_multiply_ntt(a, b, ab, n, p); });
+    }
+  }
+  check_against_naive("scalar", 300, 2013265921u, rng, [&](u32 *a, u32 *b, u32 *ab, u32 n, u32 p)
+                      { poly_multiply_ntt(a, b, ab, n, p, 31u, workspace); });
+  check_against_naive("simd", 300, 2013265921u, rng, [&](u32 *a, u32 *b, u32 *ab, u32 n, u32 p)
+                      { poly_multiply_ntt_simd((int *)a, (int *)b, (int *)ab, (int)n, (int)p, 31, workspace); });
+  std::cout << "[✓] 工作区版本的乘法与朴素乘法一致" << std::endl;
+
+  // 容量够用时不再分配：缓冲区地址不变
+  assert(workspace.capacity() == 2048 * sizeof(u32));
+  assert((reinterpret_cast<std::size_t>(workspace.buffer<u32>(0)) % NttWorkspace::alignment) == 0);
+  assert((reinterpret_cast<std::size_t>(workspace.buffer<u32>(1)) % NttWorkspace::alignment) == 0);
+  u32 *first = workspace.buffer<u32>(0);
+  {
+    std::vector<u32> a(1000, 1), b(1000, 1), ab(2048);
+    poly_multiply_ntt(a.data(), b.data(), ab.data(), 1000u, 998244353u, 3u, workspace);
+    poly_multiply_ntt(a.data(), b.data(), ab.data(), 10u, 998244353u, 3u, workspace);
+  }
+  assert(workspace.buffer<u32>(0) == first);
+
+  // 每个线程有自己的默认工作区
+  NttWorkspace *main_workspace = &thread_local_workspace();
+  NttWorkspace *other_workspace = nullptr;
+  std::thread([&]()
+              { other_workspace = &thread_local_workspace(); })
+      .join();
+  assert(main_workspace != other_workspace);
+  std::cout << "[✓] 工作区跨调用复用，线程之间互不共享" << std::endl;
+
+  // 延迟：小规模时分配内存占比更大
+  const u32 p = 998244353;
+  for (u32 n : {1024u, 131072u})
+  {
+    const int repeat = n < 10000 ? 2000 : 20;
+    std::vector<u32> a(n), b(n), ab(2 * n);
+    for (u32 i = 0; i < n; ++i)
+    {
+      a[i] = rng() % p;
+      b[i] = rng() % p;
+    }
+    poly_multiply_ntt_alloc(a.data(), b.data(), ab.data(), n, p);
+    poly_multiply_ntt(a.data(), b.data(), ab.data(), n, p);
+
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < repeat; ++r)
+      poly_multiply_ntt_alloc(a.data(), b.data(), ab.data(), n, p);
+    double alloc_us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / repeat;
+
+    start = std::chrono::steady_clock::now();
+    for (int r = 0; r < repeat; ++r)
+      poly_multiply_ntt(a.data(), b.data(), ab.data(), n, p);
+    double workspace_us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / repeat;
+
+    std::cout << "n = " << n << " 乘法平均: 每次分配 " << alloc_us << " us, 工作区 " << workspace_us << " us" << std::endl;
+  }
+
+  // 峰值内存：n = 2^20（n_expanded = 2^21），减去只准备输入和计划时的峰值
+  const u32 n = 1 << 20;
+  long base_kb = peak_rss_kb(0, n, p);
+  long alloc_kb = peak_rss_kb(1, n, p) - base_kb;
+  long workspace_kb = peak_rss_kb(2, n, p) - base_kb;
+  std::cout << "n = " << n << " 乘法额外的峰值 RSS: 每次分配 " << alloc_kb << " KB, 工作区 " << workspace_kb << " KB" << std::endl;
+  assert(workspace_kb < alloc_kb);
+  return 0;
+}